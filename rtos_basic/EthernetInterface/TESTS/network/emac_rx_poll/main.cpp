@@ -0,0 +1,141 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "mbed.h"
+#include "rtos.h"
+#include "EthernetInterface.h"
+#include "lpc17_emac.h"
+
+/* Receive cost of the LPC1768 EMAC driver under a UDP flood, with the RX
+   ring polled (LPC_RX_POLL 1) or a receive task wakeup on every RX
+   interrupt (LPC_RX_POLL 0, set in lpc_emac_config.h).
+
+   The board takes datagrams on RX_PORT for WINDOWS windows of WINDOW_MS
+   each. Send them from a machine on the LAN, at a rate of your choosing,
+   for instance:
+
+     iperf -u -c <board address> -p 9001 -l 1024 -b 20M -t 60
+
+   For each window the benchmark prints the frames the driver passed to
+   the stack and the datagrams the socket delivered, the receive task
+   wakeups and ring passes per thousand frames, the frames dropped for want
+   of an RX buffer and the overruns, and the share of the processor left
+   to a spinning thread below the receiver, against a calibration window
+   without traffic. It ends with the histogram of frames taken per pass:
+   with polling, a loaded link shows passes of LPC_RX_BUDGET frames and
+   few wakeups, and the spare processor should not fall below that of
+   LPC_RX_POLL 0 at the same rate. The mbed tools leave TESTS out of the
+   application build; build this as a test of its own, or copy it to an
+   empty program with the EthernetInterface and mbed-rtos libraries, and
+   read the results at 9600 baud. */
+
+#define RX_PORT         9001
+#define WINDOW_MS       2000
+#define WINDOWS         15
+#define SPIN_STACK      256
+
+static volatile uint32_t spins;
+static char buf[1500];
+
+static void spin(void)
+{
+    while (true) {
+        spins++;
+    }
+}
+
+static uint32_t spins_in_window(void)
+{
+    uint32_t before = spins;
+
+    Thread::wait(WINDOW_MS);
+    return spins - before;
+}
+
+int main()
+{
+    EthernetInterface eth;
+    UDPSocket sock;
+    Endpoint from;
+    Thread spinner(osPriorityLow, SPIN_STACK);
+    lpc_emac_stats_t first, before, after;
+    uint32_t idle_spins, frames, datagrams, spun;
+    float expected;
+    int i;
+
+    eth.init();
+    if (eth.connect() != 0) {
+        printf("no network\r\n");
+        return 1;
+    }
+    sock.bind(RX_PORT);
+    sock.set_blocking(false, 100);
+    spinner.start(callback(spin));
+
+    // The spinner's share of an idle window is the whole processor
+    printf("\r\n%s, UDP port %d, LPC_RX_POLL %d, LPC_RX_BUDGET %d\r\n",
+           eth.getIPAddress(), RX_PORT, LPC_RX_POLL, LPC_RX_BUDGET);
+    printf("calibrating, keep the link quiet\r\n");
+    idle_spins = spins_in_window();
+
+    printf("%7s %7s %7s %7s %7s %7s %7s\r\n", "frames", "dgrams", "wake/k", "pass/k",
+           "nobuf", "overrun", "spare%");
+    lpc_emac_get_stats(&first);
+    for (i = 0; i < WINDOWS; i++) {
+        Timer timer;
+        uint32_t before_spins = spins;
+
+        lpc_emac_get_stats(&before);
+        datagrams = 0;
+        timer.start();
+        while (timer.read_ms() < WINDOW_MS) {
+            if (sock.receiveFrom(from, buf, sizeof(buf)) > 0) {
+                datagrams++;
+            }
+        }
+        lpc_emac_get_stats(&after);
+        spun = spins - before_spins;
+        // The last wait for a datagram may run past the window
+        expected = idle_spins * (timer.read_ms() / (float)WINDOW_MS);
+
+        frames = after.rx_frames - before.rx_frames;
+        printf("%7lu %7lu %7lu %7lu %7lu %7lu %7.1f\r\n", (unsigned long)frames,
+               (unsigned long)datagrams,
+               (unsigned long)(frames ? (after.rx_wakeups - before.rx_wakeups) * 1000ULL / frames : 0),
+               (unsigned long)(frames ? (after.rx_passes - before.rx_passes) * 1000ULL / frames : 0),
+               (unsigned long)(after.rx_drop_nobuf - before.rx_drop_nobuf),
+               (unsigned long)(after.rx_overrun - before.rx_overrun),
+               expected > 0 ? spun * 100.0f / expected : 0.0f);
+    }
+
+    printf("frames per pass:");
+    for (i = 0; i <= LPC_RX_BUDGET; i++) {
+        printf(" %d%s:%lu", i, (i == LPC_RX_BUDGET) ? "+" : "",
+               (unsigned long)(after.rx_batch[i] - first.rx_batch[i]));
+    }
+    printf("\r\ndone\r\n");
+
+    sock.close();
+    eth.disconnect();
+    while (true) {
+        Thread::wait(1000);
+    }
+}
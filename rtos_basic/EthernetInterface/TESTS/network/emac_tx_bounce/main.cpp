@@ -0,0 +1,126 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "mbed.h"
+#include "rtos.h"
+#include "EthernetInterface.h"
+#include "lwip/mem.h"
+#include "lpc17_emac.h"
+
+/* UDP transmit throughput of the LPC1768 EMAC driver with and without
+   bounce buffers.
+
+   lwip_sendto sends the datagram from the caller's buffer, as a PBUF_REF
+   segment behind the header pbuf. lpc_low_level_output sends each segment
+   from its own descriptor, and copies to a bounce buffer only those that
+   the EMAC cannot reach by DMA. The benchmark sends the same datagrams
+   from three buffers:
+
+     heap     the lwIP heap in AHBSRAM0, which the EMAC reads in place
+     iram     a buffer in the local SRAM, bounced
+     flash    constant data in flash, bounced
+
+   and prints frames and Mbit/s, with the driver counters over the run:
+   tx_frames, tx_bounce_segs and tx_bounce_bytes per frame, and frames
+   dropped for want of a bounce buffer. TCP is not measured: lwip_send
+   copies into the TCP send buffer, which is in DMA memory, so TCP frames
+   never bounce.
+
+   The datagrams go to SINK_PORT of SINK_IP, which only needs to be on the
+   LAN; a sink such as "nc -ul 9000 >/dev/null" on it lets the rate be
+   checked at the other end. The mbed tools leave TESTS out of the
+   application build; build this as a test of its own, or copy it to an
+   empty program with the EthernetInterface and mbed-rtos libraries, and
+   read the results at 9600 baud. */
+
+#ifndef SINK_IP
+#define SINK_IP         "192.168.1.2"
+#endif
+#define SINK_PORT       9000
+#define DATAGRAM_SIZE   1024
+#define DATAGRAMS       4000
+
+static char iram_buf[DATAGRAM_SIZE];
+static const char flash_buf[DATAGRAM_SIZE] = "emac_tx_bounce";
+
+static void run(const char *name, const char *buf, UDPSocket &sock, Endpoint &sink)
+{
+    lpc_emac_stats_t before, after;
+    uint32_t frames;
+    int failed = 0, i;
+    Timer timer;
+
+    lpc_emac_get_stats(&before);
+    timer.start();
+    for (i = 0; i < DATAGRAMS; i++) {
+        if (sock.sendTo(sink, (char *)buf, DATAGRAM_SIZE) != DATAGRAM_SIZE) {
+            failed++;
+        }
+    }
+    timer.stop();
+    lpc_emac_get_stats(&after);
+
+    frames = after.tx_frames - before.tx_frames;
+    printf("%-6s %6lu %6d %7.2f %6.2f %6.0f %6lu\r\n", name, (unsigned long)frames, failed,
+           frames * (DATAGRAM_SIZE + 42) * 8.0f / timer.read() / 1e6f,
+           frames ? (after.tx_bounce_segs - before.tx_bounce_segs) / (float)frames : 0.0f,
+           frames ? (after.tx_bounce_bytes - before.tx_bounce_bytes) / (float)frames : 0.0f,
+           (unsigned long)(after.tx_drop_nomem - before.tx_drop_nomem));
+}
+
+int main()
+{
+    EthernetInterface eth;
+    UDPSocket sock;
+    Endpoint sink;
+    char *heap_buf;
+
+    eth.init();
+    if (eth.connect() != 0) {
+        printf("no network\r\n");
+        return 1;
+    }
+    printf("\r\n%s, sending to %s:%d\r\n", eth.getIPAddress(), SINK_IP, SINK_PORT);
+    sock.init();
+    sink.set_address(SINK_IP, SINK_PORT);
+
+    heap_buf = (char *)mem_malloc(DATAGRAM_SIZE);
+    if (heap_buf == NULL) {
+        printf("no lwIP heap for the buffer\r\n");
+        return 1;
+    }
+    memset(heap_buf, 0x5A, DATAGRAM_SIZE);
+    memset(iram_buf, 0x5A, DATAGRAM_SIZE);
+
+    printf("%-6s %6s %6s %7s %6s %6s %6s\r\n", "buffer", "frames", "failed", "Mbit/s",
+           "segs", "bytes", "nomem");
+    run("heap", heap_buf, sock, sink);
+    run("iram", iram_buf, sock, sink);
+    run("flash", flash_buf, sock, sink);
+    printf("done\r\n");
+
+    mem_free(heap_buf);
+    sock.close();
+    eth.disconnect();
+    while (true) {
+        Thread::wait(1000);
+    }
+}
@@ -0,0 +1,369 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+#include "lwip/opt.h"
+#include "lwip/sys.h"
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/tcpip.h"
+#include "netif/etharp.h"
+
+#include "mbed_interface.h"
+#include "critical.h"
+#include "os_host.h"
+#include "host_emac.h"
+#include "eth_arch.h"
+
+#if NO_SYS
+#error The host Ethernet driver needs NO_SYS == 0
+#endif
+
+#define RX_PRIORITY     (osPriorityNormal)
+#define RX_SIGNAL       1
+
+/** Largest frame, without the CRC */
+#define HOST_EMAC_FRAME 1514
+
+typedef struct host_frame {
+    struct host_frame *next;
+    u8_t               wired;   /* the wire model was applied */
+    u16_t              len;
+    u8_t               data[HOST_EMAC_FRAME];
+} host_frame_t;
+
+struct host_enetdata {
+    struct netif      *netif;
+    int                fd;          /* TAP device or socket */
+    sys_thread_t       rx_thread;
+    host_frame_t      *rx_head;     /* frames waiting for the receive thread */
+    host_frame_t      *rx_tail;
+    u32_t              rx_count;
+    int                rx_enabled;
+    host_emac_wire_t   wire;
+    u32_t              rand;        /* state of the drop generator */
+    uint64_t           wire_busy;   /* when the wire is free for the next frame */
+    host_emac_stats_t  stats;
+};
+
+static struct host_enetdata host_enetdata;
+
+/* xorshift32, good enough to spread the drops */
+static u32_t host_emac_rand(struct host_enetdata *enet)
+{
+    u32_t x = enet->rand;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    enet->rand = x;
+    return x;
+}
+
+/** Apply the wire model to a frame read from the descriptor
+
+  @return microseconds until the frame arrives, or -1 when it is dropped
+*/
+static int32_t host_emac_wire_delay(struct host_enetdata *enet, host_frame_t *frame)
+{
+    uint64_t now, due;
+
+    if ((enet->wire.loss_ppm != 0) &&
+        ((host_emac_rand(enet) % 1000000U) < enet->wire.loss_ppm)) {
+        return -1;
+    }
+
+    /* Frames arrive one after the other at the wire rate */
+    now = os_host_time();
+    due = now;
+    if (enet->wire.rate_kbps != 0) {
+        if (enet->wire_busy > now) {
+            due = enet->wire_busy;
+        }
+        due += ((uint64_t)frame->len * 8000U) / enet->wire.rate_kbps;
+        enet->wire_busy = due;
+    }
+    due += enet->wire.delay_us;
+    return (int32_t)(due - now);
+}
+
+/** Receive interrupt: queue the frame for the receive thread
+
+  A frame read from the descriptor first goes through the wire model, and
+  comes back once the wire has delivered it.
+*/
+static void host_emac_rx_irq(void *arg)
+{
+    struct host_enetdata *enet = &host_enetdata;
+    host_frame_t *frame = (host_frame_t *)arg;
+    int32_t delay;
+
+    if (!frame->wired) {
+        frame->wired = 1;
+        delay = host_emac_wire_delay(enet, frame);
+        if (delay < 0) {
+            enet->stats.rx_drop_loss++;
+            free(frame);
+            return;
+        }
+        if (delay > 0) {
+            os_host_irq(&host_emac_rx_irq, frame, (uint32_t)delay);
+            return;
+        }
+    }
+
+    if (enet->rx_count >= HOST_EMAC_RX_QUEUE) {
+        enet->stats.rx_drop_queue++;
+        free(frame);
+        return;
+    }
+    frame->next = NULL;
+    if (enet->rx_tail != NULL) {
+        enet->rx_tail->next = frame;
+    } else {
+        enet->rx_head = frame;
+    }
+    enet->rx_tail = frame;
+    enet->rx_count++;
+
+    if (enet->rx_enabled) {
+        osSignalSet(enet->rx_thread->id, RX_SIGNAL);
+    }
+}
+
+static host_frame_t *host_emac_rx_take(struct host_enetdata *enet)
+{
+    host_frame_t *frame;
+
+    core_util_critical_section_enter();
+    frame = enet->rx_head;
+    if (frame != NULL) {
+        enet->rx_head = frame->next;
+        if (enet->rx_head == NULL) {
+            enet->rx_tail = NULL;
+        }
+        enet->rx_count--;
+    }
+    core_util_critical_section_exit();
+    return frame;
+}
+
+/** Receive thread: pass the queued frames to the stack */
+static void host_emac_rx_thread(void *arg)
+{
+    struct host_enetdata *enet = (struct host_enetdata *)arg;
+    host_frame_t *frame;
+    struct pbuf *p;
+
+    for (;;) {
+        osSignalWait(RX_SIGNAL, osWaitForever);
+
+        while ((frame = host_emac_rx_take(enet)) != NULL) {
+            p = pbuf_alloc(PBUF_RAW, frame->len + ETH_PAD_SIZE, PBUF_POOL);
+            if (p == NULL) {
+                enet->stats.rx_drop_nobuf++;
+                free(frame);
+                pbuf_reclaim_ooseq();
+                continue;
+            }
+#if ETH_PAD_SIZE
+            pbuf_header(p, -ETH_PAD_SIZE);
+#endif
+            pbuf_take(p, frame->data, frame->len);
+#if ETH_PAD_SIZE
+            pbuf_header(p, ETH_PAD_SIZE);
+#endif
+            free(frame);
+
+            enet->stats.rx_frames++;
+            if (enet->netif->input(p, enet->netif) != ERR_OK) {
+                pbuf_free(p);
+            }
+        }
+    }
+}
+
+/** Reader of the descriptor, on a host thread the RTOS does not know */
+static void *host_emac_reader(void *arg)
+{
+    struct host_enetdata *enet = (struct host_enetdata *)arg;
+    host_frame_t *frame;
+    ssize_t len;
+
+    for (;;) {
+        frame = (host_frame_t *)malloc(sizeof(host_frame_t));
+        if (frame == NULL) {
+            mbed_die();
+        }
+        len = read(enet->fd, frame->data, HOST_EMAC_FRAME);
+        if (len <= 0) {
+            free(frame);
+            return NULL;
+        }
+        frame->wired = 0;
+        frame->len = (u16_t)len;
+        os_host_irq(&host_emac_rx_irq, frame, 0);
+    }
+}
+
+/** Low level output of a frame, called by etharp */
+static err_t host_emac_output(struct netif *netif, struct pbuf *p)
+{
+    struct host_enetdata *enet = (struct host_enetdata *)netif->state;
+    u8_t buf[HOST_EMAC_FRAME];
+    u16_t len;
+
+#if ETH_PAD_SIZE
+    pbuf_header(p, -ETH_PAD_SIZE);
+#endif
+    len = pbuf_copy_partial(p, buf, sizeof(buf), 0);
+#if ETH_PAD_SIZE
+    pbuf_header(p, ETH_PAD_SIZE);
+#endif
+
+    if (write(enet->fd, buf, len) != (ssize_t)len) {
+        enet->stats.tx_drop_err++;
+        return ERR_IF;
+    }
+    enet->stats.tx_frames++;
+    enet->stats.tx_bytes += len;
+    return ERR_OK;
+}
+
+static int host_emac_tap_open(const char *name)
+{
+    struct ifreq ifr;
+    int fd;
+
+    fd = open("/dev/net/tun", O_RDWR);
+    if (fd < 0) {
+        return -1;
+    }
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+    if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void host_emac_wire(const host_emac_wire_t *wire)
+{
+    core_util_critical_section_enter();
+    host_enetdata.wire = *wire;
+    host_enetdata.rand = (wire->seed != 0) ? wire->seed : 0x2545F491U;
+    core_util_critical_section_exit();
+}
+
+void host_emac_get_stats(host_emac_stats_t *stats)
+{
+    core_util_critical_section_enter();
+    *stats = host_enetdata.stats;
+    core_util_critical_section_exit();
+}
+
+/**
+ * Set up the network interface, on the descriptor named by the
+ * HOST_EMAC_TAP or HOST_EMAC_FD environment variable.
+ *
+ * This function should be passed as a parameter to netif_add().
+ *
+ * @param[in] netif the lwip network interface structure
+ * @return ERR_OK if the interface is initialized
+ *         ERR_IF if there is no descriptor or it cannot be opened
+ */
+err_t eth_arch_enetif_init(struct netif *netif)
+{
+    struct host_enetdata *enet = &host_enetdata;
+    const char *env;
+    pthread_t reader;
+
+    LWIP_ASSERT("netif != NULL", (netif != NULL));
+
+    enet->fd = -1;
+    if ((env = getenv("HOST_EMAC_TAP")) != NULL) {
+        enet->fd = host_emac_tap_open(env);
+    } else if ((env = getenv("HOST_EMAC_FD")) != NULL) {
+        enet->fd = atoi(env);
+    }
+    if (enet->fd < 0) {
+        return ERR_IF;
+    }
+
+    enet->netif = netif;
+    if (enet->rand == 0) {
+        enet->rand = 0x2545F491U;
+    }
+
+    /* The address of the target without an interface chip, and the
+       process id to tell the two ends of a socket pair apart */
+    mbed_mac_address((char *)netif->hwaddr);
+    netif->hwaddr[4] = (u8_t)(getpid() >> 8);
+    netif->hwaddr[5] = (u8_t)getpid();
+    netif->hwaddr_len = ETHARP_HWADDR_LEN;
+
+    netif->mtu = 1500;
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET | NETIF_FLAG_IGMP;
+#if LWIP_NETIF_HOSTNAME
+    netif->hostname = "lwiphost";
+#endif
+    netif->name[0] = 'e';
+    netif->name[1] = 'n';
+    netif->output = etharp_output;
+    netif->linkoutput = host_emac_output;
+    netif->state = enet;
+
+    enet->rx_thread = sys_thread_new("receive_thread", host_emac_rx_thread, enet, DEFAULT_THREAD_STACKSIZE, RX_PRIORITY);
+    LWIP_ASSERT("RxThread creation error", (enet->rx_thread));
+
+    if (pthread_create(&reader, NULL, &host_emac_reader, enet) != 0) {
+        return ERR_IF;
+    }
+    pthread_detach(reader);
+
+    /* The cable is always plugged in */
+    tcpip_callback_with_block((tcpip_callback_fn)netif_set_link_up, (void *)netif, 0);
+
+    return ERR_OK;
+}
+
+void eth_arch_enable_interrupts(void)
+{
+    core_util_critical_section_enter();
+    host_enetdata.rx_enabled = 1;
+    if ((host_enetdata.rx_head != NULL) && (host_enetdata.rx_thread != NULL)) {
+        osSignalSet(host_enetdata.rx_thread->id, RX_SIGNAL);
+    }
+    core_util_critical_section_exit();
+}
+
+/* Frames keep arriving while interrupts are disabled, and wait in the
+   receive queue until they are enabled again */
+void eth_arch_disable_interrupts(void)
+{
+    host_enetdata.rx_enabled = 0;
+}
@@ -0,0 +1,112 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef HOST_EMAC_H
+#define HOST_EMAC_H
+
+#include "lwip/opt.h"
+#include "lwip/netif.h"
+
+/** Ethernet driver of the host port
+
+  The files in lwip-eth/arch/TARGET_HOST run the lwIP stack of the target,
+  unchanged, on a Linux workstation: sys_arch.c runs on the RTOS host port
+  (rtx/TARGET_HOST), and this driver takes the place of the EMAC. Changes
+  to the stack can then be measured and debugged without a board.
+
+  The interface is backed by a file descriptor chosen when it starts:
+  - HOST_EMAC_TAP=name: the TAP device of that name, to talk to the host
+    network stack. The device must exist or the process must be allowed to
+    create it.
+  - HOST_EMAC_FD=n: descriptor n, inherited from the parent process, one
+    end of a socketpair(AF_UNIX, SOCK_SEQPACKET) whose other end is given
+    to a second process. Two programs built on the stack then talk to each
+    other through the real etharp.c, ip.c, tcp_in.c and tcp_out.c code,
+    with nothing else on the wire.
+
+  A host thread reads the descriptor and raises a simulated receive
+  interrupt with os_host_irq. The interrupt queues the frame for the
+  receive thread, as the EMAC RX ring would; the queue holds
+  HOST_EMAC_RX_QUEUE frames and more are dropped and counted. The receive
+  thread copies each frame into a PBUF_POOL pbuf and passes it to
+  netif->input, so pool exhaustion shows as on the target.
+
+  The receive side can model a slower wire: a propagation delay, a rate
+  at which frames arrive one after the other, and random drops from a
+  seed of its own. The kernel must run on the real time clock
+  (OS_HOST_REALTIME), as frames come from outside the process.
+
+  Building: UNITTESTS/CMakeLists.txt builds the stack with this driver as
+  the host_lwip library, and UNITTESTS/lwip/bench_lwip.c measures TCP
+  throughput, UDP datagrams per second and request/response latency over
+  it. By hand: compile the lwIP core, api and netif sources,
+  lwip-sys/arch/sys_arch.c, lwip-sys/arch/checksum.c and
+  lwip-eth/arch/TARGET_HOST/host_emac.c with the RTOS host port (see
+  os_host.h), defining TARGET_HOST and TOOLCHAIN_GCC. The include path is
+  that of the target build with lwip-eth/arch/TARGET_HOST in place of the
+  target's driver directory, and rtx/TARGET_HOST ahead of
+  rtx/TARGET_CORTEX_M.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Frames held for the receive thread */
+#ifndef HOST_EMAC_RX_QUEUE
+#define HOST_EMAC_RX_QUEUE  16
+#endif
+
+/** Properties of the wire, as seen by the receiver */
+typedef struct {
+    u32_t delay_us;     /**< propagation delay, in microseconds */
+    u32_t rate_kbps;    /**< wire rate in kbit/s, 0 to deliver at once */
+    u32_t loss_ppm;     /**< frames dropped, per million */
+    u32_t seed;         /**< seed of the drops, 0 for a fixed default */
+} host_emac_wire_t;
+
+/** Driver counters, which wrap around */
+typedef struct {
+    u32_t rx_frames;        /**< Frames passed to the stack */
+    u32_t rx_drop_queue;    /**< Frames dropped because the receive queue was full */
+    u32_t rx_drop_nobuf;    /**< Frames dropped because the pbuf pool was empty */
+    u32_t rx_drop_loss;     /**< Frames dropped by the wire model */
+    u32_t tx_frames;        /**< Frames sent */
+    u32_t tx_bytes;         /**< Bytes sent */
+    u32_t tx_drop_err;      /**< Frames the descriptor did not take */
+} host_emac_stats_t;
+
+/** Set the wire model
+
+  The wire starts without delay, rate limit or loss. Changes apply to the
+  frames read after the call.
+
+  @param wire  the new properties
+*/
+void host_emac_wire(const host_emac_wire_t *wire);
+
+/** Read the driver counters
+
+  @param stats  receives a copy of the counters
+*/
+void host_emac_get_stats(host_emac_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
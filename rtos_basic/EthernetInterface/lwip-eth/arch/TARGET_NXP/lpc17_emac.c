@@ -34,6 +34,7 @@
 #include "netif/ppp_oe.h"
 
 #include "lpc17xx_emac.h"
+#include "lpc17_emac.h"
 #include "eth_arch.h"
 #include "lpc_emac_config.h"
 #include "lpc_phy.h"
@@ -54,6 +55,26 @@
 #error LPC_NUM_BUFF_RXDESCS must be at least 3
 #endif
 
+#if (LPC_RX_BUF_SIZE < 136) || (LPC_RX_BUF_SIZE > 2048) || (LPC_RX_BUF_SIZE & 3)
+#error LPC_RX_BUF_SIZE must be a multiple of 4 from 136 to 2048
+#endif
+
+#if (LPC_NUM_BUFF_RXDESCS - 1) * LPC_RX_BUF_SIZE < EMAC_ETH_MAX_FLEN
+#error The RX descriptor ring must hold a frame of EMAC_ETH_MAX_FLEN bytes
+#endif
+
+#if LPC_RX_BUDGET < 1
+#error LPC_RX_BUDGET must be at least 1
+#endif
+
+#if LPC_NUM_RX_BUFS <= LPC_NUM_BUFF_RXDESCS
+#error LPC_NUM_RX_BUFS must be larger than LPC_NUM_BUFF_RXDESCS
+#endif
+
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error The zero-copy receive path needs LWIP_SUPPORT_CUSTOM_PBUF
+#endif
+
 /** @defgroup lwip17xx_emac_DRIVER	lpc17 EMAC driver for LWIP
  * @ingroup lwip_emac
  *
@@ -113,6 +134,15 @@ typedef struct
 	volatile u32_t statushashcrc; /**< RX hash CRC */
 } LPC_TXRX_STATUS_T;
 
+/** \brief  RX pool buffer, passed to the stack as a custom pbuf
+ */
+struct lpc_rxbuf
+{
+	struct pbuf_custom pc;    /**< pbuf handed to the stack, must be first */
+	struct lpc_rxbuf *next;   /**< Next free buffer in the pool */
+	u8_t *data;               /**< DMA buffer of LPC_RX_BUF_SIZE bytes */
+};
+
 /* LPC EMAC driver data structure */
 struct lpc_enetdata {
     /* prxs must be 8 byte aligned! */
@@ -121,10 +151,12 @@ struct lpc_enetdata {
 	LPC_TXRX_DESC_T ptxd[LPC_NUM_BUFF_TXDESCS];   /**< Pointer to TX descriptor list */
 	LPC_TXRX_STATUS_T ptxs[LPC_NUM_BUFF_TXDESCS]; /**< Pointer to TX statuses */
 	LPC_TXRX_DESC_T prxd[LPC_NUM_BUFF_RXDESCS];   /**< Pointer to RX descriptor list */
-	struct pbuf *rxb[LPC_NUM_BUFF_RXDESCS]; /**< RX pbuf pointer list, zero-copy mode */
-	u32_t rx_fill_desc_index; /**< RX descriptor next available index */
-	volatile u32_t rx_free_descs; /**< Count of free RX descriptors */
+	struct lpc_rxbuf *rxb[LPC_NUM_BUFF_RXDESCS]; /**< RX buffer of each descriptor */
+	struct lpc_rxbuf *rx_free; /**< RX pool buffers not in the ring or the stack */
+	u32_t rx_free_count; /**< Count of buffers on the rx_free list */
+	lpc_emac_stats_t stats; /**< Driver counters */
 	struct pbuf *txb[LPC_NUM_BUFF_TXDESCS]; /**< TX pbuf pointer list, zero-copy mode */
+	struct pbuf *txbounce[LPC_NUM_BUFF_TXDESCS]; /**< TX bounce buffer of each descriptor */
 	u32_t lpc_last_tx_idx; /**< TX last descriptor index, zero-copy mode */
 #if NO_SYS == 0
 	sys_thread_t RxThread; /**< RX receive thread data object pointer */
@@ -156,115 +188,221 @@ struct lpc_enetdata {
  */
 ETHMEM_SECTION struct lpc_enetdata lpc_enetdata;
 
-/** \brief  Queues a pbuf into the RX descriptor list
- *
- *  \param[in] lpc_enetif Pointer to the drvier data structure
- *  \param[in] p            Pointer to pbuf to queue
- */
-static void lpc_rxqueue_pbuf(struct lpc_enetdata *lpc_enetif, struct pbuf *p)
-{
-	u32_t idx;
+#if defined(TARGET_LPC1768) && defined(TOOLCHAIN_GCC_ARM)
+/* The rest of AHBSRAM1 goes to the memp pools, see LPC_AHBSRAM1_SIZE */
+typedef char lpc_enetdata_ahbsram1_overflow[(sizeof(struct lpc_enetdata) <= LPC_EMAC_AHBSRAM1_SHARE) ? 1 : -1];
+#endif
 
-	/* Get next free descriptor index */
-	idx = lpc_enetif->rx_fill_desc_index;
+/* The RX pool shares AHBSRAM0 with the lwIP heap, see MEM_SIZE */
+#if defined(TARGET_LPC1768)
+#  define RXMEM_SECTION __attribute__((section("AHBSRAM0"),aligned))
+#else
+#  define RXMEM_SECTION ETHMEM_SECTION
+#endif
 
-	/* Setup descriptor and clear statuses */
-	lpc_enetif->prxd[idx].control = EMAC_RCTRL_INT | ((u32_t) (p->len - 1));
-	lpc_enetif->prxd[idx].packet = (u32_t) p->payload;
-	lpc_enetif->prxs[idx].statusinfo = 0xFFFFFFFF;
-	lpc_enetif->prxs[idx].statushashcrc = 0xFFFFFFFF;
+/** \brief  RX pool DMA buffers
+ */
+RXMEM_SECTION static u32_t lpc_rxmem[LPC_NUM_RX_BUFS][LPC_RX_BUF_SIZE / 4];
 
-	/* Save pbuf pointer for push to network layer later */
-	lpc_enetif->rxb[idx] = p;
+/** \brief  RX pool buffer descriptors, kept out of the DMA memory
+ */
+static struct lpc_rxbuf lpc_rxbufs[LPC_NUM_RX_BUFS];
 
-	/* Wrap at end of descriptor list */
-	idx++;
-	if (idx >= LPC_NUM_BUFF_RXDESCS)
-		idx = 0;
+/** \brief  Returns a buffer to the RX pool
+ *
+ *  \param[in] lpc_enetif Pointer to the driver data structure
+ *  \param[in] b          Buffer to free
+ */
+static void lpc_rxbuf_put(struct lpc_enetdata *lpc_enetif, struct lpc_rxbuf *b)
+{
+	SYS_ARCH_DECL_PROTECT(lev);
 
-	/* Queue descriptor(s) */
-	lpc_enetif->rx_free_descs -= 1;
-	lpc_enetif->rx_fill_desc_index = idx;
-	LPC_EMAC->RxConsumeIndex = idx;
+	SYS_ARCH_PROTECT(lev);
+	b->next = lpc_enetif->rx_free;
+	lpc_enetif->rx_free = b;
+	lpc_enetif->rx_free_count++;
+	SYS_ARCH_UNPROTECT(lev);
+}
 
-	LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
-		("lpc_rxqueue_pbuf: pbuf packet queued: %p (free desc=%d)\n", p,
-			lpc_enetif->rx_free_descs));
+/** \brief  Custom pbuf free function of RX frames
+ *
+ *  Called by pbuf_free() from whichever thread releases the last
+ *  reference to a received buffer. The buffer goes back to the pool and
+ *  is put in the descriptor ring again as frames are received.
+ *
+ *  \param[in] p  The pbuf of an RX pool buffer
+ */
+static void lpc_rxbuf_free(struct pbuf *p)
+{
+	lpc_rxbuf_put(&lpc_enetdata, (struct lpc_rxbuf *) p);
 }
 
-/** \brief  Attempt to allocate and requeue a new pbuf for RX
+/** \brief  Takes buffers from the RX pool
  *
- *  \param[in]     netif Pointer to the netif structure
- *  \returns         1 if a packet was allocated and requeued, otherwise 0
+ *  Either all requested buffers are taken, or none.
+ *
+ *  \param[in]  lpc_enetif Pointer to the driver data structure
+ *  \param[out] bufs       Receives the buffers, linked by their next field
+ *  \param[in]  count      Number of buffers to take
+ *  \return                1 if the buffers were taken, otherwise 0
  */
-s32_t lpc_rx_queue(struct netif *netif)
+static s32_t lpc_rxbuf_get(struct lpc_enetdata *lpc_enetif,
+	struct lpc_rxbuf **bufs, u32_t count)
 {
-	struct lpc_enetdata *lpc_enetif = netif->state;
-	struct pbuf *p;
-	s32_t queued = 0;
-
-	/* Attempt to requeue as many packets as possible */
-	while (lpc_enetif->rx_free_descs > 0) {
-		/* Allocate a pbuf from the pool. We need to allocate at the
-		   maximum size as we don't know the size of the yet to be
-		   received packet. */
-		p = pbuf_alloc(PBUF_RAW, (u16_t) EMAC_ETH_MAX_FLEN, PBUF_RAM);
-		if (p == NULL) {
-			LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
-				("lpc_rx_queue: could not allocate RX pbuf (free desc=%d)\n",
-				lpc_enetif->rx_free_descs));
-			return queued;
-		}
+	struct lpc_rxbuf *b;
+	u32_t i;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+	if (lpc_enetif->rx_free_count < count) {
+		SYS_ARCH_UNPROTECT(lev);
+		return 0;
+	}
+	b = lpc_enetif->rx_free;
+	*bufs = b;
+	for (i = 1; i < count; i++)
+		b = b->next;
+	lpc_enetif->rx_free = b->next;
+	b->next = NULL;
+	lpc_enetif->rx_free_count -= count;
+	if (lpc_enetif->rx_free_count < lpc_enetif->stats.rx_pool_min)
+		lpc_enetif->stats.rx_pool_min = lpc_enetif->rx_free_count;
+	SYS_ARCH_UNPROTECT(lev);
 
-		/* pbufs allocated from the RAM pool should be non-chained. */
-		LWIP_ASSERT("lpc_rx_queue: pbuf is not contiguous (chained)",
-			pbuf_clen(p) <= 1);
+	return 1;
+}
 
-		/* Queue packet */
-		lpc_rxqueue_pbuf(lpc_enetif, p);
+/** \brief  Queues a buffer into an RX descriptor
+ *
+ *  \param[in] lpc_enetif Pointer to the drvier data structure
+ *  \param[in] idx        Descriptor index
+ *  \param[in] b          Buffer to queue
+ */
+static void lpc_rxqueue_buf(struct lpc_enetdata *lpc_enetif, u32_t idx,
+	struct lpc_rxbuf *b)
+{
+	/* Setup descriptor and clear statuses */
+	lpc_enetif->prxd[idx].control = EMAC_RCTRL_INT | ((u32_t) (LPC_RX_BUF_SIZE - 1));
+	lpc_enetif->prxd[idx].packet = (u32_t) b->data;
+	lpc_enetif->prxs[idx].statusinfo = 0xFFFFFFFF;
+	lpc_enetif->prxs[idx].statushashcrc = 0xFFFFFFFF;
 
-		/* Update queued count */
-		queued++;
-	}
+	/* Save buffer pointer for push to network layer later */
+	lpc_enetif->rxb[idx] = b;
 
-	return queued;
+	LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
+		("lpc_rxqueue_buf: buffer queued: %p (index=%d)\n", b, idx));
 }
 
 /** \brief  Sets up the RX descriptor ring buffers.
  *
  *  This function sets up the descriptor list used for receive packets.
+ *  Buffers still in the ring, after an overrun, go back to the pool
+ *  first.
  *
  *  \param[in]  lpc_enetif  Pointer to driver data structure
  *  \returns                   Always returns ERR_OK
  */
 static err_t lpc_rx_setup(struct lpc_enetdata *lpc_enetif)
 {
+	struct lpc_rxbuf *b;
+	u32_t idx;
+
 	/* Setup pointers to RX structures */
 	LPC_EMAC->RxDescriptor = (u32_t) &lpc_enetif->prxd[0];
 	LPC_EMAC->RxStatus = (u32_t) &lpc_enetif->prxs[0];
 	LPC_EMAC->RxDescriptorNumber = LPC_NUM_BUFF_RXDESCS - 1;
 
-	lpc_enetif->rx_free_descs = LPC_NUM_BUFF_RXDESCS;
-	lpc_enetif->rx_fill_desc_index = 0;
+	for (idx = 0; idx < LPC_NUM_BUFF_RXDESCS; idx++) {
+		if (lpc_enetif->rxb[idx] != NULL) {
+			lpc_rxbuf_put(lpc_enetif, lpc_enetif->rxb[idx]);
+			lpc_enetif->rxb[idx] = NULL;
+		}
+	}
 
-	/* Build RX buffer and descriptors */
-	lpc_rx_queue(lpc_enetif->netif);
+	/* Build RX buffer and descriptors. The pool is larger than the
+	   ring, so this always succeeds. */
+	lpc_rxbuf_get(lpc_enetif, &b, LPC_NUM_BUFF_RXDESCS);
+	for (idx = 0; idx < LPC_NUM_BUFF_RXDESCS; idx++) {
+		lpc_rxqueue_buf(lpc_enetif, idx, b);
+		b = b->next;
+	}
+	LPC_EMAC->RxConsumeIndex = 0;
 
 	return ERR_OK;
 }
 
-/** \brief  Allocates a pbuf and returns the data from the incoming packet.
+/** \brief  Sets up the RX pool
+ *
+ *  \param[in]  lpc_enetif  Pointer to driver data structure
+ */
+static void lpc_rx_pool_init(struct lpc_enetdata *lpc_enetif)
+{
+	u32_t i;
+
+	/* The driver data is not zeroed at startup */
+	memset(&lpc_enetif->stats, 0, sizeof(lpc_enetif->stats));
+	for (i = 0; i < LPC_NUM_BUFF_RXDESCS; i++)
+		lpc_enetif->rxb[i] = NULL;
+	lpc_enetif->rx_free = NULL;
+	lpc_enetif->rx_free_count = 0;
+	for (i = 0; i < LPC_NUM_RX_BUFS; i++) {
+		lpc_rxbufs[i].data = (u8_t *) lpc_rxmem[i];
+		lpc_rxbufs[i].pc.custom_free_function = lpc_rxbuf_free;
+		lpc_rxbuf_put(lpc_enetif, &lpc_rxbufs[i]);
+	}
+	lpc_enetif->stats.rx_pool_min = LPC_NUM_RX_BUFS;
+}
+
+/** \brief  Finds the last descriptor of the next received frame
+ *
+ *  A frame larger than LPC_RX_BUF_SIZE spans several descriptors. The
+ *  EMAC moves RxProduceIndex on as each one is filled, so the first
+ *  descriptors of a frame can be seen before its last one is.
+ *
+ *  \param[in]  lpc_enetif  Pointer to driver data structure
+ *  \param[out] last        Index of the last descriptor of the frame
+ *  \return                 Number of descriptors of the frame, or 0 if
+ *                          no complete frame has been received
+ */
+static u32_t lpc_rx_frame(struct lpc_enetdata *lpc_enetif, u32_t *last)
+{
+	u32_t idx, pidx, n;
+
+	idx = LPC_EMAC->RxConsumeIndex;
+	pidx = LPC_EMAC->RxProduceIndex;
+	n = 0;
+	while (idx != pidx) {
+		n++;
+		if (lpc_enetif->prxs[idx].statusinfo & EMAC_RINFO_LAST_FLAG) {
+			*last = idx;
+			return n;
+		}
+		idx++;
+		if (idx >= LPC_NUM_BUFF_RXDESCS)
+			idx = 0;
+	}
+
+	return 0;
+}
+
+/** \brief  Takes the received frame from the descriptor ring
+ *
+ *  The frame's buffers are passed on as a chain of custom pbufs, and the
+ *  descriptors refilled from the RX pool. If the pool is short of buffers
+ *  the frame is dropped and its buffers stay in the ring.
  *
  *  \param[in] netif the lwip network interface structure for this lpc_enetif
- *  \return a pbuf filled with the received packet (including MAC header)
- *         NULL on memory error
+ *  \return a pbuf chain of the received packet (including MAC header)
+ *         NULL if there was no packet, or it was dropped
  */
 static struct pbuf *lpc_low_level_input(struct netif *netif)
 {
 	struct lpc_enetdata *lpc_enetif = netif->state;
-	struct pbuf *p = NULL;
-	u32_t idx, length;
-	u16_t origLength;
+	struct pbuf *p = NULL, *q, *prev = NULL;
+	struct lpc_rxbuf *b, *nb;
+	u32_t idx, last, n, status, length, len;
+	s32_t drop = 0;
 
 #ifdef LOCK_RX_THREAD
 #if NO_SYS == 0
@@ -281,6 +419,7 @@ static struct pbuf *lpc_low_level_input(struct netif *netif)
 	if (LPC_EMAC->IntStatus & EMAC_INT_RX_OVERRUN) {
 		LINK_STATS_INC(link.err);
 		LINK_STATS_INC(link.drop);
+		lpc_enetif->stats.rx_overrun++;
 
 		/* Temporarily disable RX */
 		LPC_EMAC->MAC1 &= ~EMAC_MAC1_REC_EN;
@@ -289,15 +428,7 @@ static struct pbuf *lpc_low_level_input(struct netif *netif)
 		LPC_EMAC->MAC1 |= EMAC_MAC1_RES_RX;
 		LPC_EMAC->IntClear = EMAC_INT_RX_OVERRUN;
 
-		/* De-allocate all queued RX pbufs */
-		for (idx = 0; idx < LPC_NUM_BUFF_RXDESCS; idx++) {
-			if (lpc_enetif->rxb[idx] != NULL) {
-				pbuf_free(lpc_enetif->rxb[idx]);
-				lpc_enetif->rxb[idx] = NULL;
-			}
-		}
-
-		/* Start RX side again */
+		/* Start RX side again, the queued RX buffers are requeued */
 		lpc_rx_setup(lpc_enetif);
 
 		/* Re-enable RX */
@@ -313,77 +444,96 @@ static struct pbuf *lpc_low_level_input(struct netif *netif)
 	}
 
 	/* Determine if a frame has been received */
-	length = 0;
-	idx = LPC_EMAC->RxConsumeIndex;
-	if (LPC_EMAC->RxProduceIndex != idx) {
-		/* Handle errors */
-		if (lpc_enetif->prxs[idx].statusinfo & (EMAC_RINFO_CRC_ERR |
-			EMAC_RINFO_SYM_ERR | EMAC_RINFO_ALIGN_ERR | EMAC_RINFO_LEN_ERR)) {
-#if LINK_STATS
-			if (lpc_enetif->prxs[idx].statusinfo & (EMAC_RINFO_CRC_ERR |
-				EMAC_RINFO_SYM_ERR | EMAC_RINFO_ALIGN_ERR))
-				LINK_STATS_INC(link.chkerr);
-			if (lpc_enetif->prxs[idx].statusinfo & EMAC_RINFO_LEN_ERR)
-				LINK_STATS_INC(link.lenerr);
+	n = lpc_rx_frame(lpc_enetif, &last);
+	if (n == 0) {
+#ifdef LOCK_RX_THREAD
+#if NO_SYS == 0
+		sys_mutex_unlock(&lpc_enetif->TXLockMutex);
 #endif
+#endif
+		return NULL;
+	}
 
-			/* Drop the frame */
-			LINK_STATS_INC(link.drop);
-
-			/* Re-queue the pbuf for receive */
-			lpc_enetif->rx_free_descs++;
-			p = lpc_enetif->rxb[idx];
-			lpc_enetif->rxb[idx] = NULL;
-			lpc_rxqueue_pbuf(lpc_enetif, p);
+	/* Errors are reported in the status of the last fragment */
+	status = lpc_enetif->prxs[last].statusinfo;
+	if (status & (EMAC_RINFO_CRC_ERR | EMAC_RINFO_SYM_ERR |
+		EMAC_RINFO_ALIGN_ERR | EMAC_RINFO_LEN_ERR |
+		EMAC_RINFO_OVERRUN | EMAC_RINFO_NO_DESCR)) {
+#if LINK_STATS
+		if (status & (EMAC_RINFO_CRC_ERR | EMAC_RINFO_SYM_ERR |
+			EMAC_RINFO_ALIGN_ERR))
+			LINK_STATS_INC(link.chkerr);
+		if (status & EMAC_RINFO_LEN_ERR)
+			LINK_STATS_INC(link.lenerr);
+#endif
 
-			LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
-				("lpc_low_level_input: Packet dropped with errors (0x%x)\n",
-				lpc_enetif->prxs[idx].statusinfo));
+		/* Drop the frame */
+		LINK_STATS_INC(link.drop);
+		lpc_enetif->stats.rx_drop_err++;
+		drop = 1;
 
-			p = NULL;
-		} else {
-			/* A packet is waiting, get length */
-			length = (lpc_enetif->prxs[idx].statusinfo & 0x7FF) + 1;
+		LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
+			("lpc_low_level_input: Packet dropped with errors (0x%x)\n",
+			status));
+	} else if (!lpc_rxbuf_get(lpc_enetif, &nb, n)) {
+		/* Drop the frame, the ring keeps its buffers. Out-of-sequence
+		   TCP data may be holding them, have the stack let go of it. */
+		LINK_STATS_INC(link.drop);
+		lpc_enetif->stats.rx_drop_nobuf++;
+		pbuf_reclaim_ooseq();
+		drop = 1;
 
-			/* Zero-copy */
-			p = lpc_enetif->rxb[idx];
-			origLength = p->len;
-			p->len = (u16_t) length;
+		LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
+			("lpc_low_level_input: Packet dropped, no RX buffer (%d needed)\n",
+			n));
+	}
 
-			/* Free pbuf from descriptor */
-			lpc_enetif->rxb[idx] = NULL;
-			lpc_enetif->rx_free_descs++;
+	/* Pass the buffers on and refill the descriptors */
+	idx = LPC_EMAC->RxConsumeIndex;
+	length = 0;
+	while (n > 0) {
+		n--;
+		b = lpc_enetif->rxb[idx];
 
-			/* Attempt to queue new buffer(s) */
-			if (lpc_rx_queue(lpc_enetif->netif) == 0) {
-    			/* Drop the frame due to OOM. */
-    			LINK_STATS_INC(link.drop);
+		if (drop) {
+			lpc_rxqueue_buf(lpc_enetif, idx, b);
+		} else {
+			len = (lpc_enetif->prxs[idx].statusinfo & EMAC_RINFO_SIZE) + 1;
+			length += len;
+			q = pbuf_alloced_custom(PBUF_RAW, (u16_t) len, PBUF_REF, &b->pc,
+				b->data, LPC_RX_BUF_SIZE);
+			if (prev == NULL)
+				p = q;
+			else
+				prev->next = q;
+			prev = q;
+
+			lpc_rxqueue_buf(lpc_enetif, idx, nb);
+			nb = nb->next;
+		}
 
-    			/* Re-queue the pbuf for receive */
-    			p->len = origLength;
-    			lpc_rxqueue_pbuf(lpc_enetif, p);
+		idx++;
+		if (idx >= LPC_NUM_BUFF_RXDESCS)
+			idx = 0;
+	}
 
-    			LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
-    				("lpc_low_level_input: Packet index %d dropped for OOM\n",
-    				idx));
-			
-#ifdef LOCK_RX_THREAD
-#if NO_SYS == 0
-        		sys_mutex_unlock(&lpc_enetif->TXLockMutex);
-#endif
-#endif
+	/* Give the descriptors back to the EMAC */
+	LPC_EMAC->RxConsumeIndex = idx;
 
-		        return NULL;
-			}
+	if (p != NULL) {
+		/* Set the chain lengths */
+		len = length;
+		for (q = p; q != NULL; q = q->next) {
+			q->tot_len = (u16_t) len;
+			len -= q->len;
+		}
 
-			LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
-				("lpc_low_level_input: Packet received: %p, size %d (index=%d)\n",
-				p, length, idx));
+		LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
+			("lpc_low_level_input: Packet received: %p, size %d (index=%d)\n",
+			p, length, last));
 
-			/* Save size */
-			p->tot_len = (u16_t) length;
-			LINK_STATS_INC(link.recv);
-		}
+		LINK_STATS_INC(link.recv);
+		lpc_enetif->stats.rx_frames++;
 	}
 
 #ifdef LOCK_RX_THREAD
@@ -429,11 +579,26 @@ void lpc_enetif_input(struct netif *netif)
 
 		default:
 			/* Return buffer */
+			((struct lpc_enetdata *) netif->state)->stats.rx_drop_type++;
 			pbuf_free(p);
 			break;
 	}
 }
 
+/** \brief  Read the EMAC driver counters
+ *
+ *  \param[out] stats  Receives a copy of the counters
+ */
+void lpc_emac_get_stats(lpc_emac_stats_t *stats)
+{
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+	*stats = lpc_enetdata.stats;
+	stats->rx_pool_free = lpc_enetdata.rx_free_count;
+	SYS_ARCH_UNPROTECT(lev);
+}
+
 /** \brief  Determine if the passed address is usable for the ethernet
  *          DMA controller.
  *
@@ -466,6 +631,8 @@ static err_t lpc_tx_setup(struct lpc_enetdata *lpc_enetif)
 	for (idx = 0; idx < LPC_NUM_BUFF_TXDESCS; idx++) {
 		lpc_enetif->ptxd[idx].control = 0;
 		lpc_enetif->ptxs[idx].statusinfo = 0xFFFFFFFF;
+		lpc_enetif->txb[idx] = NULL;
+		lpc_enetif->txbounce[idx] = NULL;
 	}
 
 	/* Setup pointers to TX structures */
@@ -499,6 +666,10 @@ static void lpc_tx_reclaim_st(struct lpc_enetdata *lpc_enetif, u32_t cidx)
 			pbuf_free(lpc_enetif->txb[lpc_enetif->lpc_last_tx_idx]);
 		 	lpc_enetif->txb[lpc_enetif->lpc_last_tx_idx] = NULL;
 		}
+		if (lpc_enetif->txbounce[lpc_enetif->lpc_last_tx_idx] != NULL) {
+			pbuf_free(lpc_enetif->txbounce[lpc_enetif->lpc_last_tx_idx]);
+			lpc_enetif->txbounce[lpc_enetif->lpc_last_tx_idx] = NULL;
+		}
 
 #if NO_SYS == 0
 		osSemaphoreRelease(lpc_enetif->xTXDCountSem.id);
@@ -554,6 +725,11 @@ s32_t lpc_tx_ready(struct netif *netif)
  *          interrupt context, as it may block until TX descriptors
  *          become available.
  *
+ *  Each segment of the pbuf chain is sent from its own descriptor,
+ *  without a copy. Only segments outside the DMA capable memory are
+ *  copied, each into a bounce buffer of its own that is freed with its
+ *  descriptor in lpc_tx_reclaim().
+ *
  *  \param[in] netif the lwip network interface structure for this lpc_enetif
  *  \param[in] p the MAC packet to send (e.g. IP packet including MAC addresses and type)
  *  \return ERR_OK if the packet could be sent or an err_t value if the packet couldn't be sent
@@ -562,55 +738,56 @@ static err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 {
 	struct lpc_enetdata *lpc_enetif = netif->state;
 	struct pbuf *q;
-	u8_t *dst;
-    u32_t idx, notdmasafe = 0;
-	struct pbuf *np;
-	s32_t dn;
+	u32_t idx, notdmasafe = 0;
+	struct pbuf *np, *bounce = NULL, *last_bounce = NULL;
+	s32_t dn = 0, sent = 0;
 
 	/* Zero-copy TX buffers may be fragmented across mutliple payload
 	   chains. Determine the number of descriptors needed for the
-	   transfer. The pbuf chaining can be a mess! */
-	dn = (s32_t) pbuf_clen(p);
-
-	/* Test to make sure packet addresses are DMA safe. A DMA safe
-	   address is once that uses external memory or periphheral RAM.
-	   IRAM and FLASH are not safe! */
-	for (q = p; q != NULL; q = q->next)
-		notdmasafe += lpc_packet_addr_notsafe(q->payload);
+	   transfer, one for each segment that is not empty. */
+	for (q = p; q != NULL; q = q->next) {
+		if (q->len == 0)
+			continue;
+		dn++;
+
+		/* Test to make sure packet addresses are DMA safe. A DMA safe
+		   address is once that uses external memory or periphheral RAM.
+		   IRAM and FLASH are not safe! */
+		if (!lpc_packet_addr_notsafe(q->payload))
+			continue;
+		notdmasafe++;
 
 #if LPC_TX_PBUF_BOUNCE_EN==1
-	/* If the pbuf is not DMA safe, a new bounce buffer (pbuf) will be
-	   created that will be used instead. This requires an copy from the
-	   non-safe DMA region to the new pbuf */
-	if (notdmasafe) {
-		/* Allocate a pbuf in DMA memory */
-		np = pbuf_alloc(PBUF_RAW, p->tot_len, PBUF_RAM);
-		if (np == NULL)
+		/* The segment is copied to a bounce buffer (pbuf) in DMA memory.
+		   The bounce buffers are kept in a list in chain order. */
+		np = pbuf_alloc(PBUF_RAW, q->len, PBUF_RAM);
+		if (np == NULL) {
+			if (bounce != NULL)
+				pbuf_free(bounce);
+			lpc_enetif->stats.tx_drop_nomem++;
 			return ERR_MEM;
+		}
 
 		/* This buffer better be contiguous! */
 		LWIP_ASSERT("lpc_low_level_output: New transmit pbuf is chained",
 			(pbuf_clen(np) == 1));
 
-		/* Copy to DMA safe pbuf */
-		dst = (u8_t *) np->payload;
-	 	for(q = p; q != NULL; q = q->next) {
-			/* Copy the buffer to the descriptor's buffer */
-	  		MEMCPY(dst, (u8_t *) q->payload, q->len);
-		  dst += q->len;
-		}
-		np->len = p->tot_len;
+		MEMCPY(np->payload, q->payload, q->len);
+		lpc_enetif->stats.tx_bounce_bytes += q->len;
 
 		LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
 			("lpc_low_level_output: Switched to DMA safe buffer, old=%p, new=%p\n",
-			q, np));
+			q->payload, np->payload));
 
-		/* use the new buffer for descrptor queueing. The original pbuf will
-		   be de-allocated outsuide this driver. */
-		p = np;
-		dn = 1;
+		if (last_bounce == NULL)
+			bounce = np;
+		else
+			last_bounce->next = np;
+		last_bounce = np;
+#endif
 	}
-#else
+
+#if LPC_TX_PBUF_BOUNCE_EN!=1
 	if (notdmasafe)
 		LWIP_ASSERT("lpc_low_level_output: Not a DMA safe pbuf",
 			(notdmasafe == 0));
@@ -633,22 +810,35 @@ static err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 	sys_mutex_lock(&lpc_enetif->TXLockMutex);
 #endif
 
-	/* Prevent LWIP from de-allocating this pbuf. The driver will
-	   free it once it's been transmitted. */
-	if (!notdmasafe)
+	/* Prevent LWIP from de-allocating this pbuf while a segment is sent
+	   from it. The driver will free it once it's been transmitted. */
+	if (notdmasafe < (u32_t) dn)
 		pbuf_ref(p);
 
 	/* Setup transfers */
-	q = p;
-	while (dn > 0) {
-		dn--;
+	for (q = p; q != NULL; q = q->next) {
+		if (q->len == 0)
+			continue;
+		sent++;
+
+		/* Send a bounced segment from its bounce buffer */
+		np = NULL;
+#if LPC_TX_PBUF_BOUNCE_EN==1
+		if (notdmasafe && lpc_packet_addr_notsafe(q->payload)) {
+			np = bounce;
+			bounce = np->next;
+			np->next = NULL;
+			lpc_enetif->stats.tx_bounce_segs++;
+		}
+#endif
+		lpc_enetif->txbounce[idx] = np;
 
 		/* Only save pointer to free on last descriptor */
-		if (dn == 0) {
+		if (sent == dn) {
 			/* Save size of packet and signal it's ready */
 			lpc_enetif->ptxd[idx].control = (q->len - 1) | EMAC_TCTRL_INT |
 				EMAC_TCTRL_LAST;
-            lpc_enetif->txb[idx] = p;
+			lpc_enetif->txb[idx] = (notdmasafe < (u32_t) dn) ? p : NULL;
 		}
 		else {
 			/* Save size of packet, descriptor is not last */
@@ -658,11 +848,9 @@ static err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 
 		LWIP_DEBUGF(UDP_LPC_EMAC | LWIP_DBG_TRACE,
 			("lpc_low_level_output: pbuf packet(%p) sent, chain#=%d,"
-			" size = %d (index=%d)\n", q->payload, dn, q->len, idx));
+			" size = %d (index=%d)\n", q->payload, dn - sent, q->len, idx));
 
-		lpc_enetif->ptxd[idx].packet = (u32_t) q->payload;
-
-		q = q->next;
+		lpc_enetif->ptxd[idx].packet = (u32_t) ((np != NULL) ? np->payload : q->payload);
 
 		idx++;
 		if (idx >= LPC_NUM_BUFF_TXDESCS)
@@ -672,6 +860,7 @@ static err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 	LPC_EMAC->TxProduceIndex = idx;
 
 	LINK_STATS_INC(link.xmit);
+	lpc_enetif->stats.tx_frames++;
 
 #if NO_SYS == 0
 	/* Restore access */
@@ -697,10 +886,14 @@ void ENET_IRQHandler(void)
 	/* Interrupts are of 2 groups - transmit or receive. Based on the
 	   interrupt, kick off the receive or transmit (cleanup) task */
 
-	/* Get pending interrupts */
-	ints = LPC_EMAC->IntStatus;
+	/* Get pending interrupts. Masked ones stay pending. */
+	ints = LPC_EMAC->IntStatus & LPC_EMAC->IntEnable;
 
 	if (ints & RXINTGROUP) {
+#if LPC_RX_POLL
+        /* RX interrupts stay masked while the RX receive task polls */
+        LPC_EMAC->IntEnable &= ~RXINTGROUP;
+#endif
         /* RX group interrupt(s): Give signal to wakeup RX receive task.*/
         osSignalSet(lpc_enetdata.RxThread->id, RX_SIGNAL);
     }
@@ -716,6 +909,19 @@ void ENET_IRQHandler(void)
 }
 
 #if NO_SYS == 0
+/** \brief  Counts a pass of the receive task over the RX ring
+ *
+ *  \param[in] lpc_enetif  Pointer to driver data structure
+ *  \param[in] n           Number of frames taken in the pass
+ */
+static void lpc_rx_count_pass(struct lpc_enetdata *lpc_enetif, u32_t n)
+{
+	lpc_enetif->stats.rx_passes++;
+	if (n > LPC_RX_BUDGET)
+		n = LPC_RX_BUDGET;
+	lpc_enetif->stats.rx_batch[n]++;
+}
+
 /** \brief  Packet reception task
  *
  * This task is called when a packet is received. It will
@@ -725,14 +931,52 @@ void ENET_IRQHandler(void)
  */
 static void packet_rx(void* pvParameters) {
     struct lpc_enetdata *lpc_enetif = pvParameters;
+    u32_t last, n;
 
     while (1) {
         /* Wait for receive task to wakeup */
         osSignalWait(RX_SIGNAL, osWaitForever);
+        lpc_enetif->stats.rx_wakeups++;
+
+#if LPC_RX_POLL
+        while (1) {
+            /* Process a batch of packets */
+            n = 0;
+            while ((n < LPC_RX_BUDGET) && (lpc_rx_frame(lpc_enetif, &last) != 0)) {
+                lpc_enetif_input(lpc_enetif->netif);
+                n++;
+            }
+            lpc_rx_count_pass(lpc_enetif, n);
 
-        /* Process packets until all empty */
-        while (LPC_EMAC->RxConsumeIndex != LPC_EMAC->RxProduceIndex)
+            /* More may be waiting, let the other threads run first */
+            if (n == LPC_RX_BUDGET) {
+                osThreadYield();
+                continue;
+            }
+
+            /* The ring looks empty. A frame received after the status is
+               cleared interrupts once RX interrupts are enabled again, one
+               received before is found here. A frame whose last fragment
+               is still being received is left for that interrupt too.
+               Frame errors are read from the descriptors, a pending
+               overrun is left to wake the task. */
+            LPC_EMAC->IntClear = EMAC_INT_RX_DONE | EMAC_INT_RX_ERR;
+            if (lpc_rx_frame(lpc_enetif, &last) != 0)
+                continue;
+            LPC_EMAC->IntEnable |= RXINTGROUP;
+            break;
+        }
+#else
+        /* Process packets until all empty. A frame whose last
+           fragment is still being received is left for the next
+           RX interrupt. */
+        n = 0;
+        while (lpc_rx_frame(lpc_enetif, &last) != 0) {
             lpc_enetif_input(lpc_enetif->netif);
+            n++;
+        }
+        lpc_rx_count_pass(lpc_enetif, n);
+#endif
     }
 }
 
@@ -773,6 +1017,10 @@ static void packet_tx(void* pvParameters) {
                     pbuf_free(lpc_enetif->txb[idx]);
                     lpc_enetif->txb[idx] = NULL;
                 }
+                if (lpc_enetif->txbounce[idx] != NULL) {
+                    pbuf_free(lpc_enetif->txbounce[idx]);
+                    lpc_enetif->txbounce[idx] = NULL;
+                }
             }
 
 #if NO_SYS == 0
@@ -871,6 +1119,7 @@ static err_t low_level_init(struct netif *netif)
 		(((u32_t) netif->hwaddr[5]) << 8);
 
 	/* Setup transmit and receive descriptors */
+	lpc_rx_pool_init(lpc_enetif);
 	if (lpc_tx_setup(lpc_enetif) != ERR_OK)
 		return ERR_BUF;
 	if (lpc_rx_setup(lpc_enetif) != ERR_OK)
@@ -0,0 +1,74 @@
+/**********************************************************************
+* $Id$		lpc17_emac.h
+*//**
+* @file		lpc17_emac.h
+* @brief	LPC17 ethernet driver statistics
+*
+***********************************************************************
+* Software that is described herein is for illustrative purposes only
+* which provides customers with programming information regarding the
+* products. This software is supplied "AS IS" without any warranties.
+* NXP Semiconductors assumes no responsibility or liability for the
+* use of the software, conveys no license or title under any patent,
+* copyright, or mask work right to the product. NXP Semiconductors
+* reserves the right to make changes in the software without
+* notification. NXP Semiconductors also make no representation or
+* warranty that such application will be suitable for the specified
+* use without further testing or modification.
+**********************************************************************/
+
+#ifndef __LPC17_EMAC_H
+#define __LPC17_EMAC_H
+
+#include "lwip/opt.h"
+#include "lpc_emac_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @ingroup lwip17xx_emac_DRIVER
+ * @{
+ */
+
+/** \brief  EMAC driver counters
+ *
+ *  The counters are kept by the driver whether or not LWIP_STATS is
+ *  enabled, and wrap around.
+ */
+typedef struct
+{
+	u32_t rx_frames;       /**< Frames passed to the stack */
+	u32_t rx_drop_err;     /**< Frames dropped for CRC, symbol, alignment or length errors */
+	u32_t rx_drop_nobuf;   /**< Frames dropped because the RX pool had no buffer to refill the ring */
+	u32_t rx_drop_type;    /**< Frames dropped for an unsupported ethertype */
+	u32_t rx_overrun;      /**< RX overruns, each resetting the receive side */
+	u32_t rx_pool_free;    /**< RX pool buffers free now */
+	u32_t rx_pool_min;     /**< Fewest RX pool buffers free since the driver started */
+	u32_t rx_wakeups;      /**< Receive task wakeups by the RX interrupt */
+	u32_t rx_passes;       /**< Passes over the RX ring */
+	u32_t rx_batch[LPC_RX_BUDGET + 1]; /**< Passes by frames taken, the last entry counts LPC_RX_BUDGET or more */
+	u32_t tx_frames;       /**< Frames queued for transmit */
+	u32_t tx_bounce_segs;  /**< Chain segments copied to a bounce buffer, outside DMA memory */
+	u32_t tx_bounce_bytes; /**< Bytes copied to bounce buffers */
+	u32_t tx_drop_nomem;   /**< Frames not sent for lack of memory for a bounce buffer */
+} lpc_emac_stats_t;
+
+/** \brief  Read the EMAC driver counters
+ *
+ *  \param[out] stats  Receives a copy of the counters
+ */
+void lpc_emac_get_stats(lpc_emac_stats_t *stats);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LPC17_EMAC_H */
+
+/* --------------------------------- End Of File ------------------------------ */
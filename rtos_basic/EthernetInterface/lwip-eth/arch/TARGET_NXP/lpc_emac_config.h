@@ -79,9 +79,41 @@ extern "C"
 #define LPC_EMAC_RMII 1         /**< Use the RMII or MII driver variant .*/
 
 /** \brief  Defines the number of descriptors used for RX. This
- *          must be a minimum value of 2.
+ *          must be a minimum value of 3. Each descriptor holds one RX
+ *          buffer, a frame spans as many descriptors as it needs buffers,
+ *          and the EMAC always leaves one descriptor unused.
  */
-#define LPC_NUM_BUFF_RXDESCS 3
+#define LPC_NUM_BUFF_RXDESCS 16
+
+/** \brief  Size in bytes of each RX DMA buffer. Frames larger than a
+ *          buffer are received into several and passed to the stack as
+ *          a pbuf chain. Must be a multiple of 4 and hold the largest
+ *          Ethernet, IP and TCP headers (134 bytes).
+ */
+#define LPC_RX_BUF_SIZE 256
+
+/** \brief  Defines the number of RX DMA buffers in the receive pool.
+ *          Received frames are passed to the stack without a copy, and
+ *          their buffers return to the pool when the stack frees them.
+ *          The buffers beyond LPC_NUM_BUFF_RXDESCS are those the stack
+ *          can hold while the descriptor ring stays full; when the pool
+ *          runs out, received frames are dropped.
+ */
+#define LPC_NUM_RX_BUFS 32
+
+/** \brief  Set this define to 1 to poll the RX descriptor ring. The first
+ *          RX interrupt wakes the receive task and is then masked while
+ *          the task takes frames from the ring, at most LPC_RX_BUDGET at
+ *          a time before letting other threads run. The interrupt is
+ *          enabled again once the ring is empty. Set this define to 0 for
+ *          a receive task wakeup on every RX interrupt.
+ */
+#define LPC_RX_POLL 1
+
+/** \brief  Defines the most frames the receive task takes from the ring
+ *          in one polling pass. Also the size of the batch histogram.
+ */
+#define LPC_RX_BUDGET 8
 
 /** \brief  Defines the number of descriptors used for TX. Must
  *          be a minimum value of 2.
@@ -94,7 +126,7 @@ extern "C"
  *          cannot be used for transmit DMA operations. If this define is
  *          set to 1, an extra check will be made with the pbufs. If a buffer
  *          is determined to be non-usable for zero-copy, a temporary bounce
- *          buffer will be created and used instead.
+ *          buffer will be created and used instead, for that buffer only.
  */
 #define LPC_TX_PBUF_BOUNCE_EN 1
 
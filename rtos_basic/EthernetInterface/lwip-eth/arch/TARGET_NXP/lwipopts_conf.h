@@ -24,7 +24,12 @@
 #if defined(TARGET_LPC4088) || defined(TARGET_LPC4088_DM)
 #define MEM_SIZE                      15360
 #elif defined(TARGET_LPC1768)
-#define MEM_SIZE                      16362
+/* AHBSRAM0 is shared with the EMAC RX pool (LPC_NUM_RX_BUFS * LPC_RX_BUF_SIZE) */
+#define MEM_SIZE                      8170
+/* AHBSRAM1 holds the memp pools and their reserve, and with GCC_ARM the
+   EMAC driver data; memp.c and lpc17_emac.c each check their share */
+#define LPC_AHBSRAM1_SIZE             16384
+#define LPC_EMAC_AHBSRAM1_SHARE       1024
 #endif
 
 #endif
@@ -52,8 +52,11 @@ typedef uintptr_t          mem_ptr_t;
 #define X32_F "lx"
 #define SZT_F "uz"
 
-/* ARM/LPC17xx is little endian only */
+/* ARM/LPC17xx is little endian only. The C library of the host port
+   defines it already. */
+#ifndef BYTE_ORDER
 #define BYTE_ORDER LITTLE_ENDIAN
+#endif
 
 /* Use LWIP error codes */
 #define LWIP_PROVIDE_ERRNO
@@ -93,8 +96,15 @@ typedef uintptr_t          mem_ptr_t;
     void* thumb2_memcpy(void* pDest, const void* pSource, size_t length);
     u16_t thumb2_checksum(void* pData, int length);
 #else
-    /* Used with IP headers only */
-    #define LWIP_CHKSUM_ALGORITHM   1
+    /* Portable word at a time routines, in checksum.c. The copy sums the
+       data as it goes instead of taking a second pass over it. */
+    #define LWIP_CHKSUM             word_checksum
+    #define LWIP_CHKSUM_ALGORITHM   0
+    #define LWIP_CHKSUM_COPY(dst,src,len)   word_checksum_copy(dst,src,len)
+    #define LWIP_CHKSUM_COPY_ALGORITHM      0
+
+    u16_t word_checksum(void* pData, int length);
+    u16_t word_checksum_copy(void* pDest, const void* pSource, u16_t length);
 #endif
 
 
@@ -1,126 +1,276 @@
-/* Copyright (C) 2013 - Adam Green (https://github.com/adamgreen)
-
-   Licensed under the Apache License, Version 2.0 (the "License");
-   you may not use this file except in compliance with the License.
-   You may obtain a copy of the License at
-
-       http://www.apache.org/licenses/LICENSE-2.0
-
-   Unless required by applicable law or agreed to in writing, software
-   distributed under the License is distributed on an "AS IS" BASIS,
-   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-   See the License for the specific language governing permissions and
-   limitations under the License.
-*/
-#if defined(TOOLCHAIN_GCC) && defined(__thumb2__)
-
-
-/* This is a hand written Thumb-2 assembly language version of the
-   algorithm 3 version of lwip_standard_chksum in lwIP's inet_chksum.c.  It
-   performs the checksumming 32-bits at a time and even unrolls the loop to
-   perform two of these 32-bit adds per loop iteration.
-   
-   Returns:
-        16-bit 1's complement summation (not inversed).
-        
-   NOTE: This function does return a uint16_t from the assembly language code
-         but is marked as void so that GCC doesn't issue warning because it
-         doesn't know about this low level return.
-*/
-__attribute__((naked)) void /*uint16_t*/ thumb2_checksum(const void* pData, int length)
-{
-    __asm (
-        ".syntax unified\n"
-        ".thumb\n"
-
-        // Push non-volatile registers we use on stack.  Push link register too to
-        // keep stack 8-byte aligned and allow single pop to restore and return.
-        "    push        {r4, lr}\n"
-        // Initialize sum, r2, to 0.
-        "    movs    r2, #0\n"
-        // Remember whether pData was at odd address in r3.  This is used later to
-        // know if it needs to swap the result since the summation will be done at
-        // an offset of 1, rather than 0.
-        "    ands    r3, r0, #1\n"
-        // Need to 2-byte align?  If not skip ahead.
-        "    beq     1$\n"
-        // We can return if there are no bytes to sum.
-        "    cbz     r1, 9$\n"
-
-        // 2-byte align.
-        // Place the first data byte in odd summation location since it needs to be
-        // swapped later.  It's ok to overwrite r2 here as it only had a value of 0
-        // up until now.  Advance r0 pointer and decrement r1 length as we go.
-        "    ldrb    r2, [r0], #1\n"
-        "    lsls    r2, r2, #8\n"
-        "    subs    r1, r1, #1\n"
-
-        // Need to 4-byte align?  If not skip ahead.
-        "1$:\n"
-        "    ands    r4, r0, #3\n"
-        "    beq     2$\n"
-        // Have more than 1 byte left to align?  If not skip ahead to take care of
-        // trailing byte.
-        "    cmp     r1, #2\n"
-        "    blt     7$\n"
-
-        // 4-byte align.
-        "    ldrh    r4, [r0], #2\n"
-        "    adds    r2, r2, r4\n"
-        "    subs    r1, r1, #2\n"
-
-        // Main summing loop which sums up data 2 words at a time.
-        // Make sure that we have more than 7 bytes left to sum.
-        "2$:\n"
-        "    cmp     r1, #8\n"
-        "    blt     3$\n"
-        // Sum next two words.  Applying previous upper 16-bit carry to
-        // lower 16-bits.
-        "    ldr     r4, [r0], #4\n"
-        "    adds    r2, r4\n"
-        "    adc     r2, r2, #0\n"
-        "    ldr     r4, [r0], #4\n"
-        "    adds    r2, r4\n"
-        "    adc     r2, r2, #0\n"
-        "    subs    r1, r1, #8\n"
-        "    b       2$\n"
-
-        // Sum up any remaining half-words.
-        "3$:\n"
-        // Make sure that we have more than 1 byte left to sum.
-        "    cmp     r1, #2\n"
-        "    blt     7$\n"
-        // Sum up next half word, continue to apply carry.
-        "    ldrh    r4, [r0], #2\n"
-        "    adds    r2, r4\n"
-        "    adc     r2, r2, #0\n"
-        "    subs    r1, r1, #2\n"
-        "    b       3$\n"
-
-        // Handle trailing byte, if it exists
-        "7$:\n"
-        "    cbz     r1, 8$\n"
-        "    ldrb    r4, [r0]\n"
-        "    adds    r2, r4\n"
-        "    adc     r2, r2, #0\n"
-
-        // Fold 32-bit checksum into 16-bit checksum.
-        "8$:\n"
-        "    ubfx    r4, r2, #16, #16\n"
-        "    ubfx    r2, r2, #0, #16\n"
-        "    adds    r2, r4\n"
-        "    ubfx    r4, r2, #16, #16\n"
-        "    ubfx    r2, r2, #0, #16\n"
-        "    adds    r2, r4\n"
-
-        // Swap bytes if started at odd address
-        "    cbz     r3, 9$\n"
-        "    rev16   r2, r2\n"
-
-        // Return final sum.
-        "9$: mov     r0, r2\n"
-        "    pop     {r4, pc}\n"
-    );
-}
-
-#endif
+/* Copyright (C) 2013 - Adam Green (https://github.com/adamgreen)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#if defined(TOOLCHAIN_GCC) && defined(__thumb2__)
+
+
+/* This is a hand written Thumb-2 assembly language version of the
+   algorithm 3 version of lwip_standard_chksum in lwIP's inet_chksum.c.  It
+   performs the checksumming 32-bits at a time and even unrolls the loop to
+   perform two of these 32-bit adds per loop iteration.
+   
+   Returns:
+        16-bit 1's complement summation (not inversed).
+        
+   NOTE: This function does return a uint16_t from the assembly language code
+         but is marked as void so that GCC doesn't issue warning because it
+         doesn't know about this low level return.
+*/
+__attribute__((naked)) void /*uint16_t*/ thumb2_checksum(const void* pData, int length)
+{
+    __asm (
+        ".syntax unified\n"
+        ".thumb\n"
+
+        // Push non-volatile registers we use on stack.  Push link register too to
+        // keep stack 8-byte aligned and allow single pop to restore and return.
+        "    push        {r4, lr}\n"
+        // Initialize sum, r2, to 0.
+        "    movs    r2, #0\n"
+        // Remember whether pData was at odd address in r3.  This is used later to
+        // know if it needs to swap the result since the summation will be done at
+        // an offset of 1, rather than 0.
+        "    ands    r3, r0, #1\n"
+        // Need to 2-byte align?  If not skip ahead.
+        "    beq     1$\n"
+        // We can return if there are no bytes to sum.
+        "    cbz     r1, 9$\n"
+
+        // 2-byte align.
+        // Place the first data byte in odd summation location since it needs to be
+        // swapped later.  It's ok to overwrite r2 here as it only had a value of 0
+        // up until now.  Advance r0 pointer and decrement r1 length as we go.
+        "    ldrb    r2, [r0], #1\n"
+        "    lsls    r2, r2, #8\n"
+        "    subs    r1, r1, #1\n"
+
+        // Need to 4-byte align?  If not skip ahead.
+        "1$:\n"
+        "    ands    r4, r0, #3\n"
+        "    beq     2$\n"
+        // Have more than 1 byte left to align?  If not skip ahead to take care of
+        // trailing byte.
+        "    cmp     r1, #2\n"
+        "    blt     7$\n"
+
+        // 4-byte align.
+        "    ldrh    r4, [r0], #2\n"
+        "    adds    r2, r2, r4\n"
+        "    subs    r1, r1, #2\n"
+
+        // Main summing loop which sums up data 2 words at a time.
+        // Make sure that we have more than 7 bytes left to sum.
+        "2$:\n"
+        "    cmp     r1, #8\n"
+        "    blt     3$\n"
+        // Sum next two words.  Applying previous upper 16-bit carry to
+        // lower 16-bits.
+        "    ldr     r4, [r0], #4\n"
+        "    adds    r2, r4\n"
+        "    adc     r2, r2, #0\n"
+        "    ldr     r4, [r0], #4\n"
+        "    adds    r2, r4\n"
+        "    adc     r2, r2, #0\n"
+        "    subs    r1, r1, #8\n"
+        "    b       2$\n"
+
+        // Sum up any remaining half-words.
+        "3$:\n"
+        // Make sure that we have more than 1 byte left to sum.
+        "    cmp     r1, #2\n"
+        "    blt     7$\n"
+        // Sum up next half word, continue to apply carry.
+        "    ldrh    r4, [r0], #2\n"
+        "    adds    r2, r4\n"
+        "    adc     r2, r2, #0\n"
+        "    subs    r1, r1, #2\n"
+        "    b       3$\n"
+
+        // Handle trailing byte, if it exists
+        "7$:\n"
+        "    cbz     r1, 8$\n"
+        "    ldrb    r4, [r0]\n"
+        "    adds    r2, r4\n"
+        "    adc     r2, r2, #0\n"
+
+        // Fold 32-bit checksum into 16-bit checksum.
+        "8$:\n"
+        "    ubfx    r4, r2, #16, #16\n"
+        "    ubfx    r2, r2, #0, #16\n"
+        "    adds    r2, r4\n"
+        "    ubfx    r4, r2, #16, #16\n"
+        "    ubfx    r2, r2, #0, #16\n"
+        "    adds    r2, r4\n"
+
+        // Swap bytes if started at odd address
+        "    cbz     r3, 9$\n"
+        "    rev16   r2, r2\n"
+
+        // Return final sum.
+        "9$: mov     r0, r2\n"
+        "    pop     {r4, pc}\n"
+    );
+}
+
+#else
+
+#include <string.h>
+#include "lwip/opt.h"
+
+/* Portable C versions of the checksum routines, for the toolchains and
+   targets without the Thumb-2 ones above.  The data is summed 32-bits at a
+   time into a 64-bit accumulator, four words per loop iteration, so no carry
+   has to be handled until the end.  Words are read in memory order, which
+   gives the same 16-bit 1's complement sum on either byte order.
+
+   Both routines return the 16-bit 1's complement summation (not inversed) in
+   the form lwip_standard_chksum does: as if the data started at an even
+   address.
+*/
+
+/* Folds a 64-bit sum of 32-bit words down to 16 bits.  Starting the data at
+   an odd address puts every byte in the other half of its 16-bit word, which
+   swapping the bytes of the result undoes. */
+static u16_t word_checksum_fold(uint64_t sum, int odd)
+{
+    sum = (sum >> 32) + (sum & 0xffffffffUL);
+    sum = (sum >> 32) + (sum & 0xffffffffUL);
+    sum = (sum >> 16) + (sum & 0xffffUL);
+    sum = (sum >> 16) + (sum & 0xffffUL);
+    sum = (sum >> 16) + (sum & 0xffffUL);
+    if (odd)
+        sum = ((sum & 0xff) << 8) | ((sum >> 8) & 0xff);
+    return (u16_t)sum;
+}
+
+u16_t word_checksum(void* pData, int length)
+{
+    const u8_t* pb = (const u8_t*)pData;
+    const u32_t* pw;
+    uint64_t sum = 0;
+    u16_t t = 0;
+    int odd = (int)((mem_ptr_t)pb & 1);
+
+    /* 2-byte align, the first byte goes in the odd summation location */
+    if (odd && length > 0) {
+        ((u8_t*)&t)[1] = *pb++;
+        length--;
+    }
+    /* 4-byte align */
+    if (((mem_ptr_t)pb & 3) && length > 1) {
+        sum += *(const u16_t*)pb;
+        pb += 2;
+        length -= 2;
+    }
+
+    pw = (const u32_t*)pb;
+    while (length >= 16) {
+        sum += pw[0];
+        sum += pw[1];
+        sum += pw[2];
+        sum += pw[3];
+        pw += 4;
+        length -= 16;
+    }
+    while (length >= 4) {
+        sum += *pw++;
+        length -= 4;
+    }
+
+    pb = (const u8_t*)pw;
+    if (length > 1) {
+        sum += *(const u16_t*)pb;
+        pb += 2;
+        length -= 2;
+    }
+    /* Trailing byte, in the even summation location */
+    if (length > 0)
+        ((u8_t*)&t)[0] = *pb;
+    sum += t;
+
+    return word_checksum_fold(sum, odd);
+}
+
+/* Copies the data and sums it in the same pass.  The destination is aligned,
+   so the stores and the summation are done on whole words.  Source words are
+   read with memcpy, which the compiler turns into a single load where the
+   target allows unaligned accesses. */
+u16_t word_checksum_copy(void* pDest, const void* pSource, u16_t length)
+{
+    u8_t* pd = (u8_t*)pDest;
+    const u8_t* ps = (const u8_t*)pSource;
+    u32_t* pw;
+    u32_t w0, w1, w2, w3;
+    uint64_t sum = 0;
+    u16_t t = 0;
+    int odd = (int)((mem_ptr_t)pd & 1);
+
+    if (odd && length > 0) {
+        ((u8_t*)&t)[1] = *pd++ = *ps++;
+        length--;
+    }
+    if (((mem_ptr_t)pd & 3) && length > 1) {
+        u16_t h;
+        memcpy(&h, ps, 2);
+        *(u16_t*)pd = h;
+        sum += h;
+        pd += 2;
+        ps += 2;
+        length -= 2;
+    }
+
+    pw = (u32_t*)pd;
+    while (length >= 16) {
+        memcpy(&w0, ps, 4);
+        memcpy(&w1, ps + 4, 4);
+        memcpy(&w2, ps + 8, 4);
+        memcpy(&w3, ps + 12, 4);
+        pw[0] = w0;
+        pw[1] = w1;
+        pw[2] = w2;
+        pw[3] = w3;
+        sum += w0;
+        sum += w1;
+        sum += w2;
+        sum += w3;
+        pw += 4;
+        ps += 16;
+        length -= 16;
+    }
+    while (length >= 4) {
+        memcpy(&w0, ps, 4);
+        *pw++ = w0;
+        sum += w0;
+        ps += 4;
+        length -= 4;
+    }
+
+    pd = (u8_t*)pw;
+    if (length > 1) {
+        u16_t h;
+        memcpy(&h, ps, 2);
+        *(u16_t*)pd = h;
+        sum += h;
+        pd += 2;
+        ps += 2;
+        length -= 2;
+    }
+    if (length > 0)
+        ((u8_t*)&t)[0] = *pd = *ps;
+    sum += t;
+
+    return word_checksum_fold(sum, odd);
+}
+
+#endif
@@ -21,6 +21,8 @@
 #include "mbed_error.h"
 #include "mbed_interface.h"
 #include "us_ticker_api.h"
+#include "toolchain.h"
+#include "rtos/rtos_mutex_profile.h"
 
 /* lwIP includes. */
 #include "lwip/opt.h"
@@ -117,7 +119,7 @@ void sys_mbox_free(sys_mbox_t *mbox) {
  *      void *msg              -- Pointer to data to post
  *---------------------------------------------------------------------------*/
 void sys_mbox_post(sys_mbox_t *mbox, void *msg) {
-    if (osMessagePut(mbox->id, (uint32_t)msg, osWaitForever) != osOK)
+    if (osMessagePut(mbox->id, (uintptr_t)msg, osWaitForever) != osOK)
         error("sys_mbox_post error\n");
 }
 
@@ -135,7 +137,7 @@ void sys_mbox_post(sys_mbox_t *mbox, void *msg) {
  *                                  if not.
  *---------------------------------------------------------------------------*/
 err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg) {
-    osStatus status = osMessagePut(mbox->id, (uint32_t)msg, 0);
+    osStatus status = osMessagePut(mbox->id, (uintptr_t)msg, 0);
     return (status == osOK) ? (ERR_OK) : (ERR_MEM);
 }
 
@@ -171,7 +173,7 @@ u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout) {
     if (event.status != osEventMessage)
         return SYS_ARCH_TIMEOUT;
     
-    *msg = (void *)event.value.v;
+    *msg = event.value.p;
     
     return (us_ticker_read() - start) / 1000;
 }
@@ -195,7 +197,7 @@ u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg) {
     if (event.status != osEventMessage)
         return SYS_MBOX_EMPTY;
     
-    *msg = (void *)event.value.v;
+    *msg = event.value.p;
     
     return ERR_OK;
 }
@@ -280,6 +282,15 @@ void sys_sem_signal(sys_sem_t *data) {
  *---------------------------------------------------------------------------*/
 void sys_sem_free(sys_sem_t *sem) {}
 
+/* Mutex wait and release, through the lock profiler when it is enabled */
+#if RTOS_MUTEX_PROFILE
+#define SYS_MUTEX_WAIT(id)      rtos_mutex_wait(id, osWaitForever, MBED_CALLER_ADDR())
+#define SYS_MUTEX_RELEASE(id)   rtos_mutex_release(id)
+#else
+#define SYS_MUTEX_WAIT(id)      osMutexWait(id, osWaitForever)
+#define SYS_MUTEX_RELEASE(id)   osMutexRelease(id)
+#endif
+
 /** Create a new mutex
  * @param mutex pointer to the mutex to create
  * @return a new mutex */
@@ -302,14 +313,14 @@ err_t sys_mutex_new(sys_mutex_t *mutex) {
 /** Lock a mutex
  * @param mutex the mutex to lock */
 void sys_mutex_lock(sys_mutex_t *mutex) {
-    if (osMutexWait(mutex->id, osWaitForever) != osOK)
+    if (SYS_MUTEX_WAIT(mutex->id) != osOK)
         error("sys_mutex_lock error\n");
 }
 
 /** Unlock a mutex
  * @param mutex the mutex to unlock */
 void sys_mutex_unlock(sys_mutex_t *mutex) {
-    if (osMutexRelease(mutex->id) != osOK)
+    if (SYS_MUTEX_RELEASE(mutex->id) != osOK)
         error("sys_mutex_unlock error\n");
 }
 
@@ -331,6 +342,9 @@ void sys_init(void) {
     lwip_sys_mutex = osMutexCreate(osMutex(lwip_sys_mutex));
     if (lwip_sys_mutex == NULL)
         error("sys_init error\n");
+#if RTOS_MUTEX_PROFILE
+    rtos_mutex_profile_name(lwip_sys_mutex, "lwip protect");
+#endif
 }
 
 /*---------------------------------------------------------------------------*
@@ -365,7 +379,7 @@ u32_t sys_jiffies(void) {
  *      sys_prot_t              -- Previous protection level (not used here)
  *---------------------------------------------------------------------------*/
 sys_prot_t sys_arch_protect(void) {
-    if (osMutexWait(lwip_sys_mutex, osWaitForever) != osOK)
+    if (SYS_MUTEX_WAIT(lwip_sys_mutex) != osOK)
         error("sys_arch_protect error\n");
     return (sys_prot_t) 1;
 }
@@ -382,7 +396,7 @@ sys_prot_t sys_arch_protect(void) {
  *      sys_prot_t              -- Previous protection level (not used here)
  *---------------------------------------------------------------------------*/
 void sys_arch_unprotect(sys_prot_t p) {
-    if (osMutexRelease(lwip_sys_mutex) != osOK)
+    if (SYS_MUTEX_RELEASE(lwip_sys_mutex) != osOK)
         error("sys_arch_unprotect error\n");
 }
 
@@ -62,6 +62,7 @@
 #include "lwip/sys.h"
 #include "lwip/stats.h"
 #include "lwip/err.h"
+#include "lwip/pbuf.h"
 
 #include <string.h>
 
@@ -207,6 +208,37 @@ static struct mem *lfree;
 /** concurrent access protection */
 static sys_mutex_t mem_mutex;
 
+#if MEM_SIZE_CLASS_MAX
+/** The size of a PBUF_RAM pbuf, as pbuf_alloc() asks for it */
+#define MEM_PBUF_RAM(offset, length) \
+  (LWIP_MEM_ALIGN_SIZE(LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf)) + (offset)) + LWIP_MEM_ALIGN_SIZE(length))
+
+#ifndef MEM_SIZE_CLASSES
+/* A TCP segment without data or options, an NTP packet (which also fits
+   a segment with options), a DNS query and a full-sized TCP segment */
+#define MEM_SIZE_CLASSES { \
+  MEM_PBUF_RAM(PBUF_LINK_HLEN + PBUF_IP_HLEN, PBUF_TRANSPORT_HLEN), \
+  MEM_PBUF_RAM(PBUF_LINK_HLEN + PBUF_IP_HLEN + PBUF_TRANSPORT_HLEN, 48), \
+  MEM_PBUF_RAM(PBUF_LINK_HLEN + PBUF_IP_HLEN + PBUF_TRANSPORT_HLEN, 12 + DNS_MAX_NAME_LENGTH + 4), \
+  MEM_PBUF_RAM(PBUF_LINK_HLEN + PBUF_IP_HLEN + PBUF_TRANSPORT_HLEN, TCP_MSS) }
+#endif /* MEM_SIZE_CLASSES */
+
+/** The size of each class, ascending */
+static const mem_size_t mem_class_size[] = MEM_SIZE_CLASSES;
+#define MEM_CLASSES (sizeof(mem_class_size) / sizeof(mem_class_size[0]))
+
+/** A freed block on the list of its class, linked through its data */
+struct mem_class_block {
+  struct mem_class_block *next;
+};
+
+/** The freed blocks kept for each class */
+static struct mem_class_block *mem_class_free[MEM_CLASSES];
+static u8_t mem_class_count[MEM_CLASSES];
+static u32_t mem_class_hits;
+static u32_t mem_class_flushes;
+#endif /* MEM_SIZE_CLASS_MAX */
+
 #if LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT
 
 static volatile u8_t mem_free_count;
@@ -279,6 +311,101 @@ plug_holes(struct mem *mem)
   }
 }
 
+#if MEM_SIZE_CLASS_MAX
+/**
+ * Find the class of a request: the first class at least as large, if the
+ * request is within a quarter below its size.
+ *
+ * @param size the aligned size of the request
+ * @return the class index, or -1 if the request is left to the heap
+ */
+static s16_t
+mem_class_of_size(mem_size_t size)
+{
+  s16_t i;
+
+  for (i = 0; i < (s16_t)MEM_CLASSES; i++) {
+    if (size <= mem_class_size[i]) {
+      return (size > mem_class_size[i] - (mem_class_size[i] >> 2)) ? i : -1;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Find the class a heap block can serve: a block of the class size, or
+ * one too small to have been split when a request of that size took it.
+ *
+ * @param mem the heap block
+ * @return the class index, or -1 if no class fits
+ */
+static s16_t
+mem_class_of_block(struct mem *mem)
+{
+  mem_size_t size = mem->next - (mem_size_t)((u8_t *)mem - ram) - SIZEOF_STRUCT_MEM;
+  s16_t i;
+
+  for (i = 0; i < (s16_t)MEM_CLASSES; i++) {
+    if ((size >= mem_class_size[i]) &&
+        (size < mem_class_size[i] + SIZEOF_STRUCT_MEM + MIN_SIZE_ALIGNED)) {
+      return i;
+    }
+  }
+  return -1;
+}
+#endif /* MEM_SIZE_CLASS_MAX */
+
+/**
+ * Put a used struct mem back on the heap. The heap must be protected by
+ * the caller.
+ *
+ * @param mem the struct mem to free
+ */
+static void
+mem_free_block(struct mem *mem)
+{
+  mem->used = 0;
+
+  if (mem < lfree) {
+    /* the newly freed struct is now the lowest */
+    lfree = mem;
+  }
+
+  MEM_STATS_DEC_USED(used, mem->next - (mem_size_t)(((u8_t *)mem - ram)));
+
+  /* finally, see if prev or next are free also */
+  plug_holes(mem);
+}
+
+#if MEM_SIZE_CLASS_MAX
+/**
+ * Put the blocks kept on the class lists back on the heap. The heap must
+ * be protected by the caller.
+ *
+ * @return 1 if any block went back, 0 if the lists were empty
+ */
+static int
+mem_class_flush(void)
+{
+  struct mem_class_block *block;
+  u16_t i;
+  int flushed = 0;
+
+  for (i = 0; i < MEM_CLASSES; i++) {
+    while ((block = mem_class_free[i]) != NULL) {
+      mem_class_free[i] = block->next;
+      mem_free_block((struct mem *)(void *)((u8_t *)block - SIZEOF_STRUCT_MEM));
+      flushed = 1;
+    }
+    mem_class_count[i] = 0;
+  }
+  if (flushed) {
+    mem_class_flushes++;
+  }
+  return flushed;
+}
+#endif /* MEM_SIZE_CLASS_MAX */
+
 /**
  * Zero the heap and initialize start, end and lowest-free
  */
@@ -289,6 +416,18 @@ mem_init(void)
 
   LWIP_ASSERT("Sanity check alignment",
     (SIZEOF_STRUCT_MEM & (MEM_ALIGNMENT-1)) == 0);
+#if MEM_SIZE_CLASS_MAX
+  {
+    u16_t i;
+    for (i = 0; i < MEM_CLASSES; i++) {
+      LWIP_ASSERT("size classes aligned and ascending",
+        (LWIP_MEM_ALIGN_SIZE(mem_class_size[i]) == mem_class_size[i]) &&
+        ((i == 0) || (mem_class_size[i - 1] < mem_class_size[i])));
+      mem_class_free[i] = NULL;
+      mem_class_count[i] = 0;
+    }
+  }
+#endif /* MEM_SIZE_CLASS_MAX */
 
   /* align the heap */
   ram = (u8_t *)LWIP_MEM_ALIGN(LWIP_RAM_HEAP_POINTER);
@@ -323,6 +462,9 @@ void
 mem_free(void *rmem)
 {
   struct mem *mem;
+#if MEM_SIZE_CLASS_MAX
+  s16_t cls;
+#endif /* MEM_SIZE_CLASS_MAX */
   LWIP_MEM_FREE_DECL_PROTECT();
 
   if (rmem == NULL) {
@@ -349,18 +491,19 @@ mem_free(void *rmem)
   mem = (struct mem *)(void *)((u8_t *)rmem - SIZEOF_STRUCT_MEM);
   /* ... which has to be in a used state ... */
   LWIP_ASSERT("mem_free: mem->used", mem->used);
-  /* ... and is now unused. */
-  mem->used = 0;
-
-  if (mem < lfree) {
-    /* the newly freed struct is now the lowest */
-    lfree = mem;
+#if MEM_SIZE_CLASS_MAX
+  /* ... and either stays used on the list of its class ... */
+  cls = mem_class_of_block(mem);
+  if ((cls >= 0) && (mem_class_count[cls] < MEM_SIZE_CLASS_MAX)) {
+    ((struct mem_class_block *)rmem)->next = mem_class_free[cls];
+    mem_class_free[cls] = (struct mem_class_block *)rmem;
+    mem_class_count[cls]++;
+    LWIP_MEM_FREE_UNPROTECT();
+    return;
   }
-
-  MEM_STATS_DEC_USED(used, mem->next - (mem_size_t)(((u8_t *)mem - ram)));
-
-  /* finally, see if prev or next are free also */
-  plug_holes(mem);
+#endif /* MEM_SIZE_CLASS_MAX */
+  /* ... or is now unused. */
+  mem_free_block(mem);
 #if LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT
   mem_free_count = 1;
 #endif /* LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT */
@@ -507,6 +650,10 @@ mem_malloc(mem_size_t size)
 {
   mem_size_t ptr, ptr2;
   struct mem *mem, *mem2;
+#if MEM_SIZE_CLASS_MAX
+  s16_t cls;
+  struct mem_class_block *block;
+#endif /* MEM_SIZE_CLASS_MAX */
 #if LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT
   u8_t local_mem_free_count = 0;
 #endif /* LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT */
@@ -529,9 +676,28 @@ mem_malloc(mem_size_t size)
     return NULL;
   }
 
+#if MEM_SIZE_CLASS_MAX
+  cls = mem_class_of_size(size);
+  if (cls >= 0) {
+    size = mem_class_size[cls];
+  }
+#endif /* MEM_SIZE_CLASS_MAX */
+
   /* protect the heap from concurrent access */
   sys_mutex_lock(&mem_mutex);
   LWIP_MEM_ALLOC_PROTECT();
+#if MEM_SIZE_CLASS_MAX
+  /* take a block kept on the list of the class first */
+  if ((cls >= 0) && ((block = mem_class_free[cls]) != NULL)) {
+    mem_class_free[cls] = block->next;
+    mem_class_count[cls]--;
+    mem_class_hits++;
+    LWIP_MEM_ALLOC_UNPROTECT();
+    sys_mutex_unlock(&mem_mutex);
+    return block;
+  }
+retry:
+#endif /* MEM_SIZE_CLASS_MAX */
 #if LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT
   /* run as long as a mem_free disturbed mem_malloc */
   do {
@@ -623,6 +789,13 @@ mem_malloc(mem_size_t size)
     /* if we got interrupted by a mem_free, try again */
   } while(local_mem_free_count != 0);
 #endif /* LWIP_ALLOW_MEM_FREE_FROM_OTHER_CONTEXT */
+#if MEM_SIZE_CLASS_MAX
+  /* the blocks kept for the classes may be in the way: give them back
+     to the heap and search again */
+  if (mem_class_flush()) {
+    goto retry;
+  }
+#endif /* MEM_SIZE_CLASS_MAX */
   LWIP_DEBUGF(MEM_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("mem_malloc: could not allocate %"S16_F" bytes\n", (s16_t)size));
   MEM_STATS_INC(err);
   LWIP_MEM_ALLOC_UNPROTECT();
@@ -630,6 +803,55 @@ mem_malloc(mem_size_t size)
   return NULL;
 }
 
+/**
+ * Report the state of the heap: the free space and how it is split up,
+ * and the blocks kept on the size class lists.
+ *
+ * @param report receives the state
+ */
+void
+mem_report(struct mem_report *report)
+{
+  struct mem *mem;
+  mem_size_t size;
+#if MEM_SIZE_CLASS_MAX
+  struct mem_class_block *block;
+  u16_t i;
+#endif /* MEM_SIZE_CLASS_MAX */
+  LWIP_MEM_ALLOC_DECL_PROTECT();
+
+  memset(report, 0, sizeof(*report));
+
+  sys_mutex_lock(&mem_mutex);
+  LWIP_MEM_ALLOC_PROTECT();
+  for (mem = (struct mem *)(void *)ram; mem != ram_end;
+       mem = (struct mem *)(void *)&ram[mem->next]) {
+    size = mem->next - (mem_size_t)((u8_t *)mem - ram) - SIZEOF_STRUCT_MEM;
+    if (mem->used) {
+      report->used_blocks++;
+    } else {
+      report->free_blocks++;
+      report->free += size;
+      if (size > report->largest) {
+        report->largest = size;
+      }
+    }
+  }
+#if MEM_SIZE_CLASS_MAX
+  for (i = 0; i < MEM_CLASSES; i++) {
+    for (block = mem_class_free[i]; block != NULL; block = block->next) {
+      mem = (struct mem *)(void *)((u8_t *)block - SIZEOF_STRUCT_MEM);
+      report->cached_blocks++;
+      report->cached += mem->next - (mem_size_t)((u8_t *)mem - ram) - SIZEOF_STRUCT_MEM;
+    }
+  }
+  report->class_hits = mem_class_hits;
+  report->class_flushes = mem_class_flushes;
+#endif /* MEM_SIZE_CLASS_MAX */
+  LWIP_MEM_ALLOC_UNPROTECT();
+  sys_mutex_unlock(&mem_mutex);
+}
+
 #endif /* MEM_USE_POOLS */
 /**
  * Contiguously allocates enough space for count objects that are size bytes
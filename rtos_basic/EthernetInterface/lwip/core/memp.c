@@ -65,10 +65,10 @@
 
 struct memp {
   struct memp *next;
-#if MEMP_OVERFLOW_CHECK
+#if MEMP_OVERFLOW_CHECK && defined(LWIP_DEBUG)
   const char *file;
   int line;
-#endif /* MEMP_OVERFLOW_CHECK */
+#endif /* MEMP_OVERFLOW_CHECK && LWIP_DEBUG */
 };
 
 #if MEMP_OVERFLOW_CHECK
@@ -100,6 +100,7 @@ struct memp {
 /* MEMP_SIZE: save space for struct memp and for sanity check */
 #define MEMP_SIZE          (LWIP_MEM_ALIGN_SIZE(sizeof(struct memp)) + MEMP_SANITY_REGION_BEFORE_ALIGNED)
 #define MEMP_ALIGN_SIZE(x) (LWIP_MEM_ALIGN_SIZE(x) + MEMP_SANITY_REGION_AFTER_ALIGNED)
+#define MEMP_ELEM_SIZE(type) (MEMP_SIZE + memp_sizes[type] + MEMP_SANITY_REGION_AFTER_ALIGNED)
 
 #else /* MEMP_OVERFLOW_CHECK */
 
@@ -109,6 +110,7 @@ struct memp {
  */
 #define MEMP_SIZE           0
 #define MEMP_ALIGN_SIZE(x) (LWIP_MEM_ALIGN_SIZE(x))
+#define MEMP_ELEM_SIZE(type) (memp_sizes[type])
 
 #endif /* MEMP_OVERFLOW_CHECK */
 
@@ -116,6 +118,9 @@ struct memp {
  *  Elements form a linked list. */
 static struct memp *memp_tab[MEMP_MAX];
 
+/** This array holds the counters of each pool. */
+static struct memp_pool_stats memp_pool_stats[MEMP_MAX];
+
 #else /* MEMP_MEM_MALLOC */
 
 #define MEMP_ALIGN_SIZE(x) (LWIP_MEM_ALIGN_SIZE(x))
@@ -147,6 +152,12 @@ static const char *memp_desc[MEMP_MAX] = {
 };
 #endif /* LWIP_DEBUG */
 
+#if defined(TARGET_LPC1768)
+#  define ETHMEM_SECTION __attribute((section("AHBSRAM1")))
+#else
+#  define ETHMEM_SECTION 
+#endif
+
 #if MEMP_SEPARATE_POOLS
 
 /** This creates each memory pool. These are named memp_memory_XXX_base (where
@@ -166,12 +177,6 @@ static u8_t *const memp_bases[] = {
 
 #else /* MEMP_SEPARATE_POOLS */
 
-#if defined(TARGET_LPC1768)
-#  define ETHMEM_SECTION __attribute((section("AHBSRAM1")))
-#else
-#  define ETHMEM_SECTION 
-#endif
-
 /** This is the actual memory used by the pools (all pools in one big block). */
 static u8_t memp_memory[MEM_ALIGNMENT - 1 
 #define LWIP_MEMPOOL(name,num,size,desc) + ( (num) * (MEMP_SIZE + MEMP_ALIGN_SIZE(size) ) )
@@ -180,24 +185,72 @@ static u8_t memp_memory[MEM_ALIGNMENT - 1
 
 #endif /* MEMP_SEPARATE_POOLS */
 
+#if MEMP_RESERVE_PAGES
+/** The largest element of any pool */
+union memp_largest {
+#define LWIP_MEMPOOL(name,num,size,desc) u8_t name ## _elem[MEMP_SIZE + MEMP_ALIGN_SIZE(size)];
+#include "lwip/memp_std.h"
+};
+
+#if MEMP_RESERVE_PAGE_SIZE
+#define MEMP_PAGE_SIZE LWIP_MEM_ALIGN_SIZE(MEMP_RESERVE_PAGE_SIZE)
+#else
+#define MEMP_PAGE_SIZE LWIP_MEM_ALIGN_SIZE(sizeof(union memp_largest))
+#endif
+
+/** The reserve of pages the pools borrow from */
+static u8_t memp_reserve[MEM_ALIGNMENT - 1 + MEMP_RESERVE_PAGES * MEMP_PAGE_SIZE] ETHMEM_SECTION;
+#define MEMP_RESERVE_BASE ((u8_t *)LWIP_MEM_ALIGN(memp_reserve))
+#endif /* MEMP_RESERVE_PAGES */
+
+#if defined(LPC_AHBSRAM1_SIZE) && !MEMP_SEPARATE_POOLS
+/** The pools and the reserve have to fit their share of AHBSRAM1 */
+typedef char memp_ahbsram1_overflow[(sizeof(memp_memory)
+#if MEMP_RESERVE_PAGES
+  + sizeof(memp_reserve)
+#endif /* MEMP_RESERVE_PAGES */
+  <= LPC_AHBSRAM1_SIZE - LPC_EMAC_AHBSRAM1_SHARE) ? 1 : -1];
+#endif /* LPC_AHBSRAM1_SIZE && !MEMP_SEPARATE_POOLS */
+
+#if MEMP_RESERVE_PAGES
+
+/** The pool each page is lent to, MEMP_MAX for a free page */
+static u8_t memp_page_owner[MEMP_RESERVE_PAGES];
+/** The elements of each page in use */
+static u16_t memp_page_used[MEMP_RESERVE_PAGES];
+
+/**
+ * Find the reserve page an element was carved from
+ *
+ * @return the page index, or -1 for an element of the pool itself
+ */
+static s16_t
+memp_page_of(struct memp *memp)
+{
+  mem_ptr_t offset = (mem_ptr_t)memp - (mem_ptr_t)MEMP_RESERVE_BASE;
+
+  if (((mem_ptr_t)memp < (mem_ptr_t)MEMP_RESERVE_BASE) ||
+      (offset >= (mem_ptr_t)MEMP_RESERVE_PAGES * MEMP_PAGE_SIZE)) {
+    return -1;
+  }
+  return (s16_t)(offset / MEMP_PAGE_SIZE);
+}
+#endif /* MEMP_RESERVE_PAGES */
+
 #if MEMP_SANITY_CHECK
 /**
- * Check that memp-lists don't form a circle
+ * Check that the list of a pool doesn't form a circle: a list holding
+ * more elements than the pool has must have one.
  */
 static int
-memp_sanity(void)
+memp_sanity(memp_t type)
 {
-  s16_t i, c;
-  struct memp *m, *n;
-
-  for (i = 0; i < MEMP_MAX; i++) {
-    for (m = memp_tab[i]; m != NULL; m = m->next) {
-      c = 1;
-      for (n = memp_tab[i]; n != NULL; n = n->next) {
-        if (n == m && --c < 0) {
-          return 0;
-        }
-      }
+  u16_t c = 0;
+  struct memp *m;
+
+  for (m = memp_tab[type]; m != NULL; m = m->next) {
+    if (++c > memp_pool_stats[type].avail) {
+      return 0;
     }
   }
   return 1;
@@ -221,9 +274,9 @@ static const char * memp_overflow_names[] = {
 static void
 memp_overflow_check_element_overflow(struct memp *p, u16_t memp_type)
 {
+#if MEMP_SANITY_REGION_AFTER_ALIGNED > 0
   u16_t k;
   u8_t *m;
-#if MEMP_SANITY_REGION_AFTER_ALIGNED > 0
   m = (u8_t*)p + MEMP_SIZE + memp_sizes[memp_type];
   for (k = 0; k < MEMP_SANITY_REGION_AFTER_ALIGNED; k++) {
     if (m[k] != 0xcd) {
@@ -239,8 +292,13 @@ memp_overflow_check_element_overflow(struct memp *p, u16_t memp_type)
       strcat(errstr, memp_overflow_names[memp_type]);
 #endif
       LWIP_ASSERT(errstr, 0);
+      memp_pool_stats[memp_type].illegal++;
+      break;
     }
   }
+#else
+  LWIP_UNUSED_ARG(p);
+  LWIP_UNUSED_ARG(memp_type);
 #endif
 }
 
@@ -254,9 +312,9 @@ memp_overflow_check_element_overflow(struct memp *p, u16_t memp_type)
 static void
 memp_overflow_check_element_underflow(struct memp *p, u16_t memp_type)
 {
+#if MEMP_SANITY_REGION_BEFORE_ALIGNED > 0
   u16_t k;
   u8_t *m;
-#if MEMP_SANITY_REGION_BEFORE_ALIGNED > 0
   m = (u8_t*)p + MEMP_SIZE - MEMP_SANITY_REGION_BEFORE_ALIGNED;
   for (k = 0; k < MEMP_SANITY_REGION_BEFORE_ALIGNED; k++) {
     if (m[k] != 0xcd) {
@@ -272,8 +330,13 @@ memp_overflow_check_element_underflow(struct memp *p, u16_t memp_type)
       strcat(errstr, memp_overflow_names[memp_type]);
 #endif
       LWIP_ASSERT(errstr, 0);
+      memp_pool_stats[memp_type].illegal++;
+      break;
     }
   }
+#else
+  LWIP_UNUSED_ARG(p);
+  LWIP_UNUSED_ARG(memp_type);
 #endif
 }
 
@@ -288,6 +351,19 @@ memp_overflow_check_all(void)
   u16_t i, j;
   struct memp *p;
 
+#if MEMP_RESERVE_PAGES
+  for (i = 0; i < MEMP_RESERVE_PAGES; ++i) {
+    if (memp_page_owner[i] != MEMP_MAX) {
+      p = (struct memp *)(void *)(MEMP_RESERVE_BASE + i * MEMP_PAGE_SIZE);
+      for (j = 0; j < MEMP_PAGE_SIZE / MEMP_ELEM_SIZE(memp_page_owner[i]); ++j) {
+        memp_overflow_check_element_overflow(p, memp_page_owner[i]);
+        memp_overflow_check_element_underflow(p, memp_page_owner[i]);
+        p = (struct memp *)(void *)((u8_t *)p + MEMP_ELEM_SIZE(memp_page_owner[i]));
+      }
+    }
+  }
+#endif /* MEMP_RESERVE_PAGES */
+
   p = (struct memp *)LWIP_MEM_ALIGN(memp_memory);
   for (i = 0; i < MEMP_MAX; ++i) {
     p = p;
@@ -306,6 +382,26 @@ memp_overflow_check_all(void)
   }
 }
 
+/**
+ * Initialize the restricted areas of a memp element.
+ *
+ * @param p the memp element
+ * @param memp_type the pool p belongs to
+ */
+static void
+memp_overflow_init_element(struct memp *p, u16_t memp_type)
+{
+  u8_t *m;
+#if MEMP_SANITY_REGION_BEFORE_ALIGNED > 0
+  m = (u8_t*)p + MEMP_SIZE - MEMP_SANITY_REGION_BEFORE_ALIGNED;
+  memset(m, 0xcd, MEMP_SANITY_REGION_BEFORE_ALIGNED);
+#endif
+#if MEMP_SANITY_REGION_AFTER_ALIGNED > 0
+  m = (u8_t*)p + MEMP_SIZE + memp_sizes[memp_type];
+  memset(m, 0xcd, MEMP_SANITY_REGION_AFTER_ALIGNED);
+#endif
+}
+
 /**
  * Initialize the restricted areas of all memp elements in every pool.
  */
@@ -314,26 +410,85 @@ memp_overflow_init(void)
 {
   u16_t i, j;
   struct memp *p;
-  u8_t *m;
 
   p = (struct memp *)LWIP_MEM_ALIGN(memp_memory);
   for (i = 0; i < MEMP_MAX; ++i) {
     p = p;
     for (j = 0; j < memp_num[i]; ++j) {
-#if MEMP_SANITY_REGION_BEFORE_ALIGNED > 0
-      m = (u8_t*)p + MEMP_SIZE - MEMP_SANITY_REGION_BEFORE_ALIGNED;
-      memset(m, 0xcd, MEMP_SANITY_REGION_BEFORE_ALIGNED);
-#endif
-#if MEMP_SANITY_REGION_AFTER_ALIGNED > 0
-      m = (u8_t*)p + MEMP_SIZE + memp_sizes[i];
-      memset(m, 0xcd, MEMP_SANITY_REGION_AFTER_ALIGNED);
-#endif
+      memp_overflow_init_element(p, i);
       p = (struct memp*)((u8_t*)p + MEMP_SIZE + memp_sizes[i] + MEMP_SANITY_REGION_AFTER_ALIGNED);
     }
   }
 }
 #endif /* MEMP_OVERFLOW_CHECK */
 
+#if MEMP_RESERVE_PAGES
+/**
+ * Lend a free reserve page to a pool that ran out of elements, and carve it
+ * into elements of that pool. Called with the pools protected.
+ *
+ * @param type the pool that ran out
+ * @return 1 if the pool got new elements, 0 if no page is free or the
+ *         elements don't fit in a page
+ */
+static int
+memp_borrow(memp_t type)
+{
+  u16_t i, j, n;
+  struct memp *memp;
+
+  n = MEMP_PAGE_SIZE / MEMP_ELEM_SIZE(type);
+  if (n == 0) {
+    return 0;
+  }
+  for (i = 0; i < MEMP_RESERVE_PAGES; ++i) {
+    if (memp_page_owner[i] == MEMP_MAX) {
+      memp_page_owner[i] = (u8_t)type;
+      memp = (struct memp *)(void *)(MEMP_RESERVE_BASE + i * MEMP_PAGE_SIZE);
+      for (j = 0; j < n; ++j) {
+#if MEMP_OVERFLOW_CHECK
+        memp_overflow_init_element(memp, type);
+#endif /* MEMP_OVERFLOW_CHECK */
+        memp->next = memp_tab[type];
+        memp_tab[type] = memp;
+        memp = (struct memp *)(void *)((u8_t *)memp + MEMP_ELEM_SIZE(type));
+      }
+      memp_pool_stats[type].avail += n;
+      memp_pool_stats[type].pages++;
+      memp_pool_stats[type].borrows++;
+      MEMP_STATS_AVAIL(avail, type, memp_pool_stats[type].avail);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Give a reserve page back once none of its elements is in use: take its
+ * elements off the free list of the pool. Called with the pools protected.
+ *
+ * @param type the pool the page is lent to
+ * @param page the page index
+ */
+static void
+memp_give_back(memp_t type, s16_t page)
+{
+  struct memp **link = &memp_tab[type];
+
+  while (*link != NULL) {
+    if (memp_page_of(*link) == page) {
+      *link = (*link)->next;
+    } else {
+      link = &(*link)->next;
+    }
+  }
+  memp_page_owner[page] = MEMP_MAX;
+  memp_pool_stats[type].avail -= MEMP_PAGE_SIZE / MEMP_ELEM_SIZE(type);
+  memp_pool_stats[type].pages--;
+  MEMP_STATS_AVAIL(avail, type, memp_pool_stats[type].avail);
+}
+#endif /* MEMP_RESERVE_PAGES */
+
 /**
  * Initialize this module.
  * 
@@ -350,7 +505,15 @@ memp_init(void)
     MEMP_STATS_AVAIL(max, i, 0);
     MEMP_STATS_AVAIL(err, i, 0);
     MEMP_STATS_AVAIL(avail, i, memp_num[i]);
+    memset(&memp_pool_stats[i], 0, sizeof(memp_pool_stats[i]));
+    memp_pool_stats[i].avail = memp_num[i];
+  }
+#if MEMP_RESERVE_PAGES
+  for (i = 0; i < MEMP_RESERVE_PAGES; ++i) {
+    memp_page_owner[i] = MEMP_MAX;
+    memp_page_used[i] = 0;
   }
+#endif /* MEMP_RESERVE_PAGES */
 
 #if !MEMP_SEPARATE_POOLS
   memp = (struct memp *)LWIP_MEM_ALIGN(memp_memory);
@@ -408,21 +571,43 @@ memp_malloc_fn(memp_t type, const char* file, const int line)
 #endif /* MEMP_OVERFLOW_CHECK >= 2 */
 
   memp = memp_tab[type];
+#if MEMP_RESERVE_PAGES
+  if ((memp == NULL) && memp_borrow(type)) {
+    memp = memp_tab[type];
+  }
+#endif /* MEMP_RESERVE_PAGES */
   
   if (memp != NULL) {
     memp_tab[type] = memp->next;
+#if MEMP_RESERVE_PAGES
+    {
+      s16_t page = memp_page_of(memp);
+      if (page >= 0) {
+        memp_page_used[page]++;
+      }
+    }
+#endif /* MEMP_RESERVE_PAGES */
 #if MEMP_OVERFLOW_CHECK
     memp->next = NULL;
+#ifdef LWIP_DEBUG
     memp->file = file;
     memp->line = line;
+#else
+    LWIP_UNUSED_ARG(file);
+    LWIP_UNUSED_ARG(line);
+#endif /* LWIP_DEBUG */
 #endif /* MEMP_OVERFLOW_CHECK */
     MEMP_STATS_INC_USED(used, type);
+    if (++memp_pool_stats[type].used > memp_pool_stats[type].max) {
+      memp_pool_stats[type].max = memp_pool_stats[type].used;
+    }
     LWIP_ASSERT("memp_malloc: memp properly aligned",
                 ((mem_ptr_t)memp % MEM_ALIGNMENT) == 0);
     memp = (struct memp*)(void *)((u8_t*)memp + MEMP_SIZE);
   } else {
     LWIP_DEBUGF(MEMP_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("memp_malloc: out of memory in pool %s\n", memp_desc[type]));
     MEMP_STATS_INC(err, type);
+    memp_pool_stats[type].err++;
   }
 
   SYS_ARCH_UNPROTECT(old_level);
@@ -461,15 +646,46 @@ memp_free(memp_t type, void *mem)
 #endif /* MEMP_OVERFLOW_CHECK */
 
   MEMP_STATS_DEC(used, type); 
+  memp_pool_stats[type].used--;
   
+#if MEMP_RESERVE_PAGES
+  {
+    s16_t page = memp_page_of(memp);
+    if ((page >= 0) && (--memp_page_used[page] == 0)) {
+      /* the element goes back with its page */
+      memp_give_back(type, page);
+      SYS_ARCH_UNPROTECT(old_level);
+      return;
+    }
+  }
+#endif /* MEMP_RESERVE_PAGES */
+
   memp->next = memp_tab[type]; 
   memp_tab[type] = memp;
 
 #if MEMP_SANITY_CHECK
-  LWIP_ASSERT("memp sanity", memp_sanity());
+  LWIP_ASSERT("memp sanity", memp_sanity(type));
 #endif /* MEMP_SANITY_CHECK */
 
   SYS_ARCH_UNPROTECT(old_level);
 }
 
+/**
+ * Read the counters of a pool.
+ *
+ * @param type the pool
+ * @param stats receives a copy of the counters
+ */
+void
+memp_get_stats(memp_t type, struct memp_pool_stats *stats)
+{
+  SYS_ARCH_DECL_PROTECT(old_level);
+
+  LWIP_ERROR("memp_get_stats: type < MEMP_MAX", (type < MEMP_MAX), return;);
+
+  SYS_ARCH_PROTECT(old_level);
+  *stats = memp_pool_stats[type];
+  SYS_ARCH_UNPROTECT(old_level);
+}
+
 #endif /* MEMP_MEM_MALLOC */
@@ -150,6 +150,17 @@ pbuf_pool_is_empty(void)
 #endif /* PBUF_POOL_FREE_OOSEQ */
 #endif /* !LWIP_TCP || !TCP_QUEUE_OOSEQ || NO_SYS */
 
+/**
+ * Ask for out-of-sequence TCP data to be freed, as pbuf_alloc does when
+ * the PBUF_POOL is empty. Network drivers that receive into buffers of
+ * their own call this when those run out.
+ */
+void
+pbuf_reclaim_ooseq(void)
+{
+  PBUF_POOL_IS_EMPTY();
+}
+
 /**
  * Allocates a pbuf of the given type (possibly a chain for PBUF_POOL type).
  *
@@ -369,7 +380,7 @@ pbuf_alloced_custom(pbuf_layer l, u16_t length, pbuf_type type, struct pbuf_cust
     return NULL;
   }
 
-  if (LWIP_MEM_ALIGN_SIZE(offset) + length < payload_mem_len) {
+  if (LWIP_MEM_ALIGN_SIZE(offset) + length > payload_mem_len) {
     LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_LEVEL_WARNING, ("pbuf_alloced_custom(length=%"U16_F") buffer too short\n", length));
     return NULL;
   }
@@ -97,6 +97,90 @@ struct tcp_pcb ** const tcp_pcb_lists[] = {&tcp_listen_pcbs.pcbs, &tcp_bound_pcb
 /** Only used for temporary storage. */
 struct tcp_pcb *tcp_tmp_pcb;
 
+#if TCP_PCB_HASH_SIZE
+#if ((TCP_PCB_HASH_SIZE & (TCP_PCB_HASH_SIZE - 1)) != 0)
+  #error "TCP_PCB_HASH_SIZE must be a power of 2, you have to correct it in your lwipopts.h"
+#endif
+/** Active and TIME-WAIT PCBs by their addresses and ports, each bucket
+ * chained through hash_next */
+static struct tcp_pcb *tcp_pcb_hash[TCP_PCB_HASH_SIZE];
+
+/** Hash the addresses and ports of a connection (ports in host order) */
+static u8_t
+tcp_pcb_hash_index(ip_addr_t *local_ip, u16_t local_port,
+                   ip_addr_t *remote_ip, u16_t remote_port)
+{
+  u32_t h = ip4_addr_get_u32(local_ip) ^ ip4_addr_get_u32(remote_ip) ^
+            (((u32_t)remote_port << 16) | local_port);
+  h ^= h >> 16;
+  h ^= h >> 8;
+  return (u8_t)(h & (TCP_PCB_HASH_SIZE - 1));
+}
+
+/** Add a PCB to the connection hash, called from TCP_REG for the active
+ * and TIME-WAIT lists */
+void
+tcp_pcb_hash_add(struct tcp_pcb *pcb)
+{
+  u8_t h = tcp_pcb_hash_index(&pcb->local_ip, pcb->local_port,
+                              &pcb->remote_ip, pcb->remote_port);
+  pcb->hash_next = tcp_pcb_hash[h];
+  tcp_pcb_hash[h] = pcb;
+}
+
+/** Remove a PCB from the connection hash, called from TCP_RMV for the
+ * active and TIME-WAIT lists */
+void
+tcp_pcb_hash_remove(struct tcp_pcb *pcb)
+{
+  struct tcp_pcb **link = &tcp_pcb_hash[tcp_pcb_hash_index(&pcb->local_ip,
+    pcb->local_port, &pcb->remote_ip, pcb->remote_port)];
+
+  for (; *link != NULL; link = &(*link)->hash_next) {
+    if (*link == pcb) {
+      *link = pcb->hash_next;
+      break;
+    }
+  }
+  pcb->hash_next = NULL;
+}
+
+/**
+ * Find the active or TIME-WAIT PCB of a connection. A PCB found is moved
+ * to the front of its bucket, so that subsequent lookups will be faster.
+ *
+ * @param local_ip local IP address
+ * @param local_port local port in host byte order
+ * @param remote_ip remote IP address
+ * @param remote_port remote port in host byte order
+ * @return the PCB, or NULL if there is no such connection
+ */
+struct tcp_pcb *
+tcp_pcb_hash_find(ip_addr_t *local_ip, u16_t local_port,
+                  ip_addr_t *remote_ip, u16_t remote_port)
+{
+  struct tcp_pcb **head = &tcp_pcb_hash[tcp_pcb_hash_index(local_ip,
+    local_port, remote_ip, remote_port)];
+  struct tcp_pcb *pcb, *prev = NULL;
+
+  for (pcb = *head; pcb != NULL; pcb = pcb->hash_next) {
+    if (pcb->remote_port == remote_port &&
+       pcb->local_port == local_port &&
+       ip_addr_cmp(&(pcb->remote_ip), remote_ip) &&
+       ip_addr_cmp(&(pcb->local_ip), local_ip)) {
+      if (prev != NULL) {
+        prev->hash_next = pcb->hash_next;
+        pcb->hash_next = *head;
+        *head = pcb;
+      }
+      return pcb;
+    }
+    prev = pcb;
+  }
+  return NULL;
+}
+#endif /* TCP_PCB_HASH_SIZE */
+
 /** Timer counter to handle calling slow-timer from tcp_tmr() */ 
 static u8_t tcp_timer;
 static u16_t tcp_new_port(void);
@@ -916,6 +1000,9 @@ tcp_slowtmr(void)
         LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_active_pcbs", tcp_active_pcbs == pcb);
         tcp_active_pcbs = pcb->next;
       }
+#if TCP_PCB_HASH_SIZE
+      tcp_pcb_hash_remove(pcb);
+#endif /* TCP_PCB_HASH_SIZE */
 
       TCP_EVENT_ERR(pcb->errf, pcb->callback_arg, ERR_ABRT);
       if (pcb_reset) {
@@ -973,6 +1060,9 @@ tcp_slowtmr(void)
         LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_tw_pcbs", tcp_tw_pcbs == pcb);
         tcp_tw_pcbs = pcb->next;
       }
+#if TCP_PCB_HASH_SIZE
+      tcp_pcb_hash_remove(pcb);
+#endif /* TCP_PCB_HASH_SIZE */
       pcb2 = pcb;
       pcb = pcb->next;
       memp_free(MEMP_TCP_PCB, pcb2);
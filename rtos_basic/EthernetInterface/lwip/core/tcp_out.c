@@ -738,6 +738,12 @@ tcp_enqueue_flags(struct tcp_pcb *pcb, u8_t flags)
 
   if (flags & TCP_SYN) {
     optflags = TF_SEG_OPTS_MSS;
+#if LWIP_TCP_SACK_OUT
+    /* offer SACK on our SYN, accept it on a SYN-ACK if the peer offered it */
+    if (((flags & TCP_ACK) == 0) || pcb->sack_ok) {
+      optflags |= TF_SEG_OPTS_SACK_PERM;
+    }
+#endif /* LWIP_TCP_SACK_OUT */
   }
 #if LWIP_TCP_TIMESTAMPS
   if ((pcb->flags & TF_TIMESTAMP)) {
@@ -831,6 +837,58 @@ tcp_build_timestamp_option(struct tcp_pcb *pcb, u32_t *opts)
 }
 #endif
 
+#if LWIP_TCP_SACK_OUT
+/** The most SACK blocks that fit in the TCP options, beside a timestamp
+    option there is only room for 3 */
+#define TCP_SACK_MAX_BLOCKS 4
+
+/**
+ * Find the blocks of data queued on ooseq to report in a SACK option.
+ *
+ * The ooseq segments are sorted and don't overlap, so each run of adjacent
+ * segments is a block. The block holding the segment queued last goes
+ * first (RFC 2018), the others follow in sequence order.
+ *
+ * @param pcb tcp_pcb
+ * @param left receives the first seqno of each block
+ * @param right receives the seqno following each block
+ * @param max the most blocks to report
+ * @return the number of blocks
+ */
+static u8_t
+tcp_sack_blocks(struct tcp_pcb *pcb, u32_t *left, u32_t *right, u8_t max)
+{
+  struct tcp_seg *seg = pcb->ooseq;
+  u32_t l, r;
+  u8_t n = 0, i;
+
+  while (seg != NULL) {
+    l = seg->tcphdr->seqno;
+    r = l + TCP_TCPLEN(seg);
+    for (seg = seg->next; (seg != NULL) && (seg->tcphdr->seqno == r); seg = seg->next) {
+      r += TCP_TCPLEN(seg);
+    }
+    if (TCP_SEQ_BETWEEN(pcb->sack_recent, l, r - 1)) {
+      if (n == max) {
+        n--;
+      }
+      for (i = n; i > 0; i--) {
+        left[i] = left[i - 1];
+        right[i] = right[i - 1];
+      }
+      left[0] = l;
+      right[0] = r;
+      n++;
+    } else if (n < max) {
+      left[n] = l;
+      right[n] = r;
+      n++;
+    }
+  }
+  return n;
+}
+#endif /* LWIP_TCP_SACK_OUT */
+
 /** Send an ACK without data.
  *
  * @param pcb Protocol control block for the TCP connection to send the ACK
@@ -841,12 +899,25 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
   struct pbuf *p;
   struct tcp_hdr *tcphdr;
   u8_t optlen = 0;
+#if LWIP_TCP_SACK_OUT
+  u32_t sack_left[TCP_SACK_MAX_BLOCKS], sack_right[TCP_SACK_MAX_BLOCKS];
+  u8_t sack_n = 0, i;
+  u32_t *opts;
+#endif /* LWIP_TCP_SACK_OUT */
 
 #if LWIP_TCP_TIMESTAMPS
   if (pcb->flags & TF_TIMESTAMP) {
     optlen = LWIP_TCP_OPT_LENGTH(TF_SEG_OPTS_TS);
   }
 #endif
+#if LWIP_TCP_SACK_OUT
+  if (pcb->sack_ok && (pcb->ooseq != NULL)) {
+    sack_n = tcp_sack_blocks(pcb, sack_left, sack_right,
+      (optlen != 0) ? TCP_SACK_MAX_BLOCKS - 1 : TCP_SACK_MAX_BLOCKS);
+    /* two NOPs, kind, length and the blocks */
+    optlen += 4 + 8 * sack_n;
+  }
+#endif /* LWIP_TCP_SACK_OUT */
 
   p = tcp_output_alloc_header(pcb, optlen, 0, htonl(pcb->snd_nxt));
   if (p == NULL) {
@@ -867,6 +938,17 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
     tcp_build_timestamp_option(pcb, (u32_t *)(tcphdr + 1));
   }
 #endif 
+#if LWIP_TCP_SACK_OUT
+  if (sack_n > 0) {
+    opts = (u32_t *)(void *)(tcphdr + 1) + (optlen - (4 + 8 * sack_n)) / 4;
+    /* Pad with two NOP options to make everything nicely aligned */
+    opts[0] = htonl(0x01010500UL | (2 + 8 * sack_n));
+    for (i = 0; i < sack_n; i++) {
+      opts[1 + 2 * i] = htonl(sack_left[i]);
+      opts[2 + 2 * i] = htonl(sack_right[i]);
+    }
+  }
+#endif /* LWIP_TCP_SACK_OUT */
 
 #if CHECKSUM_GEN_TCP
   tcphdr->chksum = inet_chksum_pseudo(p, &(pcb->local_ip), &(pcb->remote_ip),
@@ -1072,6 +1154,11 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
     TCP_BUILD_MSS_OPTION(*opts);
     opts += 1;
   }
+  if (seg->flags & TF_SEG_OPTS_SACK_PERM) {
+    /* Pad with two NOP options to make everything nicely aligned */
+    *opts = PP_HTONL(0x01010402);
+    opts += 1;
+  }
 #if LWIP_TCP_TIMESTAMPS
   pcb->ts_lastacksent = pcb->rcv_nxt;
 
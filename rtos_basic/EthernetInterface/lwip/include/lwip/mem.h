@@ -86,6 +86,20 @@ typedef u16_t mem_size_t;
 /* lwIP alternative malloc */
 void  mem_init(void);
 void *mem_trim(void *mem, mem_size_t size);
+
+/** State of the heap, as reported by mem_report() */
+struct mem_report {
+  mem_size_t free;          /* bytes in free heap blocks */
+  mem_size_t largest;       /* the largest free heap block */
+  u16_t free_blocks;        /* free heap blocks */
+  u16_t used_blocks;        /* heap blocks in use, cached ones included */
+  mem_size_t cached;        /* bytes in blocks kept on the size class lists */
+  u16_t cached_blocks;      /* blocks kept on the size class lists */
+  u32_t class_hits;         /* allocations taken from a size class list */
+  u32_t class_flushes;      /* times the lists went back to the heap */
+};
+
+void  mem_report(struct mem_report *report);
 #endif /* MEM_USE_POOLS */
 void *mem_malloc(mem_size_t size);
 void *mem_calloc(mem_size_t count, mem_size_t size);
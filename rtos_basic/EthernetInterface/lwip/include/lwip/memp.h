@@ -107,6 +107,19 @@ void *memp_malloc(memp_t type);
 #endif
 void  memp_free(memp_t type, void *mem);
 
+/** Counters of a pool, kept whether or not MEMP_STATS is enabled */
+struct memp_pool_stats {
+  u16_t avail;    /* elements in the pool, borrowed ones included */
+  u16_t used;     /* elements in use */
+  u16_t max;      /* most elements in use at once */
+  u16_t err;      /* allocations that failed, wraps around */
+  u16_t pages;    /* reserve pages borrowed */
+  u16_t borrows;  /* reserve pages borrowed since start, wraps around */
+  u16_t illegal;  /* elements found with overwritten overflow regions */
+};
+
+void  memp_get_stats(memp_t type, struct memp_pool_stats *stats);
+
 #endif /* MEMP_MEM_MALLOC */
 
 #ifdef __cplusplus
@@ -156,12 +156,31 @@
 
 /**
  * MEMP_SANITY_CHECK==1: run a sanity check after each memp_free() to make
- * sure that there are no cycles in the linked lists.
+ * sure that there are no cycles in the linked list of the pool.
  */
 #ifndef MEMP_SANITY_CHECK
 #define MEMP_SANITY_CHECK               0
 #endif
 
+/**
+ * MEMP_RESERVE_PAGES: the number of pages in a reserve shared by the memp
+ * pools. A pool that runs out of elements borrows a free page and carves
+ * it into elements, and gives the page back once they are all free again.
+ * 0 disables the reserve, and a pool that runs out fails the allocation.
+ */
+#ifndef MEMP_RESERVE_PAGES
+#define MEMP_RESERVE_PAGES              0
+#endif
+
+/**
+ * MEMP_RESERVE_PAGE_SIZE: the size of a reserve page in bytes. Pools whose
+ * elements are larger never borrow. 0 makes pages as large as the largest
+ * element of any pool, so that every pool can borrow.
+ */
+#ifndef MEMP_RESERVE_PAGE_SIZE
+#define MEMP_RESERVE_PAGE_SIZE          0
+#endif
+
 /**
  * MEM_USE_POOLS==1: Use an alternative to malloc() by allocating from a set
  * of memory pools of various sizes. When mem_malloc is called, an element of
@@ -180,6 +199,22 @@
 #define MEM_USE_POOLS_TRY_BIGGER_POOL   0
 #endif
 
+/**
+ * MEM_SIZE_CLASS_MAX: the number of freed heap blocks kept on the free list
+ * of each size class, in front of the heap. mem_malloc() takes a block of
+ * a class from its list before it searches the heap, and the lists go back
+ * to the heap when a search fails. 0 searches the heap for every block.
+ *
+ * The classes are set by MEM_SIZE_CLASSES, a braced list of ascending
+ * sizes. By default they are the PBUF_RAM pbufs of a TCP segment without
+ * data or options, of an NTP packet, of a DNS query and of a full-sized TCP
+ * segment. Requests within a quarter below a class size are rounded up to
+ * it.
+ */
+#ifndef MEM_SIZE_CLASS_MAX
+#define MEM_SIZE_CLASS_MAX              0
+#endif
+
 /**
  * MEMP_USE_CUSTOM_POOLS==1: whether to include a user file lwippools.h
  * that defines additional pools beyond the "standard" ones required
@@ -431,6 +466,17 @@
 #define ARP_TABLE_SIZE                  10
 #endif
 
+/**
+ * ETHARP_HASH_SIZE: Number of hash buckets indexing the ARP table by IP
+ * address, must be a power of 2. With the index, looking an address up and
+ * adding one to a table with free entries do not search the table, so a
+ * large ARP_TABLE_SIZE costs no more per packet than a small one. Set to 0
+ * to search the table linearly.
+ */
+#ifndef ETHARP_HASH_SIZE
+#define ETHARP_HASH_SIZE                16
+#endif
+
 /**
  * ARP_QUEUEING==1: Multiple outgoing packets are queued during hardware address
  * resolution. By default, only the most recent packet is queued per IP address.
@@ -921,6 +967,24 @@
 #define TCP_QUEUE_OOSEQ                 (LWIP_TCP)
 #endif
 
+/**
+ * TCP_OOSEQ_MAX_BYTES: The maximum number of bytes queued on ooseq per pcb.
+ * Segments beyond the limit are dropped, the highest sequence numbers
+ * first. Default is 0 (no limit). Only valid for TCP_QUEUE_OOSEQ==1.
+ */
+#ifndef TCP_OOSEQ_MAX_BYTES
+#define TCP_OOSEQ_MAX_BYTES             0
+#endif
+
+/**
+ * TCP_OOSEQ_MAX_PBUFS: The maximum number of pbufs queued on ooseq per pcb.
+ * Segments beyond the limit are dropped, the highest sequence numbers
+ * first. Default is 0 (no limit). Only valid for TCP_QUEUE_OOSEQ==1.
+ */
+#ifndef TCP_OOSEQ_MAX_PBUFS
+#define TCP_OOSEQ_MAX_PBUFS             0
+#endif
+
 /**
  * TCP_MSS: TCP Maximum segment size. (default is 536, a conservative default,
  * you might want to increase this.)
@@ -978,6 +1042,16 @@
 #define TCP_SNDQUEUELOWAT               ((TCP_SND_QUEUELEN)/2)
 #endif
 
+/**
+ * TCP_PCB_HASH_SIZE: Number of hash buckets indexing the active and
+ * TIME-WAIT TCP PCBs by local and remote address and port, must be a power
+ * of 2. With the index, matching an incoming segment to its connection
+ * costs the same for any MEMP_NUM_TCP_PCB. Set to 0 to search the PCB lists.
+ */
+#ifndef TCP_PCB_HASH_SIZE
+#define TCP_PCB_HASH_SIZE               16
+#endif
+
 /**
  * TCP_LISTEN_BACKLOG: Enable the backlog option for tcp listen pcb.
  */
@@ -1019,6 +1093,16 @@
 #define LWIP_TCP_TIMESTAMPS             0
 #endif
 
+/**
+ * LWIP_TCP_SACK_OUT==1: offer the TCP selective acknowledgment option and,
+ * if the peer accepts it, report the data queued on ooseq in the SACK
+ * option of the ACKs sent without data. SACK blocks received are not used.
+ * Requires TCP_QUEUE_OOSEQ.
+ */
+#ifndef LWIP_TCP_SACK_OUT
+#define LWIP_TCP_SACK_OUT               0
+#endif
+
 /**
  * TCP_WND_UPDATE_THRESHOLD: difference in window to trigger an
  * explicit window update
@@ -174,6 +174,11 @@ struct tcp_pcb {
 
   /* ports are in host byte order */
   u16_t remote_port;
+
+#if TCP_PCB_HASH_SIZE
+  /* next PCB in the same bucket of the connection hash */
+  struct tcp_pcb *hash_next;
+#endif /* TCP_PCB_HASH_SIZE */
   
   u8_t flags;
 #define TF_ACK_DELAY   ((u8_t)0x01U)   /* Delayed ACK. */
@@ -263,6 +268,11 @@ struct tcp_pcb {
   u32_t ts_recent;
 #endif /* LWIP_TCP_TIMESTAMPS */
 
+#if LWIP_TCP_SACK_OUT
+  u8_t sack_ok;       /* the peer accepts the SACK option */
+  u32_t sack_recent;  /* seqno of the segment last queued on ooseq */
+#endif /* LWIP_TCP_SACK_OUT */
+
   /* idle time before KEEPALIVE is sent */
   u32_t keep_idle;
 #if LWIP_TCP_KEEPALIVE
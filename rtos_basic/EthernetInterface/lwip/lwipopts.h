@@ -52,8 +52,21 @@
 #define MEMP_NUM_TCP_PCB_LISTEN     4
 #define MEMP_NUM_TCP_PCB            4
 #define MEMP_NUM_PBUF               8
+// Pools out of elements borrow 512 byte pages from a shared reserve, so
+// PBUF_POOL elements (a full frame each) never do
+#define MEMP_RESERVE_PAGES          2
+#define MEMP_RESERVE_PAGE_SIZE      512
+// Keep two freed heap blocks of each common pbuf size off the heap; they
+// go back to it when an allocation would otherwise fail
+#ifndef MEM_SIZE_CLASS_MAX
+#define MEM_SIZE_CLASS_MAX          2
+#endif
 
-#define TCP_QUEUE_OOSEQ             0
+// Queue out-of-order segments, reporting them in SACK options, within a
+// budget of two full segments of EMAC receive buffers
+#define TCP_QUEUE_OOSEQ             1
+#define TCP_OOSEQ_MAX_PBUFS         12
+#define LWIP_TCP_SACK_OUT           1
 #define TCP_OVERSIZE                0
 
 #define LWIP_DHCP                   1
@@ -97,10 +110,19 @@
 
 #ifdef LWIP_DEBUG
 #define MEMP_OVERFLOW_CHECK         1
+// The default 16 byte regions on both sides don't fit AHBSRAM1
+#define MEMP_SANITY_REGION_BEFORE   4
+#define MEMP_SANITY_REGION_AFTER    4
 #define MEMP_SANITY_CHECK           1
 #else
 #define LWIP_NOASSERT               1
 #define LWIP_STATS                  0
+// Keep a small overflow region after each pool element, checked on
+// memp_free and counted in memp_get_stats, without the list walk
+#define MEMP_OVERFLOW_CHECK         1
+#define MEMP_SANITY_REGION_BEFORE   0
+#define MEMP_SANITY_REGION_AFTER    4
+#define MEMP_SANITY_CHECK           0
 #endif
 
 #define LWIP_PLATFORM_BYTESWAP      1
@@ -109,8 +131,16 @@
 
 /* MSS should match the hardware packet size */
 #define TCP_MSS                     1460
+#ifndef TCP_SND_BUF
 #define TCP_SND_BUF                 (2 * TCP_MSS)
-#define TCP_WND                     (2 * TCP_MSS)
+#endif
+// Room for a lost segment and three more behind it, so the sender gets the
+// three duplicate ACKs of a fast retransmit. The EMAC RX pool holds them
+// (4 frames of 6 buffers, of LPC_NUM_RX_BUFS 32), and the out-of-order
+// queue keeps two of them (TCP_OOSEQ_MAX_PBUFS)
+#ifndef TCP_WND
+#define TCP_WND                     (4 * TCP_MSS)
+#endif
 #define TCP_SND_QUEUELEN            (2 * TCP_SND_BUF/TCP_MSS)
 
 // Broadcast
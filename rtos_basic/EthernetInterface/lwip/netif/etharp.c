@@ -107,10 +107,29 @@ struct etharp_entry {
 #if ETHARP_SUPPORT_STATIC_ENTRIES
   u8_t static_entry;
 #endif /* ETHARP_SUPPORT_STATIC_ENTRIES */
+#if ETHARP_HASH_SIZE
+  /** Next entry in the same hash bucket or on the free list, plus 1. */
+  u8_t next;
+#endif /* ETHARP_HASH_SIZE */
 };
 
 static struct etharp_entry arp_table[ARP_TABLE_SIZE];
 
+#if ETHARP_HASH_SIZE
+/* Links hold an entry index plus 1, so that the zero-initialized table
+   starts out with empty buckets and an empty free list. */
+/** First entry of each hash bucket, plus 1 */
+static u8_t etharp_hash[ETHARP_HASH_SIZE];
+/** First entry of the list of freed entries, plus 1 */
+static u8_t etharp_free;
+/** Number of entries ever taken, entries from here on were never used */
+static u8_t etharp_used;
+/** Last entry found by address, checked before the hash */
+static u8_t etharp_last;
+
+#define ETHARP_HASH(ipaddr) etharp_hash_addr(ip4_addr_get_u32(ipaddr))
+#endif /* ETHARP_HASH_SIZE */
+
 #if !LWIP_NETIF_HWADDRHINT
 static u8_t etharp_cached_entry;
 #endif /* !LWIP_NETIF_HWADDRHINT */
@@ -135,6 +154,9 @@ static err_t update_arp_entry(struct netif *netif, ip_addr_t *ipaddr, struct eth
 #if (LWIP_ARP && (ARP_TABLE_SIZE > 0x7f))
   #error "ARP_TABLE_SIZE must fit in an s8_t, you have to reduce it in your lwipopts.h"
 #endif
+#if (LWIP_ARP && ETHARP_HASH_SIZE && ((ETHARP_HASH_SIZE & (ETHARP_HASH_SIZE - 1)) != 0))
+  #error "ETHARP_HASH_SIZE must be a power of 2, you have to correct it in your lwipopts.h"
+#endif
 
 
 #if ARP_QUEUEING
@@ -164,10 +186,87 @@ free_etharp_q(struct etharp_q_entry *q)
 
 #endif /* ARP_QUEUEING */
 
+#if ETHARP_HASH_SIZE
+/** Hash an IP address (in network order) to a bucket. All address bytes are
+ * folded in, so hosts on one subnet spread over the buckets. */
+static u8_t
+etharp_hash_addr(u32_t addr)
+{
+  addr ^= addr >> 16;
+  addr ^= addr >> 8;
+  return (u8_t)(addr & (ETHARP_HASH_SIZE - 1));
+}
+
+/** Find the pending or stable entry for an IP address
+ *
+ * @param ipaddr IP address to find
+ * @return the entry index, or ARP_TABLE_SIZE if there is none
+ */
+static u8_t
+etharp_hash_find(ip_addr_t *ipaddr)
+{
+  u8_t i = etharp_last;
+
+  if ((arp_table[i].state != ETHARP_STATE_EMPTY) &&
+      ip_addr_cmp(ipaddr, &arp_table[i].ipaddr)) {
+    return i;
+  }
+  for (i = etharp_hash[ETHARP_HASH(ipaddr)]; i != 0; i = arp_table[i - 1].next) {
+    if ((arp_table[i - 1].state != ETHARP_STATE_EMPTY) &&
+        ip_addr_cmp(ipaddr, &arp_table[i - 1].ipaddr)) {
+      etharp_last = i - 1;
+      return i - 1;
+    }
+  }
+  return ARP_TABLE_SIZE;
+}
+
+/** Take an empty entry off the free list
+ *
+ * @return the entry index, or ARP_TABLE_SIZE if all entries are in use
+ */
+static u8_t
+etharp_take_free(void)
+{
+  u8_t i;
+
+  if (etharp_free != 0) {
+    i = etharp_free - 1;
+    etharp_free = arp_table[i].next;
+  } else if (etharp_used < ARP_TABLE_SIZE) {
+    i = etharp_used++;
+  } else {
+    return ARP_TABLE_SIZE;
+  }
+  arp_table[i].next = 0;
+  return i;
+}
+
+/** Remove an entry from its hash bucket and put it on the free list */
+static void
+etharp_hash_remove(u8_t i)
+{
+  u8_t *link = &etharp_hash[ETHARP_HASH(&arp_table[i].ipaddr)];
+
+  while (*link != 0) {
+    if (*link == i + 1) {
+      *link = arp_table[i].next;
+      break;
+    }
+    link = &arp_table[*link - 1].next;
+  }
+  arp_table[i].next = etharp_free;
+  etharp_free = i + 1;
+}
+#endif /* ETHARP_HASH_SIZE */
+
 /** Clean up ARP table entries */
 static void
 free_entry(int i)
 {
+#if ETHARP_HASH_SIZE
+  etharp_hash_remove((u8_t)i);
+#endif /* ETHARP_HASH_SIZE */
   /* remove from SNMP ARP index tree */
   snmp_delete_arpidx_tree(arp_table[i].netif, &arp_table[i].ipaddr);
   /* and empty packet queue */
@@ -264,6 +363,12 @@ find_entry(ip_addr_t *ipaddr, u8_t flags)
   s8_t old_queue = ARP_TABLE_SIZE;
   /* its age */
   u8_t age_queue = 0;
+#if ETHARP_HASH_SIZE
+  /* address to match in the search sweep, the hash has been searched */
+  ip_addr_t *match = NULL;
+#else /* ETHARP_HASH_SIZE */
+  ip_addr_t *match = ipaddr;
+#endif /* ETHARP_HASH_SIZE */
 
   /**
    * a) do a search through the cache, remember candidates
@@ -278,8 +383,25 @@ find_entry(ip_addr_t *ipaddr, u8_t flags)
    * 4) remember the oldest pending entry with queued packets (if any)
    * 5) search for a matching IP entry, either pending or stable
    *    until 5 matches, or all entries are searched for.
+   *
+   * With the hash, a matching entry is looked up there, and empty entries
+   * are taken from the free list. The sweep is only done to find an entry
+   * to recycle when the table is full.
    */
 
+#if ETHARP_HASH_SIZE
+  if (ipaddr != NULL) {
+    i = etharp_hash_find(ipaddr);
+    if (i < ARP_TABLE_SIZE) {
+      LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("find_entry: found matching entry %"U16_F"\n", (u16_t)i));
+      return i;
+    }
+  }
+  if ((flags & ETHARP_FLAG_FIND_ONLY) == 0) {
+    empty = etharp_take_free();
+  }
+  if ((empty == ARP_TABLE_SIZE) && ((flags & ETHARP_FLAG_TRY_HARD) != 0))
+#endif /* ETHARP_HASH_SIZE */
   for (i = 0; i < ARP_TABLE_SIZE; ++i) {
     u8_t state = arp_table[i].state;
     /* no empty entry found yet and now we do find one? */
@@ -291,7 +413,7 @@ find_entry(ip_addr_t *ipaddr, u8_t flags)
       LWIP_ASSERT("state == ETHARP_STATE_PENDING || state == ETHARP_STATE_STABLE",
         state == ETHARP_STATE_PENDING || state == ETHARP_STATE_STABLE);
       /* if given, does IP address match IP address in ARP entry? */
-      if (ipaddr && ip_addr_cmp(ipaddr, &arp_table[i].ipaddr)) {
+      if (match && ip_addr_cmp(match, &arp_table[i].ipaddr)) {
         LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("find_entry: found matching entry %"U16_F"\n", (u16_t)i));
         /* found exact IP address match, simply bail out */
         return i;
@@ -378,6 +500,10 @@ find_entry(ip_addr_t *ipaddr, u8_t flags)
     /* { empty or recyclable entry found } */
     LWIP_ASSERT("i < ARP_TABLE_SIZE", i < ARP_TABLE_SIZE);
     free_entry(i);
+#if ETHARP_HASH_SIZE
+    /* take it back off the free list */
+    i = etharp_take_free();
+#endif /* ETHARP_HASH_SIZE */
   }
 
   LWIP_ASSERT("i < ARP_TABLE_SIZE", i < ARP_TABLE_SIZE);
@@ -389,6 +515,14 @@ find_entry(ip_addr_t *ipaddr, u8_t flags)
     /* set IP address */
     ip_addr_copy(arp_table[i].ipaddr, *ipaddr);
   }
+#if ETHARP_HASH_SIZE
+  {
+    /* link it into the bucket of its address */
+    u8_t h = ETHARP_HASH(&arp_table[i].ipaddr);
+    arp_table[i].next = etharp_hash[h];
+    etharp_hash[h] = i + 1;
+  }
+#endif /* ETHARP_HASH_SIZE */
   arp_table[i].ctime = 0;
 #if ETHARP_SUPPORT_STATIC_ENTRIES
   arp_table[i].static_entry = 0;
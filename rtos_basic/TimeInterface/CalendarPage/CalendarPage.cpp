@@ -3,14 +3,52 @@
 #include "CalendarPage.h"
 
 
+// Day of week offsets for the 1st of each month, for Sakamoto's method,
+// which counts the year as if it started in March.
+static const uint8_t MonthOffset[] = { 0, 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+static const uint8_t DaysInMonth[] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+
 CalendarPage::CalendarPage(uint8_t Month, uint16_t Year) {
     month = Month;
     year = Year;
     verbose = false;
+    useCount = 0;
+    memset(cache, 0, sizeof(cache));
     Compute(month, year);
 }
 
 
+bool CalendarPage::FromCache(uint8_t Month, uint16_t Year) {
+    for (int i = 0; i < CALENDAR_CACHE_SIZE; i++) {
+        if (cache[i].month == Month && cache[i].year == Year) {
+            cache[i].used = ++useCount;
+            firstday = cache[i].firstday;
+            memcpy(DayMap, cache[i].DayMap, sizeof(DayMap));
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// Replace the least recently used entry, which is an unused
+// entry if there are any.
+void CalendarPage::ToCache(void) {
+    CachedPage_t * lru = &cache[0];
+
+    for (int i = 1; i < CALENDAR_CACHE_SIZE; i++) {
+        if (cache[i].used < lru->used)
+            lru = &cache[i];
+    }
+    lru->month = month;
+    lru->year = year;
+    lru->firstday = firstday;
+    lru->used = ++useCount;
+    memcpy(lru->DayMap, DayMap, sizeof(DayMap));
+}
+
+
 // 37 Elements with Array index 0 to 36,
 //    populated with 0 or the day number 
 //
@@ -22,61 +60,47 @@ CalendarPage::CalendarPage(uint8_t Month, uint16_t Year) {
 // 35 36                    |    30 31
 //
 void CalendarPage::Compute(uint8_t Month, uint16_t Year) {
-    const int DaysInMonth[] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
     const char * MonthName[] = { "", "January", "February", "March", "April", "May", "June",
         "July", "August", "September", "October", "November", "December" };
     const char * DayName[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
     int NumberOfDaysInMonth;
-    int FirstDayOfMonth = 0;
-    int DayOfWeekCounter = 0;
-    int DateCounter = 1;
-    int index = 0;
-    int day = 1;
+    int DateCounter;
 
     month = Month;
     year = Year;
-    int y = year - (14 - month) / 12;
-    int m = month + 12 * ((14 - month) / 12) - 2;
+    if (!verbose && FromCache(month, year))
+        return;
 
-    firstday = (day + y + y / 4 - y / 100 + y / 400 + (31 * m / 12)) % 7;
+    int y = year - (month < 3);
+    firstday = (y + y / 4 - y / 100 + y / 400 + MonthOffset[month] + 1) % 7;
     if ( (month == 2) && (year % 400 == 0 || (year % 4 == 0 && year % 100 != 0)) ) {
         NumberOfDaysInMonth = 29;
     } else {
         NumberOfDaysInMonth = DaysInMonth[month];
     }
 
+    memset(DayMap, 0, sizeof(DayMap));
+    for (DateCounter = 1; DateCounter <= NumberOfDaysInMonth; ++DateCounter) {
+        DayMap[firstday + DateCounter - 1] = DateCounter;
+    }
+
     if (verbose) {
+        int last = firstday + NumberOfDaysInMonth - 1;
+
         printf("%20s %d\r\n", MonthName[month], year);
         for (int d = 0; d < 7; d++) {
             printf("%4s", DayName[d]);
         }
         printf("\r\n");
-    }
-
-    memset(DayMap, 0, sizeof(DayMap));
-    for (FirstDayOfMonth = 0; FirstDayOfMonth < firstday; ++FirstDayOfMonth) {
-        if (verbose)
-            printf("%4s", "");
-        DayMap[index++] = 0;
-    }
-
-    int tempfirstday = firstday;
-    DateCounter = 1;
-    DayOfWeekCounter = tempfirstday;
-    //This loop represents the date display and will continue to run until
-    //the number of days in that month have been reached
-    for (DateCounter = 1; DateCounter <= NumberOfDaysInMonth; ++DateCounter) {
-        DayMap[index++] = DateCounter;
-        if (verbose)
-            printf("%4d", DateCounter);
-        ++DayOfWeekCounter;
-        if (DayOfWeekCounter > 6 && DateCounter != NumberOfDaysInMonth) {
-            if (verbose) 
+        for (int i = 0; i <= last; i++) {
+            if (DayMap[i] == 0)
+                printf("%4s", "");
+            else
+                printf("%4d", DayMap[i]);
+            if (i % 7 == 6 && i != last)
                 printf("\r\n");
-            DayOfWeekCounter = 0;
         }
-    }
-    if (verbose)
         printf("\r\n");
-    tempfirstday = DayOfWeekCounter + 1;
+    }
+    ToCache();
 }
@@ -6,6 +6,7 @@
 #include <mbed.h>
 
 #define CALENDAR_DATA_MAP_SIZE 37
+#define CALENDAR_CACHE_SIZE 4       // recently computed pages kept for reuse
 /// Creates a calendar for a specified Month and Year
 ///
 /// This class is a simple CalendarPage creator. For a specified
@@ -17,6 +18,9 @@
 /// samples, none of which had any evidence of a coyright 
 /// statement.
 ///
+/// The most recently computed pages are cached, so that paging
+/// back and forth between months does not recompute them.
+///
 /// @code 
 /// CalendarPage c;
 /// c.Compute(3, 2018);
@@ -81,6 +85,26 @@ public:
     ///
     void Compute(uint8_t Month, uint16_t Year);
 
+    /// Get the day of the week of the 1st of the month.
+    ///
+    /// @returns 0 = Sunday, ... 6 = Saturday.
+    ///
+    int FirstDay() {
+        return firstday;
+    }
+
+    /// Get the month of the computed page; e.g. 1 = January, ...
+    ///
+    uint8_t Month() {
+        return month;
+    }
+
+    /// Get the year of the computed page; e.g. 2018
+    ///
+    uint16_t Year() {
+        return year;
+    }
+
     /// The CalendarPage information, expressed as an accessible array.
     ///
     /// - There are DayMapEntries() in the Array index 0 to n-1.
@@ -106,10 +130,23 @@ public:
         return CALENDAR_DATA_MAP_SIZE;
     }
 private:
+    typedef struct {
+        uint8_t month;          // 0 when the entry is unused
+        uint16_t year;
+        uint8_t firstday;
+        uint32_t used;          // Compute count when last used
+        uint8_t DayMap[CALENDAR_DATA_MAP_SIZE];
+    } CachedPage_t;
+
+    bool FromCache(uint8_t Month, uint16_t Year);
+    void ToCache(void);
+
     int firstday;
     uint8_t month;
     uint16_t year;
     bool verbose;
+    CachedPage_t cache[CALENDAR_CACHE_SIZE];
+    uint32_t useCount;
 };
 
 
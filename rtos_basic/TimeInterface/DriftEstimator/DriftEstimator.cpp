@@ -0,0 +1,183 @@
+
+#include "DriftEstimator.h"
+#include <math.h>
+
+// Battery backed register usage:
+// GPREG2: 32 bits
+//      time_t value of the newest sample, zero when there is no fit
+// GPREG3: 32 bits
+//      span of the history up to the newest sample, in seconds
+// GPREG4: 32 bits
+//      fitted error in units of 0.001 ppm (signed)
+//
+// The fit is kept rather than the samples: three registers cannot hold
+// two samples at full precision, and rounding their times to a quarter
+// hour put the restored estimate out by as much as 2%.
+#define PPM_UNIT 1000
+#define PPM_MAX  1000   // well beyond any watch crystal
+
+#define CAL_MAX 131071
+
+
+DriftEstimator::DriftEstimator()
+{
+    first = 0;
+    num = 0;
+    epoch = 0;
+    ppm = 0.0f;
+    cal = 0;
+    fitted = false;
+    restore();
+}
+
+void DriftEstimator::reset(void)
+{
+    first = 0;
+    num = 0;
+    epoch = 0;
+    fitted = false;
+    save();
+}
+
+void DriftEstimator::restore(void)
+{
+    time_t newest = LPC_RTC->GPREG2;
+    int32_t span = LPC_RTC->GPREG3;
+    int32_t kept = LPC_RTC->GPREG4;
+    time_t now = time(NULL);
+    double x;
+
+    // The registers hold junk after the battery is first connected, so
+    // only accept a fit that ends in the past, of a plausible error.
+    if (newest == 0 || newest > now || span < DRIFT_MIN_SPAN || (time_t)span > newest
+    || kept > PPM_MAX * PPM_UNIT || kept < -PPM_MAX * PPM_UNIT)
+        return;
+    x = -(double)kept / PPM_UNIT * span;
+    if (x > INT32_MAX || x < INT32_MIN)
+        return;
+    // Two samples on the fitted line, which the next ones refine
+    epoch = newest - span;
+    hist[0].t = 0;
+    hist[0].x = 0;
+    hist[1].t = span;
+    hist[1].x = (int32_t)x;
+    num = 2;
+    fit();
+}
+
+void DriftEstimator::save(void)
+{
+    if (fitted) {
+        LPC_RTC->GPREG3 = at(num - 1)->t;
+        LPC_RTC->GPREG4 = (int32_t)floor(ppm * PPM_UNIT + 0.5f);
+        LPC_RTC->GPREG2 = epoch + at(num - 1)->t;
+    } else {
+        LPC_RTC->GPREG2 = 0;
+    }
+}
+
+bool DriftEstimator::add_sample(time_t tref, int32_t offset_us, int32_t curCal)
+{
+    sample_t s;
+    sample_t * last;
+
+    if (offset_us >= DRIFT_MAX_OFFSET * 1000000 || offset_us <= -DRIFT_MAX_OFFSET * 1000000) {
+        // The clock was set, not tuned; start over from here
+        first = 0;
+        num = 0;
+        fitted = false;
+    }
+    if (num == 0) {
+        epoch = tref;
+        hist[0].t = 0;
+        hist[0].x = 0;
+        num = 1;
+        save();
+        return false;
+    }
+    last = at(num - 1);
+    s.t = tref - epoch;
+    if (s.t <= last->t)
+        return false;
+    // Undo what the calibration did over the interval, which added (or
+    // removed) a second every |cal| seconds, to get the raw error.
+    s.x = last->x + offset_us;
+    if (curCal) {
+        int32_t dt = s.t - last->t;
+        int32_t step = (curCal > 0) ? 1000000 : -1000000;
+        int32_t n = dt / (curCal > 0 ? curCal : -curCal);
+
+        if (fitted) {
+            // The count of whole second steps is n or n + 1, depending on
+            // where the calibration counter stood; take the one that
+            // agrees with the drift fitted so far. The fit is well within
+            // half a second over the interval once it has two samples.
+            float expect = -ppm * dt;
+            float x0 = (float)offset_us + (float)n * step;
+            if (fabsf(x0 + step - expect) < fabsf(x0 - expect))
+                n++;
+            s.x += n * step;
+        } else {
+            // Spread the steps over the interval, within a second
+            s.x += (int32_t)((int64_t)dt * 1000000 / curCal);
+        }
+    }
+
+    if (num == DRIFT_HISTORY_SIZE) {
+        first = (first + 1) % DRIFT_HISTORY_SIZE;
+        num--;
+    }
+    *at(num++) = s;
+
+    // Rebase on the oldest sample, which keeps the values small
+    sample_t base = *at(0);
+    for (int i = 0; i < num; i++) {
+        at(i)->t -= base.t;
+        at(i)->x -= base.x;
+    }
+    epoch += base.t;
+
+    if (at(num - 1)->t < DRIFT_MIN_SPAN)
+        return false;
+    fit();
+    save();
+    return true;
+}
+
+void DriftEstimator::fit(void)
+{
+    // Least-squares slope of x over t, in usec per sec
+    double tm = 0, xm = 0, stt = 0, stx = 0;
+    for (int i = 0; i < num; i++) {
+        tm += at(i)->t;
+        xm += at(i)->x;
+    }
+    tm /= num;
+    xm /= num;
+    for (int i = 0; i < num; i++) {
+        double dt = at(i)->t - tm;
+        stt += dt * dt;
+        stx += dt * (at(i)->x - xm);
+    }
+    double slope = stx / stt;
+
+    // The raw offset grows as the clock loses time, so the clock runs
+    // fast by -slope, and needs a calibration rate of +slope.
+    ppm = (float)-slope;
+    fitted = true;
+    if (slope > 1000000.0 / CAL_MAX || slope < -1000000.0 / CAL_MAX) {
+        cal = (int32_t)(1000000.0 / slope + (slope > 0 ? 0.5 : -0.5));
+    } else {
+        cal = 0;    // below the resolution of the calibration register
+    }
+}
+
+int32_t DriftEstimator::get_cal(void)
+{
+    return cal;
+}
+
+float DriftEstimator::get_ppm(void)
+{
+    return ppm;
+}
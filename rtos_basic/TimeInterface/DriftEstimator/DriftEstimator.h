@@ -0,0 +1,99 @@
+
+#ifndef DRIFTESTIMATOR_H
+#define DRIFTESTIMATOR_H
+
+#include <mbed.h>
+
+#define DRIFT_HISTORY_SIZE 8        // samples kept for the fit
+#define DRIFT_MIN_SPAN     3600     // seconds of history needed before fitting
+#define DRIFT_MAX_OFFSET   60       // larger offsets mean the clock was set, not drifting
+
+/// Learns the frequency error of the RTC oscillator from successive
+/// NTP offsets, and computes the RTC calibration value to correct it.
+///
+/// Each sample is the offset (reference less local) measured at a sync.
+/// Since the clock is corrected at every sync, and the calibration may
+/// have been running in between, each offset is first turned back into
+/// the raw, uncalibrated, error of the oscillator. A least-squares line
+/// through the accumulated raw error then gives the frequency error,
+/// and from that the calibration value. The calibration is refined on
+/// every sync, so it converges as the history grows.
+///
+/// The fitted error, the time of the newest sample and the span of the
+/// history are kept in the battery backed registers GPREG2 to GPREG4, so
+/// that the estimator resumes after a reset from the same fit, which the
+/// following samples go on to refine.
+///
+/// @code
+/// DriftEstimator drift;
+/// ...
+///     // after each successful NTP sync
+///     if (drift.add_sample(time(NULL), offset_us, get_cal()))
+///         set_cal(drift.get_cal());
+/// @endcode
+///
+class DriftEstimator {
+public:
+    /// Constructor, which restores any history kept in the
+    /// battery backed registers.
+    ///
+    DriftEstimator();
+
+    /// Discard the history, as when the clock was set by hand.
+    ///
+    void reset(void);
+
+    /// Add a sample from a sync with a reference clock.
+    ///
+    /// @param[in] tref is the reference time of the sync.
+    /// @param[in] offset_us is the measured offset, the reference time
+    ///     less the local time, in microseconds.
+    /// @param[in] cal is the calibration value that was in effect since
+    ///     the previous sample, as read by TimeInterface::get_cal().
+    /// @returns true if a new calibration value was computed.
+    ///
+    bool add_sample(time_t tref, int32_t offset_us, int32_t cal);
+
+    /// Get the calibration value computed from the history.
+    ///
+    /// @returns calibration setting ranging from -131071 to +131071,
+    ///     or zero when the error is too small to calibrate.
+    ///
+    int32_t get_cal(void);
+
+    /// Get the oscillator frequency error computed from the history.
+    ///
+    /// @returns the error in parts per million; positive when the
+    ///     uncalibrated clock runs fast.
+    ///
+    float get_ppm(void);
+
+    /// Get the number of samples in the history.
+    ///
+    int count(void) {
+        return num;
+    }
+
+private:
+    typedef struct {
+        int32_t t;      // seconds since the epoch
+        int32_t x;      // accumulated raw offset in microseconds
+    } sample_t;
+
+    void restore(void);
+    void save(void);
+    void fit(void);
+    sample_t * at(int i) {
+        return &hist[(first + i) % DRIFT_HISTORY_SIZE];
+    }
+
+    sample_t hist[DRIFT_HISTORY_SIZE];
+    int first;
+    int num;
+    time_t epoch;
+    float ppm;
+    int32_t cal;
+    bool fitted;    // ppm holds a fit of the current history
+};
+
+#endif // DRIFTESTIMATOR_H
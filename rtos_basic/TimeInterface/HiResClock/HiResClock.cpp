@@ -0,0 +1,138 @@
+
+#include "HiResClock.h"
+
+#include "rtc_api.h"
+#include "us_ticker_api.h"
+#include "critical.h"
+
+#define NS_PER_SEC  1000000000LL
+#define NS_PER_US   1000
+#define US_PER_SEC  1000000
+
+#define SLEW_MAX_NS 500000          // the most that is corrected in one second
+#define STEP_MIN_NS 128000000       // errors at least this large are stepped
+
+// The anchor is the clock value at the last RTC second edge. It is written
+// with interrupts disabled, and readers retry if the sequence count changed
+// while they were reading it.
+static volatile uint32_t seq;       // odd while the anchor is being written
+static int64_t  base_ns;            // clock value at the last second edge
+static uint32_t base_us;            // us_ticker value at the last second edge
+static int32_t  slew_ns;            // correction spread over this second
+static int32_t  slew_q20;           // slew_ns per usec, scaled by 2^20
+static int32_t  phase_ns;           // true time of the edge less the RTC seconds
+static bool     started;
+
+
+static void set_anchor(int64_t ns, uint32_t us, int32_t slew)
+{
+    seq++;
+    __DMB();
+    base_ns  = ns;
+    base_us  = us;
+    slew_ns  = slew;
+    slew_q20 = (int32_t)(((int64_t)slew << 20) / US_PER_SEC);
+    __DMB();
+    seq++;
+}
+
+void HiResClock::start(void)
+{
+    core_util_critical_section_enter();
+    if (!started) {
+        rtc_init();
+        set_anchor((int64_t)rtc_read() * NS_PER_SEC, us_ticker_read(), 0);
+        NVIC_SetVector(RTC_IRQn, (uint32_t)&HiResClock::rtc_isr);
+        LPC_RTC->ILR  = 0x01;       // clear a stale counter increment flag
+        LPC_RTC->CIIR = 0x01;       // interrupt on each increment of seconds
+        NVIC_EnableIRQ(RTC_IRQn);
+        started = true;
+    }
+    core_util_critical_section_exit();
+}
+
+uint64_t HiResClock::now_ns(void)
+{
+    uint32_t s;
+    int64_t ns;
+    int32_t q20;
+    uint32_t elapsed;
+
+    do {
+        s = seq;
+        __DMB();
+        ns = base_ns;
+        q20 = slew_q20;
+        elapsed = us_ticker_read() - base_us;
+        __DMB();
+    } while ((s & 1) || s != seq);
+
+    // Hold just short of the next edge if its interrupt is late, so the
+    // value cannot overtake the anchor that the isr will set.
+    if (elapsed >= US_PER_SEC)
+        elapsed = US_PER_SEC - 1;
+    ns += (int64_t)elapsed * NS_PER_US + (((int64_t)elapsed * q20) >> 20);
+    return (uint64_t)ns;
+}
+
+void HiResClock::rtc_isr(void)
+{
+    uint32_t us = us_ticker_read();
+    int64_t edge;
+    int64_t next;
+    int64_t err;
+    int32_t slew;
+
+    LPC_RTC->ILR = 0x01;
+    edge = (int64_t)rtc_read() * NS_PER_SEC + phase_ns;
+    next = base_ns + NS_PER_SEC + slew_ns;
+    err = edge - next;
+    if (err >= STEP_MIN_NS || err <= -STEP_MIN_NS) {
+        // The RTC was set, so take it as it is
+        next = edge;
+        slew = 0;
+    } else if (err > SLEW_MAX_NS) {
+        slew = SLEW_MAX_NS;
+    } else if (err < -SLEW_MAX_NS) {
+        slew = -SLEW_MAX_NS;
+    } else {
+        slew = (int32_t)err;
+    }
+    // A higher priority isr reading the clock would spin on an odd count
+    core_util_critical_section_enter();
+    set_anchor(next, us, slew);
+    core_util_critical_section_exit();
+}
+
+void HiResClock::adjust_ns(int64_t offset_ns)
+{
+    int64_t phase;
+    int32_t whole;
+
+    core_util_critical_section_enter();
+    phase = phase_ns + offset_ns;
+    whole = (int32_t)(phase / NS_PER_SEC);
+    if (whole) {
+        rtc_write(rtc_read() + whole);
+        phase -= (int64_t)whole * NS_PER_SEC;
+    }
+    phase_ns = (int32_t)phase;
+    if (offset_ns >= STEP_MIN_NS || offset_ns <= -STEP_MIN_NS) {
+        // Too far off to slew, so present the new time immediately
+        set_anchor(base_ns + offset_ns, base_us, slew_ns);
+    }
+    core_util_critical_section_exit();
+}
+
+void HiResClock::resync(void)
+{
+    core_util_critical_section_enter();
+    phase_ns = 0;
+    set_anchor((int64_t)rtc_read() * NS_PER_SEC, us_ticker_read(), 0);
+    core_util_critical_section_exit();
+}
+
+int32_t HiResClock::get_phase_ns(void)
+{
+    return phase_ns;
+}
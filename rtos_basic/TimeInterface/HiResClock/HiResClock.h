@@ -0,0 +1,75 @@
+
+#ifndef HIRESCLOCK_H
+#define HIRESCLOCK_H
+
+#include <mbed.h>
+
+/// A 64-bit nanosecond clock layered over the LPC1768 RTC.
+///
+/// The RTC only counts whole seconds. This class interpolates between
+/// the RTC second edges with the free-running microsecond ticker, so the
+/// time can be read with sub-second resolution. At every RTC second edge
+/// the interpolation is re-anchored, and any remaining error against the
+/// RTC (plus the sub-second phase learned from NTP) is slewed out at no
+/// more than 500 usec per second. The returned value therefore never
+/// runs backwards, except when the clock is stepped by setting the time.
+///
+/// The read path is lock-free: now_ns() does not disable interrupts or
+/// take a mutex, so it may be used from threads and from ISRs alike.
+///
+/// @note This class uses the RTC counter increment interrupt.
+///
+/// @code
+/// HiResClock::start();
+/// ...
+///     uint64_t t0 = HiResClock::now_ns();
+///     // do something short
+///     uint64_t t1 = HiResClock::now_ns();
+///     printf("Elapsed time is %u nsec\r\n", (uint32_t)(t1 - t0));
+/// @endcode
+///
+class HiResClock {
+public:
+    /// Start the clock, if it is not already running.
+    ///
+    /// This initializes the RTC if needed, and hooks the RTC second
+    /// interrupt. It may be called more than once.
+    ///
+    static void start(void);
+
+    /// Get the current time in nanoseconds since Jan 1 1970 UTC.
+    ///
+    /// @returns the time in nanoseconds.
+    ///
+    static uint64_t now_ns(void);
+
+    /// Apply a measured offset to the clock.
+    ///
+    /// The offset is the reference time minus the local time, as computed
+    /// from an NTP exchange. Whole seconds are written into the RTC, and
+    /// the remainder is retained as the phase of the RTC second edge.
+    /// Small offsets are slewed, large ones are stepped immediately.
+    ///
+    /// @param[in] offset_ns is the signed offset in nanoseconds.
+    ///
+    static void adjust_ns(int64_t offset_ns);
+
+    /// Resynchronize after the RTC was written by other means.
+    ///
+    /// This discards the sub-second phase, and reanchors the clock to
+    /// the RTC seconds value.
+    ///
+    static void resync(void);
+
+    /// Get the sub-second phase of the RTC second edge.
+    ///
+    /// @returns the phase in nanoseconds, which is the true time of the
+    ///     RTC second edge minus the RTC seconds value.
+    ///
+    static int32_t get_phase_ns(void);
+
+private:
+    static void rtc_isr(void);
+};
+
+#endif // HIRESCLOCK_H
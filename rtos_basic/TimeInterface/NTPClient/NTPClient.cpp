@@ -22,6 +22,7 @@
 #include "UDPSocket.h"
 #include "Socket.h"
 #include "NTPClient.h"
+#include "HiResClock.h"
 
 
 //#define DEBUG "NTPc"
@@ -76,6 +77,26 @@ static void HexDump(const char * title, void * pT, int count)
 NTPClient::NTPClient(EthernetInterface * _net) : m_sock()
 {
     net = _net;
+    m_offset_ns = 0;
+    m_delay_ns = 0;
+    m_delayValid = false;
+    m_listening = false;
+    m_bcastCount = 0;
+    HiResClock::start();
+}
+
+// Convert a unix time in nanoseconds to an NTP timestamp, in host order
+void NTPClient::ns_to_ntp(uint64_t ns, uint32_t * sec, uint32_t * frac)
+{
+    *sec = (uint32_t)(ns / 1000000000ULL + NTP_TIMESTAMP_DELTA);
+    *frac = (uint32_t)(((ns % 1000000000ULL) << 32) / 1000000000ULL);
+}
+
+// Convert an NTP timestamp, in host order, to a unix time in nanoseconds
+int64_t NTPClient::ntp_to_ns(uint32_t sec, uint32_t frac)
+{
+    return ((int64_t)sec - (int64_t)NTP_TIMESTAMP_DELTA) * 1000000000LL
+        + (int64_t)(((uint64_t)frac * 1000000000ULL) >> 32);
 }
 
 
@@ -227,7 +248,7 @@ NTPResult NTPClient::setTime(const char* host, uint16_t port, uint32_t timeout)
     m_sock.bind(0); //Bind to a random port
     m_sock.set_blocking(false, timeout); //Set not blocking
 
-    time_t tQueryTime = time(NULL);
+    uint64_t tQueryTime = HiResClock::now_ns();
     //
     //Prepare NTP Packet for the query:
     //
@@ -243,10 +264,11 @@ NTPResult NTPClient::setTime(const char* host, uint16_t port, uint32_t timeout)
     pkt.refTm_s = 0;
     pkt.origTm_s = 0;
     pkt.rxTm_s = 0;
-    pkt.txTm_s = NTP_TIMESTAMP_DELTA + tQueryTime; //WARN: We are in LE format, network byte order is BE
-    pkt.refTm_f = pkt.origTm_f = pkt.rxTm_f = pkt.txTm_f = 0;
+    pkt.refTm_f = pkt.origTm_f = pkt.rxTm_f = 0;
+    ns_to_ntp(tQueryTime, &pkt.txTm_s, &pkt.txTm_f); //WARN: We are in LE format, network byte order is BE
     HexDump("NTP Post", (uint8_t *)&pkt, sizeof(NTPPacket));
     pkt.txTm_s = htonl(pkt.txTm_s);
+    pkt.txTm_f = htonl(pkt.txTm_f);
 
     // Contact the server
     // UDPSocket sock;
@@ -269,9 +291,11 @@ NTPResult NTPClient::setTime(const char* host, uint16_t port, uint32_t timeout)
     inEndpoint.set_address(nist.get_address(), 0);
     INFO(" inEndpoint instantiated: %s.", inEndpoint.get_address());
 
+    uint64_t tDestTime;
     int loopLimit = 20;  // semi-randomly selected so it doesn't hang forever here...
     do {
         ret = m_sock.receiveFrom( inEndpoint, (char*)&pkt, sizeof(NTPPacket) );
+        tDestTime = HiResClock::now_ns();
         if(ret < 0) {
             ERR("Could not receive packet, err: %d", ret);
             m_sock.close();
@@ -306,14 +330,15 @@ NTPResult NTPClient::setTime(const char* host, uint16_t port, uint32_t timeout)
     pkt.txTm_f = ntohl( pkt.txTm_f );
 
     //Compute offset, see RFC 4330 p.13
-    uint32_t destTm_s = (NTP_TIMESTAMP_DELTA + time(NULL));
-
-    // Modification by David Smart
-    // The setTime function was computing the offset incorrectly as the value was promoted to 64-bit.
-    // The side effect was that a negative offset ended up as a very large positive (e.g. jump from 
-    // 2016 to 2084). This change revises that computation.
-    int64_t offset = (((int64_t)pkt.rxTm_s - pkt.origTm_s) + ((int64_t)pkt.txTm_s - destTm_s)) / 2; //Avoid overflow
-    set_time(time(NULL) + offset);
+    //The fractions are kept, so the offset is carried in nanoseconds and
+    //the sub-second part is applied to the high resolution clock.
+    int64_t offset = ((ntp_to_ns(pkt.rxTm_s, pkt.rxTm_f) - (int64_t)tQueryTime)
+                    + (ntp_to_ns(pkt.txTm_s, pkt.txTm_f) - (int64_t)tDestTime)) / 2;
+    HiResClock::adjust_ns(offset);
+    m_offset_ns = offset;
+    m_delay_ns = (((int64_t)tDestTime - (int64_t)tQueryTime)
+                - (ntp_to_ns(pkt.txTm_s, pkt.txTm_f) - ntp_to_ns(pkt.rxTm_s, pkt.rxTm_f))) / 2;
+    m_delayValid = true;
 
     #ifdef DEBUG
     const char *ModeList[] = {
@@ -334,7 +359,9 @@ NTPResult NTPClient::setTime(const char* host, uint16_t port, uint32_t timeout)
     INFO("  pkt.rxTm_s         %08X, %u, time rcvd at server", pkt.rxTm_s, pkt.rxTm_s);
     INFO("  pkt.txTm_s         %08X, %u, time sent from server", pkt.txTm_s, pkt.txTm_s);
     INFO("  pkt.refTm_f        %08X, %u, fraction", pkt.refTm_f, pkt.refTm_f);
-    INFO("  offset             %08X, %u", destTm_s, destTm_s);
+    INFO("  pkt.rxTm_f         %08X, %u, fraction", pkt.rxTm_f, pkt.rxTm_f);
+    INFO("  pkt.txTm_f         %08X, %u, fraction", pkt.txTm_f, pkt.txTm_f);
+    INFO("  offset             %d usec", (int32_t)(offset / 1000));
     #endif
 
     m_sock.close();
@@ -348,3 +375,59 @@ NTPResult NTPClient::setTime(const char* host, uint16_t port, uint32_t timeout)
     return NTP_OK;
 }
 
+
+
+NTPResult NTPClient::listen(uint32_t timeout, const char * group)
+{
+    struct NTPPacket pkt;
+    Endpoint server;
+
+    if (!m_listening) {
+        INFO("Binding broadcast socket");
+        if (m_bsock.bind(NTP_PORT) < 0) {
+            ERR("Could not bind port %d", NTP_PORT);
+            return NTP_CONN;
+        }
+        if (group && m_bsock.join_multicast_group(group) < 0) {
+            ERR("Could not join %s", group);
+            m_bsock.close();
+            return NTP_CONN;
+        }
+        m_listening = true;
+    }
+    m_bsock.set_blocking(false, timeout);
+
+    int ret = m_bsock.receiveFrom(server, (char*)&pkt, sizeof(NTPPacket));
+    uint64_t tDestTime = HiResClock::now_ns();
+    if (ret == 0) {
+        return NTP_TIMEOUT;
+    }
+    if (ret < 0) {
+        ERR("Could not receive packet, err: %d", ret);
+        m_bsock.close();
+        m_listening = false;
+        return NTP_CONN;
+    }
+    if (ret < (int)sizeof(NTPPacket) || pkt.mode != 5 || pkt.stratum == 0) {
+        ERR("Not a broadcast packet, rcvd %d, mode %d", ret, pkt.mode);
+        return NTP_PRTCL;
+    }
+    HexDump("NTP Bcast", (uint8_t *)&pkt, sizeof(NTPPacket));
+
+    if (!m_delayValid || m_bcastCount >= NTP_BCAST_RECALIBRATE) {
+        // A broadcast carries only the server transmit time, so the path
+        // delay is measured with a regular exchange to the same server.
+        INFO("Calibrating delay to %s", server.get_address());
+        m_bcastCount = 0;
+        return setTime(server.get_address(), NTP_PORT, timeout);
+    }
+    m_bcastCount++;
+
+    pkt.txTm_s = ntohl( pkt.txTm_s );
+    pkt.txTm_f = ntohl( pkt.txTm_f );
+    int64_t offset = ntp_to_ns(pkt.txTm_s, pkt.txTm_f) + m_delay_ns - (int64_t)tDestTime;
+    HiResClock::adjust_ns(offset);
+    m_offset_ns = offset;
+    INFO("  bcast offset %d usec, delay %d usec", (int32_t)(offset / 1000), (int32_t)(m_delay_ns / 1000));
+    return NTP_OK;
+}
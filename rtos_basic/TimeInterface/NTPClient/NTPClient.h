@@ -30,12 +30,16 @@ NTP Client header file
 using std::uint8_t;
 using std::uint16_t;
 using std::uint32_t;
+using std::int64_t;
+using std::uint64_t;
 
 #include "EthernetInterface.h"
 #include "UDPSocket.h"
 
 #define NTP_DEFAULT_PORT 123
 #define NTP_DEFAULT_TIMEOUT 4000
+#define NTP_MULTICAST_GROUP "224.0.1.1"     ///< IANA assigned NTP multicast group
+#define NTP_BCAST_RECALIBRATE 64            ///< broadcasts between unicast delay calibrations
 
 ///NTP client results
 enum NTPResult {
@@ -68,8 +72,41 @@ public:
     */
     NTPResult setTime(const char* host, uint16_t port = NTP_DEFAULT_PORT, uint32_t timeout = NTP_DEFAULT_TIMEOUT); //Blocking
 
+    /**Get the offset applied by the last successful setTime
+    @return the server time less the local time, in nanoseconds
+    */
+    int64_t getOffset_ns() { return m_offset_ns; }
+
+    /**Get current time from a broadcast server (blocking)
+    Listen passively for an NTP broadcast or multicast packet, and update the time from it
+    The first call binds the NTP port and joins the multicast group.
+    The one-way delay is measured with a unicast exchange to the broadcast server, on the
+    first packet and then once every NTP_BCAST_RECALIBRATE packets.
+    Blocks until a packet is received, or the timeout
+    @param[in] timeout waiting timeout in ms
+    @param[in] group multicast group to join; NULL to listen for broadcasts only
+    @return 0 on success, NTP error code (<0) on failure
+    */
+    NTPResult listen(uint32_t timeout = NTP_DEFAULT_TIMEOUT, const char * group = NTP_MULTICAST_GROUP); //Blocking
+
+    /**Get the one-way delay measured by the last successful setTime
+    @return the delay in nanoseconds
+    */
+    int64_t getDelay_ns() { return m_delay_ns; }
+
 private:
     EthernetInterface * net;
+    int64_t m_offset_ns;
+    int64_t m_delay_ns;
+    bool m_delayValid;
+    bool m_listening;
+    int m_bcastCount;
+
+    /// Convert a unix time in nanoseconds to an NTP timestamp
+    static void ns_to_ntp(uint64_t ns, uint32_t * sec, uint32_t * frac);
+
+    /// Convert an NTP timestamp to a unix time in nanoseconds
+    static int64_t ntp_to_ns(uint32_t sec, uint32_t frac);
     
     /// The NTP Packet, as defined in RFC 4330 for Simple NTP
     ///
@@ -206,6 +243,7 @@ private:
     } __attribute__ ((packed));
 
     UDPSocket m_sock;
+    UDPSocket m_bsock;  // bound to the NTP port for listen
 };
 
 
@@ -31,11 +31,13 @@ struct LPC * LPC_RTC = &X;
 #endif
 
 
-TimeInterface::TimeInterface(EthernetInterface *net)
+TimeInterface::TimeInterface(EthernetInterface *net) : m_bcast(net)
 {
     m_net = net;
+    ntpThreadStarted = false;
     dst = false;
     memset(&dst_pair, 0, sizeof(dst_pair));  // that's enough to keep it from running
+    HiResClock::start();
 }
 
 TimeInterface::~TimeInterface()
@@ -53,11 +55,7 @@ NTPResult TimeInterface::setTime(const char* host, uint16_t port, uint32_t timeo
         res = ntp.setTime(host, port, timeout);
         INFO("  ret: %d\r\n", res);
         if (res == NTP_OK) {
-            // if the time was fetched successfully, then
-            // let's save the time last set with the local tzo applied
-            // and this saves the last time set for later precision
-            // tuning.
-            set_time(std::time(NULL));
+            synced(ntp.getOffset_ns());
         }
     } else {
         ERR("No connection");
@@ -66,6 +64,106 @@ NTPResult TimeInterface::setTime(const char* host, uint16_t port, uint32_t timeo
     return res;
 }
 
+NTPResult TimeInterface::listenTime(uint32_t timeout)
+{
+    NTPResult res;
+
+    if (m_net) {
+        res = m_bcast.listen(timeout);
+        INFO("listenTime ret: %d", res);
+        if (res == NTP_OK) {
+            synced(m_bcast.getOffset_ns());
+        }
+    } else {
+        ERR("No connection");
+        res = NTP_CONN;
+    }
+    return res;
+}
+
+void TimeInterface::synced(int64_t offset_ns)
+{
+    // learn the drift from the offset, and refine the calibration
+    int64_t offset_us = offset_ns / 1000;
+    if (offset_us > 0x7FFFFFFF)
+        offset_us = 0x7FFFFFFF;
+    else if (offset_us < -0x7FFFFFFF)
+        offset_us = -0x7FFFFFFF;
+    if (drift.add_sample(std::time(NULL), (int32_t)offset_us, get_cal())) {
+        INFO("drift %d ppb, cal %d", (int)(drift.get_ppm() * 1000), drift.get_cal());
+        set_cal(drift.get_cal());
+    }
+    // if the time was fetched successfully, then
+    // let's save the time last set for later precision
+    // tuning. The RTC itself is not rewritten, as that would
+    // lose the sub-second phase NTPClient just computed.
+    LPC_RTC->GPREG1 = std::time(NULL);
+}
+
+NTPResult TimeInterface::setTimeAsync(const char* host, uint16_t port, uint32_t timeout)
+{
+    ntp_async_request_t * req;
+
+    if (!m_net) {
+        ERR("No connection");
+        return NTP_CONN;
+    }
+    if (!ntpThreadStarted) {
+        if (ntpThread.start(callback(this, &TimeInterface::ntp_thread)) != osOK) {
+            ERR("Could not start the NTP thread");
+            return NTP_CONN;
+        }
+        ntpThreadStarted = true;
+    }
+    req = ntpRequests.alloc();
+    if (!req) {
+        WARN("setTimeAsync(%s) queue is full", host);
+        return NTP_CONN;
+    }
+    strncpy(req->host, host, sizeof(req->host) - 1);
+    req->host[sizeof(req->host) - 1] = '\0';
+    req->port = port;
+    req->timeout = timeout;
+    ntpRequests.put(req);
+    INFO("setTimeAsync(%s, %d, %d) queued", host, port, timeout);
+    return NTP_OK;
+}
+
+bool TimeInterface::getTimeAsync(ntp_async_result_t * result, uint32_t millisec)
+{
+    osEvent evt = ntpResults.get(millisec);
+
+    if (evt.status == osEventMail) {
+        ntp_async_result_t * res = (ntp_async_result_t *)evt.value.p;
+        *result = *res;
+        ntpResults.free(res);
+        return true;
+    }
+    return false;
+}
+
+void TimeInterface::ntp_thread(void)
+{
+    while (1) {
+        osEvent evt = ntpRequests.get();
+
+        if (evt.status == osEventMail) {
+            ntp_async_request_t * req = (ntp_async_request_t *)evt.value.p;
+            NTPResult res = setTime(req->host, req->port, req->timeout);
+            ntpRequests.free(req);
+
+            ntp_async_result_t * done = ntpResults.alloc();
+            if (done) {
+                done->result = res;
+                done->when = std::time(NULL);
+                ntpResults.put(done);
+            } else {
+                WARN("NTP result dropped, %d", res);
+            }
+        }
+    }
+}
+
 bool TimeInterface::parseDSTstring(TimeInterface::dst_event_t * result, const char * dstr)
 {
     int x;
@@ -138,6 +236,11 @@ time_t TimeInterface::time(time_t * timer)
     return std::time(timer);
 }
 
+uint64_t TimeInterface::now_ns(void)
+{
+    return HiResClock::now_ns();
+}
+
 uint32_t TimeInterface::minutesSinceJan(int mon, int day, int hr, int min)
 {
     return (mon * 60 * 24 * 31) + (day * 60 * 24) + (hr * 60) + min;
@@ -282,6 +385,8 @@ void TimeInterface::set_time(time_t t, int16_t tzo_min)
     time_t tval = t - (tzo_min * 60);
     rtc_init();
     rtc_write(tval);
+    HiResClock::resync();
+    drift.reset();
     LPC_RTC->GPREG1 = tval;
     INFO("set_time(%s)", ctime(&tval));
 }
@@ -2,9 +2,12 @@
 #ifndef TIMEINTERFACE_H
 #define TIMEINTERFACE_H
 #include "mbed.h"
+#include "rtos.h"
 #include <ctime>
 
 #include "NTPClient.h"
+#include "HiResClock.h"
+#include "DriftEstimator.h"
 
 // Special Registers and their usage:
 // GPREG0: 32 bits
@@ -12,12 +15,24 @@
 //      high word: 2's complement of low word for integrity checking
 // GPREG1: 32 bits
 //      time_t value when the clock was last set
+// GPREG2 - GPREG4: 3 x 32 bits
+//      drift history, see DriftEstimator
 
 
 extern "C" {
 #include "time.h"       // uses some std::time-functions
 }
 
+#define NTP_ASYNC_HOST_LEN 64   // longest host name for setTimeAsync
+#define NTP_ASYNC_QUEUE 2       // requests (and results) that may be pending
+
+/// The completion of an asynchronous NTP query, as posted by setTimeAsync.
+///
+typedef struct {
+    NTPResult result;   ///<! the result, as setTime would have returned it.
+    time_t when;        ///<! the UTC time when the query completed.
+} ntp_async_result_t;
+
 /// The tm_ex structure is patterned after the traditional tm struct, however
 /// it adds an element - the time zone offset in minutes. From this, it is then
 /// readily able to create a "local time" instead of simply a UTC time.
@@ -47,7 +62,8 @@ struct tm_ex
 /// exposed here for one consistent interface.
 ///
 /// @note This class uses the special battery backed registers
-///     GPREG0 and GPREG1 for TimeInterface data.
+///     GPREG0 and GPREG1 for TimeInterface data, and GPREG2 to GPREG4
+///     for the drift history.
 ///
 /// @note In mbed library ver 84, the gmtime method is defective,
 ///     and calls to this function return junk data. The 
@@ -62,12 +78,25 @@ struct tm_ex
 /// // +--------+
 /// // 
 /// // +--------+
+/// // | HiRes  |----> uint64_t now_ns()
+/// // | Clock  |<---- RTC second edge, NTP fraction
+/// // +--------+
+/// // 
+/// // +--------+
 /// // |        |<------------ setTime(char * server, uint16_t port, uint32_t timeout)
+/// // |        |<------------ setTimeAsync(char * server, uint16_t port, uint32_t timeout)
+/// // |        |------------> bool getTimeAsync(ntp_async_result_t *, uint32_t)
+/// // |        |<------------ listenTime(uint32_t timeout)
 /// // | NTP    |<-----------> Ethernet
 /// // |        |----+
 /// // +--------+    |
 /// //               |
 /// // +--------+    |
+/// // | drift  |<---+ offset
+/// // |        |----+-------> set_cal(int32_t)
+/// // +--------+    |
+/// //               |
+/// // +--------+    |
 /// // | RTC    |<---+-------- set_time(time_t t, int16_t tzo)
 /// // |        |<------------ adjust_sec(int32_t)
 /// // |        |<------------ set_cal(int32_t)
@@ -161,6 +190,27 @@ public:
     ///
     clock_t clock(void);
     
+    /// Gets the current UTC time in nanoseconds.
+    ///
+    /// This reads the high resolution clock, which interpolates between
+    /// the RTC second edges, and which carries the sub-second part of
+    /// the time from an NTP sync. It does not run backwards, except when
+    /// the clock is set, so it can be used for timing intervals as well.
+    ///
+    /// @code
+    /// uint64_t tstart, tend;
+    /// ...
+    ///     tstart = now_ns();
+    ///     // do something short
+    ///     tend = now_ns();
+    ///     printf("Elapsed time is %u usec\r\n", (uint32_t)((tend - tstart) / 1000));
+    /// ...
+    /// @endcode
+    ///
+    /// @returns nanoseconds since Jan 1 1970 UTC.
+    ///
+    uint64_t now_ns(void);
+    
     /// Gets the current time as a UTC time value, optionally writing it
     /// to a provided buffer.
     ///
@@ -548,6 +598,11 @@ public:
     /// This function is the interface to NTPClient.
     /// Blocks until completion
     ///
+    /// Each successful sync also adds the measured offset to the drift
+    /// history, from which the calibration value is refined. Once that
+    /// has converged, a sync once a day is enough to hold the clock
+    /// within a fraction of a second.
+    ///
     /// @param[in] host NTP server IPv4 address or hostname (will be resolved via DNS)
     /// @param[in] port port to use; defaults to 123
     /// @param[in] timeout waiting timeout in ms (osWaitForever for blocking function, not recommended)
@@ -557,9 +612,70 @@ public:
     ///
     NTPResult setTime(const char* host, uint16_t port = NTP_DEFAULT_PORT, uint32_t timeout = NTP_DEFAULT_TIMEOUT);
 
+    /// Set the clock from an internet source (non-blocking)
+    ///
+    /// This queues the query for a network thread, and returns right
+    /// away. The network thread performs the same work as setTime, which
+    /// includes DNS resolution and waiting up to timeout for the reply,
+    /// and then posts the result, which is retrieved with getTimeAsync.
+    /// The network thread is started on the first call.
+    ///
+    /// @code
+    /// ntp.setTimeAsync("time.nist.gov");
+    /// ...
+    /// while (1) {
+    ///     ntp_async_result_t res;
+    ///     if (ntp.getTimeAsync(&res) && res.result != NTP_OK)
+    ///         printf("sync failed %d\r\n", res.result);
+    ///     // update the display
+    /// }
+    /// @endcode
+    ///
+    /// @param[in] host NTP server IPv4 address or hostname (will be resolved via DNS)
+    /// @param[in] port port to use; defaults to 123
+    /// @param[in] timeout waiting timeout in ms
+    /// @returns NTP_OK if the query was queued,
+    /// @returns NTP_CONN if no network interface, or the queue is full
+    ///
+    NTPResult setTimeAsync(const char* host, uint16_t port = NTP_DEFAULT_PORT, uint32_t timeout = NTP_DEFAULT_TIMEOUT);
+
+    /// Get the result of a query queued by setTimeAsync
+    ///
+    /// @param[out] result is written with the result, when there is one.
+    /// @param[in] millisec is how long to wait for a result; defaults to
+    ///     zero, which does not wait.
+    /// @returns true if a result was retrieved.
+    ///
+    bool getTimeAsync(ntp_async_result_t * result, uint32_t millisec = 0);
+
+    /// Set the clock from an NTP broadcast (blocking)
+    ///
+    /// This listens passively for a packet sent to the NTP multicast
+    /// group, or broadcast on the LAN, so many clocks can sync from
+    /// one server without polling it. The path delay is measured with
+    /// an occasional unicast exchange to the same server. This is
+    /// normally called in a loop from its own thread.
+    ///
+    /// @code
+    /// void ntp_listener() {
+    ///     while (1)
+    ///         ntp.listenTime(60 * 60 * 1000);
+    /// }
+    /// @endcode
+    ///
+    /// @param[in] timeout waiting timeout in ms
+    /// @returns NTP_OK on success,
+    /// @returns NTP_TIMEOUT if no packet arrived,
+    /// @returns NTP_CONN if no network interface
+    /// @returns other NTP error code (<0) on failure
+    ///
+    NTPResult listenTime(uint32_t timeout = NTP_DEFAULT_TIMEOUT);
+
     // ntp interface functions    
 private:
     EthernetInterface * m_net;
+    NTPClient m_bcast;      // kept, as it stays joined to the NTP group
+    DriftEstimator drift;
 
     typedef struct {
         uint8_t MM;
@@ -573,6 +689,23 @@ private:
     } dst_event_pair_t;
 
     bool parseDSTstring(dst_event_t * result, const char * dstr);
+
+    /// Update the drift history and time last set after a sync
+    void synced(int64_t offset_ns);
+
+    typedef struct {
+        char host[NTP_ASYNC_HOST_LEN];
+        uint16_t port;
+        uint32_t timeout;
+    } ntp_async_request_t;
+
+    /// The network thread for setTimeAsync
+    void ntp_thread(void);
+
+    Thread ntpThread;
+    bool ntpThreadStarted;
+    Mail<ntp_async_request_t, NTP_ASYNC_QUEUE> ntpRequests;
+    Mail<ntp_async_result_t, NTP_ASYNC_QUEUE> ntpResults;
     
     /// Performs a "simple" computation of two dates into minutes.
     ///
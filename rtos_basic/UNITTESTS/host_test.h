@@ -0,0 +1,84 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Assertions of the host tests, named after those of Unity. A failed
+   assertion prints where it failed and ends the program, so ctest reports
+   the test as failed. */
+
+#define TEST_FAIL_MESSAGE(msg) \
+    do { \
+        fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, (msg)); \
+        fflush(stdout); \
+        exit(1); \
+    } while (0)
+
+#define TEST_ASSERT_MESSAGE(cond, msg) \
+    do { \
+        if (!(cond)) { \
+            TEST_FAIL_MESSAGE(msg); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT(cond) TEST_ASSERT_MESSAGE((cond), #cond)
+#define TEST_ASSERT_TRUE(cond) TEST_ASSERT_MESSAGE((cond), #cond)
+#define TEST_ASSERT_FALSE(cond) TEST_ASSERT_MESSAGE(!(cond), "!(" #cond ")")
+#define TEST_ASSERT_NULL(ptr) TEST_ASSERT_MESSAGE((ptr) == NULL, #ptr " == NULL")
+#define TEST_ASSERT_NOT_NULL(ptr) TEST_ASSERT_MESSAGE((ptr) != NULL, #ptr " != NULL")
+
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    do { \
+        long long e_ = (long long)(expected), a_ = (long long)(actual); \
+        if (e_ != a_) { \
+            fprintf(stderr, "%s:%d: %s: expected %lld, was %lld\n", \
+                    __FILE__, __LINE__, #actual, e_, a_); \
+            fflush(stdout); \
+            exit(1); \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_UINT_WITHIN(delta, expected, actual) \
+    do { \
+        unsigned long long e_ = (unsigned long long)(expected); \
+        unsigned long long a_ = (unsigned long long)(actual); \
+        if ((a_ > e_ ? a_ - e_ : e_ - a_) > (unsigned long long)(delta)) { \
+            fprintf(stderr, "%s:%d: %s: expected %llu +/- %llu, was %llu\n", \
+                    __FILE__, __LINE__, #actual, e_, \
+                    (unsigned long long)(delta), a_); \
+            fflush(stdout); \
+            exit(1); \
+        } \
+    } while (0)
+
+/** Run one test case, naming it first so a failure can be told apart */
+#define RUN_TEST(func) \
+    do { \
+        printf("%s\n", #func); \
+        fflush(stdout); \
+        func(); \
+    } while (0)
+
+#endif
@@ -0,0 +1,132 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "lwip/opt.h"
+#include "lwip/def.h"
+
+/* Benchmark of the checksum routines of lwip-sys/arch/checksum.c: bytes
+   per cycle of word_checksum against lwIP's 16-bit reference algorithm,
+   and of word_checksum_copy against a copy followed by a checksum, for
+   packet sizes and alignments seen on the wire. Cycles are read from the
+   time stamp counter on x86, elsewhere the results are in bytes per
+   nanosecond. */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define UNIT "cycle"
+static unsigned long long ticks(void)
+{
+    return __rdtsc();
+}
+#else
+#define UNIT "ns"
+static unsigned long long ticks(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+#endif
+
+#define BYTES_PER_RUN   (64 * 1024 * 1024)
+
+/* Algorithm 2 of lwip_standard_chksum in inet_chksum.c, its default */
+static u16_t reference_checksum(void *dataptr, int len)
+{
+    u8_t *pb = (u8_t *)dataptr;
+    u16_t *ps, t = 0;
+    u32_t sum = 0;
+    int odd = ((mem_ptr_t)pb & 1);
+
+    if (odd && len > 0) {
+        ((u8_t *)&t)[1] = *pb++;
+        len--;
+    }
+    ps = (u16_t *)(void *)pb;
+    while (len > 1) {
+        sum += *ps++;
+        len -= 2;
+    }
+    if (len > 0) {
+        ((u8_t *)&t)[0] = *(u8_t *)ps;
+    }
+    sum += t;
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    if (odd) {
+        sum = ((sum & 0xff) << 8) | ((sum & 0xff00) >> 8);
+    }
+    return (u16_t)sum;
+}
+
+static u16_t reference_copy(void *dst, const void *src, u16_t len)
+{
+    MEMCPY(dst, src, len);
+    return reference_checksum(dst, len);
+}
+
+static u8_t src_buf[2048];
+static u8_t dst_buf[2048];
+static volatile u16_t sink;
+
+static double run_sum(u16_t (*sum)(void *, int), int offset, int len)
+{
+    long i, n = BYTES_PER_RUN / len;
+    unsigned long long start = ticks();
+
+    for (i = 0; i < n; i++) {
+        sink = sum(src_buf + offset, len);
+    }
+    return (double)n * len / (ticks() - start);
+}
+
+static double run_copy(u16_t (*copy)(void *, const void *, u16_t), int offset, int len)
+{
+    long i, n = BYTES_PER_RUN / len;
+    unsigned long long start = ticks();
+
+    for (i = 0; i < n; i++) {
+        sink = copy(dst_buf, src_buf + offset, (u16_t)len);
+    }
+    return (double)n * len / (ticks() - start);
+}
+
+int main(void)
+{
+    static const int lengths[] = { 40, 64, 576, 1460 };
+    unsigned i, offset;
+
+    memset(src_buf, 0x5A, sizeof(src_buf));
+    printf("bytes/%s       length  offset  reference  word_checksum  memcpy+sum  word_checksum_copy\n", UNIT);
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        for (offset = 0; offset < 3; offset++) {
+            printf("                %6d  %6u  %9.2f  %13.2f  %10.2f  %18.2f\n", lengths[i], offset,
+                   run_sum(reference_checksum, offset, lengths[i]),
+                   run_sum(word_checksum, offset, lengths[i]),
+                   run_copy(reference_copy, offset, lengths[i]),
+                   run_copy(word_checksum_copy, offset, lengths[i]));
+        }
+    }
+    return 0;
+}
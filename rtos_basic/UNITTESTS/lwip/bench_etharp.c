@@ -0,0 +1,109 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "netif/etharp.c"
+
+#include "lwip/init.h"
+
+/* Benchmark of ARP table lookups, built for each table size and with the
+   hash (ETHARP_HASH_SIZE 16) and without it (0, a linear search), see
+   CMakeLists.txt. The table is filled with stable entries, then looked up
+   with etharp_find_addr for addresses spread over it, which defeats the
+   last-entry cache as the traffic of several hosts does, and for addresses
+   it does not hold, as the first packet to a new host does. */
+
+#define LOOKUPS     (4 * 1000 * 1000)
+
+static struct netif bench_netif;
+
+static double now_s(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static err_t bench_netif_init(struct netif *netif)
+{
+    netif->hwaddr_len = ETHARP_HWADDR_LEN;
+    netif->flags = NETIF_FLAG_BROADCAST;
+    return ERR_OK;
+}
+
+static void bench_addr(ip_addr_t *addr, int n)
+{
+    IP4_ADDR(addr, 10, 0, n >> 7, 2 + (n & 0x7f));
+}
+
+/* Lookups per second of addresses first + (n * 7 % span) */
+static double lookups(int first, int span, int *found)
+{
+    static ip_addr_t addrs[256];
+    struct eth_addr *eth_ret;
+    ip_addr_t *ip_ret;
+    double start;
+    int i;
+
+    for (i = 0; i < 256; i++) {
+        bench_addr(&addrs[i], first + i * 7 % span);
+    }
+    *found = 0;
+    start = now_s();
+    for (i = 0; i < LOOKUPS; i++) {
+        *found += etharp_find_addr(&bench_netif, &addrs[i & 255], &eth_ret, &ip_ret) >= 0;
+    }
+    return LOOKUPS / (now_s() - start);
+}
+
+int main(void)
+{
+    ip_addr_t ip, mask, gw, addr;
+    struct eth_addr eth = {{0x02, 0, 0, 0, 0, 0}};
+    int i, hits, misses;
+    double hit_rate, miss_rate;
+
+    lwip_init();
+    IP4_ADDR(&ip, 10, 0, 0, 1);
+    IP4_ADDR(&mask, 255, 0, 0, 0);
+    IP4_ADDR(&gw, 10, 0, 0, 254);
+    netif_add(&bench_netif, &ip, &mask, &gw, NULL, bench_netif_init, ethernet_input);
+
+    for (i = 0; i < ARP_TABLE_SIZE; i++) {
+        bench_addr(&addr, i);
+        eth.addr[5] = (u8_t)i;
+        update_arp_entry(&bench_netif, &addr, &eth, ETHARP_FLAG_TRY_HARD);
+    }
+    hit_rate = lookups(0, ARP_TABLE_SIZE, &hits);
+    miss_rate = lookups(ARP_TABLE_SIZE, 256, &misses);
+    printf("ARP_TABLE_SIZE %3d, ETHARP_HASH_SIZE %2d: %6.1f M lookups/s found, %6.1f M lookups/s not found\n",
+           ARP_TABLE_SIZE, ETHARP_HASH_SIZE, hit_rate / 1e6, miss_rate / 1e6);
+    if ((hits != LOOKUPS) || (misses != 0)) {
+        fprintf(stderr, "lookups went wrong: %d of %d present and %d absent addresses found\n",
+                hits, LOOKUPS, misses);
+        return 1;
+    }
+    return 0;
+}
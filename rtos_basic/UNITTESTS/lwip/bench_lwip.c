@@ -0,0 +1,472 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "lwip/opt.h"
+#include "lwip/api.h"
+#include "lwip/mem.h"
+#include "lwip/memp.h"
+#include "lwip/tcp.h"
+#include "lwip/tcpip.h"
+#include "netif/etharp.h"
+#include "cmsis_os.h"
+#include "eth_arch.h"
+#include "host_emac.h"
+
+/* Benchmark of the lwIP stack on the host.
+
+   Two processes, a server at 10.0.0.1 and a client at 10.0.0.2, run the
+   stack over the two ends of a socket pair (see host_emac.h), so every
+   frame goes through the real etharp.c, ip.c, tcp_in.c and tcp_out.c.
+
+     bench_lwip tcp   bulk TCP throughput, client to server
+     bench_lwip udp   UDP datagrams per second, client to server
+     bench_lwip rr    TCP request/response latency percentiles
+
+   Options:
+     -n count    bytes (tcp), datagrams (udp) or round trips (rr)
+     -s size     datagram (udp) or request (rr) size
+     -d usec     one-way delay of the wire
+     -r kbit/s   rate of the wire, 0 for no limit
+     -l ppm      frames lost on the wire, per million
+     -S seed     seed of the losses
+
+   The wire model applies to the frames each side receives. The exit status
+   is non-zero when the transfer does not complete, so short runs double as
+   a test of the stack.
+
+   The server has the configuration of the board. The client stands for the
+   workstation at the other end: the build runs it from bench_lwip_peer,
+   compiled with the larger buffers of HOST_LWIP_PEER, so that the board is
+   what limits the transfer. bench_lwip_record runs both sides with the
+   board configuration and records their heap traffic (see mem_trace.c). */
+
+#define PORT            5001
+#define SERVER_ADDR     1
+#define CLIENT_ADDR     2
+
+typedef enum {
+    BENCH_TCP,
+    BENCH_UDP,
+    BENCH_RR
+} bench_mode_t;
+
+typedef struct {
+    bench_mode_t mode;
+    long count;
+    int size;
+    host_emac_wire_t wire;
+} bench_config_t;
+
+static struct netif bench_netif;
+static osSemaphoreId bench_sem;
+osSemaphoreDef(bench_sem);
+
+static double now_s(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void tcpip_ready(void *arg)
+{
+    osSemaphoreRelease(bench_sem);
+}
+
+static void stack_start(bench_config_t *cfg, int server)
+{
+    ip_addr_t ip, mask, gw;
+
+    bench_sem = osSemaphoreCreate(osSemaphore(bench_sem), 0);
+    tcpip_init(tcpip_ready, NULL);
+    osSemaphoreWait(bench_sem, osWaitForever);
+
+    IP4_ADDR(&ip, 10, 0, 0, server ? SERVER_ADDR : CLIENT_ADDR);
+    IP4_ADDR(&mask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 0, 0, 0, 0);
+    if (netif_add(&bench_netif, &ip, &mask, &gw, NULL, eth_arch_enetif_init, tcpip_input) == NULL) {
+        fprintf(stderr, "netif_add failed\n");
+        _exit(2);
+    }
+    netif_set_default(&bench_netif);
+    netif_set_up(&bench_netif);
+    host_emac_wire(&cfg->wire);
+    eth_arch_enable_interrupts();
+}
+
+static void print_stats(const char *side)
+{
+    host_emac_stats_t s;
+    struct mem_report heap;
+
+    host_emac_get_stats(&s);
+    mem_report(&heap);
+    printf("%s: rx %lu frames (dropped: queue %lu nobuf %lu wire %lu), tx %lu frames\n",
+           side, (unsigned long)s.rx_frames, (unsigned long)s.rx_drop_queue,
+           (unsigned long)s.rx_drop_nobuf, (unsigned long)s.rx_drop_loss,
+           (unsigned long)s.tx_frames);
+    printf("%s: heap free %u largest %u in %u blocks, size class hits %lu flushes %lu\n",
+           side, heap.free, heap.largest, heap.free_blocks,
+           (unsigned long)heap.class_hits, (unsigned long)heap.class_flushes);
+}
+
+static struct netconn *bench_accept(void)
+{
+    struct netconn *listener, *conn;
+
+    listener = netconn_new(NETCONN_TCP);
+    netconn_bind(listener, IP_ADDR_ANY, PORT);
+    netconn_listen(listener);
+    if (netconn_accept(listener, &conn) != ERR_OK) {
+        fprintf(stderr, "accept failed\n");
+        _exit(2);
+    }
+    netconn_delete(listener);
+    return conn;
+}
+
+static struct netconn *bench_connect(void)
+{
+    struct netconn *conn;
+    ip_addr_t server;
+    int tries;
+
+    IP4_ADDR(&server, 10, 0, 0, SERVER_ADDR);
+    /* The server may not be listening yet */
+    for (tries = 0; tries < 50; tries++) {
+        conn = netconn_new(NETCONN_TCP);
+        if (netconn_connect(conn, &server, PORT) == ERR_OK) {
+            return conn;
+        }
+        netconn_delete(conn);
+        osDelay(100);
+    }
+    fprintf(stderr, "connect failed\n");
+    _exit(2);
+    return NULL;
+}
+
+static int tcp_server(bench_config_t *cfg)
+{
+    struct netconn *conn = bench_accept();
+    struct netbuf *buf;
+    long total = 0;
+    double start = 0, t;
+
+    while (netconn_recv(conn, &buf) == ERR_OK) {
+        if (total == 0) {
+            start = now_s();
+        }
+        total += netbuf_len(buf);
+        netbuf_delete(buf);
+    }
+    t = now_s() - start;
+    netconn_close(conn);
+    netconn_delete(conn);
+    printf("tcp: %ld bytes in %.3f s, %.1f Mbit/s\n", total, t, total * 8 / t / 1e6);
+    print_stats("server");
+    return (total == cfg->count) ? 0 : 1;
+}
+
+static int tcp_client(bench_config_t *cfg)
+{
+    static char data[4 * TCP_MSS];
+    struct netconn *conn = bench_connect();
+    struct netbuf *buf;
+    long sent, n;
+
+    memset(data, 'x', sizeof(data));
+    for (sent = 0; sent < cfg->count; sent += n) {
+        n = cfg->count - sent;
+        if (n > (long)sizeof(data)) {
+            n = sizeof(data);
+        }
+        if (netconn_write(conn, data, n, NETCONN_COPY) != ERR_OK) {
+            fprintf(stderr, "write failed\n");
+            return 1;
+        }
+    }
+    /* Data can still be queued: wait for the server to have it all */
+    netconn_shutdown(conn, 0, 1);
+    while (netconn_recv(conn, &buf) == ERR_OK) {
+        netbuf_delete(buf);
+    }
+    netconn_delete(conn);
+    print_stats("client");
+    return 0;
+}
+
+#define UDP_END     0xFFFFFFFFU
+
+static int udp_server(bench_config_t *cfg)
+{
+    struct netconn *conn = netconn_new(NETCONN_UDP);
+    struct netbuf *buf;
+    u32_t seq;
+    long received = 0;
+    double start = 0, last = 0;
+
+    netconn_bind(conn, IP_ADDR_ANY, PORT);
+    /* The first datagram has no timeout, the others a second */
+    while (netconn_recv(conn, &buf) == ERR_OK) {
+        seq = 0;
+        netbuf_copy(buf, &seq, sizeof(seq));
+        netbuf_delete(buf);
+        if (seq == UDP_END) {
+            break;
+        }
+        last = now_s();
+        if (received++ == 0) {
+            start = last;
+        }
+        netconn_set_recvtimeout(conn, 1000);
+    }
+    netconn_delete(conn);
+    printf("udp: %ld of %ld datagrams of %d bytes, %.0f datagrams/s\n", received,
+           cfg->count, cfg->size, (received > 1) ? (received - 1) / (last - start) : 0.0);
+    print_stats("server");
+    return (received > 0) ? 0 : 1;
+}
+
+static int udp_client(bench_config_t *cfg)
+{
+    struct netconn *conn = netconn_new(NETCONN_UDP);
+    struct netbuf *buf;
+    ip_addr_t server;
+    u32_t seq;
+    long i;
+    double start, t;
+
+    IP4_ADDR(&server, 10, 0, 0, SERVER_ADDR);
+    netconn_connect(conn, &server, PORT);
+    /* Let ARP resolve the server before the clock starts */
+    osDelay(500);
+    start = now_s();
+    for (i = 0; i <= cfg->count; i++) {
+        seq = (i < cfg->count) ? (u32_t)i : UDP_END;
+        buf = netbuf_new();
+        memset(netbuf_alloc(buf, cfg->size), 0, cfg->size);
+        pbuf_take(buf->p, &seq, sizeof(seq));
+        while (netconn_send(conn, buf) == ERR_MEM) {
+            osThreadYield();
+        }
+        netbuf_delete(buf);
+        if (i == cfg->count - 1) {
+            t = now_s() - start;
+            printf("udp: sent %ld datagrams, %.0f datagrams/s\n", cfg->count, cfg->count / t);
+            /* The server drains its queue before the end marker */
+            osDelay(200);
+        }
+    }
+    netconn_delete(conn);
+    print_stats("client");
+    return 0;
+}
+
+static int tcp_recv_all(struct netconn *conn, int size)
+{
+    struct netbuf *buf;
+    int got = 0;
+
+    while (got < size) {
+        if (netconn_recv(conn, &buf) != ERR_OK) {
+            return 0;
+        }
+        got += netbuf_len(buf);
+        netbuf_delete(buf);
+    }
+    return 1;
+}
+
+static int rr_server(bench_config_t *cfg)
+{
+    struct netconn *conn = bench_accept();
+    char *data = (char *)calloc(1, cfg->size);
+
+    tcp_nagle_disable(conn->pcb.tcp);
+    while (tcp_recv_all(conn, cfg->size)) {
+        if (netconn_write(conn, data, cfg->size, NETCONN_COPY) != ERR_OK) {
+            break;
+        }
+    }
+    netconn_delete(conn);
+    free(data);
+    print_stats("server");
+    return 0;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int rr_client(bench_config_t *cfg)
+{
+    struct netconn *conn = bench_connect();
+    char *data = (char *)calloc(1, cfg->size);
+    double *rtt = (double *)malloc(cfg->count * sizeof(double));
+    double start;
+    long i, done = 0;
+
+    tcp_nagle_disable(conn->pcb.tcp);
+    for (i = 0; i < cfg->count; i++) {
+        start = now_s();
+        if (netconn_write(conn, data, cfg->size, NETCONN_COPY) != ERR_OK ||
+            !tcp_recv_all(conn, cfg->size)) {
+            break;
+        }
+        rtt[done++] = (now_s() - start) * 1e6;
+    }
+    netconn_close(conn);
+    netconn_delete(conn);
+    if (done > 0) {
+        qsort(rtt, done, sizeof(double), compare_double);
+        printf("rr: %ld round trips of %d bytes, usec p50 %.0f p90 %.0f p99 %.0f max %.0f\n",
+               done, cfg->size, rtt[done / 2], rtt[done * 9 / 10], rtt[done * 99 / 100],
+               rtt[done - 1]);
+    }
+    free(rtt);
+    free(data);
+    print_stats("client");
+    return (done == cfg->count) ? 0 : 1;
+}
+
+static int run(bench_config_t *cfg, int server)
+{
+    stack_start(cfg, server);
+    switch (cfg->mode) {
+        case BENCH_TCP:
+            return server ? tcp_server(cfg) : tcp_client(cfg);
+        case BENCH_UDP:
+            return server ? udp_server(cfg) : udp_client(cfg);
+        default:
+            return server ? rr_server(cfg) : rr_client(cfg);
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: bench_lwip tcp|udp|rr [-n count] [-s size] [-d usec] "
+            "[-r kbit/s] [-l ppm] [-S seed]\n");
+    exit(2);
+}
+
+static void parse_config(int argc, char **argv, bench_config_t *cfg)
+{
+    int opt;
+
+    memset(cfg, 0, sizeof(*cfg));
+    if (argc < 2) {
+        usage();
+    }
+    if (strcmp(argv[1], "tcp") == 0) {
+        cfg->mode = BENCH_TCP;
+        cfg->count = 4 * 1024 * 1024;
+    } else if (strcmp(argv[1], "udp") == 0) {
+        cfg->mode = BENCH_UDP;
+        cfg->count = 20000;
+        cfg->size = 64;
+    } else if (strcmp(argv[1], "rr") == 0) {
+        cfg->mode = BENCH_RR;
+        cfg->count = 2000;
+        cfg->size = 64;
+    } else {
+        usage();
+    }
+    optind = 2;
+    while ((opt = getopt(argc, argv, "n:s:d:r:l:S:")) != -1) {
+        switch (opt) {
+            case 'n': cfg->count = atol(optarg); break;
+            case 's': cfg->size = atoi(optarg); break;
+            case 'd': cfg->wire.delay_us = strtoul(optarg, NULL, 0); break;
+            case 'r': cfg->wire.rate_kbps = strtoul(optarg, NULL, 0); break;
+            case 'l': cfg->wire.loss_ppm = strtoul(optarg, NULL, 0); break;
+            case 'S': cfg->wire.seed = strtoul(optarg, NULL, 0); break;
+            default: usage();
+        }
+    }
+    if ((cfg->mode != BENCH_TCP) && (cfg->size < (int)sizeof(u32_t))) {
+        usage();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench_config_t cfg;
+    int sv[2];
+    pid_t pid[2];
+    char fd[16];
+    int i, status, result = 0;
+
+    parse_config(argc, argv, &cfg);
+    if (getenv("BENCH_CLIENT") != NULL) {
+        /* Started as the client, by the server side below */
+        status = run(&cfg, 0);
+        fflush(stdout);
+        _exit(status);
+    }
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0) {
+        perror("socketpair");
+        return 2;
+    }
+    fflush(stdout);
+    for (i = 0; i < 2; i++) {
+        pid[i] = fork();
+        if (pid[i] == 0) {
+            /* Each side runs its own kernel and stack */
+            close(sv[1 - i]);
+            snprintf(fd, sizeof(fd), "%d", sv[i]);
+            setenv("HOST_EMAC_FD", fd, 1);
+            unsetenv("OS_HOST_VIRTUAL");
+            if (i == 1) {
+                setenv("BENCH_CLIENT", "1", 1);
+            }
+#ifdef BENCH_PEER
+            if (i == 1) {
+                execv(BENCH_PEER, argv);
+                perror(BENCH_PEER);
+                _exit(2);
+            }
+#endif
+            status = run(&cfg, i == 0);
+            fflush(stdout);
+            _exit(status);
+        }
+    }
+    close(sv[0]);
+    close(sv[1]);
+    for (i = 0; i < 2; i++) {
+        if ((waitpid(pid[i], &status, 0) < 0) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+            result = 1;
+        }
+    }
+    return result;
+}
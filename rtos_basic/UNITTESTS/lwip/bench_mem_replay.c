@@ -0,0 +1,88 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* The heap of mem.c, built here with the MEM_SIZE_CLASS_MAX of the target */
+#include "core/mem.c"
+
+#include "mem_replay.h"
+
+/* Benchmark of the lwIP heap on recorded traces (traces/README), built
+   without the size class lists (bench_mem_replay_0, the heap as it was)
+   and with those of lwipopts.h (bench_mem_replay_2). For each trace it
+   reports the fragmentation of the free heap after every operation, from
+   mem_report(), and the time per operation. The traces are given on the
+   command line, e.g. all of those in traces/. */
+
+#define TIMED_RUNS  50
+
+static double now_s(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    mem_replay_trace_t trace;
+    mem_replay_stats_t stats;
+    struct mem_report before, after;
+    double start, elapsed;
+    u32_t ops;
+    int i, run;
+
+    printf("MEM_SIZE %d, MEM_SIZE_CLASS_MAX %d\n", MEM_SIZE, MEM_SIZE_CLASS_MAX);
+    printf("%-32s %7s %6s %9s %9s %8s %7s %7s\n", "trace", "allocs", "failed",
+           "frag mean", "frag max", "min free", "hits", "ns/op");
+    for (i = 1; i < argc; i++) {
+        if (mem_replay_load(argv[i], &trace) != 0) {
+            return 1;
+        }
+        /* each trace on a fresh heap */
+        mem_init();
+        mem_report(&before);
+        mem_replay_run(&trace, 1, &stats);
+        mem_report(&after);
+        mem_replay_release();
+        ops = stats.allocs + stats.trims + stats.frees;
+
+        start = now_s();
+        for (run = 0; run < TIMED_RUNS; run++) {
+            mem_replay_stats_t timed;
+            mem_replay_run(&trace, 0, &timed);
+            mem_replay_release();
+        }
+        elapsed = now_s() - start;
+        free(trace.ops);
+
+        printf("%-32s %7u %6u %9.3f %9.3f %8u %7u %7.1f\n", argv[i],
+               (unsigned)stats.allocs, (unsigned)stats.failed,
+               stats.frag_sum / stats.samples, stats.frag_max, (unsigned)stats.free_min,
+               (unsigned)(after.class_hits - before.class_hits),
+               elapsed * 1e9 / ((double)ops * TIMED_RUNS));
+    }
+    return 0;
+}
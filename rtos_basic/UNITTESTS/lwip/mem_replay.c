@@ -0,0 +1,146 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mem_replay.h"
+
+#define REPLAY_SLOTS 1024
+
+static void *replay_slots[REPLAY_SLOTS];
+
+double mem_replay_frag(const struct mem_report *report)
+{
+    if (report->free == 0) {
+        return 0.0;
+    }
+    return 1.0 - (double)report->largest / report->free;
+}
+
+static void replay_sample(mem_replay_stats_t *stats)
+{
+    struct mem_report report;
+    double frag;
+
+    mem_report(&report);
+    frag = mem_replay_frag(&report);
+    stats->samples++;
+    stats->frag_sum += frag;
+    if (frag > stats->frag_max) {
+        stats->frag_max = frag;
+    }
+    if (report.free < stats->free_min) {
+        stats->free_min = report.free;
+    }
+}
+
+int mem_replay_load(const char *path, mem_replay_trace_t *trace)
+{
+    FILE *f;
+    mem_replay_op_t op;
+    u32_t allocated = 0;
+    int id, n;
+    unsigned size;
+
+    trace->ops = NULL;
+    trace->count = 0;
+    f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    while ((n = fscanf(f, " %c %d", &op.op, &id)) == 2) {
+        size = 0;
+        if ((id < -1) || (id >= REPLAY_SLOTS) ||
+            ((op.op != 'a') && (op.op != 't') && (op.op != 'f')) ||
+            ((op.op != 'f') && (fscanf(f, "%u", &size) != 1))) {
+            break;
+        }
+        op.id = (s16_t)id;
+        op.size = (mem_size_t)size;
+        if (trace->count == allocated) {
+            allocated = allocated ? 2 * allocated : 1024;
+            trace->ops = (mem_replay_op_t *)realloc(trace->ops, allocated * sizeof(op));
+            if (trace->ops == NULL) {
+                break;
+            }
+        }
+        trace->ops[trace->count++] = op;
+    }
+    n = (n == EOF) && !ferror(f) && (trace->ops != NULL);
+    fclose(f);
+    if (!n) {
+        fprintf(stderr, "%s: not a heap trace\n", path);
+        free(trace->ops);
+        trace->ops = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void mem_replay_run(const mem_replay_trace_t *trace, int sample, mem_replay_stats_t *stats)
+{
+    const mem_replay_op_t *op;
+    u32_t i;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->free_min = MEM_SIZE;
+    for (i = 0; i < trace->count; i++) {
+        op = &trace->ops[i];
+        /* allocations that failed when recorded are left out, and so is
+           what was done with the blocks the replay could not get */
+        if (op->id < 0) {
+            continue;
+        }
+        switch (op->op) {
+        case 'a':
+            replay_slots[op->id] = mem_malloc(op->size);
+            stats->allocs++;
+            stats->failed += (replay_slots[op->id] == NULL);
+            break;
+        case 't':
+            if (replay_slots[op->id] != NULL) {
+                replay_slots[op->id] = mem_trim(replay_slots[op->id], op->size);
+            }
+            stats->trims++;
+            break;
+        default:
+            mem_free(replay_slots[op->id]);
+            replay_slots[op->id] = NULL;
+            stats->frees++;
+            break;
+        }
+        if (sample) {
+            replay_sample(stats);
+        }
+    }
+}
+
+void mem_replay_release(void)
+{
+    int i;
+
+    for (i = 0; i < REPLAY_SLOTS; i++) {
+        mem_free(replay_slots[i]);
+        replay_slots[i] = NULL;
+    }
+}
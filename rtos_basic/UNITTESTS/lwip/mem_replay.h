@@ -0,0 +1,71 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MEM_REPLAY_H
+#define MEM_REPLAY_H
+
+#include "lwip/opt.h"
+#include "lwip/mem.h"
+
+/* Replay of lwIP heap traces, as recorded by mem_trace.c, on the heap of
+   mem.c. Shared by test_mem_replay and bench_mem_replay. */
+
+typedef struct {
+    u32_t allocs;       /* allocations replayed */
+    u32_t failed;       /* of those, the ones the heap could not serve */
+    u32_t trims;
+    u32_t frees;
+    u32_t samples;      /* operations after which the heap was inspected */
+    double frag_sum;    /* fragmentation (see mem_replay_frag) over samples */
+    double frag_max;
+    mem_size_t free_min; /* least free heap seen */
+} mem_replay_stats_t;
+
+/** The fragmentation of the free heap: 0 when it is one block, towards 1
+    as the largest block gets smaller than the free space */
+double mem_replay_frag(const struct mem_report *report);
+
+/** One recorded call: 'a' (mem_malloc), 't' (mem_trim) or 'f' (mem_free)
+    on the block named id */
+typedef struct {
+    char op;
+    s16_t id;
+    mem_size_t size;
+} mem_replay_op_t;
+
+typedef struct {
+    mem_replay_op_t *ops;
+    u32_t count;
+} mem_replay_trace_t;
+
+/** Read a trace file. Returns 0, or -1 if it cannot be read or does not
+    parse. */
+int mem_replay_load(const char *path, mem_replay_trace_t *trace);
+
+/** Replay a trace. With sample set, the heap is inspected with mem_report()
+    after each operation. Blocks the trace leaves allocated stay so, until
+    mem_replay_release(). */
+void mem_replay_run(const mem_replay_trace_t *trace, int sample, mem_replay_stats_t *stats);
+
+/** Free the blocks left allocated by the replays */
+void mem_replay_release(void);
+
+#endif
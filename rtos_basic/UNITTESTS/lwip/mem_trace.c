@@ -0,0 +1,113 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "lwip/opt.h"
+#include "lwip/mem.h"
+
+/* Recorder of the lwIP heap traffic, linked into bench_lwip_record with
+   -Wl,--wrap so that the calls of pbuf.c and the others go through it.
+   Each side of the benchmark writes the calls it makes to the file named
+   by MEM_TRACE, suffixed .server or .client, one per line:
+
+     a <id> <size>   mem_malloc(size), the block named id, or -1 if it failed
+     t <id> <size>   mem_trim of block id to size
+     f <id>          mem_free of block id
+
+   Ids are slots of the live blocks and are reused once freed. The
+   recordings are replayed by mem_replay.c. */
+
+#define TRACE_SLOTS 1024
+
+void *__real_mem_malloc(mem_size_t size);
+void *__real_mem_trim(void *mem, mem_size_t size);
+void __real_mem_free(void *mem);
+
+static FILE *trace_file;
+static void *trace_slots[TRACE_SLOTS];
+
+static FILE *trace_open(void)
+{
+    char name[256];
+    const char *base;
+
+    if (trace_file == NULL) {
+        base = getenv("MEM_TRACE");
+        if (base == NULL) {
+            base = "mem";
+        }
+        snprintf(name, sizeof(name), "%s.%s", base,
+                 getenv("BENCH_CLIENT") != NULL ? "client" : "server");
+        trace_file = fopen(name, "w");
+        if (trace_file == NULL) {
+            perror(name);
+            exit(2);
+        }
+        /* the sides end with _exit(), which does not flush */
+        setvbuf(trace_file, NULL, _IOLBF, 0);
+    }
+    return trace_file;
+}
+
+static int trace_slot(void *mem)
+{
+    int i;
+
+    for (i = 0; i < TRACE_SLOTS; i++) {
+        if (trace_slots[i] == mem) {
+            return i;
+        }
+    }
+    fprintf(stderr, "mem_trace: more than %d live blocks\n", TRACE_SLOTS);
+    exit(2);
+}
+
+void *__wrap_mem_malloc(mem_size_t size)
+{
+    void *mem = __real_mem_malloc(size);
+    int id = -1;
+
+    if (mem != NULL) {
+        id = trace_slot(NULL);
+        trace_slots[id] = mem;
+    }
+    fprintf(trace_open(), "a %d %u\n", id, (unsigned)size);
+    return mem;
+}
+
+void *__wrap_mem_trim(void *mem, mem_size_t size)
+{
+    fprintf(trace_open(), "t %d %u\n", trace_slot(mem), (unsigned)size);
+    return __real_mem_trim(mem, size);
+}
+
+void __wrap_mem_free(void *mem)
+{
+    int id;
+
+    if (mem != NULL) {
+        id = trace_slot(mem);
+        trace_slots[id] = NULL;
+        fprintf(trace_open(), "f %d\n", id);
+    }
+    __real_mem_free(mem);
+}
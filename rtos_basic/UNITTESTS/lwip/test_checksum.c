@@ -0,0 +1,164 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <string.h>
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "host_test.h"
+
+/* Tests of the portable checksum routines of lwip-sys/arch/checksum.c
+   against lwIP's reference algorithm, over every start alignment, odd and
+   even lengths, and data that makes the sums carry. */
+
+#define BUF_SIZE    1600
+#define MAX_OFFSET  8
+
+/* Algorithm 1 of lwip_standard_chksum in inet_chksum.c, which the host
+   build replaces with word_checksum */
+static u16_t reference_checksum(const void *dataptr, int len)
+{
+    const u8_t *octetptr = (const u8_t *)dataptr;
+    u32_t acc = 0;
+    u16_t src;
+
+    while (len > 1) {
+        src = (*octetptr) << 8;
+        octetptr++;
+        src |= (*octetptr);
+        octetptr++;
+        acc += src;
+        len -= 2;
+    }
+    if (len > 0) {
+        src = (*octetptr) << 8;
+        acc += src;
+    }
+    acc = (acc >> 16) + (acc & 0x0000ffffUL);
+    if ((acc & 0xffff0000UL) != 0) {
+        acc = (acc >> 16) + (acc & 0x0000ffffUL);
+    }
+    src = (u16_t)acc;
+    return htons(src);
+}
+
+static u8_t src_buf[BUF_SIZE + MAX_OFFSET];
+static u8_t dst_buf[BUF_SIZE + 2 * MAX_OFFSET];
+
+static void fill_random(u32_t seed)
+{
+    int i;
+
+    for (i = 0; i < (int)sizeof(src_buf); i++) {
+        seed = seed * 1103515245U + 12345U;
+        src_buf[i] = (u8_t)(seed >> 16);
+    }
+}
+
+/* Every length and start offset, against the reference */
+static void check_all(void)
+{
+    int offset, len;
+
+    for (offset = 0; offset < MAX_OFFSET; offset++) {
+        for (len = 0; len <= BUF_SIZE; len++) {
+            TEST_ASSERT_EQUAL(reference_checksum(src_buf + offset, len),
+                              word_checksum(src_buf + offset, len));
+        }
+    }
+}
+
+/* Every length and pair of source and destination offsets: the copy is
+   exact, stays within its bounds, and sums as the reference does */
+static void check_all_copies(int step)
+{
+    int src, dst, len;
+    u16_t sum;
+
+    for (src = 0; src < MAX_OFFSET; src++) {
+        for (dst = 0; dst < MAX_OFFSET; dst++) {
+            for (len = 0; len <= BUF_SIZE; len += step) {
+                memset(dst_buf, 0xA5, sizeof(dst_buf));
+                sum = word_checksum_copy(dst_buf + MAX_OFFSET + dst, src_buf + src, (u16_t)len);
+                TEST_ASSERT_EQUAL(reference_checksum(src_buf + src, len), sum);
+                TEST_ASSERT_EQUAL(0, memcmp(dst_buf + MAX_OFFSET + dst, src_buf + src, len));
+                TEST_ASSERT_EQUAL(0xA5, dst_buf[MAX_OFFSET + dst - 1]);
+                TEST_ASSERT_EQUAL(0xA5, dst_buf[MAX_OFFSET + dst + len]);
+            }
+        }
+    }
+}
+
+static void test_random_data(void)
+{
+    fill_random(1);
+    check_all();
+}
+
+static void test_copy_random_data(void)
+{
+    fill_random(2);
+    check_all_copies(1);
+}
+
+/* All ones: every addition carries, and the sum folds to 0xffff */
+static void test_carry_all_ones(void)
+{
+    memset(src_buf, 0xff, sizeof(src_buf));
+    check_all();
+    check_all_copies(7);
+}
+
+/* Words just short of carrying, then ones that tip them over */
+static void test_carry_alternating(void)
+{
+    int i;
+
+    for (i = 0; i < (int)sizeof(src_buf); i++) {
+        src_buf[i] = (i & 2) ? 0x00 : ((i & 1) ? 0x01 : 0xff);
+    }
+    check_all();
+    check_all_copies(7);
+}
+
+/* The largest copy lwIP asks for, all ones, so the 64-bit accumulator
+   carries 32-bit words many times over */
+static void test_carry_longest(void)
+{
+    static u8_t big_src[0xffff + 1], big_dst[0xffff + 1];
+    int len;
+
+    memset(big_src, 0xff, sizeof(big_src));
+    for (len = 0xffff - 3; len <= 0xffff; len++) {
+        TEST_ASSERT_EQUAL(reference_checksum(big_src + 1, len), word_checksum(big_src + 1, len));
+        TEST_ASSERT_EQUAL(reference_checksum(big_src, len),
+                          word_checksum_copy(big_dst, big_src, (u16_t)len));
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_random_data);
+    RUN_TEST(test_copy_random_data);
+    RUN_TEST(test_carry_all_ones);
+    RUN_TEST(test_carry_alternating);
+    RUN_TEST(test_carry_longest);
+    return 0;
+}
@@ -0,0 +1,269 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <string.h>
+
+/* The ARP table of etharp.c, with its statics in reach of the checks */
+#include "netif/etharp.c"
+
+#include "lwip/init.h"
+#include "host_test.h"
+
+/* Randomized test of the hashed ARP table (ETHARP_HASH_SIZE) against a
+   linear search of the same table, which is what find_entry does with the
+   hash compiled out.
+
+   Queries, replies, static entries and timer ticks are applied at random,
+   over three times more addresses than the table holds, so that entries
+   are recycled and time out. After each operation every lookup the hash
+   answers is checked against a linear scan of arp_table, and the buckets
+   and the free list must link each entry exactly once. The program is
+   built for several table and hash sizes (see CMakeLists.txt). */
+
+#define OPERATIONS  200000
+#define ADDRESSES   (3 * ARP_TABLE_SIZE)
+
+static struct netif test_netif;
+static unsigned frames_sent;
+static u32_t rand_state = 1;
+
+static u32_t next_rand(void)
+{
+    rand_state = rand_state * 1103515245U + 12345U;
+    return rand_state >> 8;
+}
+
+static err_t test_linkoutput(struct netif *netif, struct pbuf *p)
+{
+    frames_sent++;
+    return ERR_OK;
+}
+
+static err_t test_netif_init(struct netif *netif)
+{
+    netif->hwaddr_len = ETHARP_HWADDR_LEN;
+    memset(netif->hwaddr, 0x02, ETHARP_HWADDR_LEN);
+    netif->mtu = 1500;
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
+    netif->output = etharp_output;
+    netif->linkoutput = test_linkoutput;
+    return ERR_OK;
+}
+
+/* Host n of the test, spread over several subnets of 10/8 so that all
+   address bytes feed the hash */
+static void test_addr(ip_addr_t *addr, int n)
+{
+    IP4_ADDR(addr, 10, 0, (n * 7) & 0xff, 2 + n % 200);
+}
+
+/* The entry a linear search finds for an address, or ARP_TABLE_SIZE */
+static int linear_find(ip_addr_t *addr)
+{
+    int i;
+
+    for (i = 0; i < ARP_TABLE_SIZE; i++) {
+        if ((arp_table[i].state != ETHARP_STATE_EMPTY) &&
+            ip_addr_cmp(addr, &arp_table[i].ipaddr)) {
+            return i;
+        }
+    }
+    return ARP_TABLE_SIZE;
+}
+
+/* Every entry is in the bucket of its address or on the free list, once */
+static void check_links(void)
+{
+    u8_t seen[ARP_TABLE_SIZE];
+    int h, i, steps;
+
+    memset(seen, 0, sizeof(seen));
+    for (h = 0; h < ETHARP_HASH_SIZE; h++) {
+        steps = 0;
+        for (i = etharp_hash[h]; i != 0; i = arp_table[i - 1].next) {
+            TEST_ASSERT(i <= etharp_used);
+            TEST_ASSERT(++steps <= ARP_TABLE_SIZE);
+            TEST_ASSERT(arp_table[i - 1].state != ETHARP_STATE_EMPTY);
+            TEST_ASSERT_EQUAL(h, ETHARP_HASH(&arp_table[i - 1].ipaddr));
+            TEST_ASSERT_EQUAL(0, seen[i - 1]);
+            seen[i - 1] = 1;
+        }
+    }
+    steps = 0;
+    for (i = etharp_free; i != 0; i = arp_table[i - 1].next) {
+        TEST_ASSERT(i <= etharp_used);
+        TEST_ASSERT(++steps <= ARP_TABLE_SIZE);
+        TEST_ASSERT_EQUAL(ETHARP_STATE_EMPTY, arp_table[i - 1].state);
+        TEST_ASSERT_EQUAL(0, seen[i - 1]);
+        seen[i - 1] = 1;
+    }
+    for (i = 0; i < ARP_TABLE_SIZE; i++) {
+        TEST_ASSERT_EQUAL(i < etharp_used, seen[i]);
+        if (arp_table[i].state != ETHARP_STATE_EMPTY) {
+            /* no address in two entries */
+            TEST_ASSERT_EQUAL(i, linear_find(&arp_table[i].ipaddr));
+        }
+    }
+    TEST_ASSERT(etharp_last < ARP_TABLE_SIZE);
+}
+
+static int count_static(void)
+{
+    int i, n = 0;
+
+    for (i = 0; i < ARP_TABLE_SIZE; i++) {
+        n += (arp_table[i].state != ETHARP_STATE_EMPTY) && arp_table[i].static_entry;
+    }
+    return n;
+}
+
+/* A lookup through the hash finds what a linear search finds */
+static void check_lookup(int n)
+{
+    ip_addr_t addr;
+    struct eth_addr *eth_ret;
+    ip_addr_t *ip_ret;
+    int expected;
+
+    test_addr(&addr, n);
+    expected = linear_find(&addr);
+    if ((expected < ARP_TABLE_SIZE) && (arp_table[expected].state != ETHARP_STATE_STABLE)) {
+        expected = ARP_TABLE_SIZE;
+    }
+    if (expected == ARP_TABLE_SIZE) {
+        TEST_ASSERT_EQUAL(-1, etharp_find_addr(&test_netif, &addr, &eth_ret, &ip_ret));
+    } else {
+        TEST_ASSERT_EQUAL(expected, etharp_find_addr(&test_netif, &addr, &eth_ret, &ip_ret));
+        TEST_ASSERT(eth_ret == &arp_table[expected].ethaddr);
+    }
+}
+
+static void test_random_operations(void)
+{
+    unsigned queries = 0, replies = 0, full = 0, statics = 0, ticks = 0, recycled = 0, expired = 0;
+    int op, n, used, known, i;
+    ip_addr_t addr;
+    struct eth_addr eth = {{0x02, 0, 0, 0, 0, 0}};
+    err_t err;
+
+    for (op = 0; op < OPERATIONS; op++) {
+        u32_t r = next_rand();
+        n = (int)(next_rand() % ADDRESSES);
+        test_addr(&addr, n);
+        eth.addr[4] = (u8_t)(n >> 8);
+        eth.addr[5] = (u8_t)n;
+
+        used = 0;
+        for (i = 0; i < ARP_TABLE_SIZE; i++) {
+            used += (arp_table[i].state != ETHARP_STATE_EMPTY);
+        }
+        switch (r % 16) {
+        case 0: case 1: case 2: case 3:
+            /* an IP packet to send, with the address not yet known */
+            known = (linear_find(&addr) != ARP_TABLE_SIZE);
+            err = etharp_query(&test_netif, &addr, NULL);
+            TEST_ASSERT((err == ERR_OK) || (err == ERR_MEM));
+            recycled += !known && (used == ARP_TABLE_SIZE) && (err == ERR_OK);
+            queries++;
+            break;
+        case 4: case 5: case 6:
+            /* a reply addressed to us, as etharp_arp_input takes it */
+            err = update_arp_entry(&test_netif, &addr, &eth, ETHARP_FLAG_TRY_HARD);
+            if (err != ERR_OK) {
+                /* only static entries are never recycled */
+                TEST_ASSERT_EQUAL(ERR_MEM, err);
+                TEST_ASSERT_EQUAL(ARP_TABLE_SIZE, count_static());
+                full++;
+            }
+            replies++;
+            break;
+        case 7: case 8:
+            /* a request of someone else, only refreshing what is known */
+            err = update_arp_entry(&test_netif, &addr, &eth, 0);
+            TEST_ASSERT((err == ERR_OK) || (err == ERR_MEM));
+            break;
+        case 9:
+            if (next_rand() % 4 == 0) {
+                err = etharp_add_static_entry(&addr, &eth);
+                TEST_ASSERT((err == ERR_OK) || (err == ERR_MEM));
+                statics++;
+            } else {
+                /* mostly of a static entry, so that they do not pile up */
+                for (i = 0; i < ARP_TABLE_SIZE; i++) {
+                    if ((arp_table[i].state != ETHARP_STATE_EMPTY) && arp_table[i].static_entry &&
+                        (next_rand() % 2 == 0)) {
+                        ip_addr_copy(addr, arp_table[i].ipaddr);
+                        break;
+                    }
+                }
+                i = linear_find(&addr);
+                known = (i < ARP_TABLE_SIZE) && (arp_table[i].state == ETHARP_STATE_STABLE) &&
+                        arp_table[i].static_entry;
+                err = etharp_remove_static_entry(&addr);
+                if (known) {
+                    TEST_ASSERT_EQUAL(ERR_OK, err);
+                } else {
+                    TEST_ASSERT((err == ERR_MEM) || (err == ERR_ARG));
+                }
+            }
+            break;
+        case 10:
+            etharp_tmr();
+            for (i = 0; i < ARP_TABLE_SIZE; i++) {
+                used -= (arp_table[i].state != ETHARP_STATE_EMPTY);
+            }
+            expired += used;
+            ticks++;
+            break;
+        default:
+            check_lookup(n);
+            break;
+        }
+        check_links();
+        for (n = 0; n < ADDRESSES; n += 1 + ADDRESSES / 16) {
+            check_lookup(n);
+        }
+    }
+    printf("%u queries (%u recycling an entry), %u replies (%u with only static entries), "
+           "%u static entries, "
+           "%u ticks expiring %u entries, %u frames sent\n",
+           queries, recycled, replies, full, statics, ticks, expired, frames_sent);
+    /* the operations went through the paths that free and take entries */
+    TEST_ASSERT(recycled > 0);
+    TEST_ASSERT(expired > 0);
+    TEST_ASSERT(etharp_used == ARP_TABLE_SIZE);
+}
+
+int main(void)
+{
+    ip_addr_t ip, mask, gw;
+
+    lwip_init();
+    IP4_ADDR(&ip, 10, 0, 0, 1);
+    IP4_ADDR(&mask, 255, 0, 0, 0);
+    IP4_ADDR(&gw, 10, 0, 0, 254);
+    TEST_ASSERT_NOT_NULL(netif_add(&test_netif, &ip, &mask, &gw, NULL, test_netif_init, ethernet_input));
+    netif_set_default(&test_netif);
+    netif_set_up(&test_netif);
+
+    RUN_TEST(test_random_operations);
+    return 0;
+}
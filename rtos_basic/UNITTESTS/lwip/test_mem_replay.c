@@ -0,0 +1,164 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "lwip/opt.h"
+#include "lwip/init.h"
+#include "lwip/mem.h"
+#include "lwip/pbuf.h"
+#include "mem_replay.h"
+#include "host_test.h"
+
+/* Tests of the size class lists of mem.c (MEM_SIZE_CLASS_MAX), replaying
+   the heap traffic of both sides of a 4 MB TCP transfer of bench_lwip,
+   recorded with the configuration of the board (traces/README). The lists
+   must serve most of it, never make an allocation fail, and give all of
+   the heap back when it runs out. */
+
+static struct mem_report initial;
+static const char *trace_paths[2];
+
+static void test_fresh_heap(void)
+{
+    mem_report(&initial);
+    TEST_ASSERT_EQUAL(1, initial.free_blocks);
+    TEST_ASSERT_EQUAL(0, initial.used_blocks);
+    TEST_ASSERT_EQUAL(initial.free, initial.largest);
+}
+
+static void replay_transfer(const char *path)
+{
+    struct mem_report before, after;
+    mem_replay_trace_t trace;
+    mem_replay_stats_t stats;
+
+    TEST_ASSERT_EQUAL(0, mem_replay_load(path, &trace));
+    mem_report(&before);
+    mem_replay_run(&trace, 1, &stats);
+    mem_report(&after);
+    free(trace.ops);
+    printf("%s: %u allocations, %u class hits, fragmentation %.3f mean %.3f max\n",
+           path, (unsigned)stats.allocs, (unsigned)(after.class_hits - before.class_hits),
+           stats.frag_sum / stats.samples, stats.frag_max);
+    TEST_ASSERT(stats.allocs > 2000);
+    TEST_ASSERT_EQUAL(0, stats.failed);
+    TEST_ASSERT_EQUAL(0, after.class_flushes - before.class_flushes);
+    /* the repeated sizes came off the lists rather than the heap */
+    TEST_ASSERT(after.class_hits - before.class_hits > stats.allocs / 2);
+
+    mem_replay_release();
+    mem_report(&after);
+    /* only blocks kept on the lists are left in use */
+    TEST_ASSERT_EQUAL(after.cached_blocks, after.used_blocks);
+    TEST_ASSERT(after.cached_blocks <= 2 * MEM_SIZE_CLASS_MAX);
+}
+
+static void test_transfer_server(void)
+{
+    replay_transfer(trace_paths[0]);
+}
+
+static void test_transfer_client(void)
+{
+    replay_transfer(trace_paths[1]);
+}
+
+static void test_allocate_until_full(void)
+{
+    static void *blocks[512];
+    struct mem_report report;
+    u32_t flushes;
+    void *block;
+    int n = 0, i;
+
+    /* pbufs of two class sizes and blocks of other sizes, until the heap
+       is full */
+    for (;;) {
+        TEST_ASSERT(n < 512);
+        switch (n % 3) {
+        case 0:
+            blocks[n] = pbuf_alloc(PBUF_TRANSPORT, 0, PBUF_RAM);
+            break;
+        case 1:
+            blocks[n] = pbuf_alloc(PBUF_TRANSPORT, TCP_MSS, PBUF_RAM);
+            break;
+        default:
+            blocks[n] = mem_malloc((mem_size_t)(100 + 13 * n));
+            break;
+        }
+        if (blocks[n] == NULL) {
+            break;
+        }
+        n++;
+    }
+    mem_report(&report);
+    TEST_ASSERT_EQUAL(0, report.cached_blocks);
+    TEST_ASSERT(n > 6);
+
+    /* two full-sized pbufs freed are kept on their list, and a block the
+       lists do not serve gets one of them back */
+    pbuf_free((struct pbuf *)blocks[1]);
+    pbuf_free((struct pbuf *)blocks[4]);
+    blocks[1] = blocks[4] = NULL;
+    mem_report(&report);
+    TEST_ASSERT_EQUAL(2, report.cached_blocks);
+    flushes = report.class_flushes;
+    block = mem_malloc(1000);
+    TEST_ASSERT_NOT_NULL(block);
+    mem_report(&report);
+    TEST_ASSERT_EQUAL(flushes + 1, report.class_flushes);
+    TEST_ASSERT_EQUAL(0, report.cached_blocks);
+    mem_free(block);
+
+    for (i = 0; i < n; i++) {
+        if (i % 3 == 2) {
+            mem_free(blocks[i]);
+        } else if (blocks[i] != NULL) {
+            pbuf_free((struct pbuf *)blocks[i]);
+        }
+    }
+    /* the whole heap in one block, flushing what the frees kept */
+    block = mem_malloc(initial.largest);
+    TEST_ASSERT_NOT_NULL(block);
+    mem_free(block);
+    mem_report(&report);
+    TEST_ASSERT_EQUAL(1, report.free_blocks);
+    TEST_ASSERT_EQUAL(0, report.used_blocks);
+    TEST_ASSERT_EQUAL(initial.free, report.free);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: test_mem_replay server.trace client.trace\n");
+        return 2;
+    }
+    trace_paths[0] = argv[1];
+    trace_paths[1] = argv[2];
+    lwip_init();
+
+    RUN_TEST(test_fresh_heap);
+    RUN_TEST(test_transfer_server);
+    RUN_TEST(test_transfer_client);
+    RUN_TEST(test_allocate_until_full);
+    return 0;
+}
@@ -0,0 +1,311 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <string.h>
+
+/* The memp pools of memp.c, with their statics in reach of the checks */
+#include "core/memp.c"
+
+#include "lwip/init.h"
+#include "host_test.h"
+
+/* Tests of the memp pools in the board configuration (lwipopts.h): the
+   pages borrowed from the reserve when a pool runs out, their return once
+   none of their elements is in use, the counters of memp_get_stats(), and
+   the overflow region checked on memp_free.
+
+   A randomized run allocates and frees from several pools at once and
+   checks, after each operation, the counters against its own count of the
+   elements held, the free lists against the counters, the reserve pages
+   against their owners, and that no two elements held overlap. */
+
+#define OPERATIONS  200000
+#define HELD_MAX    64
+
+/* Pools with elements small enough to borrow pages, which lwip_init
+   leaves alone */
+static const memp_t test_pools[] = {MEMP_UDP_PCB, MEMP_TCP_PCB, MEMP_NETBUF, MEMP_TCP_SEG};
+#define TEST_POOLS  (sizeof(test_pools) / sizeof(test_pools[0]))
+
+static u32_t rand_state = 1;
+
+static u32_t next_rand(void)
+{
+    rand_state = rand_state * 1103515245U + 12345U;
+    return rand_state >> 8;
+}
+
+static struct memp_pool_stats get_stats(memp_t type)
+{
+    struct memp_pool_stats stats;
+
+    memset(&stats, 0, sizeof(stats));
+    memp_get_stats(type, &stats);
+    return stats;
+}
+
+/* Elements a reserve page holds for a pool */
+static u16_t page_elements(memp_t type)
+{
+    return MEMP_PAGE_SIZE / MEMP_ELEM_SIZE(type);
+}
+
+/* The free list holds what the pool has and doesn't hand out, and the
+   pages counted are those lent to the pool */
+static void check_pool(memp_t type)
+{
+    struct memp_pool_stats stats = get_stats(type);
+    struct memp *m;
+    u16_t free_count = 0, pages = 0, i;
+
+    for (m = memp_tab[type]; m != NULL; m = m->next) {
+        free_count++;
+        TEST_ASSERT(free_count <= stats.avail);
+    }
+    TEST_ASSERT_EQUAL(stats.avail - stats.used, free_count);
+    for (i = 0; i < MEMP_RESERVE_PAGES; i++) {
+        if (memp_page_owner[i] == type) {
+            pages++;
+            TEST_ASSERT(memp_page_used[i] > 0);
+        }
+    }
+    TEST_ASSERT_EQUAL(pages, stats.pages);
+    TEST_ASSERT_EQUAL(memp_num[type] + pages * page_elements(type), stats.avail);
+    TEST_ASSERT(stats.used <= stats.max);
+}
+
+/* Take a pool down to its last element, then past it into the reserve,
+   and back. lwip_init holds one of them already, for DNS. */
+static void test_borrow_and_give_back(void)
+{
+    void *held[HELD_MAX];
+    struct memp_pool_stats stats = get_stats(MEMP_UDP_PCB);
+    u16_t base = stats.used, n = stats.avail - stats.used;
+    u16_t per_page = page_elements(MEMP_UDP_PCB);
+    u16_t i, total = n + MEMP_RESERVE_PAGES * per_page;
+
+    TEST_ASSERT_EQUAL(0, stats.pages);
+    TEST_ASSERT(per_page > 1);
+    TEST_ASSERT(total < HELD_MAX);
+    for (i = 0; i < n; i++) {
+        held[i] = memp_malloc(MEMP_UDP_PCB);
+        TEST_ASSERT_NOT_NULL(held[i]);
+    }
+    stats = get_stats(MEMP_UDP_PCB);
+    TEST_ASSERT_EQUAL(0, stats.pages);
+    TEST_ASSERT_EQUAL(memp_num[MEMP_UDP_PCB], stats.used);
+
+    /* The next one comes from a page, and so do the rest of the page */
+    for (; i < total; i++) {
+        held[i] = memp_malloc(MEMP_UDP_PCB);
+        TEST_ASSERT_NOT_NULL(held[i]);
+        check_pool(MEMP_UDP_PCB);
+    }
+    stats = get_stats(MEMP_UDP_PCB);
+    TEST_ASSERT_EQUAL(MEMP_RESERVE_PAGES, stats.pages);
+    TEST_ASSERT_EQUAL(MEMP_RESERVE_PAGES, stats.borrows);
+    TEST_ASSERT_EQUAL(base + total, stats.max);
+
+    /* The reserve is spent: the pool and any other fail */
+    TEST_ASSERT_NULL(memp_malloc(MEMP_UDP_PCB));
+    TEST_ASSERT_EQUAL(1, get_stats(MEMP_UDP_PCB).err);
+    for (i = 0; i < memp_num[MEMP_NETBUF]; i++) {
+        held[total + i] = memp_malloc(MEMP_NETBUF);
+        TEST_ASSERT_NOT_NULL(held[total + i]);
+    }
+    TEST_ASSERT_NULL(memp_malloc(MEMP_NETBUF));
+    TEST_ASSERT_EQUAL(1, get_stats(MEMP_NETBUF).err);
+    for (i = 0; i < memp_num[MEMP_NETBUF]; i++) {
+        memp_free(MEMP_NETBUF, held[total + i]);
+    }
+
+    /* A page goes back with the last of its elements, whichever order
+       they come back in */
+    for (i = 0; i < total; i += 2) {
+        memp_free(MEMP_UDP_PCB, held[i]);
+        check_pool(MEMP_UDP_PCB);
+    }
+    for (i = 1; i < total; i += 2) {
+        memp_free(MEMP_UDP_PCB, held[i]);
+        check_pool(MEMP_UDP_PCB);
+    }
+    stats = get_stats(MEMP_UDP_PCB);
+    TEST_ASSERT_EQUAL(0, stats.pages);
+    TEST_ASSERT_EQUAL(base, stats.used);
+    TEST_ASSERT_EQUAL(memp_num[MEMP_UDP_PCB], stats.avail);
+    TEST_ASSERT_EQUAL(base + total, stats.max);
+    TEST_ASSERT_EQUAL(0, stats.illegal);
+}
+
+/* Full frames don't fit a page, so PBUF_POOL never borrows */
+static void test_large_elements_never_borrow(void)
+{
+    void *held[PBUF_POOL_SIZE];
+    u16_t i;
+
+    TEST_ASSERT_EQUAL(0, page_elements(MEMP_PBUF_POOL));
+    for (i = 0; i < PBUF_POOL_SIZE; i++) {
+        held[i] = memp_malloc(MEMP_PBUF_POOL);
+        TEST_ASSERT_NOT_NULL(held[i]);
+    }
+    TEST_ASSERT_NULL(memp_malloc(MEMP_PBUF_POOL));
+    TEST_ASSERT_EQUAL(0, get_stats(MEMP_PBUF_POOL).pages);
+    TEST_ASSERT_EQUAL(1, get_stats(MEMP_PBUF_POOL).err);
+    for (i = 0; i < PBUF_POOL_SIZE; i++) {
+        memp_free(MEMP_PBUF_POOL, held[i]);
+    }
+    check_pool(MEMP_PBUF_POOL);
+}
+
+/* A write past the end of an element, of the pool or of a page, is
+   counted when the element is freed */
+static void test_overflow_counted(void)
+{
+    void *held[HELD_MAX];
+    u16_t n = memp_num[MEMP_TCP_PCB], i;
+
+    for (i = 0; i <= n; i++) {
+        held[i] = memp_malloc(MEMP_TCP_PCB);
+        TEST_ASSERT_NOT_NULL(held[i]);
+    }
+    TEST_ASSERT_EQUAL(1, get_stats(MEMP_TCP_PCB).pages);
+    ((u8_t *)held[0])[memp_sizes[MEMP_TCP_PCB]] ^= 0xff;
+    ((u8_t *)held[n])[memp_sizes[MEMP_TCP_PCB] + MEMP_SANITY_REGION_AFTER_ALIGNED - 1] ^= 0xff;
+    memp_free(MEMP_TCP_PCB, held[1]);
+    TEST_ASSERT_EQUAL(0, get_stats(MEMP_TCP_PCB).illegal);
+    memp_free(MEMP_TCP_PCB, held[0]);
+    TEST_ASSERT_EQUAL(1, get_stats(MEMP_TCP_PCB).illegal);
+    memp_free(MEMP_TCP_PCB, held[n]);
+    TEST_ASSERT_EQUAL(2, get_stats(MEMP_TCP_PCB).illegal);
+    for (i = 2; i < n; i++) {
+        memp_free(MEMP_TCP_PCB, held[i]);
+    }
+    check_pool(MEMP_TCP_PCB);
+    TEST_ASSERT_EQUAL(0, get_stats(MEMP_TCP_PCB).used);
+    TEST_ASSERT_EQUAL(0, get_stats(MEMP_TCP_PCB).pages);
+
+    /* Mend the region of the pool element for the tests that follow */
+    ((u8_t *)held[0])[memp_sizes[MEMP_TCP_PCB]] ^= 0xff;
+}
+
+typedef struct {
+    memp_t type;
+    u8_t *mem;
+} held_elem;
+
+/* No two elements held share a byte, counting their overflow regions */
+static void check_no_overlap(const held_elem *held, int count)
+{
+    int i, j;
+
+    for (i = 0; i < count; i++) {
+        u8_t *a = held[i].mem;
+        u8_t *a_end = a + memp_sizes[held[i].type] + MEMP_SANITY_REGION_AFTER_ALIGNED;
+        for (j = i + 1; j < count; j++) {
+            u8_t *b = held[j].mem;
+            u8_t *b_end = b + memp_sizes[held[j].type] + MEMP_SANITY_REGION_AFTER_ALIGNED;
+            TEST_ASSERT(a_end <= b - MEMP_SIZE || b_end <= a - MEMP_SIZE);
+        }
+    }
+}
+
+/* Random allocations and frees over several pools sharing the reserve */
+static void test_random_operations(void)
+{
+    held_elem held[HELD_MAX];
+    u16_t used[TEST_POOLS], max[TEST_POOLS], err[TEST_POOLS], illegal[TEST_POOLS];
+    int count = 0, op;
+    unsigned p;
+    u16_t borrows = 0, borrows_after = 0;
+
+    for (p = 0; p < TEST_POOLS; p++) {
+        struct memp_pool_stats stats = get_stats(test_pools[p]);
+        used[p] = stats.used;
+        max[p] = stats.max;
+        err[p] = stats.err;
+        illegal[p] = stats.illegal;
+        borrows += stats.borrows;
+    }
+    for (op = 0; op < OPERATIONS; op++) {
+        u32_t r = next_rand();
+
+        /* Lean towards allocating until the reserve runs dry, then
+           towards freeing until it is back */
+        if (count > 0 && (count == HELD_MAX || (r % 100) < (u32_t)((op / 5000) % 2 ? 65 : 35))) {
+            int i = (r >> 8) % count;
+            for (p = 0; test_pools[p] != held[i].type; p++) {
+            }
+            memp_free(held[i].type, held[i].mem);
+            used[p]--;
+            held[i] = held[--count];
+        } else {
+            void *mem;
+            p = (r >> 8) % TEST_POOLS;
+            mem = memp_malloc(test_pools[p]);
+            if (mem == NULL) {
+                err[p]++;
+                TEST_ASSERT_EQUAL(memp_num[test_pools[p]] + get_stats(test_pools[p]).pages * page_elements(test_pools[p]),
+                                  used[p]);
+            } else {
+                memset(mem, (int)r, memp_sizes[test_pools[p]]);
+                held[count].type = test_pools[p];
+                held[count].mem = (u8_t *)mem;
+                count++;
+                if (++used[p] > max[p]) {
+                    max[p] = used[p];
+                }
+            }
+        }
+        for (p = 0; p < TEST_POOLS; p++) {
+            struct memp_pool_stats stats = get_stats(test_pools[p]);
+            TEST_ASSERT_EQUAL(used[p], stats.used);
+            TEST_ASSERT_EQUAL(max[p], stats.max);
+            TEST_ASSERT_EQUAL(err[p], stats.err);
+            TEST_ASSERT_EQUAL(illegal[p], stats.illegal);
+            check_pool(test_pools[p]);
+        }
+        if (op % 64 == 0) {
+            check_no_overlap(held, count);
+        }
+    }
+    while (count > 0) {
+        count--;
+        memp_free(held[count].type, held[count].mem);
+    }
+    for (p = 0; p < TEST_POOLS; p++) {
+        struct memp_pool_stats stats = get_stats(test_pools[p]);
+        TEST_ASSERT_EQUAL(0, stats.pages);
+        TEST_ASSERT_EQUAL(memp_num[test_pools[p]], stats.avail);
+        borrows_after += stats.borrows;
+    }
+    TEST_ASSERT(borrows_after > borrows);
+}
+
+int main(void)
+{
+    lwip_init();
+
+    RUN_TEST(test_borrow_and_give_back);
+    RUN_TEST(test_large_elements_never_borrow);
+    RUN_TEST(test_overflow_counted);
+    RUN_TEST(test_random_operations);
+    return 0;
+}
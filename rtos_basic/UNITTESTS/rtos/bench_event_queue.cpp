@@ -0,0 +1,197 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "rtos.h"
+#include "os_host.h"
+
+/* Benchmark of EventQueue against a thread per task on the host port of
+   the RTOS, in virtual time. Eight periodic tasks, of periods 5 to 40 ms,
+   each do 100 us of work for ten seconds, either as events of a queue
+   with one or two worker threads, or each on a thread of its own that
+   waits for its next period. Reported are kernel calls and thread switches
+   per thousand runs, the worst lateness of a run against its period, the
+   stack the threads take on the target, and the wall time.
+
+   The kernel calls and switches carry over to the target. The lateness
+   shows what sharing a worker costs: a task waits for the work of the
+   others due at the same time. */
+
+using namespace rtos;
+using mbed::callback;
+
+/* Of wait_api.h, which the library of the target provides */
+extern "C" void wait_us(int us);
+
+#define TASKS       8
+#define WORK_US     100
+#define RUN_MS      10000
+
+typedef struct {
+    uint32_t period_ms;
+    uint64_t next_us;                   // time the next run is due
+    uint32_t runs;
+    uint64_t worst_late_us;
+} task;
+
+static task tasks[TASKS];
+static volatile bool stopping;
+
+typedef struct {
+    unsigned long switches;
+    unsigned long calls;
+} kernel_counts;
+
+static kernel_counts counts;
+
+static void read_counts(const char *line)
+{
+    unsigned long long t;
+
+    sscanf(line, "time %llu us, %lu switches, %lu kernel calls", &t, &counts.switches, &counts.calls);
+}
+
+static kernel_counts kernel_count(void)
+{
+    os_host_dump(read_counts);
+    return counts;
+}
+
+static double now_s(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void tasks_reset(void)
+{
+    uint64_t now = os_host_time();
+    uint32_t i;
+
+    for (i = 0; i < TASKS; i++) {
+        tasks[i].period_ms = 5 * (i + 1);
+        tasks[i].next_us = now + tasks[i].period_ms * 1000;
+        tasks[i].runs = 0;
+        tasks[i].worst_late_us = 0;
+    }
+    stopping = false;
+}
+
+static void task_run(task *t)
+{
+    uint64_t now = os_host_time();
+
+    if (now > t->next_us && now - t->next_us > t->worst_late_us) {
+        t->worst_late_us = now - t->next_us;
+    }
+    t->next_us += t->period_ms * 1000;
+    t->runs++;
+    wait_us(WORK_US);
+}
+
+static void report(const char *name, uint32_t threads, double start, kernel_counts before)
+{
+    double elapsed = now_s() - start;
+    kernel_counts after = kernel_count();
+    uint64_t worst = 0;
+    uint32_t runs = 0, i;
+
+    for (i = 0; i < TASKS; i++) {
+        runs += tasks[i].runs;
+        if (tasks[i].worst_late_us > worst) {
+            worst = tasks[i].worst_late_us;
+        }
+    }
+    printf("%-8s %6u runs %8.1f kernel calls %8.1f switches /1000 runs, worst late %5.2f ms, "
+           "stacks %5u bytes, %6.3f s\n", name, (unsigned)runs,
+           (after.calls - before.calls) * 1000.0 / runs,
+           (after.switches - before.switches) * 1000.0 / runs,
+           worst / 1000.0, (unsigned)(threads * DEFAULT_STACK_SIZE), elapsed);
+}
+
+static void bench_queue(const char *name, uint32_t workers)
+{
+    EventQueue *queue = new EventQueue(TASKS);
+    int ids[TASKS];
+    uint32_t i;
+    kernel_counts before = kernel_count();
+    double start = now_s();
+
+    tasks_reset();
+    for (i = 0; i < TASKS; i++) {
+        ids[i] = queue->call_every(tasks[i].period_ms, callback(task_run, &tasks[i]));
+    }
+    queue->start(workers);
+    Thread::wait(RUN_MS);
+    for (i = 0; i < TASKS; i++) {
+        queue->cancel(ids[i]);
+    }
+    report(name, workers, start, before);
+    delete queue;
+}
+
+static void task_thread(task *t)
+{
+    uint64_t now;
+
+    while (!stopping) {
+        now = os_host_time();
+        if (t->next_us > now) {
+            Thread::wait((uint32_t)((t->next_us - now + 999) / 1000));
+        }
+        task_run(t);
+    }
+}
+
+static void bench_threads(const char *name)
+{
+    Thread *threads[TASKS];
+    uint32_t i;
+    kernel_counts before = kernel_count();
+    double start = now_s();
+
+    tasks_reset();
+    for (i = 0; i < TASKS; i++) {
+        threads[i] = new Thread();
+        threads[i]->start(callback(task_thread, &tasks[i]));
+    }
+    Thread::wait(RUN_MS);
+    stopping = true;
+    report(name, TASKS, start, before);
+    for (i = 0; i < TASKS; i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+}
+
+int main()
+{
+    os_host_config(OS_HOST_VIRTUAL, 0);
+
+    bench_queue("queue/1", 1);
+    bench_queue("queue/2", 2);
+    bench_threads("threads");
+    return 0;
+}
@@ -0,0 +1,177 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "heap_replay.h"
+
+/* Benchmark of the first fit list of rt_Memory.c against the TLSF
+   allocator of rt_Tlsf.c. For each heap trace given on the command line
+   (traces/README) it reports, per allocator:
+
+     frag     fragmentation of the free memory after every call, mean and
+              worst (heap_replay_frag), in a pool of REPLAY_POOL_SZ
+     least    the least free memory in that pool
+     pool     the smallest pool, in steps of 64 bytes, that serves the
+              whole trace
+     ns/op    time per call
+
+   Then it times random frees and allocations of 8 to 128 bytes with 16 to
+   1024 blocks live, to show how the time per call grows with the number
+   of blocks: with the number of blocks for the first fit list, which it
+   walks, and not at all for TLSF. The pools hold 64-bit host pointers,
+   so the headers are twice the size they are on the target. */
+
+#define REPLAY_POOL_SZ  (12 * 1024)
+#define TIMED_RUNS      200
+#define SWEEP_POOL_SZ   (120 * 1024)
+#define SWEEP_OPS       200000
+
+static const heap_replay_heap_t *const heaps[] = {
+    &heap_replay_first_fit, &heap_replay_tlsf
+};
+
+static double now_s(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* The smallest pool that serves the trace without a failed call */
+static uint32_t smallest_pool(const heap_replay_heap_t *heap, void *pool,
+                              const heap_replay_trace_t *trace)
+{
+    heap_replay_stats_t stats;
+    uint32_t size;
+
+    for (size = 1024; size <= REPLAY_POOL_SZ * 4; size += 64) {
+        if (heap->init(pool, size) != 0) {
+            continue;
+        }
+        heap_replay_run(heap, pool, trace, 0, &stats);
+        heap_replay_release(heap, pool);
+        if (stats.failed == 0) {
+            return size;
+        }
+    }
+    return 0;
+}
+
+static void bench_trace(const char *path, void *pool)
+{
+    heap_replay_trace_t trace;
+    heap_replay_stats_t stats;
+    const heap_replay_heap_t *heap;
+    double start, elapsed;
+    uint32_t h;
+    int run;
+
+    if (heap_replay_load(path, &trace) != 0) {
+        exit(1);
+    }
+    for (h = 0; h < sizeof(heaps) / sizeof(heaps[0]); h++) {
+        heap = heaps[h];
+        heap->init(pool, REPLAY_POOL_SZ);
+        heap_replay_run(heap, pool, &trace, 1, &stats);
+        heap_replay_release(heap, pool);
+
+        start = now_s();
+        for (run = 0; run < TIMED_RUNS; run++) {
+            heap_replay_stats_t timed;
+            heap_replay_run(heap, pool, &trace, 0, &timed);
+            heap_replay_release(heap, pool);
+        }
+        elapsed = now_s() - start;
+        printf("%-24s %-9s %6u %6u %6.3f %6.3f %7u %7u %7.1f\n", path, heap->name,
+               (unsigned)stats.allocs, (unsigned)stats.failed,
+               stats.frag_sum / stats.samples, stats.frag_max, (unsigned)stats.free_min,
+               (unsigned)smallest_pool(heap, pool, &trace),
+               elapsed * 1e9 / ((double)TIMED_RUNS * trace.count));
+    }
+    heap_replay_unload(&trace);
+}
+
+static uint32_t rand_state;
+
+static uint32_t next_rand(void)
+{
+    rand_state = rand_state * 1103515245u + 12345u;
+    return rand_state >> 16;
+}
+
+static void bench_sweep(const heap_replay_heap_t *heap, void *pool, uint32_t live)
+{
+    static void *mem[1024];
+    uint32_t free, largest, i, n;
+    double start, elapsed;
+
+    heap->init(pool, SWEEP_POOL_SZ);
+    rand_state = 1;
+    for (i = 0; i < live; i++) {
+        mem[i] = heap->alloc(pool, 8 + next_rand() % 121);
+    }
+    start = now_s();
+    for (n = 0; n < SWEEP_OPS; n++) {
+        i = next_rand() % live;
+        heap->free(pool, mem[i]);
+        mem[i] = heap->alloc(pool, 8 + next_rand() % 121);
+        if (mem[i] == NULL) {
+            fprintf(stderr, "%s: pool full\n", heap->name);
+            exit(1);
+        }
+    }
+    elapsed = now_s() - start;
+    heap->report(pool, &free, &largest);
+    printf("%-9s %6u %8.1f %6.3f\n", heap->name, (unsigned)live,
+           elapsed * 1e9 / (2.0 * SWEEP_OPS), heap_replay_frag(free, largest));
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t lives[] = {16, 64, 256, 1024};
+    void *pool = heap_replay_pool(SWEEP_POOL_SZ > REPLAY_POOL_SZ * 4 ?
+                                  SWEEP_POOL_SZ : REPLAY_POOL_SZ * 4);
+    uint32_t h, l;
+    int i;
+
+    if (pool == NULL) {
+        fprintf(stderr, "no pool below 4 GB\n");
+        return 1;
+    }
+    printf("%-24s %-9s %6s %6s %6s %6s %7s %7s %7s\n", "trace", "heap", "allocs", "failed",
+           "frag", "max", "least", "pool", "ns/op");
+    for (i = 1; i < argc; i++) {
+        bench_trace(argv[i], pool);
+    }
+    printf("\n%-9s %6s %8s %6s\n", "heap", "live", "ns/op", "frag");
+    for (h = 0; h < sizeof(heaps) / sizeof(heaps[0]); h++) {
+        for (l = 0; l < sizeof(lives) / sizeof(lives[0]); l++) {
+            bench_sweep(heaps[h], pool, lives[l]);
+        }
+    }
+    heap_replay_pool_free(pool, SWEEP_POOL_SZ > REPLAY_POOL_SZ * 4 ?
+                          SWEEP_POOL_SZ : REPLAY_POOL_SZ * 4);
+    return 0;
+}
@@ -0,0 +1,134 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/* ahead of the C library, which leaves NULL as rt_TypeDef.h has it */
+#include "rt_List.c"
+#include <stdio.h>
+#include <time.h>
+
+/* Benchmark of the ready list operations of rt_List.c against the number
+   of ready tasks, built with OS_RDYBITMAP (bench_rdy_list) and without
+   it (bench_rdy_list_linear). With a priority level full of ready tasks,
+   it reports the time of:
+
+     robin    a round robin rotation, as rt_chk_robin and rt_tsk_pass
+              make it: the next task of the level is taken, and the
+              running task goes behind the others of its level
+     wake     a task of a lower priority made ready and removed again, as
+              a wake up by a timeout or a semaphore and a deletion do it
+
+   The plain list walks the whole level in both, the bitmap list walks
+   none of it. The thread switch itself, which does not depend on the
+   list, is timed on the target by the switch_latency test of
+   mbed-rtos/TESTS. */
+
+#define MAX_READY   128
+#define OPS         1000000
+
+/* Of the kernel, which the benchmark stands in for. The post service
+   queue is not used, but has room for a few entries of the host size. */
+U32 os_fifo[2 + 4 * 4];
+U32 os_time;
+struct OS_TSK os_tsk;
+
+void os_error (U32 err_code) {
+}
+
+static struct OS_TCB tasks[MAX_READY + 2];
+
+static double now_s(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* The ready list with "ready" tasks of priority 4, and the running task
+   of that priority in tasks[ready] */
+static void fill(int ready)
+{
+    int i;
+
+    os_rdy.cb_type = HCB;
+    os_rdy.p_lnk   = NULL;
+#if (OS_RDYBITMAP)
+    os_rdy_map     = 0U;
+#endif
+    for (i = 0; i <= ready + 1; i++) {
+        tasks[i].cb_type = TCB;
+        tasks[i].prio    = 4;
+        tasks[i].state   = READY;
+        tasks[i].p_lnk   = NULL;
+        tasks[i].p_rlnk  = NULL;
+    }
+    for (i = 0; i < ready; i++) {
+        rt_put_prio(&os_rdy, &tasks[i]);
+    }
+    tasks[ready].state = RUNNING;
+    os_tsk.run = &tasks[ready];
+}
+
+static double bench_robin(int ready)
+{
+    P_TCB next;
+    double start;
+    int n;
+
+    fill(ready);
+    start = now_s();
+    for (n = 0; n < OPS; n++) {
+        next = rt_get_same_rdy_prio();
+        os_tsk.run->state = READY;
+        rt_put_prio(&os_rdy, os_tsk.run);
+        next->state = RUNNING;
+        os_tsk.run = next;
+    }
+    return (now_s() - start) * 1e9 / OPS;
+}
+
+static double bench_wake(int ready)
+{
+    P_TCB low = &tasks[ready + 1];
+    double start;
+    int n;
+
+    fill(ready);
+    low->prio = 2;
+    start = now_s();
+    for (n = 0; n < OPS; n++) {
+        rt_put_prio(&os_rdy, low);
+        rt_rmv_list(low);
+    }
+    return (now_s() - start) * 1e9 / OPS;
+}
+
+int main()
+{
+    int ready;
+
+    printf("%-7s %6s %9s %9s\n", "list", "ready", "robin ns", "wake ns");
+    for (ready = 1; ready <= MAX_READY; ready *= 2) {
+        printf("%-7s %6d %9.1f %9.1f\n", OS_RDYBITMAP ? "bitmap" : "linear", ready,
+               bench_robin(ready), bench_wake(ready));
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "rtos.h"
+#include "os_host.h"
+
+/* Benchmark of SpscRing and MpscRing against Queue on the host port of the
+   RTOS, which stands for RTX here: every Queue call is a kernel call, as an
+   SVC is on the target, while the rings only enter the kernel to wake a
+   blocked consumer. Reported are kernel calls and thread switches per
+   thousand items, and items per second of wall time, for:
+
+     isr      an interrupt handler putting bursts of items, taken at every
+              kernel call and barrier of the consumer thread
+     threads  two producer threads and the consumer at one priority, the
+              producers yielding when the queue is full
+
+   The kernel calls are what carries over to the target. The wall time
+   does not: the port takes a lock at each barrier of the rings, which
+   costs more than the kernel call it saves. */
+
+using namespace rtos;
+using mbed::callback;
+
+#define ITEMS       200000
+#define QUEUE_SZ    16
+
+struct QueueBench {
+    Queue<uint32_t, QUEUE_SZ> q;
+    bool put(uint32_t v) {
+        return q.put((uint32_t *)(uintptr_t)v) == osOK;
+    }
+    bool get(uint32_t &v) {
+        osEvent evt = q.get();
+        v = (uint32_t)evt.value.v;
+        return evt.status == osEventMessage;
+    }
+};
+
+struct SpscBench {
+    SpscRing<uint32_t, QUEUE_SZ> r;
+    bool put(uint32_t v) {
+        return r.put(v);
+    }
+    bool get(uint32_t &v) {
+        return r.get(v);
+    }
+};
+
+struct MpscBench {
+    MpscRing<uint32_t, QUEUE_SZ> r;
+    bool put(uint32_t v) {
+        return r.put(v);
+    }
+    bool get(uint32_t &v) {
+        return r.get(v);
+    }
+};
+
+typedef struct {
+    unsigned long switches;
+    unsigned long calls;
+} kernel_counts;
+
+static kernel_counts counts;
+
+static void read_counts(const char *line)
+{
+    unsigned long long t;
+
+    sscanf(line, "time %llu us, %lu switches, %lu kernel calls", &t, &counts.switches, &counts.calls);
+}
+
+static kernel_counts kernel_count(void)
+{
+    os_host_dump(read_counts);
+    return counts;
+}
+
+static double now_s(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void report(const char *name, const char *scenario, double start, kernel_counts before)
+{
+    double elapsed = now_s() - start;
+    kernel_counts after = kernel_count();
+
+    printf("%-8s %-8s %8.1f kernel calls %8.1f switches /1000 items %10.0f items/s\n", name, scenario,
+           (after.calls - before.calls) * 1000.0 / ITEMS,
+           (after.switches - before.switches) * 1000.0 / ITEMS, ITEMS / elapsed);
+}
+
+template<class Q>
+struct IsrProducer {
+    Q *q;
+    uint32_t next;
+    uint32_t burst;
+};
+
+template<class Q>
+static void isr_put(void *arg)
+{
+    IsrProducer<Q> *p = (IsrProducer<Q> *)arg;
+    uint32_t i;
+
+    for (i = 0; (i < p->burst) && (p->next < ITEMS); i++) {
+        if (!p->q->put(p->next)) {
+            break;
+        }
+        p->next++;
+    }
+    if (p->next < ITEMS) {
+        os_host_irq(isr_put<Q>, p, 0);
+    }
+}
+
+template<class Q>
+static void bench_isr(const char *name, uint32_t burst)
+{
+    static Q q;
+    IsrProducer<Q> producer = {&q, 0, burst};
+    char scenario[16];
+    uint32_t i, v = 0;
+    kernel_counts before = kernel_count();
+    double start = now_s();
+
+    os_host_irq(isr_put<Q>, &producer, 0);
+    for (i = 0; i < ITEMS; i++) {
+        if (!q.get(v) || (v != i)) {
+            fprintf(stderr, "%s: item %u out of order\n", name, (unsigned)i);
+            exit(1);
+        }
+    }
+    snprintf(scenario, sizeof(scenario), "isr/%u", (unsigned)burst);
+    report(name, scenario, start, before);
+}
+
+template<class Q>
+static void thread_put(Q *q)
+{
+    uint32_t n = 0;
+
+    while (n < ITEMS / 2) {
+        if (q->put(n)) {
+            n++;
+        } else {
+            Thread::yield();
+        }
+    }
+}
+
+template<class Q>
+static void bench_threads(const char *name)
+{
+    static Q q;
+    Thread a, b;
+    uint32_t i, v = 0;
+    kernel_counts before = kernel_count();
+    double start = now_s();
+
+    a.start(callback(thread_put<Q>, &q));
+    b.start(callback(thread_put<Q>, &q));
+    for (i = 0; i < ITEMS; i++) {
+        if (!q.get(v)) {
+            fprintf(stderr, "%s: get failed\n", name);
+            exit(1);
+        }
+    }
+    a.join();
+    b.join();
+    report(name, "threads", start, before);
+}
+
+int main()
+{
+    os_host_config(OS_HOST_REALTIME, 0);
+
+    bench_isr<QueueBench>("Queue", 1);
+    bench_isr<SpscBench>("SpscRing", 1);
+    bench_isr<MpscBench>("MpscRing", 1);
+    bench_isr<QueueBench>("Queue", 8);
+    bench_isr<SpscBench>("SpscRing", 8);
+    bench_isr<MpscBench>("MpscRing", 8);
+    bench_threads<QueueBench>("Queue");
+    bench_threads<MpscBench>("MpscRing");
+    return 0;
+}
@@ -0,0 +1,345 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#define _GNU_SOURCE
+/* ahead of the C library, which leaves NULL as rt_TypeDef.h has it */
+#include "rt_TypeDef.h"
+#include "rt_Memory.h"
+#include "rt_Tlsf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "heap_replay.h"
+
+#define REPLAY_SLOTS 1024
+
+/* rt_alloc_mem() is the first fit list; the TLSF pool is used directly */
+U8 const os_memtlsf = 0U;
+
+static void *replay_slots[REPLAY_SLOTS];
+
+/*----------------------------------------------------------------------------
+ *      Allocators
+ *---------------------------------------------------------------------------*/
+
+static void *first_fit_realloc(void *pool, void *mem, uint32_t size)
+{
+    MEMP *hdr;
+    uint32_t old;
+    void *p;
+
+    if (mem == NULL) {
+        return rt_alloc_mem(pool, size);
+    }
+    if (size == 0) {
+        rt_free_mem(pool, mem);
+        return NULL;
+    }
+    /* rt_Memory.c has no resize: move to a new block, as a realloc over
+       rt_alloc_mem() would */
+    p = rt_alloc_mem(pool, size);
+    if (p == NULL) {
+        return NULL;
+    }
+    hdr = (MEMP *)((U8 *)mem - sizeof(MEMP));
+    old = hdr->len - sizeof(MEMP);
+    memcpy(p, mem, old < size ? old : size);
+    rt_free_mem(pool, mem);
+    return p;
+}
+
+static void first_fit_report(void *pool, uint32_t *free, uint32_t *largest)
+{
+    MEMP *p;
+    uint32_t hole;
+
+    *free = *largest = 0;
+    for (p = (MEMP *)pool; p->next != NULL; p = p->next) {
+        /* the space between a block and the next, less the header a block
+           made there would take */
+        hole = (uint32_t)((U8 *)p->next - (U8 *)p) - p->len;
+        if (hole > sizeof(MEMP)) {
+            hole -= sizeof(MEMP);
+            *free += hole;
+            if (hole > *largest) {
+                *largest = hole;
+            }
+        }
+    }
+}
+
+static void tlsf_report(void *pool, uint32_t *free, uint32_t *largest)
+{
+    TLSF_STATS stats;
+
+    rt_tlsf_stats(pool, &stats);
+    *free = stats.free_size;
+    *largest = stats.max_free;
+}
+
+const heap_replay_heap_t heap_replay_first_fit = {
+    "first fit", rt_init_mem, rt_alloc_mem, first_fit_realloc, rt_free_mem, first_fit_report
+};
+
+const heap_replay_heap_t heap_replay_tlsf = {
+    "tlsf", rt_tlsf_init, rt_tlsf_alloc, rt_tlsf_realloc, rt_tlsf_free, tlsf_report
+};
+
+void *heap_replay_pool(uint32_t size)
+{
+    void *pool = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+
+    return (pool == MAP_FAILED) ? NULL : pool;
+}
+
+void heap_replay_pool_free(void *pool, uint32_t size)
+{
+    munmap(pool, size);
+}
+
+double heap_replay_frag(uint32_t free, uint32_t largest)
+{
+    if (free == 0) {
+        return 0.0;
+    }
+    return 1.0 - (double)largest / free;
+}
+
+/*----------------------------------------------------------------------------
+ *      Traces
+ *---------------------------------------------------------------------------*/
+
+/* Addresses of the live blocks of the trace being read, by slot */
+static unsigned long long load_slots[REPLAY_SLOTS];
+
+static int load_find(unsigned long long addr)
+{
+    int i;
+
+    for (i = 0; i < REPLAY_SLOTS; i++) {
+        if (load_slots[i] == addr) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int load_add(unsigned long long addr)
+{
+    int i = load_find(0);
+
+    if (i >= 0) {
+        load_slots[i] = addr;
+    }
+    return i;
+}
+
+/* Parse a line into op. Returns 1 for a record to replay, 0 for one to
+   skip, and -1 for a line that is not a record or a trace too large. */
+static int load_line(const char *line, heap_replay_op_t *op)
+{
+    unsigned long long res, caller, ptr;
+    unsigned n, size;
+
+    op->id = op->from = -1;
+    if (sscanf(line, "#m:%llx;%llx-%u", &res, &caller, &size) == 3) {
+        op->op = 'm';
+    } else if (sscanf(line, "#c:%llx;%llx-%u;%u", &res, &caller, &n, &size) == 4) {
+        op->op = 'c';
+        size *= n;
+    } else if (sscanf(line, "#r:%llx;%llx-%llx;%u", &res, &caller, &ptr, &size) == 4) {
+        op->op = 'r';
+        if (ptr != 0) {
+            op->from = (int16_t)load_find(ptr);
+            if (op->from < 0) {
+                return 0;
+            }
+        }
+        if (size == 0) {
+            /* realloc to no size frees */
+            op->op = 'f';
+            res = 0;
+        } else if (res == 0) {
+            /* failed, and the block stays */
+            return 0;
+        }
+        if (op->from >= 0) {
+            load_slots[op->from] = 0;
+        }
+    } else if (sscanf(line, "#f:%llx;%llx-%llx", &res, &caller, &ptr) == 3) {
+        op->op = 'f';
+        op->from = (int16_t)load_find(ptr);
+        if ((ptr == 0) || (op->from < 0)) {
+            return 0;
+        }
+        load_slots[op->from] = 0;
+        res = 0;
+    } else {
+        return -1;
+    }
+    op->size = size;
+    if (res != 0) {
+        op->id = (int16_t)load_add(res);
+        if (op->id < 0) {
+            fprintf(stderr, "heap_replay: more than %d live blocks\n", REPLAY_SLOTS);
+            return -2;
+        }
+    }
+    return 1;
+}
+
+int heap_replay_load(const char *path, heap_replay_trace_t *trace)
+{
+    FILE *f;
+    char line[256];
+    heap_replay_op_t op;
+    uint32_t allocated = 0;
+    int n = 0;
+
+    trace->ops = NULL;
+    trace->count = 0;
+    memset(load_slots, 0, sizeof(load_slots));
+    f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        n = load_line(line, &op);
+        if (n < -1) {
+            break;
+        }
+        if (n <= 0) {
+            continue;
+        }
+        if (trace->count == allocated) {
+            allocated = allocated ? 2 * allocated : 1024;
+            trace->ops = (heap_replay_op_t *)realloc(trace->ops, allocated * sizeof(op));
+            if (trace->ops == NULL) {
+                n = -2;
+                break;
+            }
+        }
+        trace->ops[trace->count++] = op;
+    }
+    fclose(f);
+    if ((n < -1) || (trace->count == 0)) {
+        fprintf(stderr, "%s: not a heap trace\n", path);
+        heap_replay_unload(trace);
+        return -1;
+    }
+    return 0;
+}
+
+void heap_replay_unload(heap_replay_trace_t *trace)
+{
+    free(trace->ops);
+    trace->ops = NULL;
+    trace->count = 0;
+}
+
+/*----------------------------------------------------------------------------
+ *      Replay
+ *---------------------------------------------------------------------------*/
+
+static void replay_sample(const heap_replay_heap_t *heap, void *pool, heap_replay_stats_t *stats)
+{
+    uint32_t free, largest;
+    double frag;
+
+    heap->report(pool, &free, &largest);
+    frag = heap_replay_frag(free, largest);
+    stats->samples++;
+    stats->frag_sum += frag;
+    if (frag > stats->frag_max) {
+        stats->frag_max = frag;
+    }
+    if (free < stats->free_min) {
+        stats->free_min = free;
+    }
+}
+
+void heap_replay_run(const heap_replay_heap_t *heap, void *pool,
+                     const heap_replay_trace_t *trace, int sample,
+                     heap_replay_stats_t *stats)
+{
+    const heap_replay_op_t *op;
+    void *mem;
+    uint32_t i;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->free_min = UINT32_MAX;
+    for (i = 0; i < trace->count; i++) {
+        op = &trace->ops[i];
+        mem = (op->from >= 0) ? replay_slots[op->from] : NULL;
+        if (op->from >= 0) {
+            replay_slots[op->from] = NULL;
+        }
+        switch (op->op) {
+        case 'm':
+        case 'c':
+            mem = heap->alloc(pool, op->size);
+            if ((mem != NULL) && (op->op == 'c')) {
+                memset(mem, 0, op->size);
+            }
+            stats->allocs++;
+            stats->failed += (mem == NULL);
+            replay_slots[op->id] = mem;
+            break;
+        case 'r':
+            {
+                void *moved = heap->realloc(pool, mem, op->size);
+
+                stats->allocs++;
+                if (moved == NULL) {
+                    /* carry on with the block as it was */
+                    stats->failed++;
+                    moved = mem;
+                }
+                replay_slots[op->id] = moved;
+            }
+            break;
+        default:
+            if (mem != NULL) {
+                heap->free(pool, mem);
+            }
+            stats->frees++;
+            break;
+        }
+        if (sample) {
+            replay_sample(heap, pool, stats);
+        }
+    }
+}
+
+void heap_replay_release(const heap_replay_heap_t *heap, void *pool)
+{
+    int i;
+
+    for (i = 0; i < REPLAY_SLOTS; i++) {
+        if (replay_slots[i] != NULL) {
+            heap->free(pool, replay_slots[i]);
+            replay_slots[i] = NULL;
+        }
+    }
+}
@@ -0,0 +1,109 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HEAP_REPLAY_H
+#define HEAP_REPLAY_H
+
+#include <stdint.h>
+
+/* Replay of heap traces in the format of mbed_mem_trace, as printed by its
+   default callback or recorded by heap_trace.c, on the allocators of RTX:
+   the first fit list of rt_Memory.c and the two-level segregated fit of
+   rt_Tlsf.c. Shared by test_heap and bench_heap. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** An allocator, on a pool of memory */
+typedef struct {
+    const char *name;
+    /** Make the pool, of size bytes, empty. Returns 0, or 1 if too small. */
+    uint32_t (*init)(void *pool, uint32_t size);
+    void *(*alloc)(void *pool, uint32_t size);
+    /** Resize like realloc: NULL if it cannot, with mem left as it was */
+    void *(*realloc)(void *pool, void *mem, uint32_t size);
+    uint32_t (*free)(void *pool, void *mem);
+    /** The free bytes of the pool, and the largest free block */
+    void (*report)(void *pool, uint32_t *free, uint32_t *largest);
+} heap_replay_heap_t;
+
+extern const heap_replay_heap_t heap_replay_first_fit;
+extern const heap_replay_heap_t heap_replay_tlsf;
+
+/** A pool of size bytes for the allocators, below 4 GB, since rt_Memory.c
+    keeps addresses in U32. NULL if the host cannot map one. */
+void *heap_replay_pool(uint32_t size);
+
+void heap_replay_pool_free(void *pool, uint32_t size);
+
+/** The fragmentation of the free memory: 0 when it is one block, towards 1
+    as the largest block gets smaller than the free space. The TLSF
+    statistics give the same figure, in 1/1000, as frag. */
+double heap_replay_frag(uint32_t free, uint32_t largest);
+
+/** One recorded call: 'm' (malloc), 'c' (calloc), 'r' (realloc) or 'f'
+    (free). Blocks are named by slots, reused once freed. */
+typedef struct {
+    char op;
+    int16_t id;         /* block made, -1 if the call failed or freed */
+    int16_t from;       /* block resized or freed, -1 for none */
+    uint32_t size;
+} heap_replay_op_t;
+
+typedef struct {
+    heap_replay_op_t *ops;
+    uint32_t count;
+} heap_replay_trace_t;
+
+/** Read a trace file. Lines that are not trace records, such as other
+    output of the board, are skipped, and so are calls on blocks the trace
+    does not show allocated. Returns 0, or -1 if the file cannot be read
+    or holds no record. */
+int heap_replay_load(const char *path, heap_replay_trace_t *trace);
+
+void heap_replay_unload(heap_replay_trace_t *trace);
+
+typedef struct {
+    uint32_t allocs;    /* allocations replayed, from malloc, calloc and realloc */
+    uint32_t failed;    /* of those, the ones the allocator could not serve */
+    uint32_t frees;
+    uint32_t samples;   /* operations after which the pool was inspected */
+    double frag_sum;    /* fragmentation (see heap_replay_frag) over samples */
+    double frag_max;
+    uint32_t free_min;  /* least free memory seen */
+} heap_replay_stats_t;
+
+/** Replay a trace on a pool made with heap->init(). With sample set, the
+    pool is inspected with heap->report() after each operation. Blocks the
+    trace leaves allocated stay so, until heap_replay_release(). */
+void heap_replay_run(const heap_replay_heap_t *heap, void *pool,
+                     const heap_replay_trace_t *trace, int sample,
+                     heap_replay_stats_t *stats);
+
+/** Free the blocks left allocated by the last replay */
+void heap_replay_release(const heap_replay_heap_t *heap, void *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/* Recorder of heap calls, linked into record_heap with -Wl,--wrap so that
+   the malloc, realloc and free calls of the program go through it. It
+   writes them to the file named by HEAP_TRACE in the format of the default
+   callback of mbed_mem_trace, one per line:
+
+     #m:<res>;<caller>-<size>
+     #r:<res>;<caller>-<ptr>;<size>
+     #f:0x0;<caller>-<ptr>
+
+   so that a trace printed by a board with mbed_mem_trace_set_callback(
+   mbed_mem_trace_default_callback) replays the same way (heap_replay.c).
+   calloc is left alone, as only the host port calls it, for its own
+   control blocks; their frees are passed on unrecorded. */
+
+#define TRACE_SLOTS 1024
+
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static FILE *trace_file;
+static void *trace_slots[TRACE_SLOTS];
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define CALLER()    ((uintptr_t)__builtin_return_address(0))
+
+static FILE *trace_open(void)
+{
+    const char *name;
+
+    if (trace_file == NULL) {
+        name = getenv("HEAP_TRACE");
+        if (name == NULL) {
+            name = "heap.trace";
+        }
+        trace_file = fopen(name, "w");
+        if (trace_file == NULL) {
+            perror(name);
+            exit(2);
+        }
+    }
+    return trace_file;
+}
+
+/* The slot of a live block, or -1 */
+static int trace_find(void *ptr)
+{
+    int i;
+
+    for (i = 0; i < TRACE_SLOTS; i++) {
+        if (trace_slots[i] == ptr) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void trace_add(void *ptr)
+{
+    int i;
+
+    if (ptr != NULL) {
+        i = trace_find(NULL);
+        if (i < 0) {
+            fprintf(stderr, "heap_trace: more than %d live blocks\n", TRACE_SLOTS);
+            exit(2);
+        }
+        trace_slots[i] = ptr;
+    }
+}
+
+void *__wrap_malloc(size_t size)
+{
+    void *res = __real_malloc(size);
+
+    pthread_mutex_lock(&trace_lock);
+    trace_add(res);
+    fprintf(trace_open(), "#m:0x%lx;0x%lx-%u\n", (unsigned long)(uintptr_t)res,
+            (unsigned long)CALLER(), (unsigned)size);
+    pthread_mutex_unlock(&trace_lock);
+    return res;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    void *res = __real_realloc(ptr, size);
+    int i;
+
+    pthread_mutex_lock(&trace_lock);
+    i = (ptr != NULL) ? trace_find(ptr) : -1;
+    if ((ptr == NULL) || (i >= 0)) {
+        if ((i >= 0) && ((res != NULL) || (size == 0))) {
+            trace_slots[i] = NULL;
+        }
+        if ((res != NULL) && (size != 0)) {
+            trace_add(res);
+        }
+        fprintf(trace_open(), "#r:0x%lx;0x%lx-0x%lx;%u\n", (unsigned long)(uintptr_t)res,
+                (unsigned long)CALLER(), (unsigned long)(uintptr_t)ptr, (unsigned)size);
+    }
+    pthread_mutex_unlock(&trace_lock);
+    return res;
+}
+
+void __wrap_free(void *ptr)
+{
+    int i;
+
+    if (ptr != NULL) {
+        pthread_mutex_lock(&trace_lock);
+        i = trace_find(ptr);
+        if (i >= 0) {
+            trace_slots[i] = NULL;
+            fprintf(trace_open(), "#f:0x0;0x%lx-0x%lx\n", (unsigned long)CALLER(),
+                    (unsigned long)(uintptr_t)ptr);
+        }
+        pthread_mutex_unlock(&trace_lock);
+    }
+    __real_free(ptr);
+}
+
+/* Flush the trace; the program calls it before it ends */
+void heap_trace_close(void)
+{
+    pthread_mutex_lock(&trace_lock);
+    if (trace_file != NULL) {
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
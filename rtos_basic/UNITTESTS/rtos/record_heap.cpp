@@ -0,0 +1,263 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include "rtos.h"
+#include "os_host.h"
+
+/* The heap traffic of the clock application (main.cpp), for the heap
+   traces of test_heap and bench_heap. The program runs a model of the
+   application on the host port, in virtual time, with heap_trace.c
+   recording its calls, and writes the trace to the file named by
+   HEAP_TRACE:
+
+   - the network threads start at boot and stay: the lwIP tcpip thread,
+     whose stack sys_thread_new() takes with malloc, and the NTP thread of
+     TimeInterface;
+   - the main loop, once a second, builds the time string and the copies
+     with ':' replaced that it compares with the alarm;
+   - when the time and the alarm differ by a multiple of 50, it starts the
+     motor thread, which runs for 10 s;
+   - at the alarm, the LED game and the speaker run on threads of their
+     own until four buttons are matched, and the alarm is set again a few
+     minutes on.
+
+   The threads are Thread objects created with new and deleted when they
+   end, so their stacks come and go from the heap as in the application.
+   Strings are modelled on the reference counted std::string of the
+   target's C++ library, whose characters are in a heap block of 13 bytes
+   more than their capacity; the host library keeps short strings inline
+   and would allocate nothing. */
+
+using namespace rtos;
+using mbed::callback;
+
+extern "C" void heap_trace_close(void);
+
+/* Route new and delete through the wrapped malloc and free */
+void *operator new(size_t size)
+{
+    void *p = malloc(size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
+
+#define RUN_S       600     /* length of the run, in seconds of the clock */
+
+/* A string of the target's library: the heap block of its characters */
+class TargetString {
+public:
+    TargetString() : _rep(NULL) {}
+    ~TargetString() {
+        free(_rep);
+    }
+    void assign(const char *s) {
+        size_t len = strlen(s);
+        char *rep = (char *)malloc(12 + len + 1);
+        memcpy(rep + 12, s, len + 1);
+        free(_rep);
+        _rep = rep;
+    }
+    const char *c_str() const {
+        return _rep ? _rep + 12 : "";
+    }
+private:
+    char *_rep;
+};
+
+static uint32_t rand_state = 1;
+
+static uint32_t next_rand(void)
+{
+    rand_state = rand_state * 1103515245u + 12345u;
+    return rand_state >> 16;
+}
+
+static uint32_t clock_s;                /* seconds since midnight */
+static uint32_t alarm_s;
+
+static void format_time(char *buf, uint32_t s)
+{
+    uint32_t h = (s / 3600) % 24;
+
+    sprintf(buf, "%02u:%02u:%02u %s", (unsigned)((h + 11) % 12 + 1),
+            (unsigned)((s / 60) % 60), (unsigned)(s % 60), h < 12 ? "AM" : "PM");
+}
+
+/* replaceChar(): a copy of the string, with ':' made '0' */
+static void replace_char(TargetString &out, const TargetString &in)
+{
+    char buf[32];
+    size_t i;
+
+    strcpy(buf, in.c_str());
+    for (i = 0; buf[i] != '\0'; i++) {
+        if (buf[i] == ':') {
+            buf[i] = '0';
+        }
+    }
+    out.assign(buf);
+}
+
+static void tcpip_thread(void)
+{
+    Thread::wait(osWaitForever);
+}
+
+static void ntp_thread(void)
+{
+    for (;;) {
+        /* a request, and the packet it sends and receives */
+        void *req = malloc(48);
+        Thread::wait(20 + next_rand() % 200);
+        free(req);
+        Thread::wait(300000);
+    }
+}
+
+static void motor_thread(void)
+{
+    Thread::wait(10000);
+}
+
+static volatile bool game_over;
+
+static void speaker_thread(void)
+{
+    while (!game_over) {
+        Thread::wait(250);
+    }
+}
+
+static void led_game_thread(void)
+{
+    TargetString pattern;
+    char colours[5];
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        colours[i] = 'a' + next_rand() % 4;
+        Thread::wait(400);
+    }
+    colours[4] = '\0';
+    pattern.assign(colours);
+    /* the player matches the four colours */
+    for (i = 0; i < 4; i++) {
+        Thread::wait(1000 + next_rand() % 4000);
+    }
+    game_over = true;
+}
+
+/* Start a thread of its own stack, which the caller deletes */
+static Thread *start_thread(void (*task)(void), uint32_t stack_size)
+{
+    Thread *t = new Thread(osPriorityNormal, stack_size);
+
+    t->start(callback(task));
+    return t;
+}
+
+int main()
+{
+    Thread *motor = NULL, *led_game = NULL, *speaker = NULL;
+    TargetString current_time, alarm_time;
+    char buf[32];
+    long val, val2;
+
+    os_host_config(OS_HOST_VIRTUAL, 0);
+    /* sys_thread_new() takes the stack with malloc */
+    void *tcpip_stack = malloc(1024);
+    Thread tcpip(osPriorityNormal, 1024, (unsigned char *)tcpip_stack);
+    tcpip.start(callback(tcpip_thread));
+    Thread *ntp = start_thread(ntp_thread, DEFAULT_STACK_SIZE);
+
+    clock_s = 7 * 3600;
+    alarm_s = clock_s + 120;
+    format_time(buf, alarm_s);
+    alarm_time.assign(buf);
+    for (uint32_t n = 0; n < RUN_S; n++, clock_s++) {
+        TargetString ct, at;
+
+        format_time(buf, clock_s);
+        current_time.assign(buf);
+        replace_char(ct, current_time);
+        replace_char(at, alarm_time);
+        val = atol(ct.c_str());
+        val2 = atol(at.c_str());
+
+        if (motor != NULL && motor->get_state() == Thread::Deleted) {
+            delete motor;
+            motor = NULL;
+        }
+        if (motor == NULL && labs(val - val2) % 50 == 0) {
+            motor = start_thread(motor_thread, DEFAULT_STACK_SIZE);
+        }
+        if (led_game != NULL && led_game->get_state() == Thread::Deleted) {
+            speaker->join();
+            delete speaker;
+            delete led_game;
+            speaker = led_game = NULL;
+            alarm_s = clock_s + 60 * (2 + next_rand() % 3);
+            format_time(buf, alarm_s);
+            alarm_time.assign(buf);
+        }
+        if (led_game == NULL && clock_s == alarm_s) {
+            game_over = false;
+            speaker = start_thread(speaker_thread, 1024);
+            led_game = start_thread(led_game_thread, 1024);
+        }
+        Thread::wait(1000);
+    }
+    heap_trace_close();
+    /* the threads are left running; the program ends with them */
+    (void)ntp;
+    exit(0);
+}
@@ -0,0 +1,69 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RT_HAL_CM_HOST_H
+#define RT_HAL_CM_HOST_H
+
+/* Host stand-in for rtx/TARGET_CORTEX_M/rt_HAL_CM.h, for the RTX sources
+   that are built on their own in the host tests: the compiler intrinsics
+   and the queue index helper they use, and the few registers they touch
+   as variables, without the Cortex-M instructions. The build copies those sources next to this file (see
+   CMakeLists.txt), so that their #include "rt_HAL_CM.h" finds it ahead of
+   the target one. */
+
+#include "rt_TypeDef.h"
+
+#define __inline inline
+#define __weak   __attribute__((weak))
+
+static inline U8 __clz (U32 value) {
+  return ((value == 0U) ? 32U : (U8)__builtin_clz (value));
+}
+
+/* The cycle counter and the interrupt mask of rt_Trace.c, as variables
+   that a test of it defines and sets */
+extern U32 host_demcr, host_dwt_control, host_dwt_cyccnt, host_primask;
+
+#define DEMCR_TRCENA    0x01000000U
+#define DWT_CYCCNTENA   0x00000001U
+#define DEMCR           host_demcr
+#define DWT_CONTROL     host_dwt_control
+#define DWT_CYCCNT      host_dwt_cyccnt
+
+static inline U32 __get_PRIMASK (void) { return host_primask; }
+static inline void __disable_irq (void) { host_primask = 1U; }
+static inline void __enable_irq (void) { host_primask = 0U; }
+
+/* The host tests call the kernel from one thread, with no interrupts to
+   mask */
+static inline U32 rt_inc_qi (U32 size, U8 *count, U8 *first) {
+  U32 cnt,c2;
+
+  if ((cnt = *count) < size) {
+    *count = (U8)(cnt+1U);
+    c2 = (cnt = *first) + 1U;
+    if (c2 == size) { c2 = 0U; }
+    *first = (U8)c2;
+  }
+  return (cnt);
+}
+
+#endif
@@ -0,0 +1,403 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <string.h>
+#include "rtos.h"
+#include "os_host.h"
+#include "host_test.h"
+
+/* Tests of EventQueue on the host port, in virtual time, so that the time
+   an event runs can be checked to the millisecond. The events busy-wait
+   with wait_us() to stand for work, which moves the clock on, and block
+   with Thread::wait() to keep a worker thread busy. Interrupt handlers post
+   and cancel events as the drivers would. */
+
+using namespace rtos;
+using mbed::callback;
+
+/* Of wait_api.h, which the library of the target provides */
+extern "C" void wait_us(int us);
+
+#define RUNS_MAX    32
+
+/* Order and time of the runs of the events */
+static char runs[RUNS_MAX + 1];
+static uint32_t run_ms[RUNS_MAX];
+static uint32_t run_count;
+static uint64_t start_us;
+
+static uint32_t elapsed_ms(void)
+{
+    return (uint32_t)((os_host_time() - start_us) / 1000);
+}
+
+static void runs_reset(void)
+{
+    memset(runs, 0, sizeof(runs));
+    run_count = 0;
+    start_us = os_host_time();
+}
+
+static void record(const char *tag)
+{
+    TEST_ASSERT(run_count < RUNS_MAX);
+    runs[run_count] = *tag;
+    run_ms[run_count] = elapsed_ms();
+    run_count++;
+}
+
+typedef struct {
+    unsigned long switches;
+    unsigned long calls;
+} kernel_counts;
+
+static kernel_counts counts;
+
+static void read_counts(const char *line)
+{
+    unsigned long long t;
+
+    sscanf(line, "time %llu us, %lu switches, %lu kernel calls", &t, &counts.switches, &counts.calls);
+}
+
+static kernel_counts kernel_count(void)
+{
+    os_host_dump(read_counts);
+    return counts;
+}
+
+/* Events run by due time, those due together in the order posted */
+static void test_delayed_order(void)
+{
+    EventQueue queue;
+    static const uint32_t expected_ms[] = {0, 10, 10, 20, 30};
+    uint32_t i;
+
+    runs_reset();
+    TEST_ASSERT(queue.call_in(30, callback(record, "A")) > 0);
+    TEST_ASSERT(queue.call_in(10, callback(record, "B")) > 0);
+    TEST_ASSERT(queue.call_in(20, callback(record, "C")) > 0);
+    TEST_ASSERT(queue.call_in(10, callback(record, "D")) > 0);
+    TEST_ASSERT(queue.call(callback(record, "E")) > 0);
+    TEST_ASSERT_EQUAL(5, queue.count());
+    queue.dispatch(50);
+    TEST_ASSERT_MESSAGE(strcmp(runs, "EBDCA") == 0, runs);
+    for (i = 0; i < run_count; i++) {
+        TEST_ASSERT_UINT_WITHIN(1, expected_ms[i], run_ms[i]);
+    }
+    TEST_ASSERT_EQUAL(0, queue.count());
+}
+
+static void slow_first_run(const char *tag)
+{
+    record(tag);
+    if (run_count == 1) {
+        wait_us(35000);
+    }
+}
+
+/* A periodic event that overruns is run once more straight away and then
+   keeps its period from there, rather than being run for each missed
+   period in a burst */
+static void test_periodic_catch_up(void)
+{
+    EventQueue queue;
+    static const uint32_t expected_ms[] = {10, 45, 55, 65, 75};
+    uint32_t i;
+
+    runs_reset();
+    TEST_ASSERT(queue.call_every(10, callback(slow_first_run, "P")) > 0);
+    queue.dispatch(80);
+    TEST_ASSERT_EQUAL(5, run_count);
+    for (i = 0; i < run_count; i++) {
+        TEST_ASSERT_UINT_WITHIN(1, expected_ms[i], run_ms[i]);
+    }
+    TEST_ASSERT_EQUAL(1, queue.count());
+}
+
+static EventQueue *cancel_queue;
+static int cancel_id;
+static bool cancel_result;
+
+static void cancel_self(const char *tag)
+{
+    record(tag);
+    if (run_count == 3) {
+        cancel_result = cancel_queue->cancel(cancel_id);
+    }
+}
+
+static void busy_run(const char *tag)
+{
+    record(tag);
+    wait_us(5000);
+}
+
+static void cancel_isr(void *arg)
+{
+    cancel_result = cancel_queue->cancel(cancel_id);
+}
+
+/* Cancelling a periodic event while it runs, from the event itself and
+   from an interrupt, reports that it was not removed, and the event is
+   released when it returns instead of being run again */
+static void test_cancel_running(void)
+{
+    EventQueue queue;
+
+    cancel_queue = &queue;
+    runs_reset();
+    cancel_result = true;
+    cancel_id = queue.call_every(10, callback(cancel_self, "S"));
+    TEST_ASSERT(cancel_id > 0);
+    queue.dispatch(100);
+    TEST_ASSERT_FALSE(cancel_result);
+    TEST_ASSERT_EQUAL(3, run_count);
+    TEST_ASSERT_EQUAL(0, queue.count());
+    TEST_ASSERT_FALSE(queue.cancel(cancel_id));
+
+    /* the second run lasts from 20 to 25 ms, the interrupt comes at 22 */
+    runs_reset();
+    cancel_result = true;
+    cancel_id = queue.call_every(10, callback(busy_run, "I"));
+    TEST_ASSERT(cancel_id > 0);
+    os_host_irq(cancel_isr, NULL, 22000);
+    queue.dispatch(100);
+    TEST_ASSERT_FALSE(cancel_result);
+    TEST_ASSERT_EQUAL(2, run_count);
+    TEST_ASSERT_UINT_WITHIN(1, 20, run_ms[1]);
+    TEST_ASSERT_EQUAL(0, queue.count());
+
+    /* the same interrupt before the event runs removes it */
+    runs_reset();
+    cancel_result = false;
+    cancel_id = queue.call_every(10, callback(busy_run, "J"));
+    os_host_irq(cancel_isr, NULL, 5000);
+    queue.dispatch(100);
+    TEST_ASSERT(cancel_result);
+    TEST_ASSERT_EQUAL(0, run_count);
+    TEST_ASSERT_EQUAL(0, queue.count());
+}
+
+static void noop(void)
+{
+}
+
+/* An event used again has a new id, so the id of its last use cancels
+   nothing. The generation in the id takes 15 bits and skips zero, so an
+   id only comes back after 32767 posts to the same event. */
+static void test_id_reuse(void)
+{
+    EventQueue queue(1);
+    int first, old, id;
+    uint32_t posts;
+
+    runs_reset();
+    old = queue.call(callback(noop));
+    TEST_ASSERT(old > 0);
+    TEST_ASSERT_EQUAL(0, queue.call(callback(noop)));
+    queue.dispatch(0);
+    TEST_ASSERT_EQUAL(0, queue.count());
+
+    id = queue.call_in(10, callback(record, "N"));
+    TEST_ASSERT(id > 0);
+    TEST_ASSERT(id != old);
+    TEST_ASSERT_EQUAL(old & 0xFFFF, id & 0xFFFF);
+    TEST_ASSERT_FALSE(queue.cancel(old));
+    TEST_ASSERT_EQUAL(1, queue.count());
+    queue.dispatch(20);
+    TEST_ASSERT_MESSAGE(strcmp(runs, "N") == 0, runs);
+    TEST_ASSERT_FALSE(queue.cancel(id));
+
+    first = queue.call(callback(noop));
+    TEST_ASSERT(queue.cancel(first));
+    for (posts = 1; ; posts++) {
+        id = queue.call(callback(noop));
+        TEST_ASSERT(id > 0);
+        TEST_ASSERT(queue.cancel(id));
+        if (id == first) {
+            break;
+        }
+        TEST_ASSERT(posts < 0x10000);
+    }
+    TEST_ASSERT_EQUAL(0x7FFF, posts);
+}
+
+#define WORKERS     3
+
+static EventQueue *worker_queue;
+static uint32_t burst;
+
+static void blocking_event(const char *tag)
+{
+    Thread::wait(10);
+    record(tag);
+}
+
+static void post_burst(void *arg)
+{
+    static const char *const tags[] = {"0", "1", "2", "3", "4"};
+    uint32_t i;
+
+    for (i = 0; i < burst; i++) {
+        TEST_ASSERT(worker_queue->call(callback(blocking_event, tags[i])) > 0);
+    }
+}
+
+#define NOOP_BURST  12
+
+static void post_noops(void *arg)
+{
+    uint32_t i;
+
+    for (i = 0; i < NOOP_BURST; i++) {
+        TEST_ASSERT(worker_queue->call(callback(noop)) > 0);
+    }
+}
+
+/* A stress event: when it was due, when it ran, and how long it blocks */
+typedef struct {
+    uint32_t due_ms;
+    uint32_t ran_ms;
+    uint32_t block_ms;
+    bool ran;
+} stress_event;
+
+#define STRESS_EVENTS   300
+
+static stress_event stress[STRESS_EVENTS];
+static uint32_t stress_posted;
+static uint32_t rand_state;
+
+static uint32_t next_rand(void)
+{
+    rand_state = rand_state * 1103515245u + 12345u;
+    return rand_state >> 16;
+}
+
+static void run_stress_event(stress_event *e)
+{
+    TEST_ASSERT_FALSE(e->ran);
+    e->ran_ms = elapsed_ms();
+    e->ran = true;
+    if (e->block_ms != 0) {
+        Thread::wait(e->block_ms);
+    }
+}
+
+static void post_stress(void *arg)
+{
+    stress_event *e = &stress[stress_posted];
+    uint32_t delay = next_rand() % 4;
+
+    e->due_ms = elapsed_ms() + delay;
+    e->block_ms = (next_rand() % 4 == 0) ? 1 + next_rand() % 3 : 0;
+    e->ran = false;
+    if (worker_queue->call_in(delay, callback(run_stress_event, e)) > 0) {
+        stress_posted++;
+    }
+    if (stress_posted < STRESS_EVENTS) {
+        os_host_irq(post_stress, NULL, next_rand() % 3000);
+    }
+}
+
+/* Several workers sleep on one semaphore. A post gives a token only while
+   fewer tokens are out than there are sleepers, so that every event finds
+   a worker (no lost wakeup) and no worker wakes to find nothing to do. */
+static void test_workers(void)
+{
+    EventQueue queue;
+    kernel_counts before, after;
+    uint32_t seed, i;
+
+    worker_queue = &queue;
+    TEST_ASSERT_EQUAL(osOK, queue.start(WORKERS));
+    Thread::wait(1);
+
+    /* three events posted together run on the three workers at once */
+    runs_reset();
+    burst = 3;
+    os_host_irq(post_burst, NULL, 0);
+    Thread::wait(50);
+    TEST_ASSERT_EQUAL(3, run_count);
+    for (i = 0; i < run_count; i++) {
+        TEST_ASSERT_UINT_WITHIN(1, 10, run_ms[i]);
+    }
+
+    /* five wait for one another two by two */
+    runs_reset();
+    burst = 5;
+    os_host_irq(post_burst, NULL, 0);
+    Thread::wait(50);
+    TEST_ASSERT_EQUAL(5, run_count);
+    for (i = 0; i < run_count; i++) {
+        TEST_ASSERT_UINT_WITHIN(1, i < WORKERS ? 10 : 20, run_ms[i]);
+    }
+
+    /* interrupts posting at random under several schedules */
+    for (seed = 1; seed <= 8; seed++) {
+        os_host_config(OS_HOST_VIRTUAL, seed);
+        rand_state = seed;
+        stress_posted = 0;
+        runs_reset();
+        os_host_irq(post_stress, NULL, 0);
+        while (stress_posted < STRESS_EVENTS || queue.count() != 0) {
+            Thread::wait(10);
+        }
+        for (i = 0; i < STRESS_EVENTS; i++) {
+            TEST_ASSERT(stress[i].ran);
+            TEST_ASSERT(stress[i].ran_ms + 1 >= stress[i].due_ms);
+        }
+
+        /* a burst of events from one interrupt, with the workers asleep,
+           wakes each of them once: tokens beyond the sleepers would each
+           take a worker round the dispatch loop for nothing */
+        Thread::wait(1);
+        before = kernel_count();
+        os_host_irq(post_noops, NULL, 0);
+        Thread::wait(10);
+        after = kernel_count();
+        /* a release and a wait per worker, and the wait of this thread */
+        TEST_ASSERT_EQUAL(2 * WORKERS + 1, after.calls - before.calls);
+        TEST_ASSERT_EQUAL(0, queue.count());
+
+        /* and an event posted then still finds a worker */
+        runs_reset();
+        burst = 1;
+        os_host_irq(post_burst, NULL, 0);
+        Thread::wait(50);
+        TEST_ASSERT_EQUAL(1, run_count);
+        TEST_ASSERT_UINT_WITHIN(1, 10, run_ms[0]);
+    }
+    os_host_config(OS_HOST_VIRTUAL, 0);
+}
+
+int main()
+{
+    os_host_config(OS_HOST_VIRTUAL, 0);
+
+    RUN_TEST(test_delayed_order);
+    RUN_TEST(test_periodic_catch_up);
+    RUN_TEST(test_cancel_running);
+    RUN_TEST(test_id_reuse);
+    RUN_TEST(test_workers);
+    return 0;
+}
@@ -0,0 +1,327 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/* ahead of the C library, which leaves NULL as rt_TypeDef.h has it */
+#include "rt_Tlsf.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "heap_replay.h"
+#include "host_test.h"
+
+/* Tests of the TLSF allocator of rt_Tlsf.c, and of it and the first fit
+   list of rt_Memory.c on the heap traces given as arguments. After random
+   calls, the blocks of the pool are walked to check that they tile it,
+   that no two free blocks are left side by side, that every free block is
+   in the list of its class and only there, and that the statistics, the
+   fragmentation figure among them, agree with what the walk finds. */
+
+#define POOL_SZ     (64 * 1024)
+#define SLOTS       64
+
+static void *pool;
+
+/* The free bytes and the largest free block, found by walking the pool */
+static void tlsf_check(void *p, uint32_t *free_out, uint32_t *largest_out)
+{
+    TLSF_CTL *ctl = (TLSF_CTL *)p;
+    TLSF_BLK *blk, *prev = NULL, *b;
+    TLSF_STATS stats;
+    uint32_t free = 0, largest = 0, used = 0, used_cnt = 0, free_cnt = 0, listed = 0;
+    uint32_t fl, sl;
+
+    for (blk = (TLSF_BLK *)ctl->start; (U8 *)blk != ctl->end; blk = BLK_NEXT(blk)) {
+        TEST_ASSERT(blk->prev_phys == prev);
+        TEST_ASSERT(BLK_SIZE(blk) != 0);
+        TEST_ASSERT((U8 *)BLK_NEXT(blk) <= ctl->end);
+        TEST_ASSERT(((uintptr_t)BLK_MEM(blk) & (TLSF_ALIGN - 1)) == 0);
+        if (blk->size & TLSF_FREE) {
+            /* free neighbours merge, unless the block would grow too large */
+            TEST_ASSERT((prev == NULL) || !(prev->size & TLSF_FREE) ||
+                        (BLK_SIZE(prev) + TLSF_HDR + BLK_SIZE(blk) > TLSF_BLK_MAX));
+            free += BLK_SIZE(blk);
+            free_cnt++;
+            if (BLK_SIZE(blk) > largest) {
+                largest = BLK_SIZE(blk);
+            }
+        } else {
+            used += BLK_SIZE(blk);
+            used_cnt++;
+        }
+        prev = blk;
+    }
+    TEST_ASSERT(((TLSF_BLK *)ctl->end)->prev_phys == prev);
+    TEST_ASSERT_EQUAL(0, ((TLSF_BLK *)ctl->end)->size);
+
+    for (fl = 0; fl < TLSF_FL_COUNT; fl++) {
+        TEST_ASSERT_EQUAL(ctl->sl_map[fl] != 0, (ctl->fl_map >> fl) & 1);
+        for (sl = 0; sl < TLSF_SL_COUNT; sl++) {
+            TEST_ASSERT_EQUAL(ctl->head[fl][sl] != NULL, (ctl->sl_map[fl] >> sl) & 1);
+            for (b = ctl->head[fl][sl]; b != NULL; b = b->next_free) {
+                U32 f, s;
+
+                TEST_ASSERT(b->size & TLSF_FREE);
+                rt_tlsf_map(BLK_SIZE(b), &f, &s);
+                TEST_ASSERT_EQUAL(fl, f);
+                TEST_ASSERT_EQUAL(sl, s);
+                TEST_ASSERT((b->next_free == NULL) || (b->next_free->prev_free == b));
+                TEST_ASSERT((b != ctl->head[fl][sl]) || (b->prev_free == NULL));
+                listed++;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL(free_cnt, listed);
+
+    rt_tlsf_stats(p, &stats);
+    TEST_ASSERT_EQUAL(free, stats.free_size);
+    TEST_ASSERT_EQUAL(largest, stats.max_free);
+    TEST_ASSERT_EQUAL(used, stats.cur_size);
+    TEST_ASSERT_EQUAL(used_cnt, stats.alloc_cnt);
+    /* of at most one block's worth of free memory */
+    TEST_ASSERT_EQUAL(free ? 1000 - (uint32_t)((uint64_t)largest * 1000 /
+                      (free < TLSF_BLK_MAX ? free : TLSF_BLK_MAX)) : 0, stats.frag);
+    if (free_out != NULL) {
+        *free_out = free;
+        *largest_out = largest;
+    }
+}
+
+static uint32_t rand_state;
+
+static uint32_t next_rand(void)
+{
+    rand_state = rand_state * 1103515245u + 12345u;
+    return rand_state >> 16;
+}
+
+static uint32_t random_size(void)
+{
+    /* mostly small blocks, as strings and messages, some as large as stacks */
+    if (next_rand() % 8 == 0) {
+        return 1 + next_rand() % 4096;
+    }
+    return 1 + next_rand() % 200;
+}
+
+/* Random malloc, realloc and free calls, with the contents of every block
+   checked until it is freed */
+static void test_tlsf_random(void)
+{
+    void *mem[SLOTS];
+    uint32_t size[SLOTS];
+    uint8_t fill[SLOTS];
+    uint32_t free0, largest0, free, largest, i, k, n;
+    void *moved;
+
+    TEST_ASSERT_EQUAL(0, rt_tlsf_init(pool, POOL_SZ));
+    tlsf_check(pool, &free0, &largest0);
+    TEST_ASSERT_EQUAL(free0, largest0);
+    memset(mem, 0, sizeof(mem));
+    rand_state = 1;
+    for (n = 0; n < 200000; n++) {
+        i = next_rand() % SLOTS;
+        if (mem[i] != NULL) {
+            for (k = 0; k < size[i]; k++) {
+                TEST_ASSERT_EQUAL(fill[i], ((uint8_t *)mem[i])[k]);
+            }
+        }
+        if (mem[i] == NULL) {
+            size[i] = random_size();
+            mem[i] = rt_tlsf_alloc(pool, size[i]);
+        } else if (next_rand() % 3 == 0) {
+            uint32_t grow = random_size();
+
+            moved = rt_tlsf_realloc(pool, mem[i], grow);
+            if (moved == NULL) {
+                continue;
+            }
+            mem[i] = moved;
+            if (grow < size[i]) {
+                size[i] = grow;
+            }
+            memset((uint8_t *)mem[i] + size[i], fill[i], grow - size[i]);
+            size[i] = grow;
+            continue;
+        } else {
+            TEST_ASSERT_EQUAL(0, rt_tlsf_free(pool, mem[i]));
+            mem[i] = NULL;
+            continue;
+        }
+        if (mem[i] != NULL) {
+            TEST_ASSERT(rt_tlsf_size(pool, mem[i]) >= size[i]);
+            fill[i] = (uint8_t)next_rand();
+            memset(mem[i], fill[i], size[i]);
+        }
+        if (n % 97 == 0) {
+            tlsf_check(pool, NULL, NULL);
+        }
+    }
+    for (i = 0; i < SLOTS; i++) {
+        if (mem[i] != NULL) {
+            TEST_ASSERT_EQUAL(0, rt_tlsf_free(pool, mem[i]));
+        }
+    }
+    /* all free again: one block, as at the start */
+    tlsf_check(pool, &free, &largest);
+    TEST_ASSERT_EQUAL(free0, free);
+    TEST_ASSERT_EQUAL(largest0, largest);
+}
+
+/* Freeing every other block of a full pool leaves the free memory in
+   pieces: the fragmentation figure is the share outside the largest */
+static void check_frag(const heap_replay_heap_t *heap)
+{
+    void *mem[256];
+    uint32_t free0, largest0, free, largest, n, i;
+
+    TEST_ASSERT_EQUAL(0, heap->init(pool, 32 * 1024));
+    heap->report(pool, &free0, &largest0);
+    TEST_ASSERT_EQUAL(free0, largest0);
+    TEST_ASSERT(heap_replay_frag(free0, largest0) == 0.0);
+    for (n = 0; n < 256; n++) {
+        mem[n] = heap->alloc(pool, 200);
+        if (mem[n] == NULL) {
+            break;
+        }
+    }
+    TEST_ASSERT(n > 100);
+    TEST_ASSERT(n < 256);
+    for (i = 0; i < n; i += 2) {
+        TEST_ASSERT_EQUAL(0, heap->free(pool, mem[i]));
+    }
+    heap->report(pool, &free, &largest);
+    /* n / 2 holes of one block each, and what the full pool left over */
+    TEST_ASSERT(largest >= 200);
+    TEST_ASSERT(largest < 400);
+    TEST_ASSERT(heap_replay_frag(free, largest) > 0.9);
+    /* no block larger than a hole fits */
+    TEST_ASSERT_NULL(heap->alloc(pool, largest + 1));
+    for (i = 1; i < n; i += 2) {
+        TEST_ASSERT_EQUAL(0, heap->free(pool, mem[i]));
+    }
+    heap->report(pool, &free, &largest);
+    TEST_ASSERT_EQUAL(free0, free);
+    TEST_ASSERT_EQUAL(largest0, largest);
+}
+
+static void test_frag_first_fit(void)
+{
+    check_frag(&heap_replay_first_fit);
+}
+
+static void test_frag_tlsf(void)
+{
+    check_frag(&heap_replay_tlsf);
+    TEST_ASSERT_EQUAL(0, rt_tlsf_init(pool, 32 * 1024));
+    tlsf_check(pool, NULL, NULL);
+}
+
+/* A pool larger than the largest block is covered by several free blocks,
+   which is no fragmentation: all free, it can serve any block it could */
+static void test_frag_large_pool(void)
+{
+    uint32_t size = 3 * TLSF_BLK_MAX + 1000;
+    void *large = heap_replay_pool(size);
+    void *mem[8];
+    TLSF_STATS stats;
+    int i;
+
+    TEST_ASSERT_NOT_NULL(large);
+    TEST_ASSERT_EQUAL(0, rt_tlsf_init(large, size));
+    tlsf_check(large, NULL, NULL);
+    rt_tlsf_stats(large, &stats);
+    TEST_ASSERT(stats.free_size > 3 * stats.max_free);
+    TEST_ASSERT_EQUAL(TLSF_BLK_MAX, stats.max_free);
+    TEST_ASSERT_EQUAL(0, stats.frag);
+    for (i = 0; i < 8; i++) {
+        mem[i] = rt_tlsf_alloc(large, TLSF_BLK_MAX / 4);
+        TEST_ASSERT_NOT_NULL(mem[i]);
+    }
+    for (i = 0; i < 8; i += 2) {
+        TEST_ASSERT_EQUAL(0, rt_tlsf_free(large, mem[i]));
+    }
+    tlsf_check(large, NULL, NULL);
+    for (i = 1; i < 8; i += 2) {
+        TEST_ASSERT_EQUAL(0, rt_tlsf_free(large, mem[i]));
+    }
+    tlsf_check(large, NULL, NULL);
+    rt_tlsf_stats(large, &stats);
+    TEST_ASSERT_EQUAL(0, stats.frag);
+    heap_replay_pool_free(large, size);
+}
+
+/* The pool of the replays: the traces of the clock application peak at
+   under 8 KB live, with 64-bit host pointers in the headers */
+#define REPLAY_POOL_SZ  (12 * 1024)
+
+static const char *trace_path;
+
+static void check_replay(const heap_replay_heap_t *heap, const heap_replay_trace_t *trace)
+{
+    heap_replay_stats_t stats;
+    uint32_t free0, largest0, free, largest;
+
+    TEST_ASSERT_EQUAL(0, heap->init(pool, REPLAY_POOL_SZ));
+    heap->report(pool, &free0, &largest0);
+    heap_replay_run(heap, pool, trace, 1, &stats);
+    printf("%s %s: %u allocations, %u failed, %u frees, frag %.3f mean %.3f max, free %u least\n",
+           trace_path, heap->name, (unsigned)stats.allocs, (unsigned)stats.failed,
+           (unsigned)stats.frees, stats.frag_sum / stats.samples, stats.frag_max,
+           (unsigned)stats.free_min);
+    TEST_ASSERT_EQUAL(0, stats.failed);
+    TEST_ASSERT(stats.frees > 0);
+    if (heap == &heap_replay_tlsf) {
+        tlsf_check(pool, NULL, NULL);
+    }
+    heap_replay_release(heap, pool);
+    heap->report(pool, &free, &largest);
+    TEST_ASSERT_EQUAL(free0, free);
+    TEST_ASSERT_EQUAL(largest0, largest);
+}
+
+static void test_replay(void)
+{
+    heap_replay_trace_t trace;
+
+    TEST_ASSERT_EQUAL(0, heap_replay_load(trace_path, &trace));
+    check_replay(&heap_replay_first_fit, &trace);
+    check_replay(&heap_replay_tlsf, &trace);
+    heap_replay_unload(&trace);
+}
+
+int main(int argc, char *argv[])
+{
+    int i;
+
+    pool = heap_replay_pool(POOL_SZ);
+    TEST_ASSERT_NOT_NULL(pool);
+
+    RUN_TEST(test_tlsf_random);
+    RUN_TEST(test_frag_first_fit);
+    RUN_TEST(test_frag_tlsf);
+    RUN_TEST(test_frag_large_pool);
+    for (i = 1; i < argc; i++) {
+        trace_path = argv[i];
+        RUN_TEST(test_replay);
+    }
+    heap_replay_pool_free(pool, POOL_SZ);
+    return 0;
+}
@@ -0,0 +1,251 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <string.h>
+#include <time.h>
+#include "rtos.h"
+#include "os_host.h"
+#include "host_test.h"
+
+/* Tests of the host port of the RTOS, in virtual time: every result below
+   is exact, and the same on every run. */
+
+using namespace rtos;
+using mbed::callback;
+
+#define MAX_LOG 64
+
+static char order_log[MAX_LOG];
+static int order_len;
+
+static void log_char(char c)
+{
+    if (order_len < MAX_LOG - 1) {
+        order_log[order_len++] = c;
+        order_log[order_len] = '\0';
+    }
+}
+
+static void log_id(const char *id)
+{
+    log_char(*id);
+}
+
+static void log_reset(void)
+{
+    order_len = 0;
+    order_log[0] = '\0';
+}
+
+static double wall_seconds(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* An hour of sleep takes the virtual hour, and no wall time */
+static void test_virtual_delay(void)
+{
+    uint64_t start = os_host_time();
+    double wall = wall_seconds();
+
+    Thread::wait(3600 * 1000);
+    TEST_ASSERT_UINT_WITHIN(1000, 3600ULL * 1000000, os_host_time() - start);
+    TEST_ASSERT(wall_seconds() - wall < 1.0);
+}
+
+static void high_task(void)
+{
+    log_char('H');
+}
+
+/* A thread of higher priority runs as soon as it is started, one of equal
+   priority when the starter waits */
+static void test_priority_preemption(void)
+{
+    Thread high(osPriorityHigh);
+    Thread same(osPriorityNormal);
+
+    log_reset();
+    same.start(callback(log_id, "S"));
+    log_char('m');
+    high.start(high_task);
+    log_char('M');
+    Thread::wait(1);
+    high.join();
+    same.join();
+    TEST_ASSERT_EQUAL(0, strcmp(order_log, "mHMS"));
+}
+
+static Mutex inherit_mutex;
+static Semaphore inherit_locked(0);
+static osPriority inherit_after;
+
+static void low_holder(void)
+{
+    inherit_mutex.lock();
+    inherit_locked.release();
+    Thread::wait(10);
+    log_char('L');
+    inherit_mutex.unlock();
+    inherit_after = osThreadGetPriority(osThreadGetId());
+}
+
+static void high_waiter(void)
+{
+    inherit_mutex.lock();
+    log_char('H');
+    inherit_mutex.unlock();
+}
+
+/* A thread holding a mutex runs at the priority of its highest waiter */
+static void test_priority_inheritance(void)
+{
+    Thread low(osPriorityLow);
+    Thread high(osPriorityHigh);
+
+    log_reset();
+    low.start(low_holder);
+    inherit_locked.wait();
+    high.start(high_waiter);
+    TEST_ASSERT_EQUAL(osPriorityHigh, low.get_priority());
+    low.join();
+    high.join();
+    TEST_ASSERT_EQUAL(osPriorityLow, inherit_after);
+    TEST_ASSERT_EQUAL(0, strcmp(order_log, "LH"));
+}
+
+static volatile int timer_count;
+
+static void timer_tick(void)
+{
+    timer_count++;
+}
+
+/* A periodic timer fires once per period, however long the run */
+static void test_periodic_timer(void)
+{
+    RtosTimer timer(callback(timer_tick), osTimerPeriodic);
+
+    timer_count = 0;
+    timer.start(10);
+    Thread::wait(10 * 1000 + 5);
+    timer.stop();
+    TEST_ASSERT_EQUAL(1000, timer_count);
+}
+
+static Semaphore irq_sem(0);
+static uint64_t irq_time[3];
+
+static void irq_handler(void *arg)
+{
+    int n = (int)(intptr_t)arg;
+
+    irq_time[n] = os_host_time();
+    log_char('0' + n);
+    irq_sem.release();
+}
+
+/* Interrupts run at their due time, in order, and wake the threads waiting
+   on them */
+static void test_irq(void)
+{
+    uint64_t start = os_host_time();
+    int i;
+
+    log_reset();
+    os_host_irq(irq_handler, (void *)2, 3000);
+    os_host_irq(irq_handler, (void *)0, 1000);
+    os_host_irq(irq_handler, (void *)1, 2000);
+    for (i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(1, irq_sem.wait(100));
+    }
+    TEST_ASSERT_EQUAL(0, strcmp(order_log, "012"));
+    for (i = 0; i < 3; i++) {
+        TEST_ASSERT_UINT_WITHIN(10, (i + 1) * 1000, irq_time[i] - start);
+    }
+    /* An interrupt cannot block: waits in it time out at once */
+    TEST_ASSERT_EQUAL(0, irq_sem.wait(100));
+}
+
+static Mutex race_mutex;
+
+static void racer(const char *id)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        race_mutex.lock();
+        log_id(id);
+        race_mutex.unlock();
+        Thread::yield();
+    }
+}
+
+static void run_race(uint32_t seed, char *out)
+{
+    Thread a, b, c;
+
+    os_host_config(OS_HOST_VIRTUAL, seed);
+    log_reset();
+    a.start(callback(racer, "a"));
+    b.start(callback(racer, "b"));
+    c.start(callback(racer, "c"));
+    a.join();
+    b.join();
+    c.join();
+    strcpy(out, order_log);
+    os_host_config(OS_HOST_VIRTUAL, 0);
+}
+
+/* A seed gives the same interleaving every time, and seeds differ */
+static void test_seed_replay(void)
+{
+    char plain[MAX_LOG], first[MAX_LOG], again[MAX_LOG];
+    bool differs = false;
+    uint32_t seed;
+
+    run_race(0, plain);
+    TEST_ASSERT_EQUAL(24, strlen(plain));
+    for (seed = 1; seed <= 8; seed++) {
+        run_race(seed, first);
+        run_race(seed, again);
+        TEST_ASSERT_EQUAL(0, strcmp(first, again));
+        if (strcmp(first, plain) != 0) {
+            differs = true;
+        }
+    }
+    TEST_ASSERT(differs);
+}
+
+int main()
+{
+    os_host_config(OS_HOST_VIRTUAL, 0);
+
+    RUN_TEST(test_virtual_delay);
+    RUN_TEST(test_priority_preemption);
+    RUN_TEST(test_priority_inheritance);
+    RUN_TEST(test_periodic_timer);
+    RUN_TEST(test_irq);
+    RUN_TEST(test_seed_replay);
+    return 0;
+}
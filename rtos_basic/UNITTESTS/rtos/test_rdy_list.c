@@ -0,0 +1,410 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/* ahead of the C library, which leaves NULL as rt_TypeDef.h has it */
+#include "rt_List.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+
+/* Tests of the ready list of rt_List.c against a model: arrays of the
+   tasks in the order the kernel must find them in the ready list and in a
+   semaphore wait list, highest priority first and first come first within
+   a priority, except for tasks put back at the head by rt_put_rdy_first.
+   Random calls to the list functions, made the way rt_Task.c,
+   rt_Semaphore.c, rt_Mutex.c and rt_Robin.c make them, are checked after
+   each call against the model, and with OS_RDYBITMAP against the last
+   task of each level and the bitmap as well. The build runs the test with
+   and without OS_RDYBITMAP, so both ready lists are held to one order. */
+
+#define NTASK       24
+#define STEPS       100000
+#define SEEDS       8
+
+/* Of the kernel, which the test stands in for. The post service queue is
+   not used, but has room for a few entries of the host size. */
+U32 os_fifo[2 + 4 * 4];
+U32 os_time;
+struct OS_TSK os_tsk;
+
+void os_error (U32 err_code) {
+    TEST_FAIL_MESSAGE("os_error");
+}
+
+static struct OS_TCB tasks[NTASK];
+static struct OS_TCB running;
+/* A semaphore, as the list functions see it */
+static struct OS_XCB sem;
+
+typedef struct {
+    P_TCB t[NTASK];
+    int n;
+} model_list;
+
+static model_list rdy;
+static model_list waiting;
+
+/* Insert behind the tasks of the same or a higher priority */
+static void model_put(model_list *l, P_TCB p)
+{
+    int i = l->n, j;
+
+    while ((i > 0) && (l->t[i - 1]->prio < p->prio)) {
+        i--;
+    }
+    for (j = l->n; j > i; j--) {
+        l->t[j] = l->t[j - 1];
+    }
+    l->t[i] = p;
+    l->n++;
+}
+
+static void model_put_first(model_list *l, P_TCB p)
+{
+    int j;
+
+    for (j = l->n; j > 0; j--) {
+        l->t[j] = l->t[j - 1];
+    }
+    l->t[0] = p;
+    l->n++;
+}
+
+static void model_rmv(model_list *l, P_TCB p)
+{
+    int i = 0;
+
+    while (l->t[i] != p) {
+        i++;
+        TEST_ASSERT(i < l->n);
+    }
+    l->n--;
+    for (; i < l->n; i++) {
+        l->t[i] = l->t[i + 1];
+    }
+}
+
+static void check_lists(void)
+{
+    P_TCB p, prev;
+    int i;
+#if (OS_RDYBITMAP)
+    U32 map = 0;
+    U32 lvl;
+#endif
+
+    prev = (P_TCB)&os_rdy;
+    for (i = 0, p = os_rdy.p_lnk; p != NULL; i++, prev = p, p = p->p_lnk) {
+        TEST_ASSERT(i < rdy.n);
+        TEST_ASSERT(p == rdy.t[i]);
+        TEST_ASSERT_EQUAL(READY, p->state);
+#if (OS_RDYBITMAP)
+        TEST_ASSERT(p->p_rlnk == prev);
+        lvl = RDY_LVL(p->prio);
+        map |= 1U << lvl;
+        if ((p->p_lnk == NULL) || (RDY_LVL(p->p_lnk->prio) != lvl)) {
+            TEST_ASSERT(os_rdy_tail[lvl] == p);
+        }
+#else
+        TEST_ASSERT_NULL(p->p_rlnk);
+#endif
+    }
+    TEST_ASSERT_EQUAL(rdy.n, i);
+#if (OS_RDYBITMAP)
+    TEST_ASSERT_EQUAL(map, os_rdy_map);
+#endif
+
+    prev = (P_TCB)&sem;
+    for (i = 0, p = sem.p_lnk; p != NULL; i++, prev = p, p = p->p_lnk) {
+        TEST_ASSERT(i < waiting.n);
+        TEST_ASSERT(p == waiting.t[i]);
+        TEST_ASSERT(p->p_rlnk == prev);
+    }
+    TEST_ASSERT_EQUAL(waiting.n, i);
+}
+
+static void lists_init(void)
+{
+    int i;
+
+    os_rdy.cb_type = HCB;
+    os_rdy.p_lnk   = NULL;
+#if (OS_RDYBITMAP)
+    os_rdy_map     = 0U;
+#endif
+    os_time = 0U;
+    rt_whl_init(&os_dly, os_time);
+    sem.cb_type = SCB;
+    sem.p_lnk   = NULL;
+    rdy.n = 0;
+    waiting.n = 0;
+    for (i = 0; i < NTASK; i++) {
+        memset(&tasks[i], 0, sizeof(tasks[i]));
+        tasks[i].cb_type = TCB;
+        tasks[i].state   = INACTIVE;
+        tasks[i].task_id = (U8)(i + 1);
+    }
+    running.cb_type = TCB;
+    running.state   = RUNNING;
+    os_tsk.run = &running;
+}
+
+/* Mostly the CMSIS priorities, and now and then one of the native RTX
+   priorities above 30, which share the top level of the bitmap */
+static U8 random_prio(void)
+{
+    if ((rand() % 8) == 0) {
+        return (U8)(31 + rand() % 10);
+    }
+    return (U8)(rand() % 8);
+}
+
+static void make_ready(P_TCB p)
+{
+    p->state = READY;
+    rt_put_prio(&os_rdy, p);
+    model_put(&rdy, p);
+}
+
+/* A thread switch, as rt_dispatch makes it */
+static void dispatch(void)
+{
+    P_TCB p = rt_get_first(&os_rdy);
+
+    TEST_ASSERT(p == rdy.t[0]);
+    model_rmv(&rdy, p);
+    running.prio = p->prio;
+    p->state = INACTIVE;
+}
+
+/* A wait for the semaphore with a timeout, as rt_sem_wait makes it */
+static void sem_wait(P_TCB p)
+{
+    p->state = WAIT_SEM;
+    rt_put_prio(&sem, p);
+    rt_put_dly(p, 1U + (U32)(rand() % 20));
+    model_put(&waiting, p);
+}
+
+/* A token given to the first waiter, as rt_sem_send gives it */
+static void sem_send(void)
+{
+    P_TCB p = rt_get_first(&sem);
+
+    TEST_ASSERT(p == waiting.t[0]);
+    model_rmv(&waiting, p);
+    rt_rmv_dly(p);
+    make_ready(p);
+}
+
+/* A system tick: the tasks whose delay expires are made ready, and are
+   taken into the model in the order the wheel gave them */
+static void tick(void)
+{
+    U8 was[NTASK];
+    P_TCB p;
+    int i;
+
+    for (i = 0; i < NTASK; i++) {
+        was[i] = tasks[i].state;
+    }
+    os_time++;
+    rt_dec_dly();
+    for (p = os_rdy.p_lnk; p != NULL; p = p->p_lnk) {
+        i = (int)(p - tasks);
+        if ((was[i] == WAIT_SEM) || (was[i] == WAIT_DLY)) {
+            if (was[i] == WAIT_SEM) {
+                model_rmv(&waiting, p);
+            }
+            model_put(&rdy, p);
+        }
+    }
+}
+
+/* A change of priority, as rt_tsk_prio and the mutex inheritance make it */
+static void change_prio(P_TCB p)
+{
+    p->prio = random_prio();
+    rt_resort_prio(p);
+    if (p->state == READY) {
+        model_rmv(&rdy, p);
+        model_put(&rdy, p);
+    } else if (p->state == WAIT_SEM) {
+        model_rmv(&waiting, p);
+        model_put(&waiting, p);
+    }
+}
+
+/* A task deleted, as rt_tsk_delete removes it */
+static void delete_task(P_TCB p)
+{
+    rt_rmv_list(p);
+    rt_rmv_dly(p);
+    if (p->state == READY) {
+        model_rmv(&rdy, p);
+    } else if (p->state == WAIT_SEM) {
+        model_rmv(&waiting, p);
+    }
+    p->state = INACTIVE;
+    p->p_lnk = NULL;
+    p->p_rlnk = NULL;
+}
+
+static void random_step(void)
+{
+    P_TCB p = &tasks[rand() % NTASK], q;
+    int op = rand() % 8;
+
+    switch (p->state) {
+    case INACTIVE:
+        p->prio = random_prio();
+        if (op < 3) {
+            make_ready(p);
+        } else if (op < 4) {
+            /* a preempted task, put back at the head by rt_switch_req */
+            if ((os_rdy.p_lnk == NULL) || (p->prio >= os_rdy.p_lnk->prio)) {
+                p->state = READY;
+                rt_put_rdy_first(p);
+                model_put_first(&rdy, p);
+            }
+        } else if (op < 6) {
+            sem_wait(p);
+        } else {
+            p->state = WAIT_DLY;
+            rt_put_dly(p, 1U + (U32)(rand() % 20));
+        }
+        break;
+    case READY:
+    case WAIT_SEM:
+        if (op < 2) {
+            delete_task(p);
+        } else if (op < 4) {
+            change_prio(p);
+        }
+        break;
+    default:
+        break;
+    }
+
+    switch (rand() % 8) {
+    case 0:
+        if (os_rdy.p_lnk != NULL) {
+            dispatch();
+        }
+        break;
+    case 1:
+        /* a time slice ended, as rt_chk_robin ends it */
+        if (os_rdy.p_lnk != NULL) {
+            running.prio = (rand() % 2) ? os_rdy.p_lnk->prio : random_prio();
+            q = rt_get_same_rdy_prio();
+            if (running.prio == rdy.t[0]->prio) {
+                TEST_ASSERT(q == rdy.t[0]);
+                model_rmv(&rdy, q);
+                q->state = INACTIVE;
+            } else {
+                TEST_ASSERT_NULL(q);
+            }
+        }
+        break;
+    case 2:
+        if (sem.p_lnk != NULL) {
+            sem_send();
+        }
+        break;
+    case 3:
+        tick();
+        break;
+    default:
+        break;
+    }
+}
+
+static void test_order(void)
+{
+    static const U8 prio[] = {3, 5, 1, 5, 35, 3, 31, 0, 5, 40, 3};
+    static const int order[] = {9, 4, 6, 1, 3, 8, 0, 5, 10, 2, 7};
+    P_TCB p;
+    int i;
+
+    lists_init();
+    for (i = 0; i < (int)(sizeof(prio) / sizeof(prio[0])); i++) {
+        tasks[i].prio = prio[i];
+        make_ready(&tasks[i]);
+        check_lists();
+    }
+    for (i = 0, p = os_rdy.p_lnk; p != NULL; i++, p = p->p_lnk) {
+        TEST_ASSERT(p == &tasks[order[i]]);
+    }
+}
+
+/* The rotation of rt_chk_robin: the next task of the running priority
+   runs, and the running task goes behind the others of its priority */
+static void test_round_robin(void)
+{
+    P_TCB run, next;
+    int i;
+
+    lists_init();
+    for (i = 0; i < 4; i++) {
+        tasks[i].prio = 4;
+        make_ready(&tasks[i]);
+    }
+    tasks[4].prio = 2;
+    make_ready(&tasks[4]);
+    dispatch();
+    run = &tasks[0];
+    for (i = 1; i < 10; i++) {
+        next = rt_get_same_rdy_prio();
+        TEST_ASSERT(next == &tasks[i % 4]);
+        model_rmv(&rdy, next);
+        run->state = READY;
+        rt_put_prio(&os_rdy, run);
+        model_put(&rdy, run);
+        check_lists();
+        run = next;
+    }
+    TEST_ASSERT(rdy.t[rdy.n - 1] == &tasks[4]);
+}
+
+static void test_random(void)
+{
+    unsigned seed;
+    int i;
+
+    for (seed = 1; seed <= SEEDS; seed++) {
+        srand(seed);
+        lists_init();
+        for (i = 0; i < STEPS; i++) {
+            random_step();
+            check_lists();
+        }
+    }
+}
+
+int main()
+{
+    printf("OS_RDYBITMAP %d\n", OS_RDYBITMAP);
+    RUN_TEST(test_order);
+    RUN_TEST(test_round_robin);
+    RUN_TEST(test_random);
+    return 0;
+}
@@ -0,0 +1,321 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "rtos.h"
+#include "os_host.h"
+#include "host_test.h"
+
+/* Tests of SpscRing and MpscRing on the host port, in virtual time. The
+   port takes interrupts and switches threads at the barriers of the rings
+   as well as at kernel calls, so an interrupt handler that raises itself
+   again steps a producer through each window of the consumer, and seeds
+   interleave producers between claiming a slot and publishing it. */
+
+using namespace rtos;
+using mbed::callback;
+
+#define RING_SZ     8
+
+/* An item of producer p, the nth it puts */
+#define ITEM(p, n)  (((uint32_t)(p) << 24) | (uint32_t)(n))
+
+template<class Ring>
+static void check_empty_full(void)
+{
+    Ring ring;
+    uint32_t item = 0;
+    uint32_t i;
+
+    TEST_ASSERT(ring.empty());
+    TEST_ASSERT_FALSE(ring.try_get(item));
+    TEST_ASSERT_FALSE(ring.get(item, 0));
+    for (i = 0; i < RING_SZ; i++) {
+        TEST_ASSERT(ring.put(i));
+        TEST_ASSERT_EQUAL(i + 1, ring.count());
+    }
+    TEST_ASSERT_FALSE(ring.put(RING_SZ));
+    TEST_ASSERT_EQUAL(RING_SZ, ring.count());
+    for (i = 0; i < RING_SZ; i++) {
+        TEST_ASSERT(ring.try_get(item));
+        TEST_ASSERT_EQUAL(i, item);
+    }
+    TEST_ASSERT(ring.empty());
+    TEST_ASSERT_FALSE(ring.try_get(item));
+    /* the slot freed by a get takes the next put */
+    TEST_ASSERT(ring.put(1));
+    TEST_ASSERT(ring.try_get(item));
+    TEST_ASSERT_EQUAL(1, item);
+}
+
+/* Fills of every depth, so that the indices go round the slots many times
+   and from every starting slot */
+template<class Ring>
+static void check_wrap(void)
+{
+    Ring ring;
+    uint32_t put = 0, got = 0, item = 0;
+    uint32_t round, depth, i;
+
+    for (round = 0; round < 1000; round++) {
+        /* up to a full ring, with the item left from the last round */
+        depth = 1 + (round * 5) % (RING_SZ - 1);
+        for (i = 0; i < depth; i++) {
+            TEST_ASSERT(ring.put(put++));
+        }
+        TEST_ASSERT_EQUAL(put - got, ring.count());
+        /* leave one behind now and then, to shift the phase */
+        while (ring.count() > (round % 3 == 0 ? 1U : 0U)) {
+            TEST_ASSERT(ring.try_get(item));
+            TEST_ASSERT_EQUAL(got++, item);
+        }
+    }
+    while (ring.try_get(item)) {
+        TEST_ASSERT_EQUAL(got++, item);
+    }
+    TEST_ASSERT_EQUAL(put, got);
+}
+
+template<class Ring>
+struct Stepper {
+    Ring *ring;
+    int steps;
+    uint32_t item;
+};
+
+/* Put the item from an interrupt, after as many kernel calls and barriers
+   of the running thread as there are steps */
+template<class Ring>
+static void step_put(void *arg)
+{
+    Stepper<Ring> *s = (Stepper<Ring> *)arg;
+
+    if (--s->steps > 0) {
+        os_host_irq(step_put<Ring>, s, 0);
+    } else {
+        TEST_ASSERT(s->ring->put(s->item));
+    }
+}
+
+/* A put landing anywhere in get(): before it, between raising the waiting
+   flag and checking the ring again, on the way into the semaphore, or
+   once the consumer blocks, must always end the wait. The port cannot
+   place an interrupt between the first failed check and the flag, as
+   there is no barrier there; the check after raising the flag is what
+   catches such a put on the target. */
+template<class Ring>
+static void check_lost_wakeup(void)
+{
+    Ring ring;
+    Stepper<Ring> s;
+    uint32_t item = 0;
+    uint64_t start;
+    int k;
+
+    s.ring = &ring;
+    for (k = 1; k <= 10; k++) {
+        s.steps = k;
+        s.item = k;
+        start = os_host_time();
+        os_host_irq(step_put<Ring>, &s, 0);
+        TEST_ASSERT(ring.get(item, 100));
+        TEST_ASSERT_EQUAL(k, item);
+        /* no time passed, so the put did not wait for the timeout */
+        TEST_ASSERT(os_host_time() - start < 1000);
+        TEST_ASSERT(ring.empty());
+    }
+    /* wake-ups left over by puts that found the flag raised do not make
+       an empty ring look full, nor cut a timeout short */
+    start = os_host_time();
+    TEST_ASSERT_FALSE(ring.get(item, 10));
+    TEST_ASSERT(os_host_time() - start >= 10000);
+    TEST_ASSERT_FALSE(ring.get(item, 0));
+
+    /* a put after the consumer blocked, well within the timeout */
+    s.steps = 1;
+    s.item = 42;
+    start = os_host_time();
+    os_host_irq(step_put<Ring>, &s, 5000);
+    TEST_ASSERT(ring.get(item, 10));
+    TEST_ASSERT_EQUAL(42, item);
+    TEST_ASSERT_UINT_WITHIN(100, 5000, os_host_time() - start);
+}
+
+static void test_spsc_empty_full(void)
+{
+    check_empty_full<SpscRing<uint32_t, RING_SZ> >();
+}
+
+static void test_spsc_wrap(void)
+{
+    check_wrap<SpscRing<uint32_t, RING_SZ> >();
+}
+
+static void test_spsc_lost_wakeup(void)
+{
+    check_lost_wakeup<SpscRing<uint32_t, RING_SZ> >();
+}
+
+static SpscRing<uint32_t, RING_SZ> stream_ring;
+static uint32_t stream_next;
+
+/* A producer in an interrupt, taken at every kernel call and barrier of
+   the consumer */
+static void stream_producer(void *arg)
+{
+    if (stream_ring.put(stream_next)) {
+        stream_next++;
+    }
+    if (stream_next < 1000) {
+        os_host_irq(stream_producer, NULL, 0);
+    }
+}
+
+static void test_spsc_isr_stream(void)
+{
+    uint32_t i, item = 0;
+
+    stream_next = 0;
+    os_host_irq(stream_producer, NULL, 0);
+    for (i = 0; i < 1000; i++) {
+        TEST_ASSERT(stream_ring.get(item, 1000));
+        TEST_ASSERT_EQUAL(i, item);
+    }
+    TEST_ASSERT(stream_ring.empty());
+}
+
+static void test_mpsc_empty_full(void)
+{
+    check_empty_full<MpscRing<uint32_t, RING_SZ> >();
+}
+
+static void test_mpsc_wrap(void)
+{
+    check_wrap<MpscRing<uint32_t, RING_SZ> >();
+}
+
+static void test_mpsc_lost_wakeup(void)
+{
+    check_lost_wakeup<MpscRing<uint32_t, RING_SZ> >();
+}
+
+#define PRODUCERS       3
+#define PER_PRODUCER    300
+
+static MpscRing<uint32_t, RING_SZ> shared_ring;
+static uint32_t isr_next;
+static uint32_t held_back;
+
+static void thread_producer(const char *id)
+{
+    uint32_t p = (uint32_t)(*id - '0');
+    uint32_t n = 0;
+
+    while (n < PER_PRODUCER) {
+        if (shared_ring.put(ITEM(p, n))) {
+            n++;
+        } else {
+            Thread::yield();
+        }
+    }
+}
+
+/* A producer in an interrupt, taken at every kernel call and barrier */
+static void isr_producer(void *arg)
+{
+    if (shared_ring.put(ITEM(PRODUCERS, isr_next))) {
+        isr_next++;
+    }
+    if (isr_next < PER_PRODUCER) {
+        os_host_irq(isr_producer, NULL, 0);
+    }
+}
+
+/* Every item arrives once, and those of one producer in order */
+static void consume_all(void)
+{
+    uint32_t next[PRODUCERS + 1] = {0};
+    uint32_t item = 0, p, total;
+
+    for (total = 0; total < (PRODUCERS + 1) * PER_PRODUCER; total++) {
+        if (!shared_ring.try_get(item)) {
+            /* a slot claimed and not yet published holds back the rest */
+            held_back += !shared_ring.empty();
+            TEST_ASSERT_MESSAGE(shared_ring.get(item, 1000), "producers stalled");
+        }
+        p = item >> 24;
+        TEST_ASSERT(p <= PRODUCERS);
+        TEST_ASSERT_EQUAL(next[p], item & 0xffffff);
+        next[p]++;
+    }
+    TEST_ASSERT(shared_ring.empty());
+}
+
+static void run_producers(uint32_t seed, osPriority consumer_priority)
+{
+    Thread producers[PRODUCERS];
+    static const char *const ids[PRODUCERS] = {"0", "1", "2"};
+    int i;
+
+    os_host_config(OS_HOST_VIRTUAL, seed);
+    osThreadSetPriority(osThreadGetId(), consumer_priority);
+    isr_next = 0;
+    for (i = 0; i < PRODUCERS; i++) {
+        producers[i].start(callback(thread_producer, ids[i]));
+    }
+    os_host_irq(isr_producer, NULL, 0);
+    consume_all();
+    for (i = 0; i < PRODUCERS; i++) {
+        producers[i].join();
+    }
+    osThreadSetPriority(osThreadGetId(), osPriorityNormal);
+    os_host_config(OS_HOST_VIRTUAL, 0);
+}
+
+/* Three threads and an interrupt handler against one consumer, under
+   several schedules, with the consumer ahead of the producers or sharing
+   their priority */
+static void test_mpsc_producers(void)
+{
+    uint32_t seed;
+
+    held_back = 0;
+    for (seed = 0; seed < 16; seed++) {
+        run_producers(seed, osPriorityNormal);
+        run_producers(seed, osPriorityHigh);
+    }
+    printf("consumer held back by an unpublished slot %u times\n", (unsigned)held_back);
+    TEST_ASSERT(held_back > 0);
+}
+
+int main()
+{
+    os_host_config(OS_HOST_VIRTUAL, 0);
+
+    RUN_TEST(test_spsc_empty_full);
+    RUN_TEST(test_spsc_wrap);
+    RUN_TEST(test_spsc_lost_wakeup);
+    RUN_TEST(test_spsc_isr_stream);
+    RUN_TEST(test_mpsc_empty_full);
+    RUN_TEST(test_mpsc_wrap);
+    RUN_TEST(test_mpsc_lost_wakeup);
+    RUN_TEST(test_mpsc_producers);
+    return 0;
+}
@@ -0,0 +1,328 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "rtos.h"
+#include "rtos/StackMonitor.h"
+#include "os_host.h"
+#include "host_test.h"
+
+#undef NULL     // as in StackMonitor.cpp, rt_TypeDef.h defines its own
+#include "rt_TypeDef.h"
+
+/* Tests of StackMonitor on the host port of the RTOS, built with a table of
+   STACK_MONITOR_ENTRIES (4) threads. The threads run on host stacks, so a
+   test stands for their stack use by writing into the stack memory they
+   were given, as a thread would write below its stack pointer. */
+
+using namespace rtos;
+using mbed::callback;
+
+#define STACK_FILL      0xE25A2EA5
+#define STACK_PATTERN   0xCCCCCCCC
+#define STACK_SIZE      512
+#define STACK_WORDS     (STACK_SIZE / 4)
+#define MIN_FREE        128
+
+extern "C" P_TCB rt_tid2ptcb(osThreadId thread_id);
+extern "C" osThreadId osThreadId_osTimerThread;
+
+static int warnings;
+static StackMonitor::Entry warned;
+
+static void on_warning(const StackMonitor::Entry &entry)
+{
+    warnings++;
+    warned = entry;
+}
+
+static char lines[STACK_MONITOR_ENTRIES + 1][128];
+static int num_lines;
+
+static void print_line(const char *line)
+{
+    TEST_ASSERT(num_lines <= STACK_MONITOR_ENTRIES);
+    strcpy(lines[num_lines++], line);
+}
+
+static void wait_task(void)
+{
+    Thread::signal_wait(1);
+}
+
+static void wait_thread(void const *argument)
+{
+    Thread::signal_wait(1);
+}
+
+/* Stack use as a thread leaves it: the top bytes written, the rest filled */
+static void use_stack(uint32_t *stack, uint32_t bytes)
+{
+    for (uint32_t i = STACK_WORDS - bytes / 4; i < STACK_WORDS; i++) {
+        stack[i] = 0x20000000 + i;
+    }
+}
+
+static const StackMonitor::Entry *find(StackMonitor &monitor, uint32_t arg)
+{
+    static StackMonitor::Entry entries[STACK_MONITOR_ENTRIES];
+    int num = monitor.table(entries, STACK_MONITOR_ENTRIES);
+
+    for (int i = 0; i < num; i++) {
+        if (entries[i].arg == arg) {
+            return &entries[i];
+        }
+    }
+    return (const StackMonitor::Entry *)NULL;
+}
+
+/* The main thread shares its stack with the heap and is listed unmeasured */
+static void test_main_thread(void)
+{
+    StackMonitor monitor;
+    StackMonitor::Entry entries[STACK_MONITOR_ENTRIES];
+
+    monitor.check();
+    TEST_ASSERT_EQUAL(1, monitor.table(entries, STACK_MONITOR_ENTRIES));
+    TEST_ASSERT(entries[0].id == Thread::gettid());
+    TEST_ASSERT_EQUAL(MAIN_THREAD_ID, entries[0].task_id);
+    TEST_ASSERT_FALSE(entries[0].measured);
+    TEST_ASSERT(entries[0].active);
+
+    num_lines = 0;
+    monitor.print(&print_line);
+    TEST_ASSERT_EQUAL(2, num_lines);
+    TEST_ASSERT(strstr(lines[1], "     -     -       - main (shares the heap)") != NULL);
+}
+
+/* A Thread stack, filled when the thread starts: the largest use is kept,
+   and the warning comes once, when the free stack first falls below the
+   threshold */
+static void test_high_water(void)
+{
+    static uint32_t stack[STACK_WORDS];
+    StackMonitor monitor(1000, MIN_FREE);
+    Thread thread(osPriorityHigh, STACK_SIZE, (unsigned char *)stack);
+    const StackMonitor::Entry *e;
+    uint32_t arg = (uint32_t)(uintptr_t)&thread;
+
+    monitor.attach_warning(&on_warning);
+    warnings = 0;
+    TEST_ASSERT_EQUAL(osOK, thread.start(callback(wait_task)));
+    TEST_ASSERT_EQUAL(STACK_FILL, stack[1]);
+
+    use_stack(stack, 64);
+    monitor.check();
+    e = find(monitor, arg);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT(e->measured);
+    TEST_ASSERT_EQUAL(STACK_SIZE, e->size);
+    TEST_ASSERT_EQUAL(64, e->max_used);
+    // Already filled: the monitor leaves the stack as it is
+    TEST_ASSERT_EQUAL(STACK_FILL, stack[1]);
+    TEST_ASSERT_EQUAL(0, warnings);
+
+    use_stack(stack, 400);
+    monitor.check();
+    TEST_ASSERT_EQUAL(400, find(monitor, arg)->max_used);
+    TEST_ASSERT_EQUAL(1, warnings);
+    TEST_ASSERT(warned.arg == arg);
+    TEST_ASSERT_EQUAL(400, warned.max_used);
+    TEST_ASSERT(warned.warned);
+
+    // Deeper still: recorded, but no second warning
+    use_stack(stack, 448);
+    monitor.check();
+    TEST_ASSERT_EQUAL(448, find(monitor, arg)->max_used);
+    TEST_ASSERT_EQUAL(1, warnings);
+
+    // The watermark is never lowered
+    for (uint32_t i = 1; i < STACK_WORDS; i++) {
+        stack[i] = STACK_FILL;
+    }
+    monitor.check();
+    TEST_ASSERT_EQUAL(448, find(monitor, arg)->max_used);
+
+    // Suggested size: the use plus the margin, in 8-byte units
+    unsigned task_id;
+    unsigned long entry, targ, size, used, free_bytes, suggest;
+    num_lines = 0;
+    monitor.print(&print_line);
+    TEST_ASSERT_EQUAL(3, num_lines);
+    TEST_ASSERT_EQUAL(7, sscanf(lines[2], "%u %lx %lx %lu %lu %lu %lu", &task_id,
+                                &entry, &targ, &size, &used, &free_bytes, &suggest));
+    TEST_ASSERT_EQUAL(arg, targ);
+    TEST_ASSERT_EQUAL(STACK_SIZE, size);
+    TEST_ASSERT_EQUAL(448, used);
+    TEST_ASSERT_EQUAL(STACK_SIZE - 448, free_bytes);
+    TEST_ASSERT_EQUAL((448 + MIN_FREE + 7) & ~7UL, suggest);
+
+    thread.signal_set(1);
+    thread.join();
+}
+
+/* A stack that was not filled at creation, such as that of an
+   osThreadCreate thread without OS_STKINIT: the monitor fills it below the
+   saved stack pointer when it first sees the thread, and measures from
+   there */
+static void test_fill_first_sight(void)
+{
+    // tsk_stack holds the stack pointer in 32 bits
+    uint32_t *stack = (uint32_t *)mmap(NULL, STACK_SIZE, PROT_READ | PROT_WRITE,
+                                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    TEST_ASSERT(stack != MAP_FAILED);
+    osThreadDef_t def = { wait_thread, osPriorityHigh, 1, STACK_SIZE, stack };
+    StackMonitor monitor(1000, MIN_FREE);
+    const StackMonitor::Entry *e;
+    osThreadId id;
+    P_TCB tcb;
+
+    for (uint32_t i = 0; i < STACK_WORDS; i++) {
+        stack[i] = 0x11111111;
+    }
+    stack[0] = STACK_FILL;          // the RTX overflow check word
+    id = osThreadCreate(&def, &def);
+    TEST_ASSERT_NOT_NULL(id);
+    Thread::yield();
+    tcb = rt_tid2ptcb(id);
+    TEST_ASSERT_NOT_NULL(tcb);
+    // The thread waits with 96 bytes on its stack
+    tcb->tsk_stack = (uint32_t)(uintptr_t)&stack[STACK_WORDS - 24];
+
+    monitor.check();
+    for (uint32_t i = 1; i < STACK_WORDS - 24; i++) {
+        TEST_ASSERT_EQUAL(STACK_PATTERN, stack[i]);
+    }
+    for (uint32_t i = STACK_WORDS - 24; i < STACK_WORDS; i++) {
+        TEST_ASSERT_EQUAL(0x11111111, stack[i]);
+    }
+    e = find(monitor, (uint32_t)(uintptr_t)&def);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT(e->measured);
+    TEST_ASSERT_EQUAL(96, e->max_used);
+
+    // Filled once only: later use is measured, not painted over
+    use_stack(stack, 200);
+    monitor.check();
+    TEST_ASSERT_EQUAL(STACK_PATTERN, stack[1]);
+    TEST_ASSERT_EQUAL(200, find(monitor, (uint32_t)(uintptr_t)&def)->max_used);
+
+    TEST_ASSERT_EQUAL(osOK, osThreadTerminate(id));
+    munmap(stack, STACK_SIZE);
+}
+
+/* Terminated threads stay in the table until their entry is needed */
+static void test_terminated(void)
+{
+    static uint32_t stacks[STACK_MONITOR_ENTRIES + 1][STACK_WORDS];
+    Thread *threads[STACK_MONITOR_ENTRIES + 1];
+    StackMonitor::Entry entries[STACK_MONITOR_ENTRIES];
+    StackMonitor monitor(1000, MIN_FREE);
+    const int n = STACK_MONITOR_ENTRIES - 1;    // with main, a full table
+    int terminated = 0;
+
+    for (int i = 0; i <= n; i++) {
+        threads[i] = new Thread(osPriorityHigh, STACK_SIZE, (unsigned char *)stacks[i]);
+    }
+    for (int i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL(osOK, threads[i]->start(callback(wait_task)));
+        use_stack(stacks[i], 32 * (i + 1));
+    }
+    monitor.check();
+    TEST_ASSERT_EQUAL(STACK_MONITOR_ENTRIES, monitor.table(entries, STACK_MONITOR_ENTRIES));
+
+    // No room for another thread
+    TEST_ASSERT_EQUAL(osOK, threads[n]->start(callback(wait_task)));
+    monitor.check();
+    TEST_ASSERT_NULL(find(monitor, (uint32_t)(uintptr_t)threads[n]));
+
+    // The first thread ends: kept, with its use, until the table is full
+    threads[0]->signal_set(1);
+    threads[0]->join();
+    monitor.check();
+    const StackMonitor::Entry *e = find(monitor, (uint32_t)(uintptr_t)threads[0]);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_FALSE(e->active);
+    TEST_ASSERT_EQUAL(32, e->max_used);
+    num_lines = 0;
+    monitor.print(&print_line);
+    for (int i = 1; i < num_lines; i++) {
+        if (strstr(lines[i], "(terminated)") != NULL) {
+            terminated++;
+        }
+    }
+    TEST_ASSERT_EQUAL(1, terminated);
+    // ... and the thread that had no room takes its entry
+    TEST_ASSERT_NULL(find(monitor, (uint32_t)(uintptr_t)threads[n]));
+    monitor.check();
+    TEST_ASSERT_NULL(find(monitor, (uint32_t)(uintptr_t)threads[0]));
+    e = find(monitor, (uint32_t)(uintptr_t)threads[n]);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT(e->active);
+    TEST_ASSERT_EQUAL(0, e->max_used);
+    TEST_ASSERT_EQUAL(64, find(monitor, (uint32_t)(uintptr_t)threads[1])->max_used);
+
+    for (int i = 1; i <= n; i++) {
+        threads[i]->signal_set(1);
+        threads[i]->join();
+    }
+    for (int i = 0; i <= n; i++) {
+        delete threads[i];
+    }
+}
+
+static void tick(void)
+{
+}
+
+/* The timer thread runs on a stack the host port does not record: listed
+   by name, unmeasured */
+static void test_timer_thread(void)
+{
+    StackMonitor monitor;
+    RtosTimer timer(callback(tick));
+    StackMonitor::Entry entries[STACK_MONITOR_ENTRIES];
+    int num;
+
+    monitor.check();
+    num = monitor.table(entries, STACK_MONITOR_ENTRIES);
+    TEST_ASSERT_EQUAL(2, num);
+    TEST_ASSERT(entries[1].id == osThreadId_osTimerThread);
+    TEST_ASSERT_FALSE(entries[1].measured);
+    num_lines = 0;
+    monitor.print(&print_line);
+    TEST_ASSERT(strstr(lines[2], " timer (OS_TIMERSTKSZ)") != NULL);
+}
+
+int main()
+{
+    os_host_config(OS_HOST_VIRTUAL, 0);
+
+    RUN_TEST(test_main_thread);
+    RUN_TEST(test_high_water);
+    RUN_TEST(test_fill_first_sight);
+    RUN_TEST(test_terminated);
+    RUN_TEST(test_timer_thread);
+    return 0;
+}
@@ -0,0 +1,211 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/* ahead of the C library, which leaves NULL as rt_TypeDef.h has it */
+#include "rt_Trace.c"
+#include <stdint.h>
+#include <string.h>
+#include "host_test.h"
+
+/* Tests of the CPU usage accounting and the scheduler trace ring of
+   rt_Trace.c. The cycle counter is a variable the test advances: random
+   thread switches, with random run times that take the 32-bit counter
+   around several times, are checked against the cycles the test charged
+   to each task itself, and against the switch events left in the ring.
+   The build runs the test with OS_CPUSTAT on and off (test_trace_nostat),
+   which leaves the counts at zero but the trace as it is. */
+
+#ifndef TEST_CPUSTAT
+#define TEST_CPUSTAT    1
+#endif
+#define NTASK           6
+#define TRACE_SIZE      16
+#define SWITCHES        100000
+
+/* Of the kernel and its configuration, which the test stands in for */
+struct OS_TSK os_tsk;
+U32 os_time;
+U16 const os_maxtaskrun = NTASK;
+U64 os_tsk_cycles[NTASK + 1];
+U32 os_trace_buf[TRACE_SIZE * 3];
+U8  const os_cpustat = TEST_CPUSTAT;
+U16 const os_trace_size = TRACE_SIZE;
+
+U32 host_demcr, host_dwt_control, host_dwt_cyccnt, host_primask;
+
+/* The tasks, and the idle task at the end with its id of 255 */
+static struct OS_TCB tasks[NTASK + 1];
+static U64 charged[NTASK + 1];
+
+static U32 rand_state = 1;
+
+static U32 next_rand(void)
+{
+    rand_state = rand_state * 1103515245U + 12345U;
+    return rand_state >> 8;
+}
+
+static U32 obj_of(P_TCB p)
+{
+    return (U32)(uintptr_t)p;
+}
+
+static void start(void)
+{
+    int i;
+
+    memset(tasks, 0, sizeof(tasks));
+    memset(charged, 0, sizeof(charged));
+    memset(os_trace_buf, 0, sizeof(os_trace_buf));
+    for (i = 0; i < NTASK; i++) {
+        tasks[i].task_id = (U8)(i + 1);
+        os_tsk_cycles[i] = 0xdeadbeef;
+    }
+    tasks[NTASK].task_id = 255U;
+    host_demcr = 0U;
+    host_dwt_control = 0U;
+    host_dwt_cyccnt = 0xfffff000U;
+    host_primask = 0U;
+    os_tsk.run = NULL;
+    rt_trace_init();
+}
+
+/* The entry of the ring an event went to */
+static const U32 *event(U32 n)
+{
+    return &os_trace_buf[(n & (TRACE_SIZE - 1)) * 3];
+}
+
+static void test_init(void)
+{
+    int i;
+
+    start();
+    TEST_ASSERT(host_demcr & DEMCR_TRCENA);
+    TEST_ASSERT(host_dwt_control & DWT_CYCCNTENA);
+    for (i = 0; i <= NTASK; i++) {
+        TEST_ASSERT_EQUAL(0, os_tsk_cycles[i]);
+    }
+    TEST_ASSERT_EQUAL(0, os_trace_head);
+    TEST_ASSERT_EQUAL(1, os_trace_on);
+    TEST_ASSERT_EQUAL(0, rt_trace_tid());
+}
+
+/* Each run is charged to the task that ran it, across counter wraps, and
+   each switch leaves an event with the time, both task ids and the TCB */
+static void test_switches(void)
+{
+    P_TCB prev = NULL;
+    U32 stamp = host_dwt_cyccnt, head = 0;
+    int i, n;
+
+    start();
+    for (n = 0; n < SWITCHES; n++) {
+        P_TCB next = &tasks[next_rand() % (NTASK + 1)];
+        U32 r = next_rand();
+        /* Mostly short runs, some of them long enough to wrap */
+        U32 run = (r & 1) ? (r & 0xfff) : (r << 9);
+
+        host_dwt_cyccnt += run;
+        rt_trace_switch(next);
+        if (next == prev) {
+            /* A tick asking for the running task: nothing to record */
+            TEST_ASSERT_EQUAL(head, os_trace_head);
+            continue;
+        }
+        if (prev != NULL) {
+            charged[prev - tasks] += (U32)(host_dwt_cyccnt - stamp);
+        }
+        stamp = host_dwt_cyccnt;
+        TEST_ASSERT_EQUAL(++head, os_trace_head);
+        TEST_ASSERT_EQUAL(host_dwt_cyccnt, event(head - 1)[0]);
+        TEST_ASSERT_EQUAL(TRC_INFO(TRC_SWITCH, next->task_id, (prev != NULL) ? prev->task_id : 0U),
+                          event(head - 1)[1]);
+        TEST_ASSERT_EQUAL(obj_of(next), event(head - 1)[2]);
+        os_tsk.run = next;
+        prev = next;
+        TEST_ASSERT_EQUAL(next->task_id, rt_trace_tid());
+
+        /* The running task's count includes its current run */
+        host_dwt_cyccnt += r & 0xff;
+        TEST_ASSERT_EQUAL(TEST_CPUSTAT ? charged[next - tasks] + (U32)(host_dwt_cyccnt - stamp) : 0,
+                          rt_trace_cycles(next));
+        TEST_ASSERT_EQUAL(0, host_primask);
+    }
+    for (i = 0; i <= NTASK; i++) {
+        TEST_ASSERT(charged[i] > 0);
+        TEST_ASSERT_EQUAL(TEST_CPUSTAT ? charged[i] : 0, os_tsk_cycles[i]);
+    }
+    TEST_ASSERT(charged[0] > 0x100000000ULL);
+}
+
+/* The ring keeps the latest events in order, and nothing while off */
+static void test_ring(void)
+{
+    U32 n;
+
+    start();
+    for (n = 0; n < 5 * TRACE_SIZE + 3; n++) {
+        host_dwt_cyccnt = n * 1000U;
+        rt_trace_put(TRC_INFO(TRC_SEM_GIVE, n & 0xff, n), n);
+    }
+    TEST_ASSERT_EQUAL(5 * TRACE_SIZE + 3, os_trace_head);
+    for (n = 4 * TRACE_SIZE + 3; n < 5 * TRACE_SIZE + 3; n++) {
+        TEST_ASSERT_EQUAL(n * 1000U, event(n)[0]);
+        TEST_ASSERT_EQUAL(TRC_INFO(TRC_SEM_GIVE, n & 0xff, n), event(n)[1]);
+        TEST_ASSERT_EQUAL(n, event(n)[2]);
+    }
+
+    os_trace_on = 0U;
+    rt_trace_put(TRC_INFO(TRC_ISR, 0, 15), 0);
+    TEST_ASSERT_EQUAL(5 * TRACE_SIZE + 3, os_trace_head);
+
+    /* An event put with interrupts masked leaves them masked */
+    os_trace_on = 1U;
+    host_primask = 1U;
+    rt_trace_put(TRC_INFO(TRC_ISR, 0, 15), 0);
+    TEST_ASSERT_EQUAL(5 * TRACE_SIZE + 4, os_trace_head);
+    TEST_ASSERT_EQUAL(1, host_primask);
+    host_primask = 0U;
+}
+
+/* A new task starts from zero, in the slot of its id; the idle task has
+   the last slot */
+static void test_clear(void)
+{
+    start();
+    os_tsk_cycles[2] = 1234;
+    os_tsk_cycles[NTASK] = 5678;
+    rt_trace_clear(&tasks[2]);
+    TEST_ASSERT_EQUAL(0, os_tsk_cycles[2]);
+    TEST_ASSERT_EQUAL(5678, os_tsk_cycles[NTASK]);
+    rt_trace_clear(&tasks[NTASK]);
+    TEST_ASSERT_EQUAL(0, os_tsk_cycles[NTASK]);
+}
+
+int main(void)
+{
+    RUN_TEST(test_init);
+    RUN_TEST(test_switches);
+    RUN_TEST(test_ring);
+    RUN_TEST(test_clear);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_HOST_TIME_H
+#define MBED_HOST_TIME_H
+
+/* Host stand-in for mbed.h, for the TimeInterface sources that are built
+   on their own in the host tests: the battery backed RTC registers they
+   keep their state in, as plain memory that a test can inspect, reset or
+   keep across a simulated reset of the board. time() is the C library's;
+   the tests wrap it (-Wl,--wrap=time) to run on a simulated clock. */
+
+#include <stdint.h>
+#include <time.h>
+
+typedef struct {
+    volatile uint32_t CCR;
+    volatile uint32_t CALIBRATION;
+    volatile uint32_t GPREG0;
+    volatile uint32_t GPREG1;
+    volatile uint32_t GPREG2;
+    volatile uint32_t GPREG3;
+    volatile uint32_t GPREG4;
+} LPC_RTC_TypeDef;
+
+extern LPC_RTC_TypeDef host_rtc;
+#define LPC_RTC (&host_rtc)
+
+#endif
@@ -0,0 +1,265 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "DriftEstimator.h"
+#include "host_test.h"
+
+/* Simulation of the RTC drift learning of DriftEstimator, for oscillators
+   with given frequency errors, synced with NTP once a day.
+
+   The RTC runs at 1 + ppm/10^6 of real time. Its calibration works as on
+   the LPC1768: with a value of cal, the counter skips (cal < 0) or adds
+   (cal > 0) one whole second every |cal| seconds it counts. At each sync
+   the offset, real time less RTC time plus a NTP error of up to
+   +/-JITTER_MS, goes to DriftEstimator::add_sample() with the
+   calibration in effect, as TimeInterface::synced() passes it; a new
+   calibration is written to the register, and the clock is stepped by
+   the offset, as NTPClient steps it.
+
+   Each run reports the offset found at each sync, which is the error the
+   clock gathered over the day, and the largest error at any time of the
+   day, sampled every STEP_S seconds. The calibration steps whole seconds,
+   so the clock runs up to a second off between them whatever the
+   estimate: that error is the sawtooth of the calibration, not of the
+   estimate, and shows in the offsets at the syncs as well.
+
+   A second set of runs resets the board before a sync: the estimator is
+   built again, and resumes from the fit kept in GPREG2 to GPREG4, with
+   the error rounded to 0.001 ppm. */
+
+#define DAY_S           86400
+#define DAYS            21
+#define STEP_S          10
+#define JITTER_MS       5
+#define START_TIME      1700000000
+#define RESET_DAY       5
+#define CAL_MIN_PPM     (1e6 / 131071)
+#define EST_PPM         0.05    // estimate once the history has three days
+#define SAWTOOTH_MS     1050    // a calibration step, plus the NTP error
+
+/* The battery backed RTC registers of mbed_host/mbed.h */
+LPC_RTC_TypeDef host_rtc;
+
+/* The RTC time in seconds, as time() reads it */
+static time_t rtc_now;
+
+extern "C" time_t __wrap_time(time_t *t)
+{
+    if (t != NULL) {
+        *t = rtc_now;
+    }
+    return rtc_now;
+}
+
+/* The calibration register, encoded as TimeInterface::set_cal writes it */
+static int32_t get_cal(void)
+{
+    int32_t calvalue = LPC_RTC->CALIBRATION & 0x3FFFF;
+
+    if (calvalue & 0x20000) {
+        calvalue = -(calvalue & 0x1FFFF);
+    }
+    return calvalue;
+}
+
+static void set_cal(int32_t calibration)
+{
+    if (calibration < 0) {
+        calibration = (-calibration & 0x1FFFF) | 0x20000;
+    }
+    LPC_RTC->CALIBRATION = calibration;
+}
+
+typedef struct {
+    double ppm;         // oscillator error, positive when fast
+    double real_us;     // real time
+    double rtc_us;      // RTC time, with its sub-second phase
+    double cal_count;   // seconds counted towards the next calibration step
+    double worst_ms;    // largest error since the last sync
+} sim_clock;
+
+typedef struct {
+    double offset_ms[DAYS + 1];     // offset found at each sync
+    double worst_ms[DAYS + 1];      // largest error during the day before it
+    double est_ppm[DAYS + 1];       // estimate after the sync
+    int32_t cal[DAYS + 1];          // calibration after the sync
+} sim_result;
+
+static uint32_t rand_state;
+
+static double jitter_us(void)
+{
+    rand_state = rand_state * 1103515245u + 12345u;
+    return ((double)(rand_state >> 8) / (1u << 24) * 2.0 - 1.0) * JITTER_MS * 1000.0;
+}
+
+static void advance(sim_clock *c, double dt_s)
+{
+    double rtc_s = dt_s * (1.0 + c->ppm * 1e-6);
+    int32_t cal = get_cal();
+    double err_ms;
+
+    c->real_us += dt_s * 1e6;
+    c->rtc_us += rtc_s * 1e6;
+    if (cal != 0) {
+        c->cal_count += rtc_s;
+        while (c->cal_count >= abs(cal)) {
+            c->cal_count -= abs(cal);
+            c->rtc_us += (cal > 0) ? 1e6 : -1e6;
+        }
+    }
+    err_ms = fabs(c->real_us - c->rtc_us) / 1000.0;
+    if (err_ms > c->worst_ms) {
+        c->worst_ms = err_ms;
+    }
+    rtc_now = (time_t)floor(c->rtc_us / 1e6);
+}
+
+static void simulate(double ppm, int reset_day, sim_result *r)
+{
+    DriftEstimator *drift;
+    sim_clock c = {ppm, START_TIME * 1e6, START_TIME * 1e6, 0.0, 0.0};
+    double offset_us;
+    int day, s;
+
+    memset(&host_rtc, 0, sizeof(host_rtc));
+    rand_state = 1;
+    rtc_now = START_TIME;
+    drift = new DriftEstimator();
+    for (day = 0; day <= DAYS; day++) {
+        if (day > 0) {
+            c.worst_ms = 0.0;
+            for (s = 0; s < DAY_S; s += STEP_S) {
+                advance(&c, STEP_S);
+            }
+        }
+        if (day == reset_day) {
+            delete drift;
+            drift = new DriftEstimator();
+            TEST_ASSERT_EQUAL(2, drift->count());
+        }
+        offset_us = c.real_us - c.rtc_us + jitter_us();
+        if (drift->add_sample(rtc_now, (int32_t)offset_us, get_cal())) {
+            set_cal(drift->get_cal());
+        }
+        c.rtc_us += offset_us;
+        rtc_now = (time_t)floor(c.rtc_us / 1e6);
+
+        r->offset_ms[day] = offset_us / 1000.0;
+        r->worst_ms[day] = c.worst_ms;
+        r->est_ppm[day] = drift->get_ppm();
+        r->cal[day] = get_cal();
+    }
+    delete drift;
+}
+
+static const double ppms[] = {-100, -23, -5, 5, 23, 50, 100, 200};
+
+static void print_header(void)
+{
+    printf("%7s %4s %8s %8s %8s %8s %8s %7s %9s %9s\n", "ppm", "day", "est", "cal",
+           "off/day1", "off/day2", "off/day3", "off max", "worst", "worst");
+    printf("%7s %4s %8s %8s %8s %8s %8s %7s %9s %9s\n", "", "", "ppm", "", "ms", "ms", "ms",
+           "ms 4-21", "ms 1-3", "ms 4-21");
+}
+
+/* One line per oscillator: the estimate at the end, the offsets of the
+   first syncs, and the largest offset and error once the history has three
+   days in it */
+static void print_result(double ppm, const sim_result *r)
+{
+    double off_max = 0.0, worst_early = 0.0, worst_late = 0.0;
+    int day;
+
+    for (day = 1; day <= DAYS; day++) {
+        if (day <= 3) {
+            worst_early = fmax(worst_early, r->worst_ms[day]);
+        } else {
+            off_max = fmax(off_max, fabs(r->offset_ms[day]));
+            worst_late = fmax(worst_late, r->worst_ms[day]);
+        }
+    }
+    printf("%7.1f %4d %8.3f %8d %8.1f %8.1f %8.1f %7.1f %9.1f %9.1f\n", ppm, DAYS,
+           r->est_ppm[DAYS], (int)r->cal[DAYS], r->offset_ms[1], r->offset_ms[2],
+           r->offset_ms[3], off_max, worst_early, worst_late);
+}
+
+/* Once three days are in, the estimate is within EST_PPM and the clock
+   within a calibration step of real time, reset or not; a clock too good
+   to calibrate stays within its own drift over a day. */
+static void check_result(double ppm, const sim_result *r)
+{
+    double bound_ms;
+    int day;
+
+    if (fabs(ppm) < CAL_MIN_PPM) {
+        bound_ms = fabs(ppm) * DAY_S / 1000.0 + 2 * JITTER_MS;
+    } else {
+        bound_ms = SAWTOOTH_MS;
+    }
+    for (day = 4; day <= DAYS; day++) {
+        TEST_ASSERT(fabs(r->est_ppm[day] - ppm) < EST_PPM);
+        TEST_ASSERT(r->worst_ms[day] < bound_ms);
+        if (fabs(ppm) < CAL_MIN_PPM) {
+            TEST_ASSERT_EQUAL(0, r->cal[day]);
+        } else {
+            TEST_ASSERT(fabs(r->cal[day] + 1e6 / ppm) < fabs(1e6 / ppm) * 1e-3);
+        }
+    }
+}
+
+static void test_converge(void)
+{
+    sim_result r;
+    unsigned i;
+
+    print_header();
+    for (i = 0; i < sizeof(ppms) / sizeof(ppms[0]); i++) {
+        simulate(ppms[i], -1, &r);
+        print_result(ppms[i], &r);
+        check_result(ppms[i], &r);
+    }
+}
+
+static void test_restore(void)
+{
+    sim_result r;
+    unsigned i;
+
+    printf("reset before the sync of day %d\n", RESET_DAY);
+    print_header();
+    for (i = 0; i < sizeof(ppms) / sizeof(ppms[0]); i++) {
+        simulate(ppms[i], RESET_DAY, &r);
+        print_result(ppms[i], &r);
+        check_result(ppms[i], &r);
+    }
+}
+
+int main()
+{
+    RUN_TEST(test_converge);
+    RUN_TEST(test_restore);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "mbed.h"
+#include "uLCD_4DGL.h"
+#include "calendarDisplay.h"
+
+static const char * monthName[] = { "", "January", "February", "March", "April", "May", "June",
+    "July", "August", "September", "October", "November", "December" };
+
+calendarDisplay::calendarDisplay(uLCD_4DGL &lcd) : screen(lcd) {
+}
+
+// Each row goes out as one text_string, instead of a printf that sends
+// every character as its own command and waits for its ack. Rows are
+// padded to the full width, so no cls is needed between months.
+void calendarDisplay::showMonth(uint8_t month, uint16_t year, int today) {
+    char line[24];
+    char header[] = "Su Mo Tu We Th Fr Sa";
+
+    page.Compute(month, year);
+    screen.textbackground_color(BLACK);
+    sprintf(line, "%-15s%5d", monthName[month], year);
+    screen.text_string(line, 0, 0, FONT_5X7, WHITE);
+    screen.text_string(header, 0, 1, FONT_5X7, GREEN);
+    for (int row = 0; row < 6; row++) {
+        char *p = line;
+        for (int col = 0; col < 7; col++) {
+            int i = row * 7 + col;
+            if (i < page.DayMapEntries() && page.DayMap[i] != 0) {
+                p += sprintf(p, "%2d", page.DayMap[i]);
+            } else {
+                p += sprintf(p, "  ");
+            }
+            if (col < 6) {
+                *p++ = ' ';
+            }
+        }
+        *p = '\0';
+        screen.text_string(line, 0, row + 2, FONT_5X7, WHITE);
+    }
+    if (today >= 1 && today <= 31) {
+        int i = page.FirstDay() + today - 1;
+        if (i < page.DayMapEntries() && page.DayMap[i] == today) {
+            sprintf(line, "%2d", today);
+            screen.textbackground_color(RED);
+            screen.text_string(line, (i % 7) * 3, i / 7 + 2, FONT_5X7, WHITE);
+            screen.textbackground_color(BLACK);
+        }
+    }
+    screen.set_font(FONT_7X8);
+}
@@ -0,0 +1,12 @@
+#include "mbed.h"
+#include "uLCD_4DGL.h"
+#include "CalendarPage.h"
+class calendarDisplay
+{
+    public:
+        calendarDisplay(uLCD_4DGL &lcd);
+        void showMonth(uint8_t month, uint16_t year, int today = 0);
+    private:
+        uLCD_4DGL &screen;
+        CalendarPage page;
+};
@@ -9,6 +9,8 @@
 #include <string>
 #include <TimeInterface.h>
 #include "rtos.h"
+#include "rtos/rtos_idle.h"
+#include "rtos/rtos_mutex_profile.h"
 
 Motor A(p22, p6, p5, 1); // pwm, fwd, rev, can brake 
 Motor B(p21, p7, p8, 1); // pwm, fwd, rev, can brake
@@ -44,6 +46,13 @@ int charCount = 0;
 int matched = 0;
 int dist0 = 0;
 
+#if RTOS_MUTEX_PROFILE
+void print_line(const char *line)
+{
+    device.printf("%s\r\n", line);
+}
+#endif
+
 void dist(int distance)
 {
     //put code here to execute when the distance has changed
@@ -128,6 +137,7 @@ void robotMove_thread()
 
 int main()
 {
+    rtos_attach_idle_hook(&rtos_idle_tickless);  // no kernel ticks while idle
     hourSet.mode(PullDown);
     minSet.mode(PullDown);
     snooze.mode(PullDown);
@@ -158,6 +168,11 @@ int main()
         int val = atoi(cT.c_str());
         int val2 = atoi(aT.c_str());
         device.baud(9600);
+#if RTOS_MUTEX_PROFILE
+        if (device.readable() && device.getc() == 'm') {
+            rtos_mutex_profile_dump(&print_line, 8);    // most contended locks
+        }
+#endif
         //device.printf("val 1 is %d\n\r", val);
         //device.printf("val 1 is %s\n\r", checkSuffix(std::abs(val-val2), 50));
         bool result = std::abs(val-val2) % 50 == 0;
@@ -0,0 +1,139 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "mbed.h"
+#include "rtos.h"
+
+/* Thread switch latency of the RTX scheduler against the number of ready
+   threads, in processor cycles, for the LPC1768.
+
+   Up to MAX_FILLERS threads at the priority of main yield in a loop, so
+   the ready list holds that many threads of one level. main times a round
+   of yields with the DWT cycle counter: one yield of main and one of each
+   filler, ready+1 thread switches, each of which puts the yielding thread
+   behind the others of its level. It prints the cheapest round and the
+   mean per switch. As a cross-check it also prints the cycles per filler
+   turn from the CPU usage accounting (os_tsk_cycles, read through
+   Thread::cpu_cycles), which charges the cycles up to each switch to the
+   thread that was running.
+
+   The mean includes the SysTick and the round robin; the cheapest round
+   does not. With OS_RDYBITMAP the cycles per switch stay flat as threads
+   are added; build with -DOS_RDYBITMAP=0 to compare with the plain list,
+   which walks the level at every switch. The mbed tools leave TESTS out
+   of the application build; build this as a test of its own, or copy it
+   to an empty program with mbed-rtos, and read the results at 9600 baud. */
+
+#ifndef OS_RDYBITMAP
+#define OS_RDYBITMAP    1   // as RTX_Config.h defaults it
+#endif
+
+#define MAX_FILLERS     12  // OS_TASKCNT is 14 on the LPC1768
+#define ROUNDS          2000
+#define FILLER_STACK    512
+
+static volatile bool stop;
+static volatile uint32_t turns[MAX_FILLERS];
+
+static uint32_t cycles_now(void)
+{
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        // Normally running already for the kernel's CPU usage accounting
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+    return DWT->CYCCNT;
+}
+
+static void filler(volatile uint32_t *count)
+{
+    while (!stop) {
+        Thread::yield();
+        (*count)++;
+    }
+}
+
+static void measure(int ready)
+{
+    Thread *threads[MAX_FILLERS];
+    uint64_t cycles_before[MAX_FILLERS];
+    uint32_t turns_before[MAX_FILLERS];
+    uint64_t filler_cycles = 0;
+    uint32_t filler_turns = 0;
+    uint32_t t0, dt, best = 0xFFFFFFFFu;
+    uint64_t total = 0;
+    int i, r;
+
+    stop = false;
+    for (i = 0; i < ready; i++) {
+        turns[i] = 0;
+        threads[i] = new Thread(osPriorityNormal, FILLER_STACK);
+        threads[i]->start(callback(filler, &turns[i]));
+    }
+    // Let every filler reach its loop
+    Thread::yield();
+    Thread::yield();
+    for (i = 0; i < ready; i++) {
+        cycles_before[i] = threads[i]->cpu_cycles();
+        turns_before[i] = turns[i];
+    }
+
+    for (r = 0; r < ROUNDS; r++) {
+        t0 = cycles_now();
+        Thread::yield();
+        dt = cycles_now() - t0;
+        total += dt;
+        if (dt < best) {
+            best = dt;
+        }
+    }
+
+    for (i = 0; i < ready; i++) {
+        filler_cycles += threads[i]->cpu_cycles() - cycles_before[i];
+        filler_turns += turns[i] - turns_before[i];
+    }
+    stop = true;
+    for (i = 0; i < ready; i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    printf("%-7s %5d %10lu %10lu %10lu\r\n", OS_RDYBITMAP ? "bitmap" : "linear", ready,
+           (unsigned long)(best / (ready + 1)),
+           (unsigned long)(total / ((uint64_t)ROUNDS * (ready + 1))),
+           (unsigned long)(filler_turns ? filler_cycles / filler_turns : 0));
+}
+
+int main()
+{
+    static const int counts[] = {1, 2, 4, 8, 12};
+    unsigned i;
+
+    printf("\r\nthread switch cycles, %lu Hz core clock\r\n", (unsigned long)SystemCoreClock);
+    printf("%-7s %5s %10s %10s %10s\r\n", "list", "ready", "best", "mean", "per turn");
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        measure(counts[i]);
+    }
+    printf("done\r\n");
+    while (true) {
+        Thread::wait(1000);
+    }
+}
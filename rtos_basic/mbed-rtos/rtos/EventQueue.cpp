@@ -0,0 +1,243 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "rtos/EventQueue.h"
+
+#include "platform/critical.h"
+#include "platform/mbed_error.h"
+#include "us_ticker_api.h"
+
+/* Longest a worker sleeps at a time, so the queue clock is read well
+ * within the 71 minute wrap of the microsecond ticker. */
+#define EVENT_QUEUE_MAX_WAIT    600000
+
+namespace rtos {
+
+enum {
+    EVENT_FREE,
+    EVENT_PENDING,
+    EVENT_RUNNING,
+    EVENT_CANCELLED                     // running, and not to be run again
+};
+
+EventQueue::EventQueue(uint32_t event_count)
+    : _free(NULL), _pending(NULL), _event_count(event_count), _used(0),
+      _now_ms(0), _sleepers(0), _wakeups(0), _workers(NULL), _worker_count(0) {
+    _events = new Event[event_count];
+    if (_events == NULL) {
+        error("Error initialising the event queue\n");
+    }
+    for (uint32_t i = event_count; i > 0; i--) {
+        _events[i - 1].state = EVENT_FREE;
+        _events[i - 1].gen = 0;
+        _events[i - 1].next = _free;
+        _free = &_events[i - 1];
+    }
+    _last_us = us_ticker_read();
+}
+
+/* Advance the queue clock. Call in a critical section. */
+uint32_t EventQueue::tick() {
+    uint32_t us = us_ticker_read();
+    uint32_t elapsed = us - _last_us;
+
+    _now_ms += elapsed / 1000;
+    _last_us = us - elapsed % 1000;
+    return _now_ms;
+}
+
+/* Put an event in the pending list, after those due at the same time.
+ * Call in a critical section. */
+void EventQueue::insert(Event *e) {
+    Event **p = &_pending;
+
+    while (*p != NULL && (int32_t)((*p)->due - e->due) <= 0) {
+        p = &(*p)->next;
+    }
+    e->next = *p;
+    *p = e;
+    e->state = EVENT_PENDING;
+}
+
+/* Return an event to the arena. Call in a critical section. */
+void EventQueue::release(Event *e) {
+    e->state = EVENT_FREE;
+    e->func = NULL;
+    e->next = _free;
+    _free = e;
+    _used--;
+}
+
+int EventQueue::post(uint32_t delay, uint32_t period, mbed::Callback<void()> func) {
+    Event *e;
+    int id;
+
+    core_util_critical_section_enter();
+    e = _free;
+    if (e == NULL) {
+        core_util_critical_section_exit();
+        return 0;
+    }
+    _free = e->next;
+    _used++;
+    e->func = func;
+    e->due = tick() + delay;
+    e->period = period;
+    e->gen = (e->gen + 1) & 0x7FFF;
+    if (e->gen == 0) {
+        e->gen = 1;
+    }
+    id = ((int)e->gen << 16) | (int)(e - _events + 1);
+    insert(e);
+    // Wake a sleeping thread, unless enough are already woken
+    bool wake = (_wakeups < _sleepers);
+    if (wake) {
+        _wakeups++;
+    }
+    core_util_critical_section_exit();
+    if (wake) {
+        _sem.release();
+    }
+    return id;
+}
+
+bool EventQueue::cancel(int id) {
+    uint32_t index = (uint32_t)(id & 0xFFFF) - 1;
+    bool removed = false;
+
+    if (id <= 0 || index >= _event_count) {
+        return false;
+    }
+    core_util_critical_section_enter();
+    Event *e = &_events[index];
+    if (e->gen == (uint16_t)(id >> 16)) {
+        if (e->state == EVENT_PENDING) {
+            Event **p = &_pending;
+            while (*p != e) {
+                p = &(*p)->next;
+            }
+            *p = e->next;
+            release(e);
+            removed = true;
+        } else if (e->state == EVENT_RUNNING) {
+            e->state = EVENT_CANCELLED;
+        }
+    }
+    core_util_critical_section_exit();
+    return removed;
+}
+
+void EventQueue::dispatch(uint32_t millisec) {
+    uint32_t start, now, wait;
+    int32_t tokens;
+    Event *e;
+
+    core_util_critical_section_enter();
+    start = tick();
+    core_util_critical_section_exit();
+
+    for (;;) {
+        core_util_critical_section_enter();
+        now = tick();
+        e = _pending;
+        if (e != NULL && (int32_t)(e->due - now) <= 0) {
+            _pending = e->next;
+            e->state = EVENT_RUNNING;
+            core_util_critical_section_exit();
+
+            e->func();
+
+            core_util_critical_section_enter();
+            if (e->state == EVENT_RUNNING && e->period != 0) {
+                e->due += e->period;
+                now = tick();
+                if ((int32_t)(e->due - now) < 0) {
+                    e->due = now;       // fell behind: skip the missed runs
+                }
+                insert(e);
+            } else {
+                release(e);
+            }
+            core_util_critical_section_exit();
+            continue;
+        }
+
+        // Nothing due: sleep until the next event or the end of the run
+        wait = (e != NULL) ? e->due - now : osWaitForever;
+        if (millisec != osWaitForever) {
+            if (now - start >= millisec) {
+                core_util_critical_section_exit();
+                return;
+            }
+            if (wait > millisec - (now - start)) {
+                wait = millisec - (now - start);
+            }
+        }
+        if (wait > EVENT_QUEUE_MAX_WAIT) {
+            wait = EVENT_QUEUE_MAX_WAIT;
+        }
+        _sleepers++;
+        core_util_critical_section_exit();
+
+        tokens = _sem.wait(wait);
+
+        core_util_critical_section_enter();
+        _sleepers--;
+        if (tokens > 0 && _wakeups > 0) {
+            _wakeups--;
+        }
+        core_util_critical_section_exit();
+    }
+}
+
+void EventQueue::worker() {
+    dispatch(osWaitForever);
+}
+
+osStatus EventQueue::start(uint32_t workers, osPriority priority, uint32_t stack_size) {
+    if (_workers != NULL || workers == 0) {
+        return osErrorValue;
+    }
+    _workers = new Thread*[workers];
+    for (uint32_t i = 0; i < workers; i++) {
+        _workers[i] = new Thread(priority, stack_size);
+        osStatus status = _workers[i]->start(mbed::callback(this, &EventQueue::worker));
+        _worker_count++;
+        if (status != osOK) {
+            return status;
+        }
+    }
+    return osOK;
+}
+
+uint32_t EventQueue::count() {
+    return _used;
+}
+
+EventQueue::~EventQueue() {
+    for (uint32_t i = 0; i < _worker_count; i++) {
+        delete _workers[i];
+    }
+    delete[] _workers;
+    delete[] _events;
+}
+
+}
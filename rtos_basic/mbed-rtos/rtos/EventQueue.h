@@ -0,0 +1,155 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <stdint.h>
+#include "cmsis_os.h"
+#include "platform/Callback.h"
+#include "rtos/Thread.h"
+#include "rtos/Semaphore.h"
+
+namespace rtos {
+/** \addtogroup rtos */
+/** @{*/
+
+/** The EventQueue class runs callbacks on a pool of worker threads.
+ Instead of a thread with its own stack per activity, work is posted to
+ the queue as events, each a callback to run now, after a delay, or
+ periodically. Events come from a fixed arena allocated when the queue is
+ created, so posting takes no heap and is safe from an ISR. Events run in
+ the order they fall due, one at a time on each worker thread, and must
+ not block for long, since they hold up the events behind them.
+
+ @code
+ EventQueue queue(16);
+
+ void echo_isr() {
+     queue.call(callback(&sonar, &Sonar::update));
+ }
+
+ int main() {
+     queue.call_every(100, &blink);
+     queue.start(1);
+     ...
+ @endcode
+*/
+class EventQueue {
+public:
+    /** Create an event queue, without worker threads.
+      @param   event_count  most events that can be pending or running at a time. (default: 16)
+    */
+    EventQueue(uint32_t event_count=16);
+
+    /** Post an event to run as soon as possible.
+      @param   func  callback to run.
+      @return  event id, for cancel(), or 0 if all events are in use.
+      @note callable from interrupt
+    */
+    int call(mbed::Callback<void()> func) {
+        return post(0, 0, func);
+    }
+
+    /** Post an event to run after a delay.
+      @param   millisec  delay in milliseconds.
+      @param   func      callback to run.
+      @return  event id, for cancel(), or 0 if all events are in use.
+      @note callable from interrupt
+    */
+    int call_in(uint32_t millisec, mbed::Callback<void()> func) {
+        return post(millisec, 0, func);
+    }
+
+    /** Post an event to run periodically, the first time after one period.
+      @param   millisec  period in milliseconds, non-zero.
+      @param   func      callback to run.
+      @return  event id, for cancel(), or 0 if all events are in use.
+      @note callable from interrupt
+    */
+    int call_every(uint32_t millisec, mbed::Callback<void()> func) {
+        return post(millisec, millisec ? millisec : 1, func);
+    }
+
+    /** Cancel a pending event.
+      A periodic event that is running is not run again.
+      @param   id  event id returned when the event was posted.
+      @return  true if the event was removed before it ran, false if it ran already or is running.
+      @note callable from interrupt
+    */
+    bool cancel(int id);
+
+    /** Start worker threads that run the events.
+      @param   workers     number of worker threads. (default: 1)
+      @param   priority    priority of the worker threads. (default: osPriorityNormal)
+      @param   stack_size  stack size of each worker thread in bytes. (default: DEFAULT_STACK_SIZE)
+      @return  status code that indicates the execution status of the function.
+    */
+    osStatus start(uint32_t workers=1, osPriority priority=osPriorityNormal,
+                   uint32_t stack_size=DEFAULT_STACK_SIZE);
+
+    /** Run events from the calling thread, as a worker does.
+      @param   millisec  time to run for, or osWaitForever. (default: osWaitForever)
+      @note not callable from interrupt
+    */
+    void dispatch(uint32_t millisec=osWaitForever);
+
+    /** Number of events pending or running.
+      @return  the number of events in use.
+    */
+    uint32_t count();
+
+    virtual ~EventQueue();
+
+private:
+    struct Event {
+        Event *next;                    // next pending or free event
+        mbed::Callback<void()> func;
+        uint32_t due;                   // time to run, in queue milliseconds
+        uint32_t period;                // period, 0 for a single run
+        uint16_t gen;                   // generation, part of the event id
+        uint8_t state;
+    };
+
+    int post(uint32_t delay, uint32_t period, mbed::Callback<void()> func);
+    uint32_t tick();
+    void insert(Event *e);
+    void release(Event *e);
+    void worker();
+
+    Event *_events;
+    Event *_free;                       // unused events
+    Event *_pending;                    // events to run, by due time
+    uint32_t _event_count;
+    uint32_t _used;
+    uint32_t _now_ms;                   // queue clock
+    uint32_t _last_us;                  // microsecond ticker at _now_ms
+    uint32_t _sleepers;                 // threads waiting for an event
+    uint32_t _wakeups;                  // semaphore tokens given to sleepers
+    Semaphore _sem;
+    Thread **_workers;
+    uint32_t _worker_count;
+};
+
+}
+#endif
+
+/** @}*/
@@ -0,0 +1,177 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MPSCRING_H
+#define MPSCRING_H
+
+#include <stdint.h>
+
+#include "cmsis.h"
+#include "cmsis_os.h"
+#include "rtos/Semaphore.h"
+
+namespace rtos {
+/** \addtogroup rtos */
+/** @{*/
+
+/** The MpscRing class passes items from any number of producers to one consumer without a kernel call.
+ Producers, threads or interrupt handlers, claim a slot with an exclusive
+ load and store (LDREX/STREX) on the put index, and then publish it with a
+ per-slot sequence number, so put() takes no lock and no SVC and a
+ producer never waits for another one. A consumer thread can block in
+ get(), and a producer then releases a semaphore only while the consumer
+ is waiting.
+
+ An item is seen by the consumer in the order the slots were claimed: a
+ producer that is interrupted between claiming and publishing holds back
+ the items claimed after it until it resumes.
+
+  @tparam  T         data type of a single item, copied by assignment.
+  @tparam  queue_sz  number of slots, a power of two.
+  @note at most one context may get at a time.
+*/
+template<typename T, uint32_t queue_sz>
+class MpscRing {
+    typedef char queue_sz_must_be_a_power_of_two[((queue_sz & (queue_sz - 1)) == 0) ? 1 : -1];
+
+public:
+    /** Create an empty ring. */
+    MpscRing() : _head(0), _tail(0), _waiting(0) {
+        for (uint32_t i = 0; i < queue_sz; i++) {
+            _seq[i] = 0;
+        }
+    }
+
+    /** Put an item in the ring, from any thread or interrupt.
+      @param   item  item to copy in.
+      @return  true on success, false if the ring is full.
+    */
+    bool put(const T &item) {
+        uint32_t head;
+
+        if (!claim(head)) {
+            return false;
+        }
+        _buf[head & (queue_sz - 1)] = item;
+        __DMB();                        // item before the sequence number
+        _seq[head & (queue_sz - 1)] = head + 1;
+        __DMB();
+        if (_waiting) {
+            _waiting = 0;
+            _sem.release();
+        }
+        return true;
+    }
+
+    /** Take an item from the ring if there is one, from the consumer.
+      @param   item  receives the item.
+      @return  true if an item was taken, false if the ring is empty or the next item is not published yet.
+    */
+    bool try_get(T &item) {
+        uint32_t tail = _tail;
+
+        if (_seq[tail & (queue_sz - 1)] != tail + 1) {
+            return false;
+        }
+        __DMB();                        // sequence number before the item
+        item = _buf[tail & (queue_sz - 1)];
+        __DMB();                        // item read before the slot is reused
+        _tail = tail + 1;
+        return true;
+    }
+
+    /** Take an item from the ring, or wait for one, from the consumer.
+      @param   item      receives the item.
+      @param   millisec  timeout value or 0 in case of no time-out. (default: osWaitForever).
+      @return  true if an item was taken, false on timeout.
+      @note only callable from interrupt with a timeout of 0.
+    */
+    bool get(T &item, uint32_t millisec=osWaitForever) {
+        while (!try_get(item)) {
+            if (millisec == 0) {
+                return false;
+            }
+            _waiting = 1;
+            __DMB();
+            if (try_get(item)) {        // put() may have missed the flag
+                _waiting = 0;
+                return true;
+            }
+            if (_sem.wait(millisec) <= 0 && millisec != osWaitForever) {
+                _waiting = 0;
+                return try_get(item);
+            }
+        }
+        return true;
+    }
+
+    /** Number of slots claimed and not yet taken.
+      @return  the number of items, including those still being put.
+    */
+    uint32_t count() const {
+        return _head - _tail;
+    }
+
+    /** Check if the ring is empty.
+      @return  true if no slot is claimed.
+    */
+    bool empty() const {
+        return _head == _tail;
+    }
+
+private:
+    /* Claim the next slot, unless the ring is full */
+    bool claim(uint32_t &head) {
+#if (__CORTEX_M >= 0x03)
+        do {
+            head = __LDREXW(&_head);
+            if (head - _tail >= queue_sz) {
+                __CLREX();
+                return false;
+            }
+        } while (__STREXW(head + 1, &_head) != 0);
+        return true;
+#else
+        bool ok = false;
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        head = _head;
+        if (head - _tail < queue_sz) {
+            _head = head + 1;
+            ok = true;
+        }
+        __set_PRIMASK(primask);
+        return ok;
+#endif
+    }
+
+    volatile uint32_t _head;            // slots claimed by producers
+    volatile uint32_t _tail;            // items taken, written by the consumer only
+    volatile uint8_t  _waiting;         // the consumer is blocked in get()
+    Semaphore _sem;
+    volatile uint32_t _seq[queue_sz];   // put index + 1 of the item in each slot, once published
+    T _buf[queue_sz];
+};
+
+}
+#endif
+
+/** @}*/
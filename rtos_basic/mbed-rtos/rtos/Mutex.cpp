@@ -23,10 +23,20 @@
 
 #include <string.h>
 #include "platform/mbed_error.h"
+#include "platform/toolchain.h"
+#include "rtos/rtos_mutex_profile.h"
 
 namespace rtos {
 
 Mutex::Mutex() {
+    constructor(NULL);
+}
+
+Mutex::Mutex(const char *name) {
+    constructor(name);
+}
+
+void Mutex::constructor(const char *name) {
 #ifdef CMSIS_OS_RTX
     memset(_mutex_data, 0, sizeof(_mutex_data));
     _osMutexDef.mutex = _mutex_data;
@@ -35,21 +45,43 @@ Mutex::Mutex() {
     if (_osMutexId == NULL) {
         error("Error initializing the mutex object\n");
     }
+#if RTOS_MUTEX_PROFILE
+    if (name != NULL) {
+        rtos_mutex_profile_name(_osMutexId, name);
+    }
+#else
+    (void)name;
+#endif
 }
 
 osStatus Mutex::lock(uint32_t millisec) {
+#if RTOS_MUTEX_PROFILE
+    return rtos_mutex_wait(_osMutexId, millisec, MBED_CALLER_ADDR());
+#else
     return osMutexWait(_osMutexId, millisec);
+#endif
 }
 
 bool Mutex::trylock() {
+#if RTOS_MUTEX_PROFILE
+    return (rtos_mutex_wait(_osMutexId, 0, MBED_CALLER_ADDR()) == osOK);
+#else
     return (osMutexWait(_osMutexId, 0) == osOK);
+#endif
 }
 
 osStatus Mutex::unlock() {
+#if RTOS_MUTEX_PROFILE
+    return rtos_mutex_release(_osMutexId);
+#else
     return osMutexRelease(_osMutexId);
+#endif
 }
 
 Mutex::~Mutex() {
+#if RTOS_MUTEX_PROFILE
+    rtos_mutex_profile_forget(_osMutexId);
+#endif
     osMutexDelete(_osMutexId);
 }
 
@@ -37,6 +37,11 @@ public:
     /** Create and Initialize a Mutex object */
     Mutex();
 
+    /** Create and Initialize a Mutex object
+      @param   name  name to show in the lock profile (RTOS_MUTEX_PROFILE), kept by reference.
+    */
+    Mutex(const char *name);
+
     /** Wait until a Mutex becomes available.
       @param   millisec  timeout value or 0 in case of no time-out. (default: osWaitForever)
       @return  status code that indicates the execution status of the function.
@@ -56,6 +61,8 @@ public:
     ~Mutex();
 
 private:
+    void constructor(const char *name);
+
     osMutexId _osMutexId;
     osMutexDef_t _osMutexDef;
 #ifdef CMSIS_OS_RTX
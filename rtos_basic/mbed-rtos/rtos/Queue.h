@@ -60,7 +60,7 @@ public:
       @return  status code that indicates the execution status of the function.
     */
     osStatus put(T* data, uint32_t millisec=0) {
-        return osMessagePut(_queue_id, (uint32_t)data, millisec);
+        return osMessagePut(_queue_id, (uintptr_t)data, millisec);
     }
 
     /** Get a message or Wait for a message from a Queue.
@@ -23,7 +23,6 @@
 
 #include <string.h>
 
-#include "mbed.h"
 #include "cmsis_os.h"
 #include "platform/mbed_error.h"
 
@@ -31,7 +30,7 @@ namespace rtos {
 
 void RtosTimer::constructor(mbed::Callback<void()> func, os_timer_type type) {
 #ifdef CMSIS_OS_RTX
-    _timer.ptimer = (void (*)(const void *))Callback<void()>::thunk;
+    _timer.ptimer = (void (*)(const void *))mbed::Callback<void()>::thunk;
 
     memset(_timer_data, 0, sizeof(_timer_data));
     _timer.timer = _timer_data;
@@ -100,7 +100,7 @@ private:
 #if defined(CMSIS_OS_RTX) && !defined(__MBED_CMSIS_RTOS_CM)
     uint32_t _timer_data[5];
 #else
-    uint32_t _timer_data[6];
+    uint32_t _timer_data[7];
 #endif
 };
 
@@ -0,0 +1,158 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <stdint.h>
+
+#include "cmsis.h"
+#include "cmsis_os.h"
+#include "rtos/Semaphore.h"
+
+namespace rtos {
+/** \addtogroup rtos */
+/** @{*/
+
+/** The SpscRing class passes items from one producer to one consumer without a kernel call.
+ The producer is typically an interrupt handler and the consumer a thread.
+ Items are copied into a ring of queue_sz slots; each side only writes its
+ own index, so put() and try_get() need no lock and no SVC, and are safe
+ from an ISR. A consumer thread can block in get(), and the producer then
+ releases a semaphore only while the consumer is waiting.
+
+ @code
+ SpscRing<uint32_t, 16> echoes;
+
+ void echo_isr() {
+     echoes.put(us_ticker_read());
+ }
+
+ void echo_thread() {
+     uint32_t t;
+     while (echoes.get(t)) {
+         ...
+     }
+ }
+ @endcode
+
+  @tparam  T         data type of a single item, copied by assignment.
+  @tparam  queue_sz  number of slots, a power of two.
+  @note at most one context may put and one may get at a time; use MpscRing for several producers.
+*/
+template<typename T, uint32_t queue_sz>
+class SpscRing {
+    typedef char queue_sz_must_be_a_power_of_two[((queue_sz & (queue_sz - 1)) == 0) ? 1 : -1];
+
+public:
+    /** Create an empty ring. */
+    SpscRing() : _head(0), _tail(0), _waiting(0) {
+    }
+
+    /** Put an item in the ring, from the producer.
+      @param   item  item to copy in.
+      @return  true on success, false if the ring is full.
+    */
+    bool put(const T &item) {
+        uint32_t head = _head;
+
+        if (head - _tail >= queue_sz) {
+            return false;
+        }
+        _buf[head & (queue_sz - 1)] = item;
+        __DMB();                        // item before the index
+        _head = head + 1;
+        __DMB();
+        if (_waiting) {
+            _waiting = 0;
+            _sem.release();
+        }
+        return true;
+    }
+
+    /** Take an item from the ring if there is one, from the consumer.
+      @param   item  receives the item.
+      @return  true if an item was taken, false if the ring is empty.
+    */
+    bool try_get(T &item) {
+        uint32_t tail = _tail;
+
+        if (_head == tail) {
+            return false;
+        }
+        __DMB();                        // index before the item
+        item = _buf[tail & (queue_sz - 1)];
+        __DMB();                        // item read before the slot is reused
+        _tail = tail + 1;
+        return true;
+    }
+
+    /** Take an item from the ring, or wait for one, from the consumer.
+      @param   item      receives the item.
+      @param   millisec  timeout value or 0 in case of no time-out. (default: osWaitForever).
+      @return  true if an item was taken, false on timeout.
+      @note only callable from interrupt with a timeout of 0.
+    */
+    bool get(T &item, uint32_t millisec=osWaitForever) {
+        while (!try_get(item)) {
+            if (millisec == 0) {
+                return false;
+            }
+            _waiting = 1;
+            __DMB();
+            if (try_get(item)) {        // put() may have missed the flag
+                _waiting = 0;
+                return true;
+            }
+            if (_sem.wait(millisec) <= 0 && millisec != osWaitForever) {
+                _waiting = 0;
+                return try_get(item);
+            }
+        }
+        return true;
+    }
+
+    /** Number of items in the ring.
+      @return  the number of items; only a snapshot if the other side is active.
+    */
+    uint32_t count() const {
+        return _head - _tail;
+    }
+
+    /** Check if the ring is empty.
+      @return  true if there are no items.
+    */
+    bool empty() const {
+        return _head == _tail;
+    }
+
+private:
+    volatile uint32_t _head;            // items put, written by the producer only
+    volatile uint32_t _tail;            // items taken, written by the consumer only
+    volatile uint8_t  _waiting;         // the consumer is blocked in get()
+    Semaphore _sem;
+    T _buf[queue_sz];
+};
+
+}
+#endif
+
+/** @}*/
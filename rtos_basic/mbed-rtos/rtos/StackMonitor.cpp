@@ -0,0 +1,230 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "rtos/StackMonitor.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// rt_tid2ptcb is an internal function which we exposed to get TCB for thread id
+#undef NULL  //Workaround for conflicting macros in rt_TypeDef.h and stdio.h
+#include "rt_TypeDef.h"
+
+extern "C" P_TCB rt_tid2ptcb(osThreadId thread_id);
+extern "C" uint32_t const os_stackinfo;
+extern "C" osThreadId osThreadId_osTimerThread;
+
+#define STACK_FILL      0xE25A2EA5  // fill of Thread stacks, and the RTX overflow check word
+#define STACK_PATTERN   0xCCCCCCCC  // fill of other stacks with OS_STKINIT
+
+namespace rtos {
+
+static bool is_fill(uint32_t word) {
+    return word == STACK_FILL || word == STACK_PATTERN;
+}
+
+static uint32_t stack_size(P_TCB tcb) {
+    return (tcb->priv_stack != 0) ? tcb->priv_stack : (uint16_t)os_stackinfo;
+}
+
+static void default_warning(const StackMonitor::Entry &entry) {
+    printf("StackMonitor: thread %u (entry %08lx) has used %lu of %lu stack bytes\r\n",
+           entry.task_id, (unsigned long)entry.entry,
+           (unsigned long)entry.max_used, (unsigned long)entry.size);
+}
+
+StackMonitor::StackMonitor(uint32_t period_ms, uint32_t min_free,
+        osPriority priority, uint32_t stack_size)
+    : _thread(priority, stack_size), _period_ms(period_ms), _min_free(min_free),
+      _warning(&default_warning) {
+    memset(_entries, 0, sizeof(_entries));
+}
+
+osStatus StackMonitor::start() {
+    return _thread.start(mbed::callback(this, &StackMonitor::run));
+}
+
+void StackMonitor::run() {
+    while (true) {
+        check();
+        Thread::wait(_period_ms);
+    }
+}
+
+StackMonitor::Entry *StackMonitor::lookup(osThreadId id, uint32_t entry) {
+    int free_index = -1;
+    int oldest = -1;
+
+    for (int i = 0; i < STACK_MONITOR_ENTRIES; i++) {
+        Entry *e = &_entries[i];
+        if (e->id == id && e->entry == entry && e->active) {
+            return e;
+        }
+        if (e->id == NULL) {
+            if (free_index < 0) {
+                free_index = i;
+            }
+        } else if (!e->active && oldest < 0) {
+            oldest = i;
+        }
+    }
+    // Forget a terminated thread when the table is full
+    if (free_index < 0) {
+        free_index = oldest;
+    }
+    return (free_index < 0) ? (Entry *)NULL : &_entries[free_index];
+}
+
+void StackMonitor::check() {
+    int warn[STACK_MONITOR_ENTRIES];
+    int num_warn = 0;
+    bool seen[STACK_MONITOR_ENTRIES];
+    osThreadEnumId enum_id;
+    osThreadId id;
+
+    memset(seen, 0, sizeof(seen));
+    _mutex.lock();
+    enum_id = _osThreadsEnumStart();
+    while ((id = _osThreadEnumNext(enum_id)) != NULL) {
+        P_TCB tcb = rt_tid2ptcb(id);
+        if (tcb == NULL) {
+            continue;
+        }
+        Entry *e = lookup(id, (uint32_t)(uintptr_t)tcb->ptask);
+        if (e == (Entry *)NULL) {
+            continue;
+        }
+        uint32_t size = stack_size(tcb);
+        uint32_t words = size / 4;
+        uint32_t *stack = tcb->stack;
+
+        if (e->id != id || e->entry != (uint32_t)(uintptr_t)tcb->ptask || !e->active) {
+            // First sight of this thread
+            memset(e, 0, sizeof(*e));
+            e->id = id;
+            e->entry = (uint32_t)(uintptr_t)tcb->ptask;
+            e->arg = (uint32_t)(uintptr_t)tcb->argv;
+            e->size = size;
+            e->task_id = tcb->task_id;
+            e->active = true;
+            // The host port records no stack for the threads it creates itself
+            e->measured = (tcb->task_id != MAIN_THREAD_ID) && (stack != NULL);
+            if (e->measured && !is_fill(stack[1]) && id != osThreadGetId()) {
+                // Not filled at creation: fill below the saved stack pointer,
+                // with the scheduler locked so the thread cannot run meanwhile
+                os_suspend();
+                for (uint32_t *p = &stack[1]; p < (uint32_t *)(uintptr_t)tcb->tsk_stack; p++) {
+                    *p = STACK_PATTERN;
+                }
+                os_resume(0);
+            }
+        }
+        seen[e - _entries] = true;
+        if (!e->measured) {
+            continue;
+        }
+
+        uint32_t unused = 0;
+        while (unused < words && is_fill(stack[unused])) {
+            unused++;
+        }
+        uint32_t used = size - unused * 4;
+        if (used > e->max_used) {
+            e->max_used = used;
+            if (!e->warned && size - used < _min_free) {
+                e->warned = true;
+                warn[num_warn++] = e - _entries;
+            }
+        }
+    }
+    _osThreadEnumFree(enum_id);
+
+    for (int i = 0; i < STACK_MONITOR_ENTRIES; i++) {
+        if (!seen[i]) {
+            _entries[i].active = false;
+        }
+    }
+    _mutex.unlock();
+
+    for (int i = 0; i < num_warn; i++) {
+        _mutex.lock();
+        Entry entry = _entries[warn[i]];
+        _mutex.unlock();
+        _warning(entry);
+    }
+}
+
+int StackMonitor::table(Entry *entries, int count) {
+    int num = 0;
+
+    _mutex.lock();
+    for (int i = 0; i < STACK_MONITOR_ENTRIES && num < count; i++) {
+        if (_entries[i].id != NULL) {
+            entries[num++] = _entries[i];
+        }
+    }
+    _mutex.unlock();
+    return num;
+}
+
+void StackMonitor::print(void (*print)(const char *line)) {
+    Entry entries[STACK_MONITOR_ENTRIES];
+    char line[128];
+    int num = table(entries, STACK_MONITOR_ENTRIES);
+
+    print("task entry    arg       size  used  free suggest");
+    for (int i = 0; i < num; i++) {
+        const Entry &e = entries[i];
+        const char *name = "";
+
+        if (e.task_id == 255) {
+            name = " idle (OS_IDLESTKSIZE)";
+        } else if (e.task_id == MAIN_THREAD_ID) {
+            name = " main (shares the heap)";
+        } else if (e.id == osThreadId_osTimerThread) {
+            name = " timer (OS_TIMERSTKSZ)";
+        }
+        if (e.measured) {
+            // Largest use plus the warning margin, in whole 8-byte units
+            uint32_t suggest = (e.max_used + _min_free + 7) & ~7UL;
+            sprintf(line, "%4u %08lx %08lx %5lu %5lu %5lu %7lu%s%s", e.task_id,
+                    (unsigned long)e.entry, (unsigned long)e.arg, (unsigned long)e.size,
+                    (unsigned long)e.max_used, (unsigned long)(e.size - e.max_used),
+                    (unsigned long)suggest, name, e.active ? "" : " (terminated)");
+        } else {
+            sprintf(line, "%4u %08lx %08lx %5lu     -     -       -%s", e.task_id,
+                    (unsigned long)e.entry, (unsigned long)e.arg, (unsigned long)e.size, name);
+        }
+        print(line);
+    }
+}
+
+void StackMonitor::attach_warning(void (*fptr)(const Entry &entry)) {
+    _mutex.lock();
+    _warning = (fptr != NULL) ? fptr : &default_warning;
+    _mutex.unlock();
+}
+
+StackMonitor::~StackMonitor() {
+    _thread.terminate();
+}
+
+}
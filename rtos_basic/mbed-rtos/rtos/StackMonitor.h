@@ -0,0 +1,130 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef STACKMONITOR_H
+#define STACKMONITOR_H
+
+#include <stdint.h>
+#include "cmsis_os.h"
+#include "rtos/Thread.h"
+#include "rtos/Mutex.h"
+
+/** Most threads the StackMonitor keeps a record for */
+#ifndef STACK_MONITOR_ENTRIES
+#define STACK_MONITOR_ENTRIES   16
+#endif
+
+namespace rtos {
+/** \addtogroup rtos */
+/** @{*/
+
+/** The StackMonitor class watches the stack use of all threads.
+
+ A low priority thread walks every thread periodically, and measures how
+ much of its stack has ever been written, from the watermark pattern left
+ below the deepest use. The largest use of each thread is kept in a table,
+ also after the thread terminates, and a warning is given the first time
+ a thread's free stack falls below a threshold.
+
+ Stacks of Thread objects are filled with the pattern when they are
+ created. Other stacks (the idle and timer threads, and those created with
+ osThreadCreate, such as the lwIP threads) are only filled when OS_STKINIT
+ is set; otherwise the monitor fills their unused part when it first sees
+ them, so their use is measured from then on. The main thread shares its
+ stack area with the heap and is not measured.
+
+ @code
+ StackMonitor monitor(1000, 128);
+ monitor.start();
+ ...
+     monitor.print(&print_line);   // suggested sizes for each thread
+ @endcode
+*/
+class StackMonitor {
+public:
+    /** Stack use of one thread, as kept in the table */
+    struct Entry {
+        osThreadId id;          /**< thread ID, or NULL for an unused entry */
+        uint32_t entry;         /**< address of the thread function */
+        uint32_t arg;           /**< thread argument, the Thread object for Thread threads */
+        uint32_t size;          /**< stack size in bytes */
+        uint32_t max_used;      /**< largest stack use seen, in bytes */
+        uint8_t  task_id;       /**< kernel task id, 255 for the idle thread */
+        bool     measured;      /**< false if the stack cannot be measured */
+        bool     active;        /**< false once the thread has terminated */
+        bool     warned;        /**< a low stack warning was given */
+    };
+
+    /** Create a stack monitor, without starting it.
+      @param   period_ms  time between checks in milliseconds. (default: 1000)
+      @param   min_free   warn when less than this many bytes of a stack were never used. (default: 128)
+      @param   priority   priority of the monitor thread. (default: osPriorityLow)
+      @param   stack_size stack size of the monitor thread in bytes. (default: DEFAULT_STACK_SIZE)
+    */
+    StackMonitor(uint32_t period_ms=1000, uint32_t min_free=128,
+                 osPriority priority=osPriorityLow,
+                 uint32_t stack_size=DEFAULT_STACK_SIZE);
+
+    /** Start checking periodically from the monitor thread.
+      @return  status code that indicates the execution status of the function.
+    */
+    osStatus start();
+
+    /** Check all threads once, from the calling thread.
+      @note not callable from interrupt
+    */
+    void check();
+
+    /** Copy the table of threads seen so far.
+      @param   entries  receives the entries
+      @param   count    the most entries to copy
+      @return  the number of entries copied
+    */
+    int table(Entry *entries, int count);
+
+    /** Print the table, with a suggested stack size for each thread.
+      @param   print  function to output one line, without a line ending
+    */
+    void print(void (*print)(const char *line));
+
+    /** Attach a function to be called when a thread's free stack falls below the threshold
+      @param   fptr  pointer to the function, or NULL to print a warning with printf
+    */
+    void attach_warning(void (*fptr)(const Entry &entry));
+
+    virtual ~StackMonitor();
+
+private:
+    void run();
+    Entry *lookup(osThreadId id, uint32_t entry);
+
+    Thread _thread;
+    Mutex _mutex;
+    uint32_t _period_ms;
+    uint32_t _min_free;
+    void (*_warning)(const Entry &entry);
+    Entry _entries[STACK_MONITOR_ENTRIES];
+};
+
+}
+#endif
+
+/** @}*/
@@ -21,7 +21,8 @@
  */
 #include "rtos/Thread.h"
 
-#include "mbed.h"
+#include "platform/mbed_error.h"
+#include "platform/mbed_assert.h"
 #include "rtos/rtos_idle.h"
 
 // rt_tid2ptcb is an internal function which we exposed to get TCB for thread id
@@ -53,7 +54,7 @@ void Thread::constructor(osPriority priority,
 #endif
 }
 
-void Thread::constructor(Callback<void()> task,
+void Thread::constructor(mbed::Callback<void()> task,
         osPriority priority, uint32_t stack_size, unsigned char *stack_pointer) {
     constructor(priority, stack_size, stack_pointer);
 
@@ -71,7 +72,7 @@ void Thread::constructor(Callback<void()> task,
     }
 }
 
-osStatus Thread::start(Callback<void()> task) {
+osStatus Thread::start(mbed::Callback<void()> task) {
     _mutex.lock();
 
     if (_tid != 0) {
@@ -248,7 +249,7 @@ uint32_t Thread::free_stack() {
 
     if (_tid != NULL) {
         P_TCB tcb = rt_tid2ptcb(_tid);
-        uint32_t bottom = (uint32_t)tcb->stack;
+        uint32_t bottom = (uint32_t)(uintptr_t)tcb->stack;
         size = tcb->tsk_stack - bottom;
     }
 
@@ -279,7 +280,7 @@ uint32_t Thread::used_stack() {
 
     if (_tid != NULL) {
         P_TCB tcb = rt_tid2ptcb(_tid);
-        uint32_t top = (uint32_t)tcb->stack + tcb->priv_stack;
+        uint32_t top = (uint32_t)(uintptr_t)tcb->stack + tcb->priv_stack;
         size =  top - tcb->tsk_stack;
     }
 
@@ -326,6 +327,22 @@ uint32_t Thread::max_stack() {
 #endif
 }
 
+uint64_t Thread::cpu_cycles() {
+#ifdef __MBED_CMSIS_RTOS_CM
+    uint64_t cycles = 0;
+    _mutex.lock();
+
+    if (_tid != NULL) {
+        cycles = osThreadGetCycles(_tid);
+    }
+
+    _mutex.unlock();
+    return cycles;
+#else
+    return 0;
+#endif
+}
+
 osEvent Thread::signal_wait(int32_t signals, uint32_t millisec) {
     return osSignalWait(signals, millisec);
 }
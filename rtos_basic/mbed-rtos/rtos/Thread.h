@@ -291,6 +291,12 @@ public:
     */
     uint32_t max_stack();
 
+    /** Get the processor cycles this Thread has run for
+      @return  the cycle count since the thread was started, including
+               the interrupt handlers that ran while it was running
+    */
+    uint64_t cpu_cycles();
+
     /** Wait for one or more Signal Flags to become signaled for the current RUNNING thread.
       @param   signals   wait until all specified signal flags set or 0 for any single signal flag.
       @param   millisec  timeout value or 0 in case of no time-out. (default: osWaitForever).
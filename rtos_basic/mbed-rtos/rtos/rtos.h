@@ -32,17 +32,23 @@
 #include "rtos/Mail.h"
 #include "rtos/MemoryPool.h"
 #include "rtos/Queue.h"
+#include "rtos/StackMonitor.h"
+#include "rtos/SpscRing.h"
+#include "rtos/MpscRing.h"
+#include "rtos/EventQueue.h"
 
 using namespace rtos;
 
 /* Get mbed lib version number, as RTOS depends on mbed lib features
    like mbed_error, Callback and others.
 */
+#ifndef __MBED_CMSIS_RTOS_HOST
 #include "mbed.h"
 
 #if (MBED_LIBRARY_VERSION < 122)
 #error "This version of RTOS requires mbed library version > 121"
 #endif
+#endif
 
 #endif
 
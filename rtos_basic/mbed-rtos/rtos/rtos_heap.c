@@ -0,0 +1,184 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "rtos/rtos_heap.h"
+#include <string.h>
+#include "critical.h"
+#include "mbed_stats.h"
+#include "mbed_mem_trace.h"
+#include "toolchain.h"
+
+#undef NULL  //Workaround for conflicting macros in rt_TypeDef.h and string.h
+#include "rt_TypeDef.h"
+#include "rt_Tlsf.h"
+
+#if defined(__CC_ARM) && (RTOS_TLSF_HEAP_SIZE != 0)
+
+/* The C library allocator, behind the $Sub$$ wrappers below */
+extern void *$Super$$malloc(size_t size);
+extern void *$Super$$realloc(void *ptr, size_t size);
+extern void $Super$$free(void *ptr);
+
+static uint64_t heap_arena[RTOS_TLSF_HEAP_SIZE / 8];
+static uint8_t heap_ready;
+
+/* Allocator calls are short and take a bounded time, so the arena is
+ * guarded by a critical section rather than a mutex, which also makes
+ * it safe to use before the kernel runs. */
+static void heap_init(void)
+{
+    if (!heap_ready) {
+        rt_tlsf_init(heap_arena, sizeof(heap_arena));
+        heap_ready = 1;
+    }
+}
+
+static void *heap_alloc(size_t size)
+{
+    void *ptr;
+
+    core_util_critical_section_enter();
+    heap_init();
+    ptr = rt_tlsf_alloc(heap_arena, size);
+    core_util_critical_section_exit();
+    if (ptr == NULL) {
+        ptr = $Super$$malloc(size);
+    }
+    return ptr;
+}
+
+static int heap_owns(void *ptr)
+{
+    return rt_tlsf_owns(heap_arena, ptr) != 0;
+}
+
+void *$Sub$$malloc(size_t size)
+{
+    void *ptr = heap_alloc(size);
+#ifdef MBED_MEM_TRACING_ENABLED
+    mbed_mem_trace_malloc(ptr, size, MBED_CALLER_ADDR());
+#endif
+    return ptr;
+}
+
+void *$Sub$$calloc(size_t nmemb, size_t size)
+{
+    size_t total = nmemb * size;
+    void *ptr = NULL;
+
+    if (size == 0 || total / size == nmemb) {
+        ptr = heap_alloc(total);
+        if (ptr != NULL) {
+            memset(ptr, 0, total);
+        }
+    }
+#ifdef MBED_MEM_TRACING_ENABLED
+    mbed_mem_trace_calloc(ptr, nmemb, size, MBED_CALLER_ADDR());
+#endif
+    return ptr;
+}
+
+void *$Sub$$realloc(void *ptr, size_t size)
+{
+    void *res;
+
+    if (ptr == NULL || !heap_owns(ptr)) {
+        res = (ptr == NULL) ? heap_alloc(size) : $Super$$realloc(ptr, size);
+    } else {
+        core_util_critical_section_enter();
+        res = rt_tlsf_realloc(heap_arena, ptr, size);
+        core_util_critical_section_exit();
+        if (res == NULL && size != 0) {
+            /* The arena is full: move the block to the library heap */
+            res = $Super$$malloc(size);
+            if (res != NULL) {
+                size_t old = rt_tlsf_size(heap_arena, ptr);
+                memcpy(res, ptr, (old < size) ? old : size);
+                core_util_critical_section_enter();
+                rt_tlsf_free(heap_arena, ptr);
+                core_util_critical_section_exit();
+            }
+        }
+    }
+#ifdef MBED_MEM_TRACING_ENABLED
+    mbed_mem_trace_realloc(res, ptr, size, MBED_CALLER_ADDR());
+#endif
+    return res;
+}
+
+void $Sub$$free(void *ptr)
+{
+#ifdef MBED_MEM_TRACING_ENABLED
+    mbed_mem_trace_free(ptr, MBED_CALLER_ADDR());
+#endif
+    if (ptr != NULL && heap_owns(ptr)) {
+        core_util_critical_section_enter();
+        rt_tlsf_free(heap_arena, ptr);
+        core_util_critical_section_exit();
+    } else {
+        $Super$$free(ptr);
+    }
+}
+
+int rtos_heap_get_stats(rtos_heap_stats_t *stats)
+{
+    TLSF_STATS st;
+
+    core_util_critical_section_enter();
+    heap_init();
+    rt_tlsf_stats(heap_arena, &st);
+    core_util_critical_section_exit();
+
+    stats->current_size = st.cur_size;
+    stats->max_size = st.max_size;
+    stats->total_size = st.total_size;
+    stats->alloc_cnt = st.alloc_cnt;
+    stats->alloc_fail_cnt = st.fail_cnt;
+    stats->free_size = st.free_size;
+    stats->max_free = st.max_free;
+    stats->frag = st.frag;
+    return 0;
+}
+
+/* Replaces the stub in the mbed library, which reports nothing unless
+ * the library was built with MBED_HEAP_STATS_ENABLED. */
+void mbed_stats_heap_get(mbed_stats_heap_t *stats)
+{
+    rtos_heap_stats_t st;
+
+    rtos_heap_get_stats(&st);
+    stats->current_size = st.current_size;
+    stats->max_size = st.max_size;
+    stats->total_size = st.total_size;
+    stats->alloc_cnt = st.alloc_cnt;
+    stats->alloc_fail_cnt = st.alloc_fail_cnt;
+}
+
+#else
+
+int rtos_heap_get_stats(rtos_heap_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    return -1;
+}
+
+#endif
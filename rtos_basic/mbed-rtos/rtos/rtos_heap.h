@@ -0,0 +1,76 @@
+
+/** \addtogroup rtos */
+/** @{*/
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RTOS_HEAP_H
+#define RTOS_HEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Size in bytes of the heap arena served by the TLSF allocator, 0 to keep
+ *  the C library allocator. Define it for the whole build, for example with
+ *  -DRTOS_TLSF_HEAP_SIZE=16384, since it must be seen by rtos_heap.c.
+ */
+#ifndef RTOS_TLSF_HEAP_SIZE
+#define RTOS_TLSF_HEAP_SIZE     0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** TLSF heap statistics, see rtos_heap_get_stats()
+ */
+typedef struct {
+    uint32_t current_size;      /**< bytes allocated currently, in whole blocks */
+    uint32_t max_size;          /**< most bytes allocated at any time */
+    uint32_t total_size;        /**< cumulative sum of bytes ever allocated */
+    uint32_t alloc_cnt;         /**< current number of allocations */
+    uint32_t alloc_fail_cnt;    /**< allocations the arena could not serve */
+    uint32_t free_size;         /**< bytes in free blocks of the arena */
+    uint32_t max_free;          /**< largest free block of the arena */
+    uint32_t frag;              /**< fragmentation in 1/1000: the share of free bytes outside the largest free block */
+} rtos_heap_stats_t;
+
+/** Get the TLSF heap statistics
+
+  With RTOS_TLSF_HEAP_SIZE set (ARM compiler only), malloc, calloc, realloc
+  and free are served from a fixed arena by a two-level segregated fit
+  allocator, which takes a constant time per call instead of searching
+  the free list. Requests the arena cannot serve go to the C library heap,
+  and are counted in alloc_fail_cnt. mbed_stats_heap_get() then reports
+  the same figures.
+
+  @param stats  receives the statistics
+  @return  0 on success, -1 if the TLSF heap is not in use
+*/
+int rtos_heap_get_stats(rtos_heap_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @}*/
@@ -21,6 +21,16 @@
  */
 
 #include "rtos/rtos_idle.h"
+#include "cmsis.h"
+#include "cmsis_os.h"
+
+/* RTX kernel timer configuration, from RTX_CM_lib.h */
+extern uint32_t const os_trv;
+extern uint32_t const os_clockrate;
+
+#define SYSTICK_MAX     0xFFFFFFUL
+
+static rtos_idle_stats_t idle_stats;
 
 static void default_idle_hook(void)
 {
@@ -42,6 +52,78 @@ void rtos_attach_idle_hook(void (*fptr)(void))
     }
 }
 
+void rtos_idle_tickless(void)
+{
+    uint32_t period = os_trv + 1;
+    uint32_t ticks, first, reload, elapsed, passed, next, ctrl;
+
+    ticks = os_suspend();
+    if (ticks <= 1 || (SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) == 0) {
+        /* Nothing to gain, or the kernel timer is not the SysTick: sleep
+           until the next interrupt, as the tick would wake us anyway */
+        os_resume(0);
+        __DSB();
+        __WFI();
+        return;
+    }
+
+    __disable_irq();
+    /* The scheduler lock left the SysTick counting with its interrupt off.
+       Restart it to expire on the tick edge of the deadline, or as far as
+       its 24 bits reach. */
+    first = SysTick->VAL;
+    if (ticks - 1 > (SYSTICK_MAX - first) / period) {
+        ticks = (SYSTICK_MAX - first) / period + 1;
+    }
+    reload = first + (ticks - 1) * period;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk;
+    SysTick->LOAD = reload;
+    SysTick->VAL  = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    __DSB();
+    __WFI();
+
+    /* Still masked, so the wake-up interrupt (if it was the SysTick) is only
+       pending. Find how far the counter got. */
+    ctrl = SysTick->CTRL;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk;
+    elapsed = reload - SysTick->VAL;
+    if (ctrl & SysTick_CTRL_COUNTFLAG_Msk) {
+        /* Slept to the deadline, and then some until here */
+        idle_stats.wake_latency_us = (uint32_t)((uint64_t)elapsed * os_clockrate / period);
+        if (idle_stats.wake_latency_us > idle_stats.max_wake_latency_us) {
+            idle_stats.max_wake_latency_us = idle_stats.wake_latency_us;
+        }
+        elapsed += reload + 1;
+        SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+    }
+    passed = (elapsed >= first) ? 1 + (elapsed - first) / period : 0;
+    next = first + passed * period - elapsed;
+    if (next < 2) {
+        next = 2;   /* a reload value of zero would stop the counter */
+    }
+
+    /* Run out the tick in progress, then carry on with normal periods */
+    SysTick->LOAD = next - 1;
+    SysTick->VAL  = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = os_trv;
+
+    idle_stats.sleeps++;
+    idle_stats.ticks_skipped += passed;
+    __enable_irq();
+
+    os_resume(passed);
+}
+
+void rtos_idle_get_stats(rtos_idle_stats_t *stats)
+{
+    __disable_irq();
+    *stats = idle_stats;
+    __enable_irq();
+}
+
 void rtos_idle_loop(void)
 {
     //Continuously call the idle hook function pointer
@@ -26,13 +26,42 @@
 #define RTOS_IDLE_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Tickless idle statistics, see rtos_idle_tickless()
+ */
+typedef struct {
+    uint32_t sleeps;                /**< number of times the idle thread went to sleep */
+    uint32_t ticks_skipped;         /**< kernel ticks that passed without a tick interrupt */
+    uint32_t wake_latency_us;       /**< delay from the last timed wake-up to the kernel resuming */
+    uint32_t max_wake_latency_us;   /**< largest delay seen from a timed wake-up */
+} rtos_idle_stats_t;
+
 void rtos_attach_idle_hook(void (*fptr)(void));
 
+/** Idle hook that sleeps without kernel ticks until the next deadline
+
+  Suspends the scheduler, stretches the SysTick period to the next thread
+  delay or timer expiry, and sleeps with WFI. Any interrupt ends the sleep
+  early. On wake, the kernel time is advanced by the ticks that passed,
+  and the tick in progress is shortened to stay in phase.
+
+  @code
+  rtos_attach_idle_hook(&rtos_idle_tickless);
+  @endcode
+*/
+void rtos_idle_tickless(void);
+
+/** Get the tickless idle statistics
+
+  @param stats  receives a copy of the counters
+*/
+void rtos_idle_get_stats(rtos_idle_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,265 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "rtos/rtos_mutex_profile.h"
+#include <stdio.h>
+#include <string.h>
+#include "cmsis.h"
+#include "critical.h"
+#if (__CORTEX_M < 0x03)
+#include "us_ticker_api.h"
+#endif
+
+#undef NULL  //Workaround for conflicting macros in rt_TypeDef.h and stdio.h
+#include "rt_TypeDef.h"
+
+static rtos_mutex_profile_t profile[RTOS_MUTEX_PROFILE_ENTRIES];
+static uint32_t profile_dropped;        // mutexes not recorded, the table being full
+
+/* Processor cycle count */
+static uint32_t profile_now(void)
+{
+#if (__CORTEX_M >= 0x03)
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        // Normally running already for the kernel's CPU usage accounting
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+    return DWT->CYCCNT;
+#else
+    return us_ticker_read() * (SystemCoreClock / 1000000);
+#endif
+}
+
+/* Record of a mutex, added if "add" is set. Call in a critical section. */
+static rtos_mutex_profile_t *profile_lookup(osMutexId mutex, int add)
+{
+    rtos_mutex_profile_t *free_entry = NULL;
+    uint32_t i;
+
+    for (i = 0; i < RTOS_MUTEX_PROFILE_ENTRIES; i++) {
+        if (profile[i].mutex == mutex) {
+            return &profile[i];
+        }
+        if (profile[i].mutex == NULL && free_entry == NULL) {
+            free_entry = &profile[i];
+        }
+    }
+    if (!add) {
+        return NULL;
+    }
+    if (free_entry == NULL) {
+        profile_dropped++;
+        return NULL;
+    }
+    memset(free_entry, 0, sizeof(*free_entry));
+    free_entry->mutex = mutex;
+    return free_entry;
+}
+
+osStatus rtos_mutex_wait(osMutexId mutex, uint32_t millisec, void *caller)
+{
+    P_MUCB mcb = (P_MUCB)mutex;
+    P_TCB self = (P_TCB)osThreadGetId();
+    rtos_mutex_profile_t *e;
+    uint32_t start, now, wait;
+    uint8_t blocker = 0;
+    int boost = 0;
+    osStatus status;
+
+    start = profile_now();
+    status = osMutexWait(mutex, 0);
+    if (status != osOK && millisec != 0) {
+        // Held by another thread: note who, and if it inherits our priority
+        core_util_critical_section_enter();
+        if (mcb->owner != NULL) {
+            blocker = mcb->owner->task_id;
+            boost = (mcb->owner->prio < self->prio);
+        }
+        core_util_critical_section_exit();
+        status = osMutexWait(mutex, millisec);
+    }
+    now = profile_now();
+    wait = now - start;
+
+    core_util_critical_section_enter();
+    e = profile_lookup(mutex, 1);
+    if (e != NULL) {
+        if (blocker != 0) {
+            e->contended++;
+            e->boosts += boost;
+            e->wait_total += wait;
+            if (wait > e->wait_max) {
+                e->wait_max = wait;
+                e->wait_site = caller;
+                e->blocker = blocker;
+            }
+        }
+        if (status == osOK) {
+            e->locks++;
+            if (mcb->level == 1) {
+                // First lock of this owner, not a recursive one
+                e->hold_start = now;
+                e->owner = self->task_id;
+                e->owner_site = caller;
+            }
+        } else if (blocker != 0) {
+            e->timeouts++;
+        }
+    }
+    core_util_critical_section_exit();
+    return status;
+}
+
+osStatus rtos_mutex_release(osMutexId mutex)
+{
+    P_MUCB mcb = (P_MUCB)mutex;
+    P_TCB self = (P_TCB)osThreadGetId();
+    rtos_mutex_profile_t *e;
+    uint32_t hold;
+
+    // Record before releasing, as a waiting thread may run at once
+    core_util_critical_section_enter();
+    if (mcb->level == 1 && mcb->owner == self) {
+        e = profile_lookup(mutex, 0);
+        if (e != NULL) {
+            hold = profile_now() - e->hold_start;
+            e->hold_total += hold;
+            if (hold > e->hold_max) {
+                e->hold_max = hold;
+            }
+        }
+    }
+    core_util_critical_section_exit();
+    return osMutexRelease(mutex);
+}
+
+void rtos_mutex_profile_name(osMutexId mutex, const char *name)
+{
+    rtos_mutex_profile_t *e;
+
+    core_util_critical_section_enter();
+    e = profile_lookup(mutex, 1);
+    if (e != NULL) {
+        e->name = name;
+    }
+    core_util_critical_section_exit();
+}
+
+void rtos_mutex_profile_forget(osMutexId mutex)
+{
+    rtos_mutex_profile_t *e;
+
+    core_util_critical_section_enter();
+    e = profile_lookup(mutex, 0);
+    if (e != NULL) {
+        e->mutex = NULL;
+    }
+    core_util_critical_section_exit();
+}
+
+void rtos_mutex_profile_reset(void)
+{
+    uint32_t i;
+
+    core_util_critical_section_enter();
+    for (i = 0; i < RTOS_MUTEX_PROFILE_ENTRIES; i++) {
+        if (profile[i].mutex != NULL) {
+            osMutexId mutex = profile[i].mutex;
+            const char *name = profile[i].name;
+            uint32_t hold_start = profile[i].hold_start;
+
+            memset(&profile[i], 0, sizeof(profile[i]));
+            profile[i].mutex = mutex;
+            profile[i].name = name;
+            profile[i].hold_start = hold_start;
+        }
+    }
+    profile_dropped = 0;
+    core_util_critical_section_exit();
+}
+
+uint32_t rtos_mutex_profile_read(rtos_mutex_profile_t *entries, uint32_t count)
+{
+    rtos_mutex_profile_t e;
+    uint32_t i, j, n = 0;
+
+    for (i = 0; i < RTOS_MUTEX_PROFILE_ENTRIES; i++) {
+        core_util_critical_section_enter();
+        e = profile[i];
+        core_util_critical_section_exit();
+        if (e.mutex == NULL) {
+            continue;
+        }
+        // Insert in order of total wait, dropping the least waited for
+        for (j = n; j > 0 && entries[j - 1].wait_total < e.wait_total; j--) {
+            if (j < count) {
+                entries[j] = entries[j - 1];
+            }
+        }
+        if (j < count) {
+            entries[j] = e;
+            if (n < count) {
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+void rtos_mutex_profile_dump(void (*print)(const char *line), uint32_t count)
+{
+    rtos_mutex_profile_t entries[8];
+    uint32_t mhz = SystemCoreClock / 1000000;
+    uint32_t n, i;
+    char line[128];
+
+    if (count > sizeof(entries) / sizeof(entries[0])) {
+        count = sizeof(entries) / sizeof(entries[0]);
+    }
+    n = rtos_mutex_profile_read(entries, count);
+    print("mutex           locks  waits boost tmo  wait avg/max us   hold avg/max us  owner    longest wait");
+    for (i = 0; i < n; i++) {
+        const rtos_mutex_profile_t *e = &entries[i];
+        char name[16];
+
+        if (e->name != NULL) {
+            sprintf(name, "%.15s", e->name);
+        } else {
+            sprintf(name, "%08lx", (unsigned long)e->mutex);
+        }
+        sprintf(line, "%-15s %6lu %6lu %5lu %3lu %8lu %8lu %8lu %8lu  t%-3u %08lx t%-3u %08lx",
+                name, (unsigned long)e->locks, (unsigned long)e->contended,
+                (unsigned long)e->boosts, (unsigned long)e->timeouts,
+                (unsigned long)(e->contended ? e->wait_total / e->contended / mhz : 0),
+                (unsigned long)(e->wait_max / mhz),
+                (unsigned long)(e->locks ? e->hold_total / e->locks / mhz : 0),
+                (unsigned long)(e->hold_max / mhz),
+                e->owner, (unsigned long)e->owner_site, e->blocker, (unsigned long)e->wait_site);
+        print(line);
+    }
+    if (profile_dropped != 0) {
+        sprintf(line, "%lu mutexes not profiled, raise RTOS_MUTEX_PROFILE_ENTRIES",
+                (unsigned long)profile_dropped);
+        print(line);
+    }
+}
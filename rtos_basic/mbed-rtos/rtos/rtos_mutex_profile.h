@@ -0,0 +1,140 @@
+
+/** \addtogroup rtos */
+/** @{*/
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RTOS_MUTEX_PROFILE_H
+#define RTOS_MUTEX_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cmsis_os.h"
+
+/** Set to 1 for the whole build to profile rtos::Mutex and the lwIP
+ *  mutexes, for example with -DRTOS_MUTEX_PROFILE=1
+ */
+#ifndef RTOS_MUTEX_PROFILE
+#define RTOS_MUTEX_PROFILE          0
+#endif
+
+/** Most mutexes the profile keeps a record for */
+#ifndef RTOS_MUTEX_PROFILE_ENTRIES
+#define RTOS_MUTEX_PROFILE_ENTRIES  16
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Lock statistics of one mutex, see rtos_mutex_profile_read()
+
+  Times are in processor cycles. Threads are identified by their kernel
+  task id, as in the scheduler trace.
+*/
+typedef struct {
+    osMutexId mutex;        /**< mutex ID */
+    const char *name;       /**< name given with rtos_mutex_profile_name(), or NULL */
+    uint32_t locks;         /**< times the mutex was acquired */
+    uint32_t contended;     /**< acquisitions that found the mutex held by another thread */
+    uint32_t boosts;        /**< waits that raised the owner's priority (priority inheritance) */
+    uint32_t timeouts;      /**< waits that timed out */
+    uint64_t wait_total;    /**< time spent waiting, summed over all acquisitions */
+    uint32_t wait_max;      /**< longest wait */
+    uint64_t hold_total;    /**< time held, summed over all acquisitions */
+    uint32_t hold_max;      /**< longest hold */
+    uint32_t hold_start;    /**< when the current owner acquired the mutex */
+    void *owner_site;       /**< call site of the current or last owner */
+    void *wait_site;        /**< call site of the longest wait */
+    uint8_t owner;          /**< task id of the current or last owner */
+    uint8_t blocker;        /**< task id of the owner during the longest wait */
+} rtos_mutex_profile_t;
+
+/** Wait for a mutex, and record the wait and the new owner
+
+  Used in place of osMutexWait() when RTOS_MUTEX_PROFILE is set.
+
+  @param mutex     mutex ID
+  @param millisec  timeout value or 0 in case of no time-out
+  @param caller    call site to record for the lock
+  @return  status code, as from osMutexWait()
+  @note not callable from interrupt
+*/
+osStatus rtos_mutex_wait(osMutexId mutex, uint32_t millisec, void *caller);
+
+/** Release a mutex, and record how long it was held
+
+  Used in place of osMutexRelease() when RTOS_MUTEX_PROFILE is set.
+
+  @param mutex  mutex ID
+  @return  status code, as from osMutexRelease()
+*/
+osStatus rtos_mutex_release(osMutexId mutex);
+
+/** Give a mutex a name to show in the profile
+  @param mutex  mutex ID
+  @param name   name, kept by reference
+*/
+void rtos_mutex_profile_name(osMutexId mutex, const char *name);
+
+/** Drop the record of a mutex that is being deleted
+  @param mutex  mutex ID
+*/
+void rtos_mutex_profile_forget(osMutexId mutex);
+
+/** Clear the statistics of all mutexes, keeping their names
+*/
+void rtos_mutex_profile_reset(void);
+
+/** Copy the records of the most contended mutexes
+
+  @param entries  receives the records, longest total wait first
+  @param count    the most records to copy
+  @return  the number of records copied
+*/
+uint32_t rtos_mutex_profile_read(rtos_mutex_profile_t *entries, uint32_t count);
+
+/** Print the most contended mutexes as a table
+
+  Times are printed in microseconds. Each line is passed to the print
+  function, without a line ending.
+
+  @code
+  static void print_line(const char *line) {
+      pc.printf("%s\r\n", line);
+  }
+  ...
+      rtos_mutex_profile_dump(&print_line, 8);
+  @endcode
+
+  @param print  function to output one line
+  @param count  the most mutexes to print
+  @note not callable from interrupt
+*/
+void rtos_mutex_profile_dump(void (*print)(const char *line), uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @}*/
@@ -0,0 +1,120 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "rtos/rtos_trace.h"
+#include <stdio.h>
+#include <string.h>
+#include "cmsis.h"
+#include "cmsis_os.h"
+
+#undef NULL  //Workaround for conflicting macros in rt_TypeDef.h and stdio.h
+#include "rt_TypeDef.h"
+#include "RTX_Config.h"
+#include "rt_Trace.h"
+
+#if (RTOS_TRACE_SWITCH != TRC_SWITCH) || (RTOS_TRACE_ISR != TRC_ISR) || \
+    (RTOS_TRACE_SEM_TAKE != TRC_SEM_TAKE) || (RTOS_TRACE_SEM_BLOCK != TRC_SEM_BLOCK) || \
+    (RTOS_TRACE_SEM_GIVE != TRC_SEM_GIVE) || (RTOS_TRACE_SEM_ISR != TRC_SEM_ISR) || \
+    (RTOS_TRACE_MUT_BOOST != TRC_MUT_BOOST)
+#error "rtos_trace.h event types do not match rt_Trace.h"
+#endif
+
+/* Version of the dump format read by tools/rtxtrace.py */
+#define DUMP_VERSION    1
+
+void rtos_trace_isr(void)
+{
+    rt_trace_put(TRC_INFO(TRC_ISR, rt_trace_tid(), __get_IPSR()), 0);
+}
+
+void rtos_trace_enable(int enable)
+{
+    os_trace_on = (enable && os_trace_size != 0) ? 1 : 0;
+}
+
+/* Oldest event still in the ring, and the number of events after it */
+static uint32_t trace_window(uint32_t *count)
+{
+    uint32_t head = os_trace_head;
+    uint32_t num = (head < os_trace_size) ? head : os_trace_size;
+
+    if (*count > num) {
+        *count = num;
+    }
+    return head - *count;
+}
+
+uint32_t rtos_trace_read(rtos_trace_event_t *events, uint32_t count)
+{
+    uint8_t on = os_trace_on;
+    uint32_t first, i;
+
+    os_trace_on = 0;
+    first = trace_window(&count);
+    for (i = 0; i < count; i++) {
+        memcpy(&events[i], &os_trace_buf[((first + i) & (os_trace_size - 1)) * 3],
+               sizeof(rtos_trace_event_t));
+    }
+    os_trace_on = on;
+    return count;
+}
+
+void rtos_trace_dump(void (*print)(const char *line))
+{
+    char line[64];
+    uint8_t on = os_trace_on;
+    uint32_t first, count, i;
+    osThreadEnumId enum_id;
+    osThreadId id;
+
+    os_trace_on = 0;
+    count = os_trace_size;
+    first = trace_window(&count);
+
+    sprintf(line, "rtxtrace %d %lu %lu %lu", DUMP_VERSION, (unsigned long)SystemCoreClock,
+            (unsigned long)os_trace_head, (unsigned long)count);
+    print(line);
+
+    /* One line per thread: task id, thread ID, entry, argument, priority, cycles */
+    enum_id = _osThreadsEnumStart();
+    while ((id = _osThreadEnumNext(enum_id)) != NULL) {
+        P_TCB tcb = (P_TCB)id;
+        uint64_t cycles = osThreadGetCycles(id);
+
+        sprintf(line, "thread %u %08lx %08lx %08lx %u %08lx%08lx", tcb->task_id,
+                (unsigned long)tcb, (unsigned long)tcb->ptask, (unsigned long)tcb->argv,
+                tcb->prio, (unsigned long)(cycles >> 32), (unsigned long)cycles);
+        print(line);
+    }
+    _osThreadEnumFree(enum_id);
+
+    /* One line per event, oldest first: time, info word, object */
+    for (i = 0; i < count; i++) {
+        const uint32_t *evt = &os_trace_buf[((first + i) & (os_trace_size - 1)) * 3];
+
+        sprintf(line, "event %08lx %08lx %08lx", (unsigned long)evt[0],
+                (unsigned long)evt[1], (unsigned long)evt[2]);
+        print(line);
+    }
+    print("rtxtrace end");
+    os_trace_on = on;
+}
@@ -0,0 +1,109 @@
+
+/** \addtogroup rtos */
+/** @{*/
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RTOS_TRACE_H
+#define RTOS_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Scheduler trace event types, see rtos_trace_event_t
+ */
+#define RTOS_TRACE_SWITCH       1   /**< thread switch: thread is the new thread, arg the previous one */
+#define RTOS_TRACE_ISR          2   /**< interrupt entry: arg is the exception number */
+#define RTOS_TRACE_SEM_TAKE     3   /**< semaphore token taken: arg is the tokens left */
+#define RTOS_TRACE_SEM_BLOCK    4   /**< semaphore has no token, the thread blocks */
+#define RTOS_TRACE_SEM_GIVE     5   /**< semaphore token returned: arg is the thread woken, or 0 */
+#define RTOS_TRACE_SEM_ISR      6   /**< semaphore token returned by an ISR: arg is the exception number */
+#define RTOS_TRACE_MUT_BOOST    7   /**< mutex owner raised by priority inheritance: thread is the owner, arg the waiter's task id plus its priority times 256 */
+
+/** A scheduler trace event, as kept in the trace ring
+
+  Threads are identified by their kernel task id: 1 and up for threads,
+  255 for the idle thread, and 0 when no thread was running.
+*/
+typedef struct {
+    uint32_t time;      /**< processor cycle count when the event was recorded */
+    uint8_t  type;      /**< event type, RTOS_TRACE_xxx */
+    uint8_t  thread;    /**< task id of the thread the event concerns */
+    uint16_t arg;       /**< event argument, depending on the type */
+    uint32_t obj;       /**< the new thread ID for a switch, the semaphore or mutex ID otherwise */
+} rtos_trace_event_t;
+
+/** Record the entry of an interrupt handler in the trace
+
+  Call this first thing in a handler whose activity should show in the
+  trace. It has no effect when the trace is disabled.
+*/
+void rtos_trace_isr(void);
+
+/** Start or stop recording trace events
+
+  Recording is on from kernel start when the trace ring is configured
+  (OS_TRACESZ, 128 events by default).
+
+  @param enable  non-zero to record events, zero to stop
+*/
+void rtos_trace_enable(int enable);
+
+/** Copy the latest trace events, oldest first
+
+  Recording is paused while the events are copied.
+
+  @param events  receives the events
+  @param count   the most events to copy
+  @return  the number of events copied
+*/
+uint32_t rtos_trace_read(rtos_trace_event_t *events, uint32_t count);
+
+/** Print the thread CPU usage and the trace ring as text
+
+  The output is meant to be captured from a serial port and decoded with
+  tools/rtxtrace.py. Each line is passed to the print function, without a
+  line ending. Recording is paused during the dump.
+
+  @code
+  static void trace_line(const char *line) {
+      pc.printf("%s\r\n", line);
+  }
+  ...
+      rtos_trace_dump(&trace_line);
+  @endcode
+
+  @param print  function to output one line
+  @note not callable from interrupt
+*/
+void rtos_trace_dump(void (*print)(const char *line));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @}*/
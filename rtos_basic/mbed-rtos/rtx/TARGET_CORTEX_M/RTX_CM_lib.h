@@ -67,20 +67,20 @@ typedef uint32_t OS_RESULT;
 
 #define runtask_id()    rt_tsk_self()
 #define mutex_init(m)   rt_mut_init(m)
-#define mutex_wait(m)   os_mut_wait(m,0xFFFFU)
+#define mutex_wait(m)   os_mut_wait(m,0xFFFFFFFFU)
 #define mutex_rel(m)    os_mut_release(m)
 
 extern uint8_t   os_running;
 extern OS_TID    rt_tsk_self    (void);
 extern void      rt_mut_init    (OS_ID mutex);
 extern OS_RESULT rt_mut_release (OS_ID mutex);
-extern OS_RESULT rt_mut_wait    (OS_ID mutex, uint16_t timeout);
+extern OS_RESULT rt_mut_wait    (OS_ID mutex, uint32_t timeout);
 
 #define os_mut_wait(mutex,timeout) _os_mut_wait((uint32_t)rt_mut_wait,mutex,timeout)
 #define os_mut_release(mutex)      _os_mut_release((uint32_t)rt_mut_release,mutex)
 
 OS_RESULT _os_mut_release (uint32_t p, OS_ID mutex)                   __svc_indirect(0);
-OS_RESULT _os_mut_wait    (uint32_t p, OS_ID mutex, uint16_t timeout) __svc_indirect(0);
+OS_RESULT _os_mut_wait    (uint32_t p, OS_ID mutex, uint32_t timeout) __svc_indirect(0);
 
 #endif
 
@@ -142,6 +142,10 @@ __USED uint32_t const os_timernum  = 0U;
 _declare_box  (mp_tcb, OS_TCB_SIZE, OS_TASK_CNT);
 uint16_t const mp_tcb_size = sizeof(mp_tcb);
 
+#ifndef OS_MEMTLSF
+ #define OS_MEMTLSF     0
+#endif
+
 #ifdef __MBED_CMSIS_RTOS_CM
 /* Memory pool for os_idle_demon stack allocation. */
 _declare_box8 (mp_stk, OS_IDLESTKSIZE*4, 1);
@@ -152,7 +156,11 @@ _declare_box8 (mp_stk, OS_STKSIZE*4, OS_TASK_CNT-OS_PRIV_CNT+1);
 uint32_t const mp_stk_size = sizeof(mp_stk);
 
 /* Memory pool for user specified stack allocation (+main, +timer) */
+#if (OS_MEMTLSF != 0)
+uint64_t       os_stack_mem[64+OS_PRIV_CNT+(OS_STACK_SZ/8)];
+#else
 uint64_t       os_stack_mem[2+OS_PRIV_CNT+(OS_STACK_SZ/8)];
+#endif
 uint32_t const os_stack_sz = sizeof(os_stack_mem);
 #endif
 
@@ -167,6 +175,31 @@ uint8_t  const os_fifo_size = OS_FIFOSZ;
 /* An array of Active task pointers. */
 void *os_active_TCB[OS_TASK_CNT];
 
+#ifndef OS_CPUSTAT
+ #define OS_CPUSTAT     1
+#endif
+#ifndef OS_TRACESZ
+ #define OS_TRACESZ     128
+#endif
+#if ((OS_TRACESZ & (OS_TRACESZ - 1)) != 0)
+#error "OS_TRACESZ must be zero or a power of two!"
+#endif
+
+/* Cycle counts of active tasks, and of the idle demon in the last entry. */
+uint64_t       os_tsk_cycles[OS_TASK_CNT+1];
+uint8_t  const os_cpustat = OS_CPUSTAT;
+
+/* Ring buffer of scheduler trace events, three words per event. */
+#if (OS_TRACESZ != 0)
+uint32_t       os_trace_buf[OS_TRACESZ*3];
+#else
+uint32_t       os_trace_buf[1];
+#endif
+uint16_t const os_trace_size = OS_TRACESZ;
+
+/* Allocator of the dynamic memory pool. */
+uint8_t  const os_memtlsf = OS_MEMTLSF;
+
 /* User Timers Resources */
 #if (OS_TIMERS != 0)
 extern void osTimerThread (void const *argument);
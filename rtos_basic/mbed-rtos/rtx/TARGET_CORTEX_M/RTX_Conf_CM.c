@@ -213,6 +213,44 @@
 
 // </h>
 
+// <h>Memory Configuration
+// =======================
+//
+//   <q>TLSF dynamic memory
+//   <i> Allocates the user specified thread stacks with a two-level
+//   <i> segregated fit allocator, which takes a constant time instead
+//   <i> of searching a first fit list. Needs 512 more bytes of memory.
+//   <i> Default: disabled
+#ifndef OS_MEMTLSF
+ #define OS_MEMTLSF     0
+#endif
+
+// </h>
+
+// <h>Trace Configuration
+// ======================
+//
+//   <q>Thread CPU usage
+//   <i> Counts the processor cycles each thread runs for, from the
+//   <i> DWT cycle counter (from the SysTick on Cortex-M0).
+//   <i> Default: enabled
+#ifndef OS_CPUSTAT
+ #define OS_CPUSTAT     1
+#endif
+
+//   <o>Scheduler trace size <0=> disabled
+//                   <32=> 32 events  <64=>   64 events
+//                  <128=> 128 events <256=> 256 events
+//                  <512=> 512 events
+//   <i> Keeps the latest thread switch, interrupt and semaphore
+//   <i> events in a ring buffer of 12 bytes per event.
+//   <i> Default: 128 events
+#ifndef OS_TRACESZ
+ #define OS_TRACESZ     128
+#endif
+
+// </h>
+
 //------------- <<< end of configuration section >>> -----------------------
 
 // Standard library system mutexes
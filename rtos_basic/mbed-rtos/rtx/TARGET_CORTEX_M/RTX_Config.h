@@ -42,6 +42,14 @@
 #define OS_ERR_MBX_OVF          3U
 #define OS_ERR_TIMER_OVF        4U
 
+/* Scheduler options */
+/* Keep the ready list indexed by priority level with a bitmap, so that    */
+/* making a task ready or removing it takes constant time. Set to 0 for    */
+/* the plain priority ordered ready list.                                  */
+#ifndef OS_RDYBITMAP
+ #define OS_RDYBITMAP   1
+#endif
+
 /* Definitions */
 #define BOX_ALIGN_8                   0x80000000U
 #define _declare_box(pool,size,cnt)   U32 pool[(((size)+3)/4)*(cnt) + 3]
@@ -53,6 +61,8 @@ extern U32 mp_tcb[];
 extern U64 mp_stk[];
 extern U32 os_fifo[];
 extern void *os_active_TCB[];
+extern U64 os_tsk_cycles[];
+extern U32 os_trace_buf[];
 
 /* Constants */
 extern U16 const os_maxtaskrun;
@@ -67,6 +77,9 @@ extern U32 const mp_stk_size;
 extern U32 const *m_tmr;
 extern U16 const mp_tmr_size;
 extern U8  const os_fifo_size;
+extern U8  const os_cpustat;
+extern U16 const os_trace_size;
+extern U8  const os_memtlsf;
 
 /* Functions */
 extern void os_idle_demon   (void);
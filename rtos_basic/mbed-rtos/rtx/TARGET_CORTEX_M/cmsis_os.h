@@ -378,6 +378,11 @@ osPriority osThreadGetPriority (osThreadId thread_id);
 #ifdef __MBED_CMSIS_RTOS_CM
 /// Get current thread state.
 uint8_t osThreadGetState (osThreadId thread_id);
+
+/// Get the processor cycles an active thread has run for.
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadCreate or \ref osThreadGetId.
+/// \return cycle count since the thread was created, or 0 if the thread ID is invalid.
+uint64_t osThreadGetCycles (osThreadId thread_id);
 #endif
 
 /// Get into from an active thread.
@@ -413,7 +418,7 @@ os_InRegs osEvent osWait (uint32_t millisec);
 extern const osTimerDef_t os_timer_def_##name
 #else                            // define the object
 #define osTimerDef(name, function)  \
-uint32_t os_timer_cb_##name[6]; \
+uint32_t os_timer_cb_##name[7]; \
 const osTimerDef_t os_timer_def_##name = \
 { (function), (os_timer_cb_##name) }
 #endif
@@ -634,7 +639,11 @@ osMessageQId osMessageCreate (const osMessageQDef_t *queue_def, osThreadId threa
 /// \param[in]     info          message information.
 /// \param[in]     millisec      \ref CMSIS_RTOS_TimeOutValue or 0 in case of no time-out.
 /// \return status code that indicates the execution status of the function.
+#ifdef __MBED_CMSIS_RTOS_HOST
+osStatus osMessagePut (osMessageQId queue_id, uintptr_t info, uint32_t millisec);
+#else
 osStatus osMessagePut (osMessageQId queue_id, uint32_t info, uint32_t millisec);
+#endif
 
 /// Get a Message or Wait for a Message from a Queue.
 /// \param[in]     queue_id      message queue ID obtained with \ref osMessageCreate.
@@ -64,6 +64,8 @@
 #include "rt_Mailbox.h"
 #include "rt_MemBox.h"
 #include "rt_Memory.h"
+#include "rt_Wheel.h"
+#include "rt_Trace.h"
 #include "rt_HAL_CM.h"
 #include "rt_OsEventObserver.h"
 
@@ -391,6 +393,7 @@ extern const osThreadDef_t   os_thread_def_osTimerThread;
 extern       osThreadId      osThreadId_osTimerThread;
 extern const osMessageQDef_t os_messageQ_def_osTimerMessageQ;
 extern       osMessageQId    osMessageQId_osTimerMessageQ;
+extern struct OS_WHL         os_timer_whl;
 
 // Thread creation and destruction
 osMutexDef(osThreadMutex);
@@ -400,17 +403,16 @@ void sysThreadTerminate(osThreadId id);
 // ==== Helper Functions ====
 
 /// Convert timeout in millisec to system ticks
-static uint16_t rt_ms2tick (uint32_t millisec) {
-  uint32_t tick;
+static uint32_t rt_ms2tick (uint32_t millisec) {
+  uint64_t tick;
 
   if (millisec == 0U) { return 0x0U; }                  // No timeout
-  if (millisec == osWaitForever) { return 0xFFFFU; }    // Indefinite timeout
-  if (millisec > 4000000U) { return 0xFFFEU; }          // Max ticks supported
+  if (millisec == osWaitForever) { return 0xFFFFFFFFU; }// Indefinite timeout
 
-  tick = ((1000U * millisec) + os_clockrate - 1U)  / os_clockrate;
-  if (tick > 0xFFFEU) { return 0xFFFEU; }
+  tick = ((1000U * (uint64_t)millisec) + os_clockrate - 1U)  / os_clockrate;
+  if (tick > 0xFFFFFFFEU) { return 0xFFFFFFFEU; }       // Max ticks supported
   
-  return (uint16_t)tick;
+  return (uint32_t)tick;
 }
 
 /// Convert Thread ID to TCB pointer
@@ -492,6 +494,7 @@ osStatus svcKernelInitialize (void) {
 
   if (os_initialized == 0U) {
     // Create OS Timers resources (Message Queue & Thread)
+    rt_whl_init(&os_timer_whl, os_time);
     osMessageQId_osTimerMessageQ = svcMessageCreate (&os_messageQ_def_osTimerMessageQ, NULL);
     osThreadId_osTimerThread = svcThreadCreate(&os_thread_def_osTimerThread, NULL, NULL);
     // Initialize thread mutex
@@ -955,6 +958,16 @@ uint8_t osThreadGetState (osThreadId thread_id) {
 
   return ptcb->state;
 }
+
+/// Get the processor cycles an active thread has run for
+uint64_t osThreadGetCycles (osThreadId thread_id) {
+  P_TCB ptcb;
+
+  ptcb = rt_tid2ptcb(thread_id);                // Get TCB pointer
+  if (ptcb == NULL) return 0U;
+
+  return rt_trace_cycles(ptcb);
+}
 #endif
 
 /// Get the requested info from the specified active thread
@@ -1073,69 +1086,17 @@ os_InRegs osEvent osWait (uint32_t millisec) {
 // Timer structures 
 
 typedef struct os_timer_cb_ {                   // Timer Control Block
-  struct os_timer_cb_ *next;                    // Pointer to next active Timer
+  struct OS_WNODE      node;                    // Entry in the timer wheel
   uint8_t             state;                    // Timer State
   uint8_t              type;                    // Timer Type (Periodic/One-shot)
   uint16_t         reserved;                    // Reserved
-  uint32_t             tcnt;                    // Timer Delay Count
   uint32_t             icnt;                    // Timer Initial Count 
   void                 *arg;                    // Timer Function Argument
   const osTimerDef_t *timer;                    // Pointer to Timer definition
 } os_timer_cb;
 
 // Timer variables
-os_timer_cb *os_timer_head;                     // Pointer to first active Timer
-
-
-// Timer Helper Functions
-
-// Insert Timer into the list sorted by time
-static void rt_timer_insert (os_timer_cb *pt, uint32_t tcnt) {
-  os_timer_cb *p, *prev;
-
-  prev = NULL;
-  p = os_timer_head;
-  while (p != NULL) {
-    if (tcnt < p->tcnt) { break; }
-    tcnt -= p->tcnt;
-    prev = p;
-    p = p->next;
-  }
-  pt->next = p;
-  pt->tcnt = tcnt;
-  if (p != NULL) {
-    p->tcnt -= pt->tcnt;
-  }
-  if (prev != NULL) {
-    prev->next = pt;
-  } else {
-    os_timer_head = pt;
-  }
-}
-
-// Remove Timer from the list
-static int32_t rt_timer_remove (os_timer_cb *pt) {
-  os_timer_cb *p, *prev;
-
-  prev = NULL;
-  p = os_timer_head;
-  while (p != NULL) {
-    if (p == pt) { break; }
-    prev = p;
-    p = p->next;
-  }
-  if (p == NULL) { return -1; }
-  if (prev != NULL) {
-    prev->next = pt->next;
-  } else {
-    os_timer_head = pt->next;
-  }
-  if (pt->next != NULL) {
-    pt->next->tcnt += pt->tcnt;
-  }
-
-  return 0;
-}
+struct OS_WHL os_timer_whl;                     // Timing wheel of active Timers
 
 
 // Timer Service Calls declarations
@@ -1177,7 +1138,8 @@ osTimerId svcTimerCreate (const osTimerDef_t *timer_def, os_timer_type type, voi
     return NULL;
   }
 
-  pt->next  = NULL;
+  pt->node.next = NULL;
+  pt->node.prev = NULL;
   pt->state = osTimerStopped;
   pt->type  =  (uint8_t)type;
   pt->arg   = argument;
@@ -1202,9 +1164,7 @@ osStatus svcTimerStart (osTimerId timer_id, uint32_t millisec) {
 
   switch (pt->state) {
     case osTimerRunning:
-      if (rt_timer_remove(pt) != 0) {
-        return osErrorResource;
-      }
+      rt_whl_rmv(&os_timer_whl, &pt->node);
       break;
     case osTimerStopped:
       pt->state = osTimerRunning;
@@ -1214,7 +1174,7 @@ osStatus svcTimerStart (osTimerId timer_id, uint32_t millisec) {
       return osErrorResource;
   }
   
-  rt_timer_insert(pt, tcnt);
+  rt_whl_put(&os_timer_whl, &pt->node, os_timer_whl.time + tcnt);
 
   return osOK;
 }
@@ -1232,9 +1192,7 @@ osStatus svcTimerStop (osTimerId timer_id) {
 
   pt->state = osTimerStopped;
 
-  if (rt_timer_remove(pt) != 0) {
-    return osErrorResource;
-  }
+  rt_whl_rmv(&os_timer_whl, &pt->node);
 
   return osOK;
 }
@@ -1250,7 +1208,7 @@ osStatus svcTimerDelete (osTimerId timer_id) {
 
   switch (pt->state) {
     case osTimerRunning:
-      rt_timer_remove(pt);
+      rt_whl_rmv(&os_timer_whl, &pt->node);
       break;
     case osTimerStopped:
       break;
@@ -1285,23 +1243,22 @@ osStatus isrMessagePut (osMessageQId queue_id, uint32_t info, uint32_t millisec)
 
 /// Timer Tick (called each SysTick)
 void sysTimerTick (void) {
-  os_timer_cb *pt, *p;
+  os_timer_cb *pt;
+  P_WNODE      p;
   osStatus     status;
 
-  p = os_timer_head;
-  if (p == NULL) { return; }
-
-  p->tcnt--;
-  while ((p != NULL) && (p->tcnt == 0U)) {
-    pt = p;
+  // All timers expiring on this tick come off the wheel as one batch
+  p = rt_whl_tick(&os_timer_whl);
+  while (p != NULL) {
+    pt = (os_timer_cb *)p;
     p = p->next;
-    os_timer_head = p;
+    pt->node.next = NULL;
     status = isrMessagePut(osMessageQId_osTimerMessageQ, (uint32_t)pt, 0U);
     if (status != osOK) {
       os_error(OS_ERR_TIMER_OVF);
     }
     if (pt->type == (uint8_t)osTimerPeriodic) {
-      rt_timer_insert(pt, pt->icnt);
+      rt_whl_put(&os_timer_whl, &pt->node, os_timer_whl.time + pt->icnt);
     } else {
       pt->state = osTimerStopped;
     }
@@ -1310,24 +1267,17 @@ void sysTimerTick (void) {
 
 /// Get user timers wake-up time 
 uint32_t sysUserTimerWakeupTime (void) {
-
-  if (os_timer_head) {
-    return os_timer_head->tcnt;
-  }
-  return 0xFFFFFFFFU;
+  return rt_whl_next(&os_timer_whl);
 }
 
 /// Update user timers on resume
 void sysUserTimerUpdate (uint32_t sleep_time) {
 
-  while ((os_timer_head != NULL) && (sleep_time != 0U)) {
-    if (sleep_time >= os_timer_head->tcnt) {
-      sleep_time -= os_timer_head->tcnt;
-      os_timer_head->tcnt = 1U;
+  while (sleep_time != 0U) {
+    sleep_time -= rt_whl_skip(&os_timer_whl, sleep_time);
+    if (sleep_time != 0U) {
       sysTimerTick();
-    } else {
-      os_timer_head->tcnt -= sleep_time;
-      break;
+      sleep_time--;
     }
   }
 }
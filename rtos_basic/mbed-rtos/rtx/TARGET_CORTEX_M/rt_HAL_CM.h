@@ -38,6 +38,7 @@
 /* Definitions */
 #define INITIAL_xPSR    0x01000000U
 #define DEMCR_TRCENA    0x01000000U
+#define DWT_CYCCNTENA   0x00000001U
 #define ITM_ITMENA      0x00000001U
 #define MAGIC_WORD      0xE25A2EA5U
 #define MAGIC_PATTERN   0xCCCCCCCCU
@@ -214,6 +215,10 @@ static inline U8 __clz(U32 value)
 /* Core Debug registers */
 #define DEMCR           (*((volatile U32 *)0xE000EDFCU))
 
+/* DWT registers */
+#define DWT_CONTROL     (*((volatile U32 *)0xE0001000U))
+#define DWT_CYCCNT      (*((volatile U32 *)0xE0001004U))
+
 /* ITM registers */
 #define ITM_CONTROL     (*((volatile U32 *)0xE0000E80U))
 #define ITM_ENABLE      (*((volatile U32 *)0xE0000E00U))
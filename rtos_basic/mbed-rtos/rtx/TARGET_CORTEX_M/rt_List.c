@@ -38,6 +38,7 @@
 #include "rt_List.h"
 #include "rt_Task.h"
 #include "rt_Time.h"
+#include "rt_Wheel.h"
 #include "rt_HAL_CM.h"
 
 /*----------------------------------------------------------------------------
@@ -46,8 +47,127 @@
 
 /* List head of chained ready tasks */
 struct OS_XCB  os_rdy;
-/* List head of chained delay tasks */
-struct OS_XCB  os_dly;
+/* Timing wheel of delayed tasks */
+struct OS_WHL  os_dly;
+
+#if (OS_RDYBITMAP)
+/* Last ready task of each priority level, and a bit set for each level   */
+/* that has ready tasks. Priorities above 30 all share level 31.          */
+P_TCB os_rdy_tail[32];
+U32   os_rdy_map;
+
+#define RDY_LVL(prio)   (((U32)(prio) < 31U) ? (U32)(prio) : 31U)
+#endif
+
+
+/*----------------------------------------------------------------------------
+ *      Local Functions
+ *---------------------------------------------------------------------------*/
+
+#if (OS_RDYBITMAP)
+
+/*--------------------------- rt_rdy_lowest ---------------------------------*/
+
+static __inline U32 rt_rdy_lowest (U32 map) {
+  /* Return the lowest level that is set in the non-zero bitmap "map".      */
+#ifdef __TARGET_ARCH_6S_M
+  U32 lvl = 0U;
+
+  while ((map & 1U) == 0U) {
+    map >>= 1;
+    lvl++;
+  }
+  return (lvl);
+#else
+  return (31U - __clz (map & (0U - map)));
+#endif
+}
+
+
+/*--------------------------- rt_rdy_put ------------------------------------*/
+
+static void rt_rdy_put (P_TCB p_task) {
+  /* Append task "p_task" to the ready list. The levels are chained highest */
+  /* first, so the task goes after the last task of its own level or, when  */
+  /* that is empty, after the last task of the nearest higher level.        */
+  /* The ready list is linked backwards like the semaphore/mailbox lists.   */
+  P_TCB p_CB;
+  P_TCB p_next;
+  U32 lvl,map;
+
+  lvl = RDY_LVL(p_task->prio);
+  if (lvl == 31U) {
+    /* Top level may hold several priorities, keep it sorted */
+    p_CB = (P_TCB)&os_rdy;
+    while ((p_CB->p_lnk != NULL) && (p_task->prio <= p_CB->p_lnk->prio)) {
+      p_CB = p_CB->p_lnk;
+    }
+  }
+  else if (os_rdy_map & (1U << lvl)) {
+    p_CB = os_rdy_tail[lvl];
+  }
+  else {
+    map = os_rdy_map & ~((2U << lvl) - 1U);
+    if (map != 0U) {
+      p_CB = os_rdy_tail[rt_rdy_lowest (map)];
+    }
+    else {
+      p_CB = (P_TCB)&os_rdy;
+    }
+  }
+  p_next = p_CB->p_lnk;
+  p_task->p_lnk  = p_next;
+  p_task->p_rlnk = p_CB;
+  p_CB->p_lnk    = p_task;
+  if (p_next != NULL) {
+    p_next->p_rlnk = p_task;
+  }
+  if ((p_next == NULL) || (RDY_LVL(p_next->prio) != lvl)) {
+    os_rdy_tail[lvl] = p_task;
+  }
+  os_rdy_map |= (1U << lvl);
+}
+
+
+/*--------------------------- rt_rdy_rmv ------------------------------------*/
+
+static void rt_rdy_rmv (P_TCB p_task) {
+  /* Remove task "p_task" from the ready list. The priority of the task may */
+  /* already have been changed, so the level it was queued on is found from */
+  /* its successor: the task either shares the level of the successor, or   */
+  /* is the last task of the nearest level above it.                        */
+  P_TCB p_prev;
+  P_TCB p_next;
+  U32 lvl,map;
+
+  p_prev = p_task->p_rlnk;
+  p_next = p_task->p_lnk;
+  p_prev->p_lnk = p_next;
+  if (p_next != NULL) {
+    p_next->p_rlnk = p_prev;
+    map = os_rdy_map & ~((2U << RDY_LVL(p_next->prio)) - 1U);
+  }
+  else {
+    map = os_rdy_map;
+  }
+  if (map != 0U) {
+    lvl = rt_rdy_lowest (map);
+    if (os_rdy_tail[lvl] == p_task) {
+      if ((p_prev->cb_type == TCB) && (RDY_LVL(p_prev->prio) == lvl)) {
+        os_rdy_tail[lvl] = p_prev;
+      }
+      else {
+        /* Level is now empty */
+        os_rdy_tail[lvl] = NULL;
+        os_rdy_map &= ~(1U << lvl);
+      }
+    }
+  }
+  p_task->p_lnk  = NULL;
+  p_task->p_rlnk = NULL;
+}
+
+#endif
 
 
 /*----------------------------------------------------------------------------
@@ -65,6 +185,12 @@ void rt_put_prio (P_XCB p_CB, P_TCB p_task) {
   U32 prio;
   BOOL sem_mbx = __FALSE;
 
+#if (OS_RDYBITMAP)
+  if (p_CB == &os_rdy) {
+    rt_rdy_put (p_task);
+    return;
+  }
+#endif
   if ((p_CB->cb_type == SCB) || (p_CB->cb_type == MCB) || (p_CB->cb_type == MUCB)) {
     sem_mbx = __TRUE;
   }
@@ -97,6 +223,13 @@ P_TCB rt_get_first (P_XCB p_CB) {
   /* "p_CB" points to head of list. */
   P_TCB p_first;
 
+#if (OS_RDYBITMAP)
+  if (p_CB == &os_rdy) {
+    p_first = os_rdy.p_lnk;
+    rt_rdy_rmv (p_first);
+    return (p_first);
+  }
+#endif
   p_first = p_CB->p_lnk;
   p_CB->p_lnk = p_first->p_lnk;
   if ((p_CB->cb_type == SCB) || (p_CB->cb_type == MCB) || (p_CB->cb_type == MUCB)) {
@@ -118,9 +251,25 @@ P_TCB rt_get_first (P_XCB p_CB) {
 void rt_put_rdy_first (P_TCB p_task) {
   /* Put task identified with "p_task" at the head of the ready list. The   */
   /* task must have at least a priority equal to highest priority in list.  */
+#if (OS_RDYBITMAP)
+  U32 lvl;
+
+  lvl = RDY_LVL(p_task->prio);
+  p_task->p_lnk  = os_rdy.p_lnk;
+  p_task->p_rlnk = (P_TCB)&os_rdy;
+  if (os_rdy.p_lnk != NULL) {
+    os_rdy.p_lnk->p_rlnk = p_task;
+  }
+  os_rdy.p_lnk = p_task;
+  if ((os_rdy_map & (1U << lvl)) == 0U) {
+    os_rdy_tail[lvl] = p_task;
+    os_rdy_map |= (1U << lvl);
+  }
+#else
   p_task->p_lnk = os_rdy.p_lnk;
   p_task->p_rlnk = NULL;
   os_rdy.p_lnk = p_task;
+#endif
 }
 
 
@@ -133,7 +282,11 @@ P_TCB rt_get_same_rdy_prio (void) {
 
   p_first = os_rdy.p_lnk;
   if (p_first->prio == os_tsk.run->prio) {
+#if (OS_RDYBITMAP)
+    rt_rdy_rmv (p_first);
+#else
     os_rdy.p_lnk = os_rdy.p_lnk->p_lnk;
+#endif
     return (p_first);
   }
   return (NULL);
@@ -146,6 +299,14 @@ void rt_resort_prio (P_TCB p_task) {
   /* Re-sort ordered lists after the priority of 'p_task' has changed.      */
   P_TCB p_CB;
 
+#if (OS_RDYBITMAP)
+  if ((p_task->state == READY) && (p_task->p_rlnk != NULL)) {
+    /* Task is chained into READY list. */
+    rt_rdy_rmv (p_task);
+    rt_rdy_put (p_task);
+    return;
+  }
+#endif
   if (p_task->p_rlnk == NULL) {
     if (p_task->state == READY) {
       /* Task is chained into READY list. */
@@ -167,56 +328,25 @@ res:rt_rmv_list (p_task);
 
 /*--------------------------- rt_put_dly ------------------------------------*/
 
-void rt_put_dly (P_TCB p_task, U16 delay) {
-  /* Put a task identified with "p_task" into chained delay wait list using */
-  /* a delay value of "delay".                                              */
-  P_TCB p;
-  U32 delta,idelay = delay;
-
-  p = (P_TCB)&os_dly;
-  if (p->p_dlnk == NULL) {
-    /* Delay list empty */
-    delta = 0U;
-    goto last;
-  }
-  delta = os_dly.delta_time;
-  while (delta < idelay) {
-    if (p->p_dlnk == NULL) {
-      /* End of list found */
-last: p_task->p_dlnk = NULL;
-      p->p_dlnk = p_task;
-      p_task->p_blnk = p;
-      p->delta_time = (U16)(idelay - delta);
-      p_task->delta_time = 0U;
-      return;
-    }
-    p = p->p_dlnk;
-    delta += p->delta_time;
-  }
-  /* Right place found */
-  p_task->p_dlnk = p->p_dlnk;
-  p->p_dlnk = p_task;
-  p_task->p_blnk = p;
-  if (p_task->p_dlnk != NULL) {
-    p_task->p_dlnk->p_blnk = p_task;
-  }
-  p_task->delta_time = (U16)(delta - idelay);
-  p->delta_time -= p_task->delta_time;
+void rt_put_dly (P_TCB p_task, U32 delay) {
+  /* Put a task identified with "p_task" into the delay wheel using a delay */
+  /* value of "delay".                                                      */
+  rt_whl_put (&os_dly, &p_task->dly, os_dly.time + delay);
 }
 
 
 /*--------------------------- rt_dec_dly ------------------------------------*/
 
 void rt_dec_dly (void) {
-  /* Decrement delta time of list head: remove tasks having a value of zero.*/
+  /* Advance the delay wheel by one tick: wake up the tasks that expire.    */
+  P_WNODE p_dly,p_next;
   P_TCB p_rdy;
 
-  if (os_dly.p_dlnk == NULL) {
-    return;
-  }
-  os_dly.delta_time--;
-  while ((os_dly.delta_time == 0U) && (os_dly.p_dlnk != NULL)) {
-    p_rdy = os_dly.p_dlnk;
+  p_next = rt_whl_tick (&os_dly);
+  while ((p_dly = p_next) != NULL) {
+    p_next = p_dly->next;
+    p_dly->next = NULL;
+    p_rdy = (P_TCB)((U8 *)p_dly - (U32)&((P_TCB)0)->dly);
     if (p_rdy->p_rlnk != NULL) {
       /* Task is really enqueued, remove task from semaphore/mailbox */
       /* timeout waiting list. */
@@ -228,18 +358,11 @@ void rt_dec_dly (void) {
       p_rdy->p_rlnk = NULL;
     }
     rt_put_prio (&os_rdy, p_rdy);
-    os_dly.delta_time = p_rdy->delta_time;
     if (p_rdy->state == WAIT_ITV) {
       /* Calculate the next time for interval wait. */
-      p_rdy->delta_time = p_rdy->interval_time + (U16)os_time;
+      p_rdy->dly.expire = p_rdy->interval_time + os_time;
     }
     p_rdy->state   = READY;
-    os_dly.p_dlnk = p_rdy->p_dlnk;
-    if (p_rdy->p_dlnk != NULL) {
-      p_rdy->p_dlnk->p_blnk = (P_TCB)&os_dly;
-      p_rdy->p_dlnk = NULL;
-    }
-    p_rdy->p_blnk = NULL;
   }
 }
 
@@ -251,6 +374,13 @@ void rt_rmv_list (P_TCB p_task) {
   /* waiting list if enqueued.                                              */
   P_TCB p_b;
 
+#if (OS_RDYBITMAP)
+  if ((p_task->state == READY) && (p_task->p_rlnk != NULL)) {
+    /* A task is enqueued in the ready list. */
+    rt_rdy_rmv (p_task);
+    return;
+  }
+#endif
   if (p_task->p_rlnk != NULL) {
     /* A task is enqueued in semaphore / mailbox waiting list. */
     p_task->p_rlnk->p_lnk = p_task->p_lnk;
@@ -275,25 +405,8 @@ void rt_rmv_list (P_TCB p_task) {
 /*--------------------------- rt_rmv_dly ------------------------------------*/
 
 void rt_rmv_dly (P_TCB p_task) {
-  /* Remove task identified with "p_task" from delay list if enqueued.      */
-  P_TCB p_b;
-
-  p_b = p_task->p_blnk;
-  if (p_b != NULL) {
-    /* Task is really enqueued */
-    p_b->p_dlnk = p_task->p_dlnk;
-    if (p_task->p_dlnk != NULL) {
-      /* 'p_task' is in the middle of list */
-      p_b->delta_time += p_task->delta_time;
-      p_task->p_dlnk->p_blnk = p_b;
-      p_task->p_dlnk = NULL;
-    }
-    else {
-      /* 'p_task' is at the end of list */
-      p_b->delta_time = 0U;
-    }
-    p_task->p_blnk = NULL;
-  }
+  /* Remove task identified with "p_task" from delay wheel if enqueued.     */
+  rt_whl_rmv (&os_dly, &p_task->dly);
 }
 
 
@@ -46,7 +46,11 @@
 
 /* Variables */
 extern struct OS_XCB os_rdy;
-extern struct OS_XCB os_dly;
+extern struct OS_WHL os_dly;
+#if (OS_RDYBITMAP)
+extern P_TCB os_rdy_tail[32];
+extern U32   os_rdy_map;
+#endif
 
 /* Functions */
 extern void  rt_put_prio      (P_XCB p_CB, P_TCB p_task);
@@ -54,7 +58,7 @@ extern P_TCB rt_get_first     (P_XCB p_CB);
 extern void  rt_put_rdy_first (P_TCB p_task);
 extern P_TCB rt_get_same_rdy_prio (void);
 extern void  rt_resort_prio   (P_TCB p_task);
-extern void  rt_put_dly       (P_TCB p_task, U16 delay);
+extern void  rt_put_dly       (P_TCB p_task, U32 delay);
 extern void  rt_dec_dly       (void);
 extern void  rt_rmv_list      (P_TCB p_task);
 extern void  rt_rmv_dly       (P_TCB p_task);
@@ -37,8 +37,8 @@
 
 /* Functions */
 extern void      rt_mbx_init  (OS_ID mailbox, U16 mbx_size);
-extern OS_RESULT rt_mbx_send  (OS_ID mailbox, void *p_msg,    U16 timeout);
-extern OS_RESULT rt_mbx_wait  (OS_ID mailbox, void **message, U16 timeout);
+extern OS_RESULT rt_mbx_send  (OS_ID mailbox, void *p_msg,    U32 timeout);
+extern OS_RESULT rt_mbx_wait  (OS_ID mailbox, void **message, U32 timeout);
 extern OS_RESULT rt_mbx_check (OS_ID mailbox);
 extern void      isr_mbx_send (OS_ID mailbox, void *p_msg);
 extern OS_RESULT isr_mbx_receive (OS_ID mailbox, void **message);
@@ -33,7 +33,9 @@
  *---------------------------------------------------------------------------*/
 
 #include "rt_TypeDef.h"
+#include "RTX_Config.h"
 #include "rt_Memory.h"
+#include "rt_Tlsf.h"
 
 
 /* Functions */
@@ -47,6 +49,9 @@
 U32 rt_init_mem (void *pool, U32 size) {
   MEMP *ptr;
 
+  if (os_memtlsf != 0U) {
+    return (rt_tlsf_init (pool, size));
+  }
   if ((pool == NULL) || (size < sizeof(MEMP))) { return (1U); }
 
   ptr = (MEMP *)pool;
@@ -67,6 +72,9 @@ void *rt_alloc_mem (void *pool, U32 size) {
   MEMP *p, *p_search, *p_new;
   U32   hole_size;
 
+  if (os_memtlsf != 0U) {
+    return (rt_tlsf_alloc (pool, size));
+  }
   if ((pool == NULL) || (size == 0U)) { return NULL; }
 
   /* Add header offset to 'size' */
@@ -112,6 +120,9 @@ void *rt_alloc_mem (void *pool, U32 size) {
 U32 rt_free_mem (void *pool, void *mem) {
   MEMP *p_search, *p_prev, *p_return;
 
+  if (os_memtlsf != 0U) {
+    return (rt_tlsf_free (pool, mem));
+  }
   if ((pool == NULL) || (mem == NULL)) { return (1U); }
 
   p_return = (MEMP *)((U32)mem - sizeof(MEMP));
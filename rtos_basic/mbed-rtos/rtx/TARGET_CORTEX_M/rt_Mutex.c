@@ -37,6 +37,7 @@
 #include "rt_List.h"
 #include "rt_Task.h"
 #include "rt_Mutex.h"
+#include "rt_Trace.h"
 #include "rt_HAL_CM.h"
 
 
@@ -215,7 +216,7 @@ OS_RESULT rt_mut_release (OS_ID mutex) {
 
 /*--------------------------- rt_mut_wait -----------------------------------*/
 
-OS_RESULT rt_mut_wait (OS_ID mutex, U16 timeout) {
+OS_RESULT rt_mut_wait (OS_ID mutex, U32 timeout) {
   /* Wait for a mutex, continue when mutex is free. */
   P_MUCB p_MCB = mutex;
 
@@ -239,6 +240,8 @@ inc:p_MCB->level++;
   if (p_MCB->owner->prio < os_tsk.run->prio) {
     p_MCB->owner->prio = os_tsk.run->prio;
     rt_resort_prio (p_MCB->owner);
+    rt_trace_put (TRC_INFO(TRC_MUT_BOOST, p_MCB->owner->task_id,
+                           os_tsk.run->task_id | ((U32)os_tsk.run->prio << 8)), (U32)p_MCB);
   }
   if (p_MCB->p_lnk != NULL) {
     rt_put_prio ((P_XCB)p_MCB, os_tsk.run);
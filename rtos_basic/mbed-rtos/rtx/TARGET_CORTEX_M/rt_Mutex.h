@@ -39,7 +39,7 @@
 extern void      rt_mut_init    (OS_ID mutex);
 extern OS_RESULT rt_mut_delete  (OS_ID mutex);
 extern OS_RESULT rt_mut_release (OS_ID mutex);
-extern OS_RESULT rt_mut_wait    (OS_ID mutex, U16 timeout);
+extern OS_RESULT rt_mut_wait    (OS_ID mutex, U32 timeout);
 
 /*----------------------------------------------------------------------------
  * end of file
@@ -38,6 +38,7 @@
 #include "rt_List.h"
 #include "rt_Task.h"
 #include "rt_Semaphore.h"
+#include "rt_Trace.h"
 #include "rt_HAL_CM.h"
 
 
@@ -99,6 +100,7 @@ OS_RESULT rt_sem_send (OS_ID semaphore) {
   if (p_SCB->p_lnk != NULL) {
     /* A task is waiting for token */
     p_TCB = rt_get_first ((P_XCB)p_SCB);
+    rt_trace_put (TRC_INFO(TRC_SEM_GIVE, rt_trace_tid(), p_TCB->task_id), (U32)p_SCB);
 #ifdef __CMSIS_RTOS
     rt_ret_val(p_TCB, 1U);
 #else
@@ -110,6 +112,7 @@ OS_RESULT rt_sem_send (OS_ID semaphore) {
   else {
     /* Store token. */
     p_SCB->tokens++;
+    rt_trace_put (TRC_INFO(TRC_SEM_GIVE, rt_trace_tid(), 0U), (U32)p_SCB);
   }
   return (OS_R_OK);
 }
@@ -117,18 +120,20 @@ OS_RESULT rt_sem_send (OS_ID semaphore) {
 
 /*--------------------------- rt_sem_wait -----------------------------------*/
 
-OS_RESULT rt_sem_wait (OS_ID semaphore, U16 timeout) {
+OS_RESULT rt_sem_wait (OS_ID semaphore, U32 timeout) {
   /* Obtain a token; possibly wait for it */
   P_SCB p_SCB = semaphore;
 
   if (p_SCB->tokens) {
     p_SCB->tokens--;
+    rt_trace_put (TRC_INFO(TRC_SEM_TAKE, rt_trace_tid(), p_SCB->tokens), (U32)p_SCB);
     return (OS_R_OK);
   }
   /* No token available: wait for one */
   if (timeout == 0U) {
     return (OS_R_TMO);
   }
+  rt_trace_put (TRC_INFO(TRC_SEM_BLOCK, rt_trace_tid(), 0U), (U32)p_SCB);
   if (p_SCB->p_lnk != NULL) {
     rt_put_prio ((P_XCB)p_SCB, os_tsk.run);
   }
@@ -148,6 +153,7 @@ void isr_sem_send (OS_ID semaphore) {
   /* Same function as "os_sem_send", but to be called by ISRs */
   P_SCB p_SCB = semaphore;
 
+  rt_trace_put (TRC_INFO(TRC_SEM_ISR, rt_trace_tid(), NVIC_INT_CTRL & 0x1FFU), (U32)p_SCB);
   rt_psq_enq (p_SCB, 0U);
   rt_psh_req ();
 }
@@ -39,7 +39,7 @@
 extern void      rt_sem_init  (OS_ID semaphore, U16 token_count);
 extern OS_RESULT rt_sem_delete(OS_ID semaphore);
 extern OS_RESULT rt_sem_send  (OS_ID semaphore);
-extern OS_RESULT rt_sem_wait  (OS_ID semaphore, U16 timeout);
+extern OS_RESULT rt_sem_wait  (OS_ID semaphore, U32 timeout);
 extern void      isr_sem_send (OS_ID semaphore);
 extern void      rt_sem_psh (P_SCB p_CB);
 
@@ -43,6 +43,7 @@
 #include "rt_Time.h"
 #include "rt_Timer.h"
 #include "rt_Robin.h"
+#include "rt_Wheel.h"
 #include "rt_HAL_CM.h"
 
 /*----------------------------------------------------------------------------
@@ -83,15 +84,12 @@ extern U32 sysUserTimerWakeupTime(void);
 U32 rt_suspend (void) {
   /* Suspend OS scheduler */
   U32 delta = 0xFFFFU;
-#ifdef __CMSIS_RTOS
   U32 sleep;
-#endif
 
   rt_tsk_lock();
   
-  if (os_dly.p_dlnk) {
-    delta = os_dly.delta_time;
-  }
+  sleep = rt_whl_next (&os_dly);
+  if (sleep < delta) { delta = sleep; }
 #ifdef __CMSIS_RTOS
   sleep = sysUserTimerWakeupTime();
   if (sleep < delta) { delta = sleep; }
@@ -112,32 +110,24 @@ extern void sysUserTimerUpdate (U32 sleep_time);
 void rt_resume (U32 sleep_time) {
   /* Resume OS scheduler after suspend */
   P_TCB next;
-  U32   delta;
+  U32   delta,skip;
 
   os_tsk.run->state = READY;
   rt_put_rdy_first (os_tsk.run);
 
   os_robin.task = NULL;
 
-  /* Update delays. */
-  if (os_dly.p_dlnk) {
-    delta = sleep_time;
-    if (delta >= os_dly.delta_time) {
-      delta   -= os_dly.delta_time;
-      os_time += os_dly.delta_time;
-      os_dly.delta_time = 1U;
-      while (os_dly.p_dlnk) {
-        rt_dec_dly();
-        if (delta == 0U) { break; }
-        delta--;
-        os_time++;
-      }
-    } else {
-      os_time           +=      delta;
-      os_dly.delta_time -= (U16)delta;
+  /* Update delays, ticking the wheel only where it has work to do. */
+  delta = sleep_time;
+  while (delta != 0U) {
+    skip     = rt_whl_skip (&os_dly, delta);
+    os_time += skip;
+    delta   -= skip;
+    if (delta != 0U) {
+      os_time++;
+      rt_dec_dly();
+      delta--;
     }
-  } else {
-    os_time += sleep_time;
   }
 
   /* Check the user timers. */
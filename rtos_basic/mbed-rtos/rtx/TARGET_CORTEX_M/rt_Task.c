@@ -37,8 +37,11 @@
 #include "rt_System.h"
 #include "rt_Task.h"
 #include "rt_List.h"
+#include "rt_Wheel.h"
+#include "rt_Time.h"
 #include "rt_MemBox.h"
 #include "rt_Robin.h"
+#include "rt_Trace.h"
 #include "rt_HAL_CM.h"
 #include "rt_OsEventObserver.h"
 
@@ -79,10 +82,10 @@ static void rt_init_context (P_TCB p_TCB, U8 priority, FUNCP task_body) {
   p_TCB->prio_base = priority;
   p_TCB->p_lnk     = NULL;
   p_TCB->p_rlnk    = NULL;
-  p_TCB->p_dlnk    = NULL;
-  p_TCB->p_blnk    = NULL;
+  p_TCB->dly.next  = NULL;
+  p_TCB->dly.prev  = NULL;
   p_TCB->p_mlnk    = NULL;
-  p_TCB->delta_time    = 0U;
+  p_TCB->dly.expire    = 0U;
   p_TCB->interval_time = 0U;
   p_TCB->events  = 0U;
   p_TCB->waits   = 0U;
@@ -100,6 +103,7 @@ static void rt_init_context (P_TCB p_TCB, U8 priority, FUNCP task_body) {
 
 void rt_switch_req (P_TCB p_new) {
   /* Switch to next task (identified by "p_new"). */
+  rt_trace_switch (p_new);
   os_tsk.new_tsk   = p_new;
   p_new->state = RUNNING;
   if (osEventObs && osEventObs->thread_switch) {
@@ -138,14 +142,14 @@ void rt_dispatch (P_TCB next_TCB) {
 
 /*--------------------------- rt_block --------------------------------------*/
 
-void rt_block (U16 timeout, U8 block_state) {
+void rt_block (U32 timeout, U8 block_state) {
   /* Block running task and choose next ready task.                         */
-  /* "timeout" sets a time-out value or is 0xffff (=no time-out).           */
+  /* "timeout" sets a time-out value or is 0xffffffff (=no time-out).       */
   /* "block_state" defines the appropriate task state */
   P_TCB next_TCB;
 
   if (timeout) {
-    if (timeout < 0xFFFFU) {
+    if (timeout < 0xFFFFFFFFU) {
       rt_put_dly (os_tsk.run, timeout);
     }
     os_tsk.run->state = block_state;
@@ -252,6 +256,7 @@ OS_TID rt_tsk_create (FUNCP task, U32 prio_stksz, void *stk, void *argv) {
   rt_init_context (task_context, (U8)(prio_stksz & 0xFFU), task);
 
   os_active_TCB[i-1U] = task_context;
+  rt_trace_clear (task_context);
   DBG_TASK_NOTIFY(task_context, __TRUE);
   rt_dispatch (task_context);
   return ((OS_TID)i);
@@ -393,11 +398,14 @@ void rt_sys_init (FUNCP first_task, U32 prio_stksz, void *stk) {
   /* Set up ready list: initially empty */
   os_rdy.cb_type = HCB;
   os_rdy.p_lnk   = NULL;
-  /* Set up delay list: initially empty */
-  os_dly.cb_type = HCB;
-  os_dly.p_dlnk  = NULL;
-  os_dly.p_blnk  = NULL;
-  os_dly.delta_time = 0U;
+#if (OS_RDYBITMAP)
+  os_rdy_map     = 0U;
+#endif
+  /* Set up delay wheel: initially empty */
+  rt_whl_init (&os_dly, os_time);
+
+  /* Start CPU usage accounting and the scheduler trace */
+  rt_trace_init ();
 
   /* Fix SP and system variables to assume idle task is running */
   /* Transform main program into idle task by assuming idle TCB */
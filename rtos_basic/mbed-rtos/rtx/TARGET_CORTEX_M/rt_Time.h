@@ -40,7 +40,7 @@ extern U32 os_time;
 
 /* Functions */
 extern U32  rt_time_get (void);
-extern void rt_dly_wait (U16 delay_time);
+extern void rt_dly_wait (U32 delay_time);
 extern void rt_itv_set  (U16 interval_time);
 extern void rt_itv_wait (void);
 
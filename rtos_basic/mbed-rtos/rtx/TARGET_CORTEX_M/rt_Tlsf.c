@@ -0,0 +1,513 @@
+/*----------------------------------------------------------------------------
+ *      CMSIS-RTOS  -  RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_TLSF.C
+ *      Purpose: Two-level segregated fit memory allocator
+ *      Rev.:    V4.79
+ *----------------------------------------------------------------------------
+ *
+ * Copyright (c) 1999-2009 KEIL, 2009-2015 ARM Germany GmbH
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  - Neither the name of ARM  nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *---------------------------------------------------------------------------*/
+
+#include "rt_TypeDef.h"
+#include "RTX_Config.h"
+#include "rt_Tlsf.h"
+#include "rt_HAL_CM.h"
+
+/*----------------------------------------------------------------------------
+ *      Two-level segregated fit
+ *
+ *  Free blocks are kept in lists by size class. The first level splits the
+ *  sizes by power of two, and the second level splits each power of two in
+ *  TLSF_SL_COUNT equal steps; blocks under TLSF_SMALL bytes have a class
+ *  per 8 bytes. A bitmap per level tells which lists are non-empty, so the
+ *  smallest class that surely fits a request is found with two bit scans,
+ *  and allocating and freeing take constant time. The control block sits
+ *  at the start of the pool; a used block of size 0 marks its end.
+ *---------------------------------------------------------------------------*/
+
+#define TLSF_ALIGN      8U                      /* block and payload alignment */
+#define TLSF_SL_LOG2    3U
+#define TLSF_SL_COUNT   (1U << TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT   (TLSF_SL_LOG2 + 3U)     /* 3 = log2 of TLSF_ALIGN     */
+#define TLSF_SMALL      (1U << TLSF_FL_SHIFT)
+#define TLSF_FL_MAX     17U                     /* blocks under 128 kB        */
+#define TLSF_FL_COUNT   (TLSF_FL_MAX - TLSF_FL_SHIFT + 1U)
+#define TLSF_BLK_MAX    ((1U << TLSF_FL_MAX) - TLSF_ALIGN)
+
+#define TLSF_FREE       1U                      /* flag in the size word      */
+
+typedef struct tlsf_blk {         /* << Block header >>                      */
+  struct tlsf_blk *prev_phys;     /* Block just below this one, NULL if first*/
+  U32              size;          /* Payload size, and the TLSF_FREE flag    */
+  struct tlsf_blk *next_free;     /* Free list links, only while free; they  */
+  struct tlsf_blk *prev_free;     /* overlay the start of the payload        */
+} TLSF_BLK;
+
+typedef struct tlsf_ctl {         /* << Pool control block >>                */
+  U32       fl_map;               /* Non-empty first level classes           */
+  U8        sl_map[TLSF_FL_COUNT];/* Non-empty lists per first level class   */
+  TLSF_BLK *head[TLSF_FL_COUNT][TLSF_SL_COUNT];
+  U8       *start;                /* First block                             */
+  U8       *end;                  /* End marker block                        */
+  TLSF_STATS stats;
+} TLSF_CTL;
+
+/* Header bytes in front of the payload, rounded to the alignment */
+#define TLSF_HDR        ((((U32)(U8 *)&((TLSF_BLK *)0)->next_free) + TLSF_ALIGN - 1U) & ~(TLSF_ALIGN - 1U))
+/* Smallest block that can be split off: header and room for the links */
+#define TLSF_BLK_MIN    ((sizeof(TLSF_BLK) + TLSF_ALIGN - 1U) & ~(TLSF_ALIGN - 1U))
+
+#define BLK_SIZE(b)     ((b)->size & ~TLSF_FREE)
+#define BLK_MEM(b)      ((void *)((U8 *)(b) + TLSF_HDR))
+#define MEM_BLK(m)      ((TLSF_BLK *)((U8 *)(m) - TLSF_HDR))
+#define BLK_NEXT(b)     ((TLSF_BLK *)((U8 *)(b) + TLSF_HDR + BLK_SIZE(b)))
+
+
+/*----------------------------------------------------------------------------
+ *      Local Functions
+ *---------------------------------------------------------------------------*/
+
+/*--------------------------- rt_tlsf_fls -----------------------------------*/
+
+static __inline U32 rt_tlsf_fls (U32 map) {
+  /* Return the highest bit that is set in the non-zero "map". */
+#ifdef __TARGET_ARCH_6S_M
+  U32 n = 31U;
+
+  while ((map & 0x80000000U) == 0U) {
+    map <<= 1;
+    n--;
+  }
+  return (n);
+#else
+  return (31U - __clz (map));
+#endif
+}
+
+
+/*--------------------------- rt_tlsf_ffs -----------------------------------*/
+
+static __inline U32 rt_tlsf_ffs (U32 map) {
+  /* Return the lowest bit that is set in the non-zero "map". */
+  return (rt_tlsf_fls (map & (0U - map)));
+}
+
+
+/*--------------------------- rt_tlsf_map -----------------------------------*/
+
+static void rt_tlsf_map (U32 size, U32 *fl, U32 *sl) {
+  /* Find the class of a block of "size" bytes. */
+  U32 f;
+
+  if (size < TLSF_SMALL) {
+    *fl = 0U;
+    *sl = size / (TLSF_SMALL / TLSF_SL_COUNT);
+  }
+  else {
+    f   = rt_tlsf_fls (size);
+    *sl = (size >> (f - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+    *fl = f - TLSF_FL_SHIFT + 1U;
+  }
+}
+
+
+/*--------------------------- rt_tlsf_insert --------------------------------*/
+
+static void rt_tlsf_insert (TLSF_CTL *ctl, TLSF_BLK *blk) {
+  /* Put free block "blk" at the head of the list of its class. */
+  U32 fl, sl;
+
+  rt_tlsf_map (BLK_SIZE(blk), &fl, &sl);
+  blk->prev_free = NULL;
+  blk->next_free = ctl->head[fl][sl];
+  if (blk->next_free != NULL) {
+    blk->next_free->prev_free = blk;
+  }
+  ctl->head[fl][sl] = blk;
+  ctl->fl_map      |= 1U << fl;
+  ctl->sl_map[fl]  |= (U8)(1U << sl);
+  ctl->stats.free_size += BLK_SIZE(blk);
+}
+
+
+/*--------------------------- rt_tlsf_remove --------------------------------*/
+
+static void rt_tlsf_remove (TLSF_CTL *ctl, TLSF_BLK *blk) {
+  /* Take free block "blk" off the list of its class. */
+  U32 fl, sl;
+
+  rt_tlsf_map (BLK_SIZE(blk), &fl, &sl);
+  if (blk->next_free != NULL) {
+    blk->next_free->prev_free = blk->prev_free;
+  }
+  if (blk->prev_free != NULL) {
+    blk->prev_free->next_free = blk->next_free;
+  }
+  else {
+    ctl->head[fl][sl] = blk->next_free;
+    if (blk->next_free == NULL) {
+      ctl->sl_map[fl] &= (U8)~(1U << sl);
+      if (ctl->sl_map[fl] == 0U) {
+        ctl->fl_map &= ~(1U << fl);
+      }
+    }
+  }
+  ctl->stats.free_size -= BLK_SIZE(blk);
+}
+
+
+/*--------------------------- rt_tlsf_find ----------------------------------*/
+
+static TLSF_BLK *rt_tlsf_find (TLSF_CTL *ctl, U32 size) {
+  /* Find a free block of at least "size" bytes, from the first non-empty  */
+  /* class whose every block fits.                                          */
+  U32 fl, sl, map;
+
+  if (size >= TLSF_SMALL) {
+    /* Round up to the next class boundary */
+    size += (1U << (rt_tlsf_fls (size) - TLSF_SL_LOG2)) - 1U;
+  }
+  if (size > TLSF_BLK_MAX) {
+    return (NULL);
+  }
+  rt_tlsf_map (size, &fl, &sl);
+  map = ctl->sl_map[fl] & (0xFFU << sl);
+  if (map == 0U) {
+    map = ctl->fl_map & (0xFFFFFFFFU << (fl + 1U));
+    if (map == 0U) {
+      return (NULL);
+    }
+    fl  = rt_tlsf_ffs (map);
+    map = ctl->sl_map[fl];
+  }
+  sl = rt_tlsf_ffs (map);
+  return (ctl->head[fl][sl]);
+}
+
+
+/*--------------------------- rt_tlsf_trim ----------------------------------*/
+
+static void rt_tlsf_trim (TLSF_CTL *ctl, TLSF_BLK *blk, U32 size) {
+  /* Shrink used block "blk" to "size" bytes, if the rest makes a block.   */
+  TLSF_BLK *rest, *next;
+  U32 left = BLK_SIZE(blk) - size;
+
+  if (left < TLSF_BLK_MIN) {
+    return;
+  }
+  rest = (TLSF_BLK *)((U8 *)BLK_MEM(blk) + size);
+  rest->prev_phys = blk;
+  rest->size      = left - TLSF_HDR;
+  blk->size       = size | (blk->size & TLSF_FREE);
+  next = BLK_NEXT(rest);
+  if ((next->size & TLSF_FREE) && (BLK_SIZE(rest) + TLSF_HDR + BLK_SIZE(next) <= TLSF_BLK_MAX)) {
+    /* Merge with the free block above */
+    rt_tlsf_remove (ctl, next);
+    rest->size += TLSF_HDR + BLK_SIZE(next);
+    next = BLK_NEXT(rest);
+  }
+  next->prev_phys = rest;
+  rest->size |= TLSF_FREE;
+  rt_tlsf_insert (ctl, rest);
+}
+
+
+/*--------------------------- rt_tlsf_used ----------------------------------*/
+
+static U32 rt_tlsf_used (TLSF_CTL *ctl, void *mem) {
+  /* Check that "mem" is an allocated block of the pool. */
+  TLSF_BLK *blk;
+
+  if (((U8 *)mem < ctl->start + TLSF_HDR) || ((U8 *)mem >= ctl->end)) {
+    return (0U);
+  }
+  blk = MEM_BLK(mem);
+  if ((blk->size & TLSF_FREE) || (BLK_SIZE(blk) == 0U)) {
+    return (0U);
+  }
+  return (1U);
+}
+
+
+/*----------------------------------------------------------------------------
+ *      Global Functions
+ *---------------------------------------------------------------------------*/
+
+// Initialize a TLSF memory pool
+//   Parameters:
+//     pool:    Pointer to memory pool
+//     size:    Size of memory pool in bytes
+//   Return:    0 - OK, 1 - Error
+
+U32 rt_tlsf_init (void *pool, U32 size) {
+  TLSF_CTL *ctl = pool;
+  TLSF_BLK *blk, *end;
+  U8  *p, *top;
+  U32 i, n;
+
+  if ((pool == NULL) || (((U32)(U8 *)pool & 3U) != 0U) || (size < sizeof(TLSF_CTL))) {
+    return (1U);
+  }
+  for (i = 0U; i < sizeof(TLSF_CTL); i++) {
+    ((U8 *)pool)[i] = 0U;
+  }
+  p   = (U8 *)pool + sizeof(TLSF_CTL);
+  p  += (0U - (U32)p) & (TLSF_ALIGN - 1U);
+  top = (U8 *)pool + size;
+  top -= (U32)top & (TLSF_ALIGN - 1U);
+  if ((top < p) || ((U32)(top - p) < TLSF_BLK_MIN + TLSF_HDR)) {
+    return (1U);
+  }
+  ctl->start = p;
+
+  /* Cover the pool with free blocks no larger than TLSF_BLK_MAX */
+  blk = NULL;
+  while ((U32)(top - p) >= TLSF_BLK_MIN + TLSF_HDR) {
+    n = (U32)(top - p) - 2U * TLSF_HDR;
+    if (n > TLSF_BLK_MAX) {
+      n = TLSF_BLK_MAX;
+    }
+    ((TLSF_BLK *)p)->prev_phys = blk;
+    ((TLSF_BLK *)p)->size      = n | TLSF_FREE;
+    blk = (TLSF_BLK *)p;
+    rt_tlsf_insert (ctl, blk);
+    p += TLSF_HDR + n;
+  }
+  /* End marker: a used block of no size */
+  end = (TLSF_BLK *)p;
+  end->prev_phys = blk;
+  end->size      = 0U;
+  ctl->end = p;
+  return (0U);
+}
+
+// Allocate Memory from a TLSF pool
+//   Parameters:
+//     pool:    Pointer to memory pool
+//     size:    Size of memory in bytes to allocate
+//   Return:    Pointer to allocated memory, 8-byte aligned
+
+void *rt_tlsf_alloc (void *pool, U32 size) {
+  TLSF_CTL *ctl = pool;
+  TLSF_BLK *blk, *next;
+
+  if ((pool == NULL) || (size == 0U)) { return NULL; }
+
+  blk = NULL;
+  if (size <= TLSF_BLK_MAX) {
+    size = (size + TLSF_ALIGN - 1U) & ~(TLSF_ALIGN - 1U);
+    if (size < TLSF_BLK_MIN - TLSF_HDR) {
+      size = TLSF_BLK_MIN - TLSF_HDR;
+    }
+    blk = rt_tlsf_find (ctl, size);
+  }
+  if (blk == NULL) {
+    ctl->stats.fail_cnt++;
+    return NULL;
+  }
+  rt_tlsf_remove (ctl, blk);
+  blk->size &= ~TLSF_FREE;
+  rt_tlsf_trim (ctl, blk, size);
+  next = BLK_NEXT(blk);
+  next->prev_phys = blk;
+
+  ctl->stats.cur_size   += BLK_SIZE(blk);
+  ctl->stats.total_size += BLK_SIZE(blk);
+  ctl->stats.alloc_cnt++;
+  if (ctl->stats.cur_size > ctl->stats.max_size) {
+    ctl->stats.max_size = ctl->stats.cur_size;
+  }
+  return (BLK_MEM(blk));
+}
+
+// Resize Memory allocated from a TLSF pool
+//   Parameters:
+//     pool:    Pointer to memory pool
+//     mem:     Pointer to allocated memory, or NULL to allocate
+//     size:    New size in bytes, or 0 to free
+//   Return:    Pointer to the memory, which may have moved; NULL if there
+//              is not enough memory, and then "mem" is left as it was
+
+void *rt_tlsf_realloc (void *pool, void *mem, U32 size) {
+  TLSF_CTL *ctl = pool;
+  TLSF_BLK *blk, *next;
+  void *p_new;
+  U32 old, i;
+
+  if (mem == NULL) {
+    return (rt_tlsf_alloc (pool, size));
+  }
+  if ((pool == NULL) || (rt_tlsf_used (ctl, mem) == 0U)) { return NULL; }
+  if (size == 0U) {
+    rt_tlsf_free (pool, mem);
+    return NULL;
+  }
+
+  if (size > TLSF_BLK_MAX) {
+    ctl->stats.fail_cnt++;
+    return NULL;
+  }
+  blk  = MEM_BLK(mem);
+  old  = BLK_SIZE(blk);
+  size = (size + TLSF_ALIGN - 1U) & ~(TLSF_ALIGN - 1U);
+  if (size < TLSF_BLK_MIN - TLSF_HDR) {
+    size = TLSF_BLK_MIN - TLSF_HDR;
+  }
+  next = BLK_NEXT(blk);
+  if ((size > old) && (next->size & TLSF_FREE) &&
+      (old + TLSF_HDR + BLK_SIZE(next) >= size) &&
+      (old + TLSF_HDR + BLK_SIZE(next) <= TLSF_BLK_MAX)) {
+    /* Grow into the free block above */
+    rt_tlsf_remove (ctl, next);
+    blk->size = old + TLSF_HDR + BLK_SIZE(next);
+    BLK_NEXT(blk)->prev_phys = blk;
+  }
+  if (BLK_SIZE(blk) >= size) {
+    rt_tlsf_trim (ctl, blk, size);
+    ctl->stats.cur_size += BLK_SIZE(blk) - old;
+    if (BLK_SIZE(blk) > old) {
+      ctl->stats.total_size += BLK_SIZE(blk) - old;
+    }
+    if (ctl->stats.cur_size > ctl->stats.max_size) {
+      ctl->stats.max_size = ctl->stats.cur_size;
+    }
+    return (mem);
+  }
+
+  /* Move to a new block */
+  p_new = rt_tlsf_alloc (pool, size);
+  if (p_new == NULL) {
+    return NULL;
+  }
+  for (i = 0U; i < old; i += 4U) {
+    *(U32 *)((U8 *)p_new + i) = *(U32 *)((U8 *)mem + i);
+  }
+  rt_tlsf_free (pool, mem);
+  return (p_new);
+}
+
+// Free Memory and return it to a TLSF pool
+//   Parameters:
+//     pool:    Pointer to memory pool
+//     mem:     Pointer to memory to free
+//   Return:    0 - OK, 1 - Error
+
+U32 rt_tlsf_free (void *pool, void *mem) {
+  TLSF_CTL *ctl = pool;
+  TLSF_BLK *blk, *prev, *next;
+
+  if ((pool == NULL) || (mem == NULL)) { return (1U); }
+  if (rt_tlsf_used (ctl, mem) == 0U) {
+    /* Not a block of this pool, or freed already */
+    return (1U);
+  }
+
+  blk = MEM_BLK(mem);
+  ctl->stats.cur_size -= BLK_SIZE(blk);
+  ctl->stats.alloc_cnt--;
+
+  prev = blk->prev_phys;
+  if ((prev != NULL) && (prev->size & TLSF_FREE) &&
+      (BLK_SIZE(prev) + TLSF_HDR + BLK_SIZE(blk) <= TLSF_BLK_MAX)) {
+    /* Merge with the free block below */
+    rt_tlsf_remove (ctl, prev);
+    prev->size = BLK_SIZE(prev) + TLSF_HDR + BLK_SIZE(blk);
+    blk = prev;
+  }
+  next = BLK_NEXT(blk);
+  if ((next->size & TLSF_FREE) && (BLK_SIZE(blk) + TLSF_HDR + BLK_SIZE(next) <= TLSF_BLK_MAX)) {
+    /* Merge with the free block above */
+    rt_tlsf_remove (ctl, next);
+    blk->size = BLK_SIZE(blk) + TLSF_HDR + BLK_SIZE(next);
+    next = BLK_NEXT(blk);
+  }
+  next->prev_phys = blk;
+  blk->size |= TLSF_FREE;
+  rt_tlsf_insert (ctl, blk);
+  return (0U);
+}
+
+// Check if Memory belongs to a TLSF pool
+//   Parameters:
+//     pool:    Pointer to memory pool
+//     mem:     Pointer to memory
+//   Return:    1 - it lies within the pool, 0 - it does not
+
+U32 rt_tlsf_owns (void *pool, void *mem) {
+  TLSF_CTL *ctl = pool;
+
+  if ((pool == NULL) || ((U8 *)mem < ctl->start) || ((U8 *)mem >= ctl->end)) {
+    return (0U);
+  }
+  return (1U);
+}
+
+// Get the usable size of Memory allocated from a TLSF pool
+//   Parameters:
+//     pool:    Pointer to memory pool
+//     mem:     Pointer to allocated memory
+//   Return:    Size in bytes, 0 if "mem" is not allocated from the pool
+
+U32 rt_tlsf_size (void *pool, void *mem) {
+  if ((pool == NULL) || (rt_tlsf_used (pool, mem) == 0U)) {
+    return (0U);
+  }
+  return (BLK_SIZE(MEM_BLK(mem)));
+}
+
+// Get the statistics of a TLSF pool
+//   Parameters:
+//     pool:    Pointer to memory pool
+//     stats:   Receives the statistics
+
+void rt_tlsf_stats (void *pool, TLSF_STATS *stats) {
+  TLSF_CTL *ctl = pool;
+  TLSF_BLK *blk;
+  U32 fl, sl, n;
+
+  *stats = ctl->stats;
+  stats->max_free = 0U;
+  stats->frag     = 0U;
+  if (ctl->fl_map != 0U) {
+    /* The largest free block is in the highest non-empty list */
+    fl = rt_tlsf_fls (ctl->fl_map);
+    sl = rt_tlsf_fls (ctl->sl_map[fl]);
+    for (blk = ctl->head[fl][sl]; blk != NULL; blk = blk->next_free) {
+      if (BLK_SIZE(blk) > stats->max_free) {
+        stats->max_free = BLK_SIZE(blk);
+      }
+    }
+    /* No block is larger than TLSF_BLK_MAX, so a larger pool is in several */
+    /* blocks even when it is all free: count against what one could hold   */
+    n = (stats->free_size < TLSF_BLK_MAX) ? stats->free_size : TLSF_BLK_MAX;
+    stats->frag = 1000U - (U32)(((U64)stats->max_free * 1000U) / n);
+  }
+}
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
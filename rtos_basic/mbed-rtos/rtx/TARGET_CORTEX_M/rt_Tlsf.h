@@ -0,0 +1,66 @@
+
+/** \addtogroup rtos */
+/** @{*/
+/*----------------------------------------------------------------------------
+ *      CMSIS-RTOS  -  RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_TLSF.H
+ *      Purpose: Two-level segregated fit memory allocator definitions
+ *      Rev.:    V4.79
+ *----------------------------------------------------------------------------
+ *
+ * Copyright (c) 1999-2009 KEIL, 2009-2015 ARM Germany GmbH
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  - Neither the name of ARM  nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *---------------------------------------------------------------------------*/
+
+/* Types */
+typedef struct tlsf_stats {       /* << Allocator statistics >>              */
+  U32 cur_size;                   /* Bytes allocated currently               */
+  U32 max_size;                   /* Most bytes allocated at any time        */
+  U32 total_size;                 /* Cumulative bytes ever allocated         */
+  U32 alloc_cnt;                  /* Current number of allocations           */
+  U32 fail_cnt;                   /* Number of failed allocations            */
+  U32 free_size;                  /* Bytes in free blocks                    */
+  U32 max_free;                   /* Largest free block                      */
+  U32 frag;                       /* Fragmentation in 1/1000: share of free  */
+                                  /* memory outside the largest free block,  */
+                                  /* of at most one block's worth (128 kB)   */
+} TLSF_STATS;
+
+/* Functions */
+extern U32   rt_tlsf_init    (void *pool, U32 size);
+extern void *rt_tlsf_alloc   (void *pool, U32 size);
+extern void *rt_tlsf_realloc (void *pool, void *mem, U32 size);
+extern U32   rt_tlsf_free    (void *pool, void *mem);
+extern U32   rt_tlsf_owns    (void *pool, void *mem);
+extern U32   rt_tlsf_size    (void *pool, void *mem);
+extern void  rt_tlsf_stats   (void *pool, TLSF_STATS *stats);
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
+
+
+/** @}*/
@@ -0,0 +1,213 @@
+/*----------------------------------------------------------------------------
+ *      CMSIS-RTOS  -  RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_TRACE.C
+ *      Purpose: CPU usage accounting and scheduler trace
+ *      Rev.:    V4.79
+ *----------------------------------------------------------------------------
+ *
+ * Copyright (c) 1999-2009 KEIL, 2009-2015 ARM Germany GmbH
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  - Neither the name of ARM  nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *---------------------------------------------------------------------------*/
+
+#include "rt_TypeDef.h"
+#include "RTX_Config.h"
+#include "rt_Task.h"
+#include "rt_Time.h"
+#include "rt_Trace.h"
+#include "rt_HAL_CM.h"
+
+/*----------------------------------------------------------------------------
+ *      CPU usage and trace
+ *
+ *  Time stamps are taken from the DWT cycle counter, which runs at the
+ *  core clock and is not clocked while the core sleeps. At each thread
+ *  switch request the cycles since the previous one are charged to the
+ *  task that was running, so time spent in interrupt handlers is charged
+ *  to the task they interrupted.
+ *
+ *  Events go into a ring of os_trace_size entries of three words: time
+ *  stamp, info word (see TRC_INFO) and object. A writer claims an entry
+ *  by advancing os_trace_head, and the oldest entries are overwritten.
+ *---------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------
+ *      Global Variables
+ *---------------------------------------------------------------------------*/
+
+/* Count of events recorded since start-up. */
+U32 os_trace_head;
+
+/* Set while events are being recorded. */
+U8 volatile os_trace_on;
+
+/* Time stamp of the last thread switch request. */
+static U32 os_trace_stamp;
+
+
+/*----------------------------------------------------------------------------
+ *      Local Functions
+ *---------------------------------------------------------------------------*/
+
+/*--------------------------- rt_trace_now ----------------------------------*/
+
+static __inline U32 rt_trace_now (void) {
+#if defined(__TARGET_ARCH_6S_M)
+  /* No cycle counter: count SysTick clocks instead. */
+  return (os_time * (os_trv + 1U) + rt_systick_val());
+#else
+  return (DWT_CYCCNT);
+#endif
+}
+
+
+/*--------------------------- rt_trace_idx ----------------------------------*/
+
+static __inline U32 rt_trace_idx (P_TCB p_TCB) {
+  /* Index of the task in 'os_tsk_cycles' */
+  if (p_TCB->task_id == 255U) {
+    return (os_maxtaskrun);
+  }
+  return ((U32)p_TCB->task_id - 1U);
+}
+
+
+/*----------------------------------------------------------------------------
+ *      Global Functions
+ *---------------------------------------------------------------------------*/
+
+/*--------------------------- rt_trace_init ---------------------------------*/
+
+void rt_trace_init (void) {
+  /* Start the cycle counter, and clear the counts and the trace. */
+  U32 i;
+
+#if !defined(__TARGET_ARCH_6S_M)
+  DEMCR       |= DEMCR_TRCENA;
+  DWT_CONTROL |= DWT_CYCCNTENA;
+#endif
+  for (i = 0U; i <= os_maxtaskrun; i++) {
+    os_tsk_cycles[i] = 0U;
+  }
+  os_trace_head  = 0U;
+  os_trace_on    = (os_trace_size != 0U) ? 1U : 0U;
+  os_trace_stamp = rt_trace_now();
+}
+
+
+/*--------------------------- rt_trace_clear --------------------------------*/
+
+void rt_trace_clear (P_TCB p_TCB) {
+  /* Clear the cycle count of a new task. */
+  os_tsk_cycles[rt_trace_idx(p_TCB)] = 0U;
+}
+
+
+/*--------------------------- rt_trace_switch -------------------------------*/
+
+void rt_trace_switch (P_TCB p_new) {
+  /* Charge the running task, and record the switch to "p_new". */
+  U32 now;
+  U32 prev = 0U;
+
+  if (p_new == os_tsk.run) {
+    /* rt_systick asks for the running task on every tick: not a switch. */
+    return;
+  }
+  now = rt_trace_now();
+  if (os_tsk.run != NULL) {
+    if (os_cpustat) {
+      os_tsk_cycles[rt_trace_idx(os_tsk.run)] += now - os_trace_stamp;
+    }
+    prev = os_tsk.run->task_id;
+  }
+  os_trace_stamp = now;
+  rt_trace_put (TRC_INFO(TRC_SWITCH, p_new->task_id, prev), (U32)p_new);
+}
+
+
+/*--------------------------- rt_trace_put ----------------------------------*/
+
+void rt_trace_put (U32 info, U32 obj) {
+  /* Record an event in the trace ring. */
+  U32 idx;
+  U32 *p_evt;
+
+  if (os_trace_on == 0U) {
+    return;
+  }
+#ifdef __USE_EXCLUSIVE_ACCESS
+  do {
+    idx = __ldrex(&os_trace_head);
+  } while (__strex(idx+1U, &os_trace_head));
+#else
+  {
+    U32 primask = __get_PRIMASK();
+    __disable_irq();
+    idx = os_trace_head++;
+    if (!primask) {
+      __enable_irq();
+    }
+  }
+#endif
+  p_evt = &os_trace_buf[(idx & (os_trace_size - 1U)) * 3U];
+  p_evt[0] = rt_trace_now();
+  p_evt[1] = info;
+  p_evt[2] = obj;
+}
+
+
+/*--------------------------- rt_trace_tid ----------------------------------*/
+
+U32 rt_trace_tid (void) {
+  /* Task id of the running task, for event info words. */
+  if (os_tsk.run == NULL) {
+    return (0U);
+  }
+  return (os_tsk.run->task_id);
+}
+
+
+/*--------------------------- rt_trace_cycles -------------------------------*/
+
+U64 rt_trace_cycles (P_TCB p_TCB) {
+  /* Cycles used by a task, including the current run if it is running. */
+  U64 cycles;
+  U32 primask = __get_PRIMASK();
+
+  __disable_irq();
+  cycles = os_tsk_cycles[rt_trace_idx(p_TCB)];
+  if ((p_TCB == os_tsk.run) && os_cpustat) {
+    cycles += rt_trace_now() - os_trace_stamp;
+  }
+  if (!primask) {
+    __enable_irq();
+  }
+  return (cycles);
+}
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
@@ -0,0 +1,68 @@
+
+/** \addtogroup rtos */
+/** @{*/
+/*----------------------------------------------------------------------------
+ *      CMSIS-RTOS  -  RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_TRACE.H
+ *      Purpose: CPU usage accounting and scheduler trace definitions
+ *      Rev.:    V4.79
+ *----------------------------------------------------------------------------
+ *
+ * Copyright (c) 1999-2009 KEIL, 2009-2015 ARM Germany GmbH
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  - Neither the name of ARM  nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *---------------------------------------------------------------------------*/
+
+/* Trace event types, in the low byte of the event info word */
+#define TRC_SWITCH      1U      /* thread switch: arg = previous task id     */
+#define TRC_ISR         2U      /* interrupt entry: arg = exception number   */
+#define TRC_SEM_TAKE    3U      /* token taken: arg = tokens left            */
+#define TRC_SEM_BLOCK   4U      /* no token, thread blocks                   */
+#define TRC_SEM_GIVE    5U      /* token returned: arg = task id woken, or 0 */
+#define TRC_SEM_ISR     6U      /* token returned by an ISR: arg = exception */
+#define TRC_MUT_BOOST   7U      /* mutex owner raised by priority inheritance:*/
+                                /* arg = waiter task id | new priority << 8  */
+
+/* Event info word: type, task id of the thread it concerns, argument */
+#define TRC_INFO(type,tid,arg)  ((U32)(type) | ((U32)(tid) << 8) | ((U32)(arg) << 16))
+
+/* Variables */
+extern U32 os_trace_head;
+extern U8  volatile os_trace_on;
+
+/* Functions */
+extern void rt_trace_init   (void);
+extern void rt_trace_clear  (P_TCB p_TCB);
+extern void rt_trace_switch (P_TCB p_new);
+extern void rt_trace_put    (U32 info, U32 obj);
+extern U32  rt_trace_tid    (void);
+extern U64  rt_trace_cycles (P_TCB p_TCB);
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
+
+
+/** @}*/
@@ -54,6 +54,12 @@ typedef U32     OS_TID;
 typedef void    *OS_ID;
 typedef U32     OS_RESULT;
 
+typedef struct OS_WNODE {         /* Timing wheel entry                      */
+  struct OS_WNODE *next;          /* Link pointer for wheel slot list        */
+  struct OS_WNODE *prev;          /* Link pointer backwards, NULL if idle    */
+  U32    expire;                  /* Tick count of expiry                    */
+} *P_WNODE;
+
 typedef struct OS_TCB {
   /* General part: identical for all implementations.                        */
   U8     cb_type;                 /* Control Block Type                      */
@@ -62,10 +68,7 @@ typedef struct OS_TCB {
   U8     task_id;                 /* Task ID value for optimized TCB access  */
   struct OS_TCB *p_lnk;           /* Link pointer for ready/sem. wait list   */
   struct OS_TCB *p_rlnk;          /* Link pointer for sem./mbx lst backwards */
-  struct OS_TCB *p_dlnk;          /* Link pointer for delay list             */
-  struct OS_TCB *p_blnk;          /* Link pointer for delay list backwards   */
-  U16    delta_time;              /* Time until time out                     */
-  U16    interval_time;           /* Time interval for periodic waits        */
+  struct OS_WNODE dly;            /* Entry in the delay wheel                */
   U16    events;                  /* Event flags                             */
   U16    waits;                   /* Wait flags                              */
   void   **msg;                   /* Direct message passing when task waits  */
@@ -74,8 +77,8 @@ typedef struct OS_TCB {
 
   /* Hardware dependant part: specific for CM processor                      */
   U8     stack_frame;             /* Stack frame: 0=Basic, 1=Extended,       */
-  U16    reserved;                /* Two reserved bytes for alignment        */
                                   /* (2=VFP/D16 stacked, 4=NEON/D32 stacked) */
+  U16    interval_time;           /* Time interval for periodic waits        */
   U32    priv_stack;              /* Private stack size, 0= system assigned  */
   U32    tsk_stack;               /* Current task Stack pointer (R13)        */
   U32    *stack;                  /* Pointer to Task Stack memory block      */
@@ -159,6 +162,16 @@ typedef struct OS_TMR {
   U16    info;                    /* User defined call info                  */
 } *P_TMR;
 
+#define WHL_BITS        4U        /* Slots per wheel level: 2^WHL_BITS       */
+#define WHL_SLOTS       (1U << WHL_BITS)
+#define WHL_LEVELS      (32U / WHL_BITS)
+
+typedef struct OS_WHL {           /* Hierarchical timing wheel               */
+  U32    time;                    /* Tick count processed up to              */
+  U16    map[WHL_LEVELS];         /* Non-empty slots of each level           */
+  struct OS_WNODE *slot[WHL_LEVELS][WHL_SLOTS];
+} *P_WHL;
+
 typedef struct OS_BM {
   void *free;                     /* Pointer to first free memory block      */
   void *end;                      /* Pointer to memory block end             */
@@ -0,0 +1,253 @@
+/*----------------------------------------------------------------------------
+ *      CMSIS-RTOS  -  RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_WHEEL.C
+ *      Purpose: Hierarchical timing wheel for delays and timers
+ *      Rev.:    V4.79
+ *----------------------------------------------------------------------------
+ *
+ * Copyright (c) 1999-2009 KEIL, 2009-2015 ARM Germany GmbH
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  - Neither the name of ARM  nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *---------------------------------------------------------------------------*/
+
+#include "rt_TypeDef.h"
+#include "RTX_Config.h"
+#include "rt_Wheel.h"
+#include "rt_HAL_CM.h"
+
+/*----------------------------------------------------------------------------
+ *      Timing wheel
+ *
+ *  Entries are kept by absolute expiry tick in WHL_LEVELS levels of
+ *  WHL_SLOTS slots. Level 0 holds entries due within WHL_SLOTS ticks, one
+ *  slot per tick; each higher level covers WHL_SLOTS times the span of the
+ *  one below. When the wheel time crosses the start of a higher level slot,
+ *  that slot is cascaded: its entries are put again, and land on a lower
+ *  level. An entry is thus moved at most WHL_LEVELS-1 times, and putting or
+ *  removing one never walks a list.
+ *---------------------------------------------------------------------------*/
+
+#define WHL_MASK        (WHL_SLOTS - 1U)
+
+/*----------------------------------------------------------------------------
+ *      Local Functions
+ *---------------------------------------------------------------------------*/
+
+/*--------------------------- rt_whl_lowest ---------------------------------*/
+
+static __inline U32 rt_whl_lowest (U32 map) {
+  /* Return the lowest bit that is set in the non-zero bitmap "map".        */
+#ifdef __TARGET_ARCH_6S_M
+  U32 n = 0U;
+
+  while ((map & 1U) == 0U) {
+    map >>= 1;
+    n++;
+  }
+  return (n);
+#else
+  return (31U - __clz (map & (0U - map)));
+#endif
+}
+
+
+/*--------------------------- rt_whl_link -----------------------------------*/
+
+static void rt_whl_link (P_WHL p_whl, P_WNODE p_node) {
+  /* Put entry "p_node" at the head of the slot that matches its expiry.   */
+  P_WNODE *p_slot;
+  U32 delta,lvl,idx;
+
+  delta = p_node->expire - p_whl->time;
+  lvl = 0U;
+  while ((lvl < (WHL_LEVELS - 1U)) && ((delta >> (WHL_BITS * (lvl + 1U))) != 0U)) {
+    lvl++;
+  }
+  idx = (p_node->expire >> (WHL_BITS * lvl)) & WHL_MASK;
+  p_slot = &p_whl->slot[lvl][idx];
+  /* The slot head acts as the "next" field of a list head entry */
+  p_node->next = *p_slot;
+  p_node->prev = (P_WNODE)p_slot;
+  if (*p_slot != NULL) {
+    (*p_slot)->prev = p_node;
+  }
+  *p_slot = p_node;
+  p_whl->map[lvl] |= (U16)(1U << idx);
+}
+
+
+/*--------------------------- rt_whl_take -----------------------------------*/
+
+static P_WNODE rt_whl_take (P_WHL p_whl, U32 lvl, U32 idx) {
+  /* Detach all entries of a slot and return them as a list. */
+  P_WNODE p_list;
+
+  p_list = p_whl->slot[lvl][idx];
+  p_whl->slot[lvl][idx] = NULL;
+  p_whl->map[lvl] &= (U16)~(1U << idx);
+  return (p_list);
+}
+
+
+/*----------------------------------------------------------------------------
+ *      Functions
+ *---------------------------------------------------------------------------*/
+
+/*--------------------------- rt_whl_init -----------------------------------*/
+
+void rt_whl_init (P_WHL p_whl, U32 time) {
+  /* Initialize an empty wheel, processed up to tick "time". */
+  U32 lvl,idx;
+
+  p_whl->time = time;
+  for (lvl = 0U; lvl < WHL_LEVELS; lvl++) {
+    p_whl->map[lvl] = 0U;
+    for (idx = 0U; idx < WHL_SLOTS; idx++) {
+      p_whl->slot[lvl][idx] = NULL;
+    }
+  }
+}
+
+
+/*--------------------------- rt_whl_put ------------------------------------*/
+
+void rt_whl_put (P_WHL p_whl, P_WNODE p_node, U32 expire) {
+  /* Put entry "p_node" into the wheel, to expire at tick "expire", which   */
+  /* must be later than the current wheel time.                             */
+  p_node->expire = expire;
+  rt_whl_link (p_whl, p_node);
+}
+
+
+/*--------------------------- rt_whl_rmv ------------------------------------*/
+
+void rt_whl_rmv (P_WHL p_whl, P_WNODE p_node) {
+  /* Remove entry "p_node" from the wheel if enqueued. */
+  P_WNODE p_prev;
+  U32 idx;
+
+  p_prev = p_node->prev;
+  if (p_prev == NULL) {
+    return;
+  }
+  p_prev->next = p_node->next;
+  if (p_node->next != NULL) {
+    p_node->next->prev = p_prev;
+  }
+  else if (((P_WNODE *)p_prev >= &p_whl->slot[0][0]) &&
+           ((P_WNODE *)p_prev <= &p_whl->slot[WHL_LEVELS-1][WHL_SLOTS-1])) {
+    /* Was the only entry of its slot */
+    idx = (U32)((P_WNODE *)p_prev - &p_whl->slot[0][0]);
+    p_whl->map[idx >> WHL_BITS] &= (U16)~(1U << (idx & WHL_MASK));
+  }
+  p_node->next = NULL;
+  p_node->prev = NULL;
+}
+
+
+/*--------------------------- rt_whl_tick -----------------------------------*/
+
+P_WNODE rt_whl_tick (P_WHL p_whl) {
+  /* Advance the wheel by one tick. Returns the list of entries that expire */
+  /* on this tick, chained by "next" and already marked as not enqueued.    */
+  P_WNODE p_list,p_node;
+  U32 time,lvl;
+
+  time = ++p_whl->time;
+  /* Find the highest level whose slot boundary is crossed */
+  lvl = 1U;
+  while ((lvl < WHL_LEVELS) && ((time & ((1U << (WHL_BITS * lvl)) - 1U)) == 0U)) {
+    lvl++;
+  }
+  /* Cascade from the top, so entries can drop more than one level */
+  while (--lvl != 0U) {
+    p_list = rt_whl_take (p_whl, lvl, (time >> (WHL_BITS * lvl)) & WHL_MASK);
+    while ((p_node = p_list) != NULL) {
+      p_list = p_node->next;
+      rt_whl_link (p_whl, p_node);
+    }
+  }
+  p_list = rt_whl_take (p_whl, 0U, time & WHL_MASK);
+  for (p_node = p_list; p_node != NULL; p_node = p_node->next) {
+    p_node->prev = NULL;
+  }
+  return (p_list);
+}
+
+
+/*--------------------------- rt_whl_next -----------------------------------*/
+
+U32 rt_whl_next (P_WHL p_whl) {
+  /* Return the number of ticks until the wheel next has work to do, an     */
+  /* expiry or a cascade, or 0xFFFFFFFF if the wheel is empty.              */
+  U32 lvl,sh,cur,map,next;
+  U64 ticks;
+
+  next = 0xFFFFFFFFU;
+  for (lvl = 0U; lvl < WHL_LEVELS; lvl++) {
+    map = p_whl->map[lvl];
+    if (map == 0U) {
+      continue;
+    }
+    sh  = WHL_BITS * lvl;
+    cur = ((p_whl->time >> sh) + 1U) & WHL_MASK;
+    /* Rotate the map so the slot after the current one is bit 0 */
+    map = ((map >> cur) | (map << (WHL_SLOTS - cur))) & ((1U << WHL_SLOTS) - 1U);
+    /* The slot may be in the next revolution of the top level, past 2^32 */
+    ticks = ((((U64)(p_whl->time >> sh) + 1U + rt_whl_lowest (map)) << sh)) - p_whl->time;
+    if (ticks > 0xFFFFFFFEU) {
+      ticks = 0xFFFFFFFEU;
+    }
+    if (ticks < next) {
+      next = (U32)ticks;
+    }
+  }
+  return (next);
+}
+
+
+/*--------------------------- rt_whl_skip -----------------------------------*/
+
+U32 rt_whl_skip (P_WHL p_whl, U32 ticks) {
+  /* Advance the wheel by up to "ticks" ticks on which there is nothing to  */
+  /* do. Returns the number of ticks skipped; when less than "ticks", the   */
+  /* next tick must be processed by rt_whl_tick.                            */
+  U32 next;
+
+  next = rt_whl_next (p_whl);
+  if (next == 0U) {
+    return (0U);
+  }
+  next--;
+  if (ticks > next) {
+    ticks = next;
+  }
+  p_whl->time += ticks;
+  return (ticks);
+}
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
@@ -0,0 +1,40 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CMSIS_OS_HOST_H
+#define CMSIS_OS_HOST_H
+
+/* The host port implements the RTX API of the Cortex-M target, see
+   os_host.h. Messages are pointer sized on the host. */
+#define __MBED_CMSIS_RTOS_HOST
+
+#ifndef WORDS_STACK_SIZE
+#define WORDS_STACK_SIZE   512
+#endif
+
+#include "../TARGET_CORTEX_M/cmsis_os.h"
+
+/* The main thread is the first the host kernel knows, and the timer thread
+   is only created with the first timer */
+#undef  MAIN_THREAD_ID
+#define MAIN_THREAD_ID     0x01
+
+#endif
@@ -0,0 +1,2074 @@
+/*----------------------------------------------------------------------------
+ *      CMSIS-RTOS  -  RTX
+ *----------------------------------------------------------------------------
+ *      Name:    OS_HOST.C
+ *      Purpose: CMSIS-RTOS API on POSIX threads, for simulation and testing
+ *      Rev.:    V4.80
+ *----------------------------------------------------------------------------
+ *
+ * Copyright (c) 1999-2009 KEIL, 2009-2015 ARM Germany GmbH
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  - Neither the name of ARM  nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *---------------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cmsis_os.h"
+#include "os_host.h"
+#include "platform/critical.h"
+#include "us_ticker_api.h"
+
+#undef NULL  //Workaround for conflicting macros in rt_TypeDef.h and stdio.h
+#include "rt_TypeDef.h"
+#include "rt_Task.h"
+
+/*----------------------------------------------------------------------------
+ *      Configuration
+ *---------------------------------------------------------------------------*/
+
+#ifndef OS_HOST_STACK
+ #define OS_HOST_STACK  (256U*1024U)    // Host stack of each thread in bytes
+#endif
+
+#ifndef OS_ROBINTOUT
+ #define OS_ROBINTOUT   5U              // Round robin timeout in ms
+#endif
+
+#ifndef OS_TIMERPRIO
+ #define OS_TIMERPRIO   5U              // Timer thread priority, 1 = Idle
+#endif
+
+#define OS_FOREVER      0xFFFFFFFFFFFFFFFFULL
+
+/* Control block types */
+#define OS_OBJ_MUTEX    1U
+#define OS_OBJ_SEM      2U
+#define OS_OBJ_POOL     3U
+#define OS_OBJ_MSGQ     4U
+#define OS_OBJ_MAILQ    5U
+#define OS_OBJ_TIMER    6U
+
+/* Where os_put_rdy queues a thread among those of its priority */
+#define OS_PUT_FIRST    0U              // ahead of them (preempted thread)
+#define OS_PUT_LAST     1U              // behind them
+#define OS_PUT_WAKE     2U              // behind, or anywhere when seeded
+
+/*----------------------------------------------------------------------------
+ *      Control blocks
+ *---------------------------------------------------------------------------*/
+
+struct os_thread_cb {
+  struct OS_TCB         tcb;            // RTX task control block for rt_tid2ptcb
+  struct os_thread_cb  *next;           // List of all threads
+  struct os_thread_cb  *lnk;            // Ready list or wait list
+  struct os_thread_cb **wlist;          // Wait list the thread is on
+  void                 *wobj;           // Mutex the thread waits for
+  struct os_mutex_cb   *mutexes;        // Mutexes owned
+  pthread_cond_t        cpu;            // Signalled when given the processor
+  uint64_t              wake;           // Timeout in us, OS_FOREVER if none
+  uint64_t              since;          // Time the processor was last given
+  uint64_t              cycles;         // Time on the processor in us
+  uint32_t              switches;       // Times the processor was given
+  uintptr_t             msg;            // Message passed to a waiting thread
+  U8                    ret;            // How the wait ended, OS_R_xxx
+};
+
+typedef struct os_object {
+  struct os_object     *next;           // List of all objects
+  void                 *storage;        // Memory given with the definition
+  U8                    type;           // Control block type
+} os_object;
+
+struct os_mutex_cb {
+  os_object             obj;
+  struct os_thread_cb  *owner;          // Owning thread, or NULL
+  struct os_thread_cb  *waiters;        // Threads waiting, by priority
+  struct os_mutex_cb   *next_owned;     // Next mutex of the owner
+  uint32_t              level;          // Nesting level
+};
+
+struct os_semaphore_cb {
+  os_object             obj;
+  struct os_thread_cb  *waiters;
+  uint32_t              tokens;
+};
+
+struct os_pool_cb {
+  os_object             obj;
+  struct os_thread_cb  *waiters;        // Threads waiting in osMailAlloc
+  void                 *free;           // Free blocks, linked by their first word
+  uint8_t              *mem;
+  uint32_t              blk_sz;
+  uint32_t              count;
+};
+
+struct os_messageQ_cb {
+  os_object             obj;
+  struct os_thread_cb  *getters;        // Threads waiting for a message
+  struct os_thread_cb  *putters;        // Threads waiting for room
+  uintptr_t            *msg;
+  uint32_t              size;
+  uint32_t              count;
+  uint32_t              first;
+};
+
+struct os_mailQ_cb {
+  os_object             obj;
+  struct os_pool_cb     pool;
+  struct os_messageQ_cb queue;
+};
+
+struct os_timer_cb {
+  os_object             obj;
+  struct os_timer_cb   *next;           // List of running timers
+  struct os_timer_cb   *due_next;       // Queue of expired timers
+  os_ptimer             ptimer;
+  void                 *arg;
+  uint64_t              wake;
+  uint64_t              period;
+  U8                    type;
+  U8                    running;
+  U8                    queued;
+};
+
+typedef struct os_irq {
+  struct os_irq        *next;
+  void                (*handler)(void *arg);
+  void                 *arg;
+  uint64_t              due;
+} os_irq;
+
+typedef struct {
+  uint32_t              index;          // Must be first, see osThreadEnumId
+  uint32_t              count;
+  osThreadId            id[1];
+} os_thread_enum;
+
+/*----------------------------------------------------------------------------
+ *      Kernel state
+ *---------------------------------------------------------------------------*/
+
+static pthread_mutex_t       os_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t        os_idle_cond;      // Interrupt raised while idle
+static bool                  os_started;
+static int                   os_mode;
+static uint32_t              os_seed;
+static uint32_t              os_rand_state;
+static uint64_t              os_vtime;          // Virtual time in us
+static struct timespec       os_start;          // Host time of kernel start
+
+static struct os_thread_cb  *os_run;            // Thread on the processor
+static struct os_thread_cb  *os_rdy;            // Ready threads, by priority
+static struct os_thread_cb  *os_threads;        // All threads
+static struct os_thread_cb  *os_main;
+static struct os_thread_cb  *os_timer_tsk;
+static os_object            *os_objects;
+static struct os_timer_cb   *os_timers;         // Running timers
+static struct os_timer_cb   *os_timer_due;      // Expired timers, in order
+static os_irq               *os_irqs;           // Pending interrupts, by time
+static uint64_t              os_slice;          // Time the running thread got the processor
+static uint32_t              os_switches;
+static uint32_t              os_calls;          // API calls, the SVCs of the target
+static uint32_t              os_mask;           // Critical section nesting
+static bool                  os_in_isr;
+static pthread_t             os_isr_thread;
+static void                (*os_idle_hook)(void);
+static __thread struct os_thread_cb *os_self;
+
+/* RTX kernel timer configuration, see osKernelSysTick */
+uint32_t const os_tickfreq = 1000000U;
+uint16_t const os_tickus_i = 1U;
+uint16_t const os_tickus_f = 0U;
+
+/* RTX thread configuration, read by StackMonitor: the default stack size,
+   with neither OS_STKINIT nor OS_STKCHECK, and the timer thread */
+uint32_t const os_stackinfo = DEFAULT_STACK_SIZE;
+osThreadId     osThreadId_osTimerThread;
+
+extern void thread_terminate_hook(osThreadId id) __attribute__((weak));
+
+static void os_dump (void (*print)(const char *line));
+
+/*----------------------------------------------------------------------------
+ *      Clock
+ *---------------------------------------------------------------------------*/
+
+static uint64_t os_host_clock (void) {
+  struct timespec ts;
+  int64_t us;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  us  = (int64_t)(ts.tv_sec - os_start.tv_sec) * 1000000;
+  us += (ts.tv_nsec - os_start.tv_nsec) / 1000;
+  return (uint64_t)us;
+}
+
+/// Current kernel time in microseconds
+static uint64_t os_now (void) {
+  if (os_mode == OS_HOST_VIRTUAL) {
+    return os_vtime;
+  }
+  return os_host_clock();
+}
+
+/// Kernel time as read by the application, a microsecond later in virtual time
+static uint64_t os_clock_read (void) {
+  if (os_mode == OS_HOST_VIRTUAL) {
+    os_vtime++;
+  }
+  return os_now();
+}
+
+static uint64_t os_deadline (uint32_t millisec) {
+  if (millisec == osWaitForever) {
+    return OS_FOREVER;
+  }
+  return os_now() + (uint64_t)millisec * 1000U;
+}
+
+static uint32_t os_rand (void) {
+  uint32_t x = os_rand_state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  os_rand_state = x;
+  return x;
+}
+
+/*----------------------------------------------------------------------------
+ *      Lists
+ *---------------------------------------------------------------------------*/
+
+/// Insert a thread in a list by priority, behind those of equal priority
+static void os_put_prio (struct os_thread_cb **list, struct os_thread_cb *t) {
+  while ((*list != NULL) && ((*list)->tcb.prio >= t->tcb.prio)) {
+    list = &(*list)->lnk;
+  }
+  t->lnk = *list;
+  *list = t;
+}
+
+static void os_rmv (struct os_thread_cb **list, struct os_thread_cb *t) {
+  while (*list != NULL) {
+    if (*list == t) {
+      *list = t->lnk;
+      t->lnk = NULL;
+      return;
+    }
+    list = &(*list)->lnk;
+  }
+}
+
+static void os_put_rdy (struct os_thread_cb *t, U8 where) {
+  struct os_thread_cb **list = &os_rdy;
+  uint32_t n;
+
+  t->tcb.state = READY;
+  if (where == OS_PUT_WAKE) {
+    if (os_seed == 0U) {
+      where = OS_PUT_LAST;
+    } else {
+      where = OS_PUT_FIRST;
+      for (n = os_rand() & 3U; n != 0U; n--) {
+        if ((*list == NULL) || ((*list)->tcb.prio < t->tcb.prio)) {
+          break;
+        }
+        if ((*list)->tcb.prio == t->tcb.prio) {
+          list = &(*list)->lnk;
+        }
+      }
+    }
+  }
+  if (where == OS_PUT_LAST) {
+    os_put_prio(list, t);
+    return;
+  }
+  while ((*list != NULL) && ((*list)->tcb.prio > t->tcb.prio)) {
+    list = &(*list)->lnk;
+  }
+  t->lnk = *list;
+  *list = t;
+}
+
+/// Check a thread ID, as rt_tid2ptcb does on the target
+static struct os_thread_cb *os_tid (osThreadId thread_id) {
+  struct os_thread_cb *t;
+
+  for (t = os_threads; t != NULL; t = t->next) {
+    if (t == thread_id) {
+      return t;
+    }
+  }
+  return NULL;
+}
+
+static void *os_obj (void *id, U8 type) {
+  if ((id == NULL) || (((os_object *)id)->type != type)) {
+    return NULL;
+  }
+  return id;
+}
+
+/// Find the object created before on the same storage, or allocate a new one
+static void *os_obj_get (void *storage, U8 type, size_t size) {
+  os_object *obj;
+
+  if (storage != NULL) {
+    for (obj = os_objects; obj != NULL; obj = obj->next) {
+      if ((obj->storage == storage) && (obj->type == type)) {
+        return obj;
+      }
+    }
+  }
+  obj = calloc(1, size);
+  if (obj == NULL) {
+    return NULL;
+  }
+  obj->storage = storage;
+  obj->type    = type;
+  obj->next    = os_objects;
+  os_objects   = obj;
+  return obj;
+}
+
+static void os_obj_free (void *id) {
+  os_object **list = &os_objects;
+
+  while (*list != NULL) {
+    if (*list == id) {
+      *list = (*list)->next;
+      break;
+    }
+    list = &(*list)->next;
+  }
+  ((os_object *)id)->type = 0U;
+  free(id);
+}
+
+/*----------------------------------------------------------------------------
+ *      Scheduler
+ *---------------------------------------------------------------------------*/
+
+static void os_fatal (const char *msg) {
+  fprintf(stderr, "os_host: %s\n", msg);
+  abort();
+}
+
+static void os_init (void) {
+  pthread_condattr_t attr;
+  const char *env;
+
+  clock_gettime(CLOCK_MONOTONIC, &os_start);
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&os_idle_cond, &attr);
+  pthread_condattr_destroy(&attr);
+
+  env = getenv("OS_HOST_VIRTUAL");
+  if ((env != NULL) && (atoi(env) != 0)) {
+    os_mode = OS_HOST_VIRTUAL;
+  }
+  env = getenv("OS_HOST_SEED");
+  if (env != NULL) {
+    os_seed = (uint32_t)strtoul(env, NULL, 0);
+    os_rand_state = os_seed;
+  }
+  os_started = true;
+}
+
+static struct os_thread_cb *os_thread_new (os_pthread func, void *argument, U8 prio) {
+  struct os_thread_cb *t;
+  struct os_thread_cb *p;
+  U8 id;
+
+  t = calloc(1, sizeof(struct os_thread_cb));
+  if (t == NULL) {
+    return NULL;
+  }
+  pthread_cond_init(&t->cpu, NULL);
+
+  // Task IDs as on the target: 1 and up, 255 is the idle task
+  for (id = 1U; id < 255U; id++) {
+    for (p = os_threads; p != NULL; p = p->next) {
+      if (p->tcb.task_id == id) {
+        break;
+      }
+    }
+    if (p == NULL) {
+      break;
+    }
+  }
+  t->tcb.cb_type   = 0U;
+  t->tcb.task_id   = id;
+  t->tcb.prio      = prio;
+  t->tcb.prio_base = prio;
+  t->tcb.ptask     = (FUNCP)func;
+  t->tcb.argv      = argument;
+  t->wake          = OS_FOREVER;
+  t->next          = os_threads;
+  os_threads       = t;
+  return t;
+}
+
+static void os_thread_unlink (struct os_thread_cb *t) {
+  struct os_thread_cb **list = &os_threads;
+
+  while (*list != NULL) {
+    if (*list == t) {
+      *list = t->next;
+      break;
+    }
+    list = &(*list)->next;
+  }
+  if (t == os_main) {
+    os_main = NULL;
+  }
+}
+
+/// Earliest time something is due: a timeout, a timer or an interrupt
+static uint64_t os_next_event (void) {
+  struct os_thread_cb *t;
+  struct os_timer_cb *pt;
+  uint64_t next = OS_FOREVER;
+
+  for (t = os_threads; t != NULL; t = t->next) {
+    if ((t->tcb.state >= WAIT_DLY) && (t->wake < next)) {
+      next = t->wake;
+    }
+  }
+  for (pt = os_timers; pt != NULL; pt = pt->next) {
+    if (pt->wake < next) {
+      next = pt->wake;
+    }
+  }
+  if ((os_irqs != NULL) && (os_irqs->due < next)) {
+    next = os_irqs->due;
+  }
+  return next;
+}
+
+/// Make a waiting thread ready, with the result of its wait
+static void os_wake (struct os_thread_cb *t, U8 ret) {
+  if (t->wlist != NULL) {
+    os_rmv(t->wlist, t);
+    t->wlist = NULL;
+  }
+  t->wake = OS_FOREVER;
+  t->ret  = ret;
+  os_put_rdy(t, OS_PUT_WAKE);
+}
+
+/// Run the interrupts that are due, unless a critical section holds them back
+static void os_irq_run (uint64_t now) {
+  os_irq *irq;
+  os_irq *due;
+  os_irq **last;
+
+  if ((os_mask != 0U) || os_in_isr) {
+    return;
+  }
+  // Take those due now; interrupts their handlers raise wait for the next
+  // kernel call or barrier, so a handler can raise itself again
+  for (last = &os_irqs; (*last != NULL) && ((*last)->due <= now); last = &(*last)->next);
+  if (last == &os_irqs) {
+    return;
+  }
+  due = os_irqs;
+  os_irqs = *last;
+  *last = NULL;
+  while (due != NULL) {
+    irq = due;
+    due = irq->next;
+    os_in_isr = true;
+    os_isr_thread = pthread_self();
+    pthread_mutex_unlock(&os_lock);
+    irq->handler(irq->arg);
+    pthread_mutex_lock(&os_lock);
+    os_in_isr = false;
+    os_mask = 0U;
+    free(irq);
+  }
+}
+
+/// Advance the kernel: time out waits, expire timers and run interrupts
+static void os_tick (void) {
+  struct os_thread_cb *t;
+  struct os_thread_cb *first;
+  struct os_timer_cb **ppt;
+  struct os_timer_cb **pdue;
+  struct os_timer_cb *pt;
+  uint64_t now = os_now();
+
+  // Time-outs end in order of their time, and of thread creation
+  for (;;) {
+    first = NULL;
+    for (t = os_threads; t != NULL; t = t->next) {
+      if ((t->tcb.state >= WAIT_DLY) && (t->wake <= now) &&
+          ((first == NULL) || (t->wake < first->wake))) {
+        first = t;
+      }
+    }
+    if (first == NULL) {
+      break;
+    }
+    os_wake(first, OS_R_TMO);
+  }
+
+  ppt = &os_timers;
+  while (*ppt != NULL) {
+    pt = *ppt;
+    if (pt->wake > now) {
+      ppt = &pt->next;
+      continue;
+    }
+    if (!pt->queued) {
+      pt->queued = 1U;
+      pt->due_next = NULL;
+      for (pdue = &os_timer_due; *pdue != NULL; pdue = &(*pdue)->due_next);
+      *pdue = pt;
+    }
+    if (pt->type == (U8)osTimerPeriodic) {
+      pt->wake += pt->period;
+      if (pt->wake <= now) {
+        pt->wake = now + pt->period;
+      }
+      ppt = &pt->next;
+    } else {
+      pt->running = 0U;
+      *ppt = pt->next;
+    }
+  }
+  if ((os_timer_due != NULL) && (os_timer_tsk != NULL) && (os_timer_tsk->tcb.state == WAIT_MBX)) {
+    os_wake(os_timer_tsk, OS_R_MBX);
+  }
+
+  os_irq_run(now);
+}
+
+/// The processor is idle: wait for the next event, or jump to it in virtual time
+static void os_idle (void) {
+  struct timespec ts;
+  uint64_t next;
+
+  if (os_idle_hook != NULL) {
+    os_in_isr = true;
+    os_isr_thread = pthread_self();
+    pthread_mutex_unlock(&os_lock);
+    os_idle_hook();
+    pthread_mutex_lock(&os_lock);
+    os_in_isr = false;
+  }
+  os_tick();
+  if (os_rdy != NULL) {
+    return;
+  }
+
+  next = os_next_event();
+  if (os_mode == OS_HOST_VIRTUAL) {
+    if (next != OS_FOREVER) {
+      if (next > os_vtime) {
+        os_vtime = next;
+      }
+      return;
+    }
+    // Only a host thread can still raise an interrupt; allow it a second
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += 1;
+    pthread_cond_timedwait(&os_idle_cond, &os_lock, &ts);
+    if (os_irqs == NULL) {
+      fprintf(stderr, "os_host: all threads wait forever\n");
+      os_dump(NULL);
+      abort();
+    }
+    return;
+  }
+
+  if (next == OS_FOREVER) {
+    pthread_cond_wait(&os_idle_cond, &os_lock);
+    return;
+  }
+  next += (uint64_t)os_start.tv_nsec / 1000U;
+  ts.tv_sec  = os_start.tv_sec + (time_t)(next / 1000000U);
+  ts.tv_nsec = (long)(next % 1000000U) * 1000;
+  pthread_cond_timedwait(&os_idle_cond, &os_lock, &ts);
+}
+
+/// Give the processor to the first ready thread, idling until there is one
+static void os_dispatch (void) {
+  struct os_thread_cb *prev = os_run;
+  struct os_thread_cb *next;
+  uint64_t now;
+
+  if (prev != NULL) {
+    prev->cycles += os_now() - prev->since;
+  }
+  os_run = NULL;
+  while (os_rdy == NULL) {
+    os_idle();
+  }
+  next = os_rdy;
+  os_rdy = next->lnk;
+  next->lnk = NULL;
+  next->tcb.state = RUNNING;
+  now = os_now();
+  next->since = now;
+  os_slice = now;
+  os_run = next;
+  if (next != prev) {
+    next->switches++;
+    os_switches++;
+    pthread_cond_signal(&next->cpu);
+  }
+}
+
+/// Switch away from a thread that is ready or waiting, until it runs again
+static void os_switch (struct os_thread_cb *self) {
+  os_dispatch();
+  while (os_run != self) {
+    pthread_cond_wait(&self->cpu, &os_lock);
+  }
+}
+
+/// Pass the processor on if a thread of higher priority is ready, or one of
+/// equal priority when yielding, at the end of a time slice, or by the seed
+static void os_sched (struct os_thread_cb *self, bool yield) {
+  if (os_rdy == NULL) {
+    return;
+  }
+  if (os_rdy->tcb.prio > self->tcb.prio) {
+    os_put_rdy(self, OS_PUT_FIRST);
+    os_switch(self);
+    return;
+  }
+  if (os_rdy->tcb.prio < self->tcb.prio) {
+    return;
+  }
+  if (yield ||
+      (os_now() - os_slice >= OS_ROBINTOUT * 1000U) ||
+      ((os_seed != 0U) && ((os_rand() & 7U) == 0U))) {
+    os_put_rdy(self, OS_PUT_LAST);
+    os_switch(self);
+  }
+}
+
+/// Kernel call point of the running thread: let due events and others run
+static void os_preempt (struct os_thread_cb *self) {
+  os_tick();
+  os_sched(self, false);
+}
+
+/// The running thread, NULL in an interrupt handler
+static struct os_thread_cb *os_current (void) {
+  if (os_in_isr && pthread_equal(os_isr_thread, pthread_self())) {
+    return NULL;
+  }
+  if (os_self == NULL) {
+    if (os_main != NULL) {
+      os_fatal("RTOS call from a thread the kernel did not create");
+    }
+    // The first thread to call the kernel is main
+    os_main = os_thread_new(NULL, NULL, (U8)(osPriorityNormal - osPriorityIdle + 1));
+    if (os_main == NULL) {
+      os_fatal("no memory for the main thread");
+    }
+    os_main->tcb.state = RUNNING;
+    os_main->since = os_now();
+    os_slice = os_main->since;
+    os_self = os_main;
+    os_run  = os_main;
+  }
+  return os_self;
+}
+
+/// Enter the kernel from an API function
+static struct os_thread_cb *os_enter (void) {
+  struct os_thread_cb *self;
+
+  pthread_mutex_lock(&os_lock);
+  if (!os_started) {
+    os_init();
+  }
+  os_calls++;
+  self = os_current();
+  if ((self != NULL) && (os_mask == 0U)) {
+    os_preempt(self);
+  }
+  return self;
+}
+
+/// Leave the kernel, handing over to a thread of higher priority made ready
+static void os_leave (struct os_thread_cb *self) {
+  if ((self != NULL) && (os_mask == 0U) && (os_rdy != NULL) && (os_rdy->tcb.prio > self->tcb.prio)) {
+    os_put_rdy(self, OS_PUT_FIRST);
+    os_switch(self);
+  }
+  pthread_mutex_unlock(&os_lock);
+}
+
+/// RTOS calls from interrupt handlers and critical sections follow the ISR rules
+static bool os_isr (struct os_thread_cb *self) {
+  return (self == NULL) || (os_mask != 0U);
+}
+
+/// Block the running thread until woken or timed out, return OS_R_xxx
+static U8 os_block (struct os_thread_cb *self, struct os_thread_cb **list, U8 state, uint32_t millisec) {
+  if (list != NULL) {
+    os_put_prio(list, self);
+  }
+  self->wlist = list;
+  self->tcb.state = state;
+  self->ret  = OS_R_TMO;
+  self->wake = os_deadline(millisec);
+  os_switch(self);
+  return self->ret;
+}
+
+/*----------------------------------------------------------------------------
+ *      Kernel
+ *---------------------------------------------------------------------------*/
+
+osStatus osKernelInitialize (void) {
+  os_leave(os_enter());
+  return osOK;
+}
+
+osStatus osKernelStart (void) {
+  os_leave(os_enter());
+  return osOK;
+}
+
+int32_t osKernelRunning (void) {
+  return os_started ? 1 : 0;
+}
+
+uint32_t osKernelSysTick (void) {
+  uint32_t tick;
+
+  pthread_mutex_lock(&os_lock);
+  if (!os_started) {
+    os_init();
+  }
+  tick = (uint32_t)os_clock_read();
+  pthread_mutex_unlock(&os_lock);
+  return tick;
+}
+
+uint32_t us_ticker_read (void) {
+  uint32_t now;
+
+  pthread_mutex_lock(&os_lock);
+  if (!os_started) {
+    os_init();
+  }
+  now = (uint32_t)os_clock_read();
+  if ((os_self != NULL) && (os_run == os_self) && !os_in_isr && (os_mask == 0U)) {
+    os_preempt(os_self);
+  }
+  pthread_mutex_unlock(&os_lock);
+  return now;
+}
+
+/*----------------------------------------------------------------------------
+ *      Critical sections
+ *---------------------------------------------------------------------------*/
+
+void core_util_critical_section_enter (void) {
+  pthread_mutex_lock(&os_lock);
+  os_mask++;
+  pthread_mutex_unlock(&os_lock);
+}
+
+void core_util_critical_section_exit (void) {
+  pthread_mutex_lock(&os_lock);
+  if (os_mask != 0U) {
+    os_mask--;
+  }
+  // Interrupts held back run now, and a thread they woke
+  if ((os_mask == 0U) && (os_self != NULL) && (os_run == os_self) && !os_in_isr) {
+    os_preempt(os_self);
+  }
+  pthread_mutex_unlock(&os_lock);
+}
+
+bool core_util_are_interrupts_enabled (void) {
+  return os_mask == 0U;
+}
+
+/*----------------------------------------------------------------------------
+ *      Threads
+ *---------------------------------------------------------------------------*/
+
+/// Release the mutexes of a thread that terminates
+static void os_mut_release_all (struct os_thread_cb *t);
+
+static void *os_thread_start (void *arg) {
+  struct os_thread_cb *self = arg;
+
+  pthread_mutex_lock(&os_lock);
+  os_self = self;
+  while (os_run != self) {
+    pthread_cond_wait(&self->cpu, &os_lock);
+  }
+  pthread_mutex_unlock(&os_lock);
+
+  ((os_pthread)self->tcb.ptask)(self->tcb.argv);
+
+  // Returning from the thread function ends the thread, as osThreadExit
+  if (thread_terminate_hook != NULL) {
+    thread_terminate_hook(self);
+  }
+  pthread_mutex_lock(&os_lock);
+  os_mut_release_all(self);
+  os_thread_unlink(self);
+  self->tcb.state = INACTIVE;
+  os_dispatch();
+  pthread_cond_destroy(&self->cpu);
+  free(self);
+  pthread_mutex_unlock(&os_lock);
+  return NULL;
+}
+
+static struct os_thread_cb *os_thread_spawn (os_pthread func, void *argument, U8 prio) {
+  struct os_thread_cb *t;
+  pthread_attr_t attr;
+  pthread_t pt;
+  int res;
+
+  t = os_thread_new(func, argument, prio);
+  if (t == NULL) {
+    return NULL;
+  }
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, OS_HOST_STACK);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  res = pthread_create(&pt, &attr, os_thread_start, t);
+  pthread_attr_destroy(&attr);
+  if (res != 0) {
+    os_thread_unlink(t);
+    pthread_cond_destroy(&t->cpu);
+    free(t);
+    return NULL;
+  }
+  os_put_rdy(t, OS_PUT_WAKE);
+  return t;
+}
+
+osThreadId osThreadCreate (const osThreadDef_t *thread_def, void *argument) {
+  return osThreadContextCreate(thread_def, argument, NULL);
+}
+
+osThreadId osThreadContextCreate (const osThreadDef_t *thread_def, void *argument, void *context) {
+  struct os_thread_cb *self = os_enter();
+  struct os_thread_cb *t;
+  uint32_t size;
+
+  if (os_isr(self) || (thread_def == NULL) || (thread_def->pthread == NULL) ||
+      (thread_def->tpriority < osPriorityIdle) || (thread_def->tpriority > osPriorityRealtime)) {
+    os_leave(self);
+    return NULL;
+  }
+
+  t = os_thread_spawn(thread_def->pthread, argument,
+                      (U8)(thread_def->tpriority - osPriorityIdle + 1));
+  if (t != NULL) {
+    // The stack is recorded for rtos::Thread, the thread runs on a host stack
+    size = (thread_def->stacksize != 0U) ? thread_def->stacksize : DEFAULT_STACK_SIZE;
+    t->tcb.priv_stack = size;
+    t->tcb.stack      = thread_def->stack_pointer;
+    t->tcb.tsk_stack  = (U32)(uintptr_t)thread_def->stack_pointer + size;
+    t->tcb.context    = context;
+  }
+  os_leave(self);
+  return t;
+}
+
+osThreadId osThreadGetId (void) {
+  struct os_thread_cb *self = os_enter();
+  osThreadId id = os_isr(self) ? NULL : self;
+
+  os_leave(self);
+  return id;
+}
+
+osStatus osThreadTerminate (osThreadId thread_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_thread_cb *t;
+
+  if (os_isr(self)) {
+    os_leave(self);
+    return osErrorISR;
+  }
+  if (os_tid(thread_id) == NULL) {
+    os_leave(self);
+    return osErrorParameter;
+  }
+  pthread_mutex_unlock(&os_lock);
+  if (thread_terminate_hook != NULL) {
+    thread_terminate_hook(thread_id);
+  }
+  pthread_mutex_lock(&os_lock);
+
+  t = os_tid(thread_id);
+  if (t == NULL) {
+    os_leave(self);
+    return osErrorParameter;
+  }
+  os_mut_release_all(t);
+  os_thread_unlink(t);
+  if (t->wlist != NULL) {
+    os_rmv(t->wlist, t);
+    t->wlist = NULL;
+  }
+  if (t->tcb.state == READY) {
+    os_rmv(&os_rdy, t);
+  }
+  t->tcb.state = INACTIVE;
+
+  // The host thread of a terminated thread stays blocked, its control block
+  // is not freed, and it never runs again
+  if (t == self) {
+    os_switch(self);
+  }
+  os_leave(self);
+  return osOK;
+}
+
+osStatus osThreadYield (void) {
+  struct os_thread_cb *self = os_enter();
+
+  if (os_isr(self)) {
+    os_leave(self);
+    return osErrorISR;
+  }
+  os_sched(self, true);
+  os_leave(self);
+  return osOK;
+}
+
+/// Set the priority of a thread to its base or inherited one, keeping lists in order
+static void os_prio_update (struct os_thread_cb *t) {
+  struct os_mutex_cb *m;
+  U8 prio = t->tcb.prio_base;
+
+  for (m = t->mutexes; m != NULL; m = m->next_owned) {
+    if ((m->waiters != NULL) && (m->waiters->tcb.prio > prio)) {
+      prio = m->waiters->tcb.prio;
+    }
+  }
+  if (prio == t->tcb.prio) {
+    return;
+  }
+  t->tcb.prio = prio;
+  if (t->tcb.state == READY) {
+    os_rmv(&os_rdy, t);
+    os_put_rdy(t, OS_PUT_LAST);
+  } else if (t->wlist != NULL) {
+    os_rmv(t->wlist, t);
+    os_put_prio(t->wlist, t);
+  }
+}
+
+osStatus osThreadSetPriority (osThreadId thread_id, osPriority priority) {
+  struct os_thread_cb *self = os_enter();
+  struct os_thread_cb *t;
+
+  if (os_isr(self)) {
+    os_leave(self);
+    return osErrorISR;
+  }
+  t = os_tid(thread_id);
+  if (t == NULL) {
+    os_leave(self);
+    return osErrorParameter;
+  }
+  if ((priority < osPriorityIdle) || (priority > osPriorityRealtime)) {
+    os_leave(self);
+    return osErrorValue;
+  }
+  t->tcb.prio_base = (U8)(priority - osPriorityIdle + 1);
+  os_prio_update(t);
+  if (t == self) {
+    os_sched(self, false);
+  }
+  os_leave(self);
+  return osOK;
+}
+
+osPriority osThreadGetPriority (osThreadId thread_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_thread_cb *t = os_tid(thread_id);
+  osPriority prio = osPriorityError;
+
+  if (!os_isr(self) && (t != NULL)) {
+    prio = (osPriority)(t->tcb.prio - 1 + osPriorityIdle);
+  }
+  os_leave(self);
+  return prio;
+}
+
+uint8_t osThreadGetState (osThreadId thread_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_thread_cb *t = os_tid(thread_id);
+  uint8_t state = INACTIVE;
+
+  if (os_isr(self)) {
+    state = (uint8_t)osErrorISR;
+  } else if (t != NULL) {
+    state = t->tcb.state;
+  }
+  os_leave(self);
+  return state;
+}
+
+/// Processor time of a thread, in osKernelSysTick units (microseconds on the host)
+uint64_t osThreadGetCycles (osThreadId thread_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_thread_cb *t = os_tid(thread_id);
+  uint64_t cycles = 0U;
+
+  if (t != NULL) {
+    cycles = t->cycles;
+    if (t == os_run) {
+      cycles += os_now() - t->since;
+    }
+  }
+  os_leave(self);
+  return cycles;
+}
+
+os_InRegs osEvent _osThreadGetInfo (osThreadId thread_id, osThreadInfo info) {
+  struct os_thread_cb *self = os_enter();
+  struct os_thread_cb *t = os_tid(thread_id);
+  osEvent ret;
+
+  ret.status = osOK;
+  if (t == NULL) {
+    ret.status = osErrorValue;
+  } else if (info == osThreadInfoStackSize) {
+    ret.value.v = t->tcb.priv_stack;
+  } else if (info == osThreadInfoStackMax) {
+    ret.status = osErrorResource;               // Stack use is not measured
+  } else if (info == osThreadInfoEntry) {
+    ret.value.p = (void *)t->tcb.ptask;
+  } else if (info == osThreadInfoArg) {
+    ret.value.p = t->tcb.argv;
+  } else {
+    ret.status = osErrorParameter;
+  }
+  os_leave(self);
+  return ret;
+}
+
+/// Convert Thread ID to TCB pointer
+P_TCB rt_tid2ptcb (osThreadId thread_id) {
+  struct os_thread_cb *t;
+
+  pthread_mutex_lock(&os_lock);
+  t = os_tid(thread_id);
+  pthread_mutex_unlock(&os_lock);
+  return (t != NULL) ? &t->tcb : NULL;
+}
+
+osThreadEnumId _osThreadsEnumStart (void) {
+  struct os_thread_cb *self = os_enter();
+  struct os_thread_cb *t;
+  os_thread_enum *e;
+  uint32_t n = 0U;
+
+  for (t = os_threads; t != NULL; t = t->next) {
+    n++;
+  }
+  e = malloc(sizeof(os_thread_enum) + n * sizeof(osThreadId));
+  if (e != NULL) {
+    e->index = 0U;
+    e->count = 0U;
+    // Oldest first, as the task IDs are handed out on the target
+    for (; n != 0U; n--) {
+      uint32_t i = 1U;
+      for (t = os_threads; i < n; t = t->next) {
+        i++;
+      }
+      e->id[e->count++] = t;
+    }
+  }
+  os_leave(self);
+  return (osThreadEnumId)e;
+}
+
+osThreadId _osThreadEnumNext (osThreadEnumId enum_id) {
+  os_thread_enum *e = (os_thread_enum *)enum_id;
+
+  if ((e == NULL) || (e->index >= e->count)) {
+    return NULL;
+  }
+  return e->id[e->index++];
+}
+
+osStatus _osThreadEnumFree (osThreadEnumId enum_id) {
+  free(enum_id);
+  return osOK;
+}
+
+/*----------------------------------------------------------------------------
+ *      Generic wait
+ *---------------------------------------------------------------------------*/
+
+osStatus osDelay (uint32_t millisec) {
+  struct os_thread_cb *self = os_enter();
+
+  if (os_isr(self)) {
+    os_leave(self);
+    return osErrorISR;
+  }
+  if (millisec == 0U) {
+    os_leave(self);
+    return osOK;
+  }
+  os_block(self, NULL, WAIT_DLY, millisec);
+  os_leave(self);
+  return osEventTimeout;
+}
+
+os_InRegs osEvent osWait (uint32_t millisec) {
+  osEvent ret;
+
+  (void)millisec;
+  ret.status = osErrorOS;
+  return ret;
+}
+
+/*----------------------------------------------------------------------------
+ *      Signals
+ *---------------------------------------------------------------------------*/
+
+int32_t osSignalSet (osThreadId thread_id, int32_t signals) {
+  struct os_thread_cb *self = os_enter();
+  struct os_thread_cb *t = os_tid(thread_id);
+  int32_t sig;
+
+  if ((t == NULL) || ((uint32_t)signals & (0xFFFFFFFFU << osFeature_Signals))) {
+    os_leave(self);
+    return (int32_t)0x80000000U;
+  }
+  sig = (int32_t)t->tcb.events;
+  t->tcb.events |= (U16)signals;
+  if ((t->tcb.state == WAIT_AND) && ((t->tcb.events & t->tcb.waits) == t->tcb.waits)) {
+    t->tcb.events &= ~t->tcb.waits;
+    os_wake(t, OS_R_EVT);
+  } else if ((t->tcb.state == WAIT_OR) && ((t->tcb.events & t->tcb.waits) != 0U)) {
+    t->tcb.waits &= t->tcb.events;
+    t->tcb.events &= ~t->tcb.waits;
+    os_wake(t, OS_R_EVT);
+  }
+  os_leave(self);
+  return sig;
+}
+
+int32_t osSignalClear (osThreadId thread_id, int32_t signals) {
+  struct os_thread_cb *self = os_enter();
+  struct os_thread_cb *t = os_tid(thread_id);
+  int32_t sig;
+
+  if (os_isr(self) || (t == NULL) || ((uint32_t)signals & (0xFFFFFFFFU << osFeature_Signals))) {
+    os_leave(self);
+    return (int32_t)0x80000000U;
+  }
+  sig = (int32_t)t->tcb.events;
+  t->tcb.events &= (U16)~signals;
+  os_leave(self);
+  return sig;
+}
+
+os_InRegs osEvent osSignalWait (int32_t signals, uint32_t millisec) {
+  struct os_thread_cb *self = os_enter();
+  osEvent ret;
+  U16 flags;
+
+  if (os_isr(self)) {
+    os_leave(self);
+    ret.status = osErrorISR;
+    return ret;
+  }
+  if ((uint32_t)signals & (0xFFFFFFFFU << osFeature_Signals)) {
+    os_leave(self);
+    ret.status = osErrorValue;
+    return ret;
+  }
+
+  flags = (signals != 0) ? (U16)signals : 0xFFFFU;
+  if ((signals != 0) && ((self->tcb.events & flags) == flags)) {
+    self->tcb.events &= ~flags;
+    ret.status = osEventSignal;
+    ret.value.signals = signals;
+  } else if ((signals == 0) && ((self->tcb.events & flags) != 0U)) {
+    ret.status = osEventSignal;
+    ret.value.signals = self->tcb.events;
+    self->tcb.events = 0U;
+  } else if (millisec == 0U) {
+    ret.status = osOK;
+    ret.value.signals = 0;
+  } else {
+    self->tcb.waits = flags;
+    if (os_block(self, NULL, (signals != 0) ? WAIT_AND : WAIT_OR, millisec) == OS_R_EVT) {
+      ret.status = osEventSignal;
+      ret.value.signals = (signals != 0) ? signals : (int32_t)self->tcb.waits;
+    } else {
+      ret.status = osEventTimeout;
+      ret.value.signals = 0;
+    }
+  }
+  os_leave(self);
+  return ret;
+}
+
+/*----------------------------------------------------------------------------
+ *      Mutexes
+ *---------------------------------------------------------------------------*/
+
+static void os_mut_unlink (struct os_mutex_cb *m) {
+  struct os_mutex_cb **list;
+
+  if (m->owner == NULL) {
+    return;
+  }
+  for (list = &m->owner->mutexes; *list != NULL; list = &(*list)->next_owned) {
+    if (*list == m) {
+      *list = m->next_owned;
+      break;
+    }
+  }
+  m->next_owned = NULL;
+}
+
+/// Give a free mutex to its first waiter, or leave it free
+static void os_mut_give (struct os_mutex_cb *m) {
+  struct os_thread_cb *prev = m->owner;
+  struct os_thread_cb *t = m->waiters;
+
+  os_mut_unlink(m);
+  m->owner = NULL;
+  m->level = 0U;
+  if (t != NULL) {
+    os_wake(t, OS_R_MUT);
+    m->owner = t;
+    m->level = 1U;
+    m->next_owned = t->mutexes;
+    t->mutexes = m;
+    os_prio_update(t);
+  }
+  if (prev != NULL) {
+    os_prio_update(prev);
+  }
+}
+
+static void os_mut_release_all (struct os_thread_cb *t) {
+  while (t->mutexes != NULL) {
+    os_mut_give(t->mutexes);
+  }
+}
+
+osMutexId osMutexCreate (const osMutexDef_t *mutex_def) {
+  struct os_thread_cb *self = os_enter();
+  struct os_mutex_cb *m = NULL;
+
+  if (!os_isr(self) && (mutex_def != NULL)) {
+    m = os_obj_get(mutex_def->mutex, OS_OBJ_MUTEX, sizeof(struct os_mutex_cb));
+    if (m != NULL) {
+      os_mut_unlink(m);
+      m->owner   = NULL;
+      m->waiters = NULL;
+      m->level   = 0U;
+    }
+  }
+  os_leave(self);
+  return m;
+}
+
+osStatus osMutexWait (osMutexId mutex_id, uint32_t millisec) {
+  struct os_thread_cb *self = os_enter();
+  struct os_mutex_cb *m = os_obj(mutex_id, OS_OBJ_MUTEX);
+  osStatus status = osOK;
+
+  if (os_isr(self)) {
+    status = osErrorISR;
+  } else if (m == NULL) {
+    status = osErrorParameter;
+  } else if (m->owner == NULL) {
+    m->owner = self;
+    m->level = 1U;
+    m->next_owned = self->mutexes;
+    self->mutexes = m;
+  } else if (m->owner == self) {
+    m->level++;
+  } else if (millisec == 0U) {
+    status = osErrorResource;
+  } else {
+    // The owner inherits the priority of the waiter
+    self->wobj = m;
+    os_put_prio(&m->waiters, self);
+    os_prio_update(m->owner);
+    os_rmv(&m->waiters, self);
+    if (os_block(self, &m->waiters, WAIT_MUT, millisec) != OS_R_MUT) {
+      if (m->owner != NULL) {
+        os_prio_update(m->owner);
+      }
+      status = osErrorTimeoutResource;
+    }
+    self->wobj = NULL;
+  }
+  os_leave(self);
+  return status;
+}
+
+osStatus osMutexRelease (osMutexId mutex_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_mutex_cb *m = os_obj(mutex_id, OS_OBJ_MUTEX);
+  osStatus status = osOK;
+
+  if (os_isr(self)) {
+    status = osErrorISR;
+  } else if (m == NULL) {
+    status = osErrorParameter;
+  } else if ((m->owner != self) || (m->level == 0U)) {
+    status = osErrorResource;
+  } else if (--m->level == 0U) {
+    os_mut_give(m);
+  }
+  os_leave(self);
+  return status;
+}
+
+osStatus osMutexDelete (osMutexId mutex_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_mutex_cb *m = os_obj(mutex_id, OS_OBJ_MUTEX);
+  struct os_thread_cb *owner;
+
+  if (os_isr(self)) {
+    os_leave(self);
+    return osErrorISR;
+  }
+  if (m == NULL) {
+    os_leave(self);
+    return osErrorParameter;
+  }
+  owner = m->owner;
+  os_mut_unlink(m);
+  m->owner = NULL;
+  while (m->waiters != NULL) {
+    os_wake(m->waiters, OS_R_TMO);
+  }
+  if (owner != NULL) {
+    os_prio_update(owner);
+  }
+  os_obj_free(m);
+  os_leave(self);
+  return osOK;
+}
+
+/*----------------------------------------------------------------------------
+ *      Semaphores
+ *---------------------------------------------------------------------------*/
+
+osSemaphoreId osSemaphoreCreate (const osSemaphoreDef_t *semaphore_def, int32_t count) {
+  struct os_thread_cb *self = os_enter();
+  struct os_semaphore_cb *s = NULL;
+
+  if (!os_isr(self) && (semaphore_def != NULL) && (count >= 0) && (count <= osFeature_Semaphore)) {
+    s = os_obj_get(semaphore_def->semaphore, OS_OBJ_SEM, sizeof(struct os_semaphore_cb));
+    if (s != NULL) {
+      s->waiters = NULL;
+      s->tokens  = (uint32_t)count;
+    }
+  }
+  os_leave(self);
+  return s;
+}
+
+int32_t osSemaphoreWait (osSemaphoreId semaphore_id, uint32_t millisec) {
+  struct os_thread_cb *self = os_enter();
+  struct os_semaphore_cb *s = os_obj(semaphore_id, OS_OBJ_SEM);
+  int32_t res;
+
+  if (os_isr(self) || (s == NULL)) {
+    res = -1;
+  } else if (s->tokens != 0U) {
+    s->tokens--;
+    res = (int32_t)s->tokens + 1;
+  } else if (millisec == 0U) {
+    res = 0;
+  } else if (os_block(self, &s->waiters, WAIT_SEM, millisec) == OS_R_TMO) {
+    res = 0;
+  } else {
+    res = (int32_t)s->tokens + 1;
+  }
+  os_leave(self);
+  return res;
+}
+
+osStatus osSemaphoreRelease (osSemaphoreId semaphore_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_semaphore_cb *s = os_obj(semaphore_id, OS_OBJ_SEM);
+  osStatus status = osOK;
+
+  if (s == NULL) {
+    status = osErrorParameter;
+  } else if (s->tokens == (uint32_t)osFeature_Semaphore) {
+    status = osErrorResource;
+  } else if (s->waiters != NULL) {
+    os_wake(s->waiters, OS_R_SEM);              // The token goes to the waiter
+  } else {
+    s->tokens++;
+  }
+  os_leave(self);
+  return status;
+}
+
+osStatus osSemaphoreDelete (osSemaphoreId semaphore_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_semaphore_cb *s = os_obj(semaphore_id, OS_OBJ_SEM);
+
+  if (os_isr(self)) {
+    os_leave(self);
+    return osErrorISR;
+  }
+  if (s == NULL) {
+    os_leave(self);
+    return osErrorParameter;
+  }
+  while (s->waiters != NULL) {
+    os_wake(s->waiters, OS_R_TMO);
+  }
+  os_obj_free(s);
+  os_leave(self);
+  return osOK;
+}
+
+/*----------------------------------------------------------------------------
+ *      Memory pools
+ *---------------------------------------------------------------------------*/
+
+static bool os_pool_init (struct os_pool_cb *p, uint32_t count, uint32_t item_sz) {
+  uint32_t i;
+
+  // Blocks are aligned for any host type
+  p->blk_sz  = (item_sz + 7U) & ~7U;
+  p->count   = count;
+  p->waiters = NULL;
+  p->free    = NULL;
+  free(p->mem);
+  p->mem = malloc((size_t)p->blk_sz * count);
+  if (p->mem == NULL) {
+    return false;
+  }
+  for (i = count; i != 0U; i--) {
+    void **blk = (void **)(p->mem + (size_t)(i - 1U) * p->blk_sz);
+    *blk = p->free;
+    p->free = blk;
+  }
+  return true;
+}
+
+static void *os_pool_alloc (struct os_pool_cb *p) {
+  void **blk = p->free;
+
+  if (blk != NULL) {
+    p->free = *blk;
+  }
+  return blk;
+}
+
+static osStatus os_pool_free (struct os_pool_cb *p, void *block) {
+  uint8_t *b = block;
+
+  if ((b < p->mem) || (b >= p->mem + (size_t)p->blk_sz * p->count) ||
+      (((size_t)(b - p->mem) % p->blk_sz) != 0U)) {
+    return osErrorValue;
+  }
+  if (p->waiters != NULL) {
+    // The block goes to a thread waiting in osMailAlloc
+    p->waiters->msg = (uintptr_t)block;
+    os_wake(p->waiters, OS_R_MBX);
+    return osOK;
+  }
+  *(void **)block = p->free;
+  p->free = block;
+  return osOK;
+}
+
+osPoolId osPoolCreate (const osPoolDef_t *pool_def) {
+  struct os_thread_cb *self = os_enter();
+  struct os_pool_cb *p = NULL;
+
+  if (!os_isr(self) && (pool_def != NULL) && (pool_def->pool_sz != 0U) && (pool_def->item_sz != 0U)) {
+    p = os_obj_get(pool_def->pool, OS_OBJ_POOL, sizeof(struct os_pool_cb));
+    if ((p != NULL) && !os_pool_init(p, pool_def->pool_sz, pool_def->item_sz)) {
+      os_obj_free(p);
+      p = NULL;
+    }
+  }
+  os_leave(self);
+  return p;
+}
+
+void *osPoolAlloc (osPoolId pool_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_pool_cb *p = os_obj(pool_id, OS_OBJ_POOL);
+  void *mem = NULL;
+
+  if (p != NULL) {
+    mem = os_pool_alloc(p);
+  }
+  os_leave(self);
+  return mem;
+}
+
+void *osPoolCAlloc (osPoolId pool_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_pool_cb *p = os_obj(pool_id, OS_OBJ_POOL);
+  void *mem = NULL;
+
+  if (p != NULL) {
+    mem = os_pool_alloc(p);
+    if (mem != NULL) {
+      memset(mem, 0, p->blk_sz);
+    }
+  }
+  os_leave(self);
+  return mem;
+}
+
+osStatus osPoolFree (osPoolId pool_id, void *block) {
+  struct os_thread_cb *self = os_enter();
+  struct os_pool_cb *p = os_obj(pool_id, OS_OBJ_POOL);
+  osStatus status = osErrorParameter;
+
+  if (p != NULL) {
+    status = os_pool_free(p, block);
+  }
+  os_leave(self);
+  return status;
+}
+
+/*----------------------------------------------------------------------------
+ *      Message queues
+ *---------------------------------------------------------------------------*/
+
+static bool os_mq_init (struct os_messageQ_cb *q, uint32_t size) {
+  q->getters = NULL;
+  q->putters = NULL;
+  q->size    = size;
+  q->count   = 0U;
+  q->first   = 0U;
+  free(q->msg);
+  q->msg = malloc(size * sizeof(uintptr_t));
+  return q->msg != NULL;
+}
+
+static void os_mq_enq (struct os_messageQ_cb *q, uintptr_t info) {
+  q->msg[(q->first + q->count) % q->size] = info;
+  q->count++;
+}
+
+static osStatus os_mq_put (struct os_thread_cb *self, struct os_messageQ_cb *q, uintptr_t info, uint32_t millisec) {
+  if (os_isr(self) && (millisec != 0U)) {
+    return osErrorParameter;
+  }
+  if (q->getters != NULL) {
+    q->getters->msg = info;                     // Straight to the waiting thread
+    os_wake(q->getters, OS_R_MBX);
+    return osOK;
+  }
+  if (q->count < q->size) {
+    os_mq_enq(q, info);
+    return osOK;
+  }
+  if (millisec == 0U) {
+    return osErrorResource;
+  }
+  self->msg = info;
+  if (os_block(self, &q->putters, WAIT_MBX, millisec) != OS_R_MBX) {
+    return osErrorTimeoutResource;
+  }
+  return osOK;
+}
+
+static osEvent os_mq_get (struct os_thread_cb *self, struct os_messageQ_cb *q, uint32_t millisec) {
+  osEvent ret;
+
+  if (os_isr(self) && (millisec != 0U)) {
+    ret.status = osErrorParameter;
+    return ret;
+  }
+  if (q->count != 0U) {
+    ret.status = osEventMessage;
+    ret.value.p = (void *)q->msg[q->first];
+    q->first = (q->first + 1U) % q->size;
+    q->count--;
+    if (q->putters != NULL) {
+      os_mq_enq(q, q->putters->msg);            // Room for a waiting thread
+      os_wake(q->putters, OS_R_MBX);
+    }
+  } else if (millisec == 0U) {
+    ret.status = osOK;
+  } else if (os_block(self, &q->getters, WAIT_MBX, millisec) == OS_R_MBX) {
+    ret.status = osEventMessage;
+    ret.value.p = (void *)self->msg;
+  } else {
+    ret.status = osEventTimeout;
+  }
+  return ret;
+}
+
+osMessageQId osMessageCreate (const osMessageQDef_t *queue_def, osThreadId thread_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_messageQ_cb *q = NULL;
+
+  (void)thread_id;
+  if (!os_isr(self) && (queue_def != NULL) && (queue_def->queue_sz != 0U) && (queue_def->pool != NULL)) {
+    q = os_obj_get(queue_def->pool, OS_OBJ_MSGQ, sizeof(struct os_messageQ_cb));
+    if ((q != NULL) && !os_mq_init(q, queue_def->queue_sz)) {
+      os_obj_free(q);
+      q = NULL;
+    }
+  }
+  os_leave(self);
+  return q;
+}
+
+osStatus osMessagePut (osMessageQId queue_id, uintptr_t info, uint32_t millisec) {
+  struct os_thread_cb *self = os_enter();
+  struct os_messageQ_cb *q = os_obj(queue_id, OS_OBJ_MSGQ);
+  osStatus status = osErrorParameter;
+
+  if (q != NULL) {
+    status = os_mq_put(self, q, info, millisec);
+  }
+  os_leave(self);
+  return status;
+}
+
+os_InRegs osEvent osMessageGet (osMessageQId queue_id, uint32_t millisec) {
+  struct os_thread_cb *self = os_enter();
+  struct os_messageQ_cb *q = os_obj(queue_id, OS_OBJ_MSGQ);
+  osEvent ret;
+
+  ret.status = osErrorParameter;
+  if (q != NULL) {
+    ret = os_mq_get(self, q, millisec);
+  }
+  ret.def.message_id = queue_id;
+  os_leave(self);
+  return ret;
+}
+
+/*----------------------------------------------------------------------------
+ *      Mail queues
+ *---------------------------------------------------------------------------*/
+
+osMailQId osMailCreate (const osMailQDef_t *queue_def, osThreadId thread_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_mailQ_cb *q = NULL;
+
+  (void)thread_id;
+  if (!os_isr(self) && (queue_def != NULL) && (queue_def->queue_sz != 0U) &&
+      (queue_def->item_sz != 0U) && (queue_def->pool != NULL)) {
+    q = os_obj_get(queue_def->pool, OS_OBJ_MAILQ, sizeof(struct os_mailQ_cb));
+    if ((q != NULL) && (!os_pool_init(&q->pool, queue_def->queue_sz, queue_def->item_sz) ||
+                        !os_mq_init(&q->queue, queue_def->queue_sz))) {
+      free(q->pool.mem);
+      free(q->queue.msg);
+      os_obj_free(q);
+      q = NULL;
+    }
+  }
+  os_leave(self);
+  return q;
+}
+
+static void *os_mail_alloc (osMailQId queue_id, uint32_t millisec, bool clear) {
+  struct os_thread_cb *self = os_enter();
+  struct os_mailQ_cb *q = os_obj(queue_id, OS_OBJ_MAILQ);
+  void *mem = NULL;
+
+  if ((q != NULL) && !(os_isr(self) && (millisec != 0U))) {
+    mem = os_pool_alloc(&q->pool);
+    if ((mem == NULL) && (millisec != 0U) &&
+        (os_block(self, &q->pool.waiters, WAIT_MBX, millisec) == OS_R_MBX)) {
+      mem = (void *)self->msg;
+    }
+    if ((mem != NULL) && clear) {
+      memset(mem, 0, q->pool.blk_sz);
+    }
+  }
+  os_leave(self);
+  return mem;
+}
+
+void *osMailAlloc (osMailQId queue_id, uint32_t millisec) {
+  return os_mail_alloc(queue_id, millisec, false);
+}
+
+void *osMailCAlloc (osMailQId queue_id, uint32_t millisec) {
+  return os_mail_alloc(queue_id, millisec, true);
+}
+
+osStatus osMailFree (osMailQId queue_id, void *mail) {
+  struct os_thread_cb *self = os_enter();
+  struct os_mailQ_cb *q = os_obj(queue_id, OS_OBJ_MAILQ);
+  osStatus status = osErrorParameter;
+
+  if (q != NULL) {
+    status = os_pool_free(&q->pool, mail);
+  }
+  os_leave(self);
+  return status;
+}
+
+osStatus osMailPut (osMailQId queue_id, void *mail) {
+  struct os_thread_cb *self = os_enter();
+  struct os_mailQ_cb *q = os_obj(queue_id, OS_OBJ_MAILQ);
+  osStatus status = osErrorParameter;
+
+  if ((q != NULL) && (mail == NULL)) {
+    status = osErrorValue;
+  } else if (q != NULL) {
+    status = os_mq_put(self, &q->queue, (uintptr_t)mail, 0U);
+  }
+  os_leave(self);
+  return status;
+}
+
+os_InRegs osEvent osMailGet (osMailQId queue_id, uint32_t millisec) {
+  struct os_thread_cb *self = os_enter();
+  struct os_mailQ_cb *q = os_obj(queue_id, OS_OBJ_MAILQ);
+  osEvent ret;
+
+  ret.status = osErrorParameter;
+  if (q != NULL) {
+    ret = os_mq_get(self, &q->queue, millisec);
+    if (ret.status == osEventMessage) {
+      ret.status = osEventMail;
+    }
+  }
+  ret.def.mail_id = queue_id;
+  os_leave(self);
+  return ret;
+}
+
+/*----------------------------------------------------------------------------
+ *      Timers
+ *---------------------------------------------------------------------------*/
+
+/// Timer thread: calls the functions of expired timers, as osTimerThread
+static void os_timer_thread (void const *argument) {
+  struct os_thread_cb *self;
+  struct os_timer_cb *pt;
+  os_ptimer func;
+  void *arg;
+
+  (void)argument;
+  for (;;) {
+    self = os_enter();
+    while (os_timer_due == NULL) {
+      os_block(self, NULL, WAIT_MBX, osWaitForever);
+    }
+    pt = os_timer_due;
+    os_timer_due = pt->due_next;
+    pt->queued = 0U;
+    func = pt->ptimer;
+    arg  = pt->arg;
+    os_leave(self);
+    func(arg);
+  }
+}
+
+static void os_timer_unlink (struct os_timer_cb *pt) {
+  struct os_timer_cb **list;
+
+  for (list = &os_timers; *list != NULL; list = &(*list)->next) {
+    if (*list == pt) {
+      *list = pt->next;
+      break;
+    }
+  }
+  pt->running = 0U;
+}
+
+osTimerId osTimerCreate (const osTimerDef_t *timer_def, os_timer_type type, void *argument) {
+  struct os_thread_cb *self = os_enter();
+  struct os_timer_cb *pt = NULL;
+
+  if (os_isr(self) || (timer_def == NULL) || (timer_def->ptimer == NULL)) {
+    os_leave(self);
+    return NULL;
+  }
+  if (os_timer_tsk == NULL) {
+    os_timer_tsk = os_thread_spawn(os_timer_thread, NULL, (U8)OS_TIMERPRIO);
+    osThreadId_osTimerThread = os_timer_tsk;
+  }
+  if (os_timer_tsk != NULL) {
+    pt = os_obj_get(timer_def->timer, OS_OBJ_TIMER, sizeof(struct os_timer_cb));
+  }
+  if (pt != NULL) {
+    if (pt->running) {
+      os_timer_unlink(pt);
+    }
+    pt->ptimer = timer_def->ptimer;
+    pt->arg    = argument;
+    pt->type   = (U8)type;
+  }
+  os_leave(self);
+  return pt;
+}
+
+osStatus osTimerStart (osTimerId timer_id, uint32_t millisec) {
+  struct os_thread_cb *self = os_enter();
+  struct os_timer_cb *pt = os_obj(timer_id, OS_OBJ_TIMER);
+
+  if (os_isr(self)) {
+    os_leave(self);
+    return osErrorISR;
+  }
+  if (pt == NULL) {
+    os_leave(self);
+    return osErrorParameter;
+  }
+  if (millisec == 0U) {
+    os_leave(self);
+    return osErrorValue;
+  }
+  if (!pt->running) {
+    pt->running = 1U;
+    pt->next = os_timers;
+    os_timers = pt;
+  }
+  pt->period = (uint64_t)millisec * 1000U;
+  pt->wake   = os_now() + pt->period;
+  os_leave(self);
+  return osOK;
+}
+
+osStatus osTimerStop (osTimerId timer_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_timer_cb *pt = os_obj(timer_id, OS_OBJ_TIMER);
+  osStatus status = osOK;
+
+  if (os_isr(self)) {
+    status = osErrorISR;
+  } else if (pt == NULL) {
+    status = osErrorParameter;
+  } else if (!pt->running) {
+    status = osErrorResource;
+  } else {
+    os_timer_unlink(pt);
+  }
+  os_leave(self);
+  return status;
+}
+
+osStatus osTimerDelete (osTimerId timer_id) {
+  struct os_thread_cb *self = os_enter();
+  struct os_timer_cb *pt = os_obj(timer_id, OS_OBJ_TIMER);
+  struct os_timer_cb **list;
+
+  if (os_isr(self)) {
+    os_leave(self);
+    return osErrorISR;
+  }
+  if (pt == NULL) {
+    os_leave(self);
+    return osErrorParameter;
+  }
+  os_timer_unlink(pt);
+  for (list = &os_timer_due; *list != NULL; list = &(*list)->due_next) {
+    if (*list == pt) {
+      *list = pt->due_next;
+      break;
+    }
+  }
+  os_obj_free(pt);
+  os_leave(self);
+  return osOK;
+}
+
+/*----------------------------------------------------------------------------
+ *      RTX extensions and idle
+ *---------------------------------------------------------------------------*/
+
+/// Milliseconds to the next timeout, timer or interrupt
+uint32_t os_suspend (void) {
+  uint64_t next;
+  uint64_t now;
+
+  pthread_mutex_lock(&os_lock);
+  next = os_next_event();
+  now  = os_now();
+  pthread_mutex_unlock(&os_lock);
+  if (next == OS_FOREVER) {
+    return 0xFFFFU;
+  }
+  return (next <= now) ? 0U : (uint32_t)((next - now) / 1000U);
+}
+
+/// Time passes by itself on the host
+void os_resume (uint32_t sleep_time) {
+  (void)sleep_time;
+}
+
+/// Called when the processor goes idle, with the ISR rules for RTOS calls
+void rtos_attach_idle_hook (void (*fptr)(void)) {
+  pthread_mutex_lock(&os_lock);
+  os_idle_hook = fptr;
+  pthread_mutex_unlock(&os_lock);
+}
+
+/*----------------------------------------------------------------------------
+ *      Host port interface
+ *---------------------------------------------------------------------------*/
+
+void os_host_config (int mode, uint32_t seed) {
+  uint64_t now;
+
+  pthread_mutex_lock(&os_lock);
+  if (!os_started) {
+    os_init();
+  }
+  now = os_now();
+  if (mode == OS_HOST_VIRTUAL) {
+    os_vtime = now;
+  } else if (os_mode == OS_HOST_VIRTUAL) {
+    // Continue the host clock from the virtual time
+    clock_gettime(CLOCK_MONOTONIC, &os_start);
+    os_start.tv_sec  -= (time_t)(now / 1000000U);
+    os_start.tv_nsec -= (long)(now % 1000000U) * 1000;
+    if (os_start.tv_nsec < 0) {
+      os_start.tv_nsec += 1000000000;
+      os_start.tv_sec--;
+    }
+  }
+  os_mode = mode;
+  os_seed = seed;
+  os_rand_state = seed;
+  pthread_mutex_unlock(&os_lock);
+}
+
+uint64_t os_host_time (void) {
+  uint64_t now;
+
+  pthread_mutex_lock(&os_lock);
+  if (!os_started) {
+    os_init();
+  }
+  now = os_now();
+  pthread_mutex_unlock(&os_lock);
+  return now;
+}
+
+void os_host_barrier (void) {
+  pthread_mutex_lock(&os_lock);
+  if (os_started && (os_self != NULL) && (os_run == os_self) && !os_in_isr && (os_mask == 0U)) {
+    os_preempt(os_self);
+  }
+  pthread_mutex_unlock(&os_lock);
+}
+
+void os_host_irq (void (*handler)(void *arg), void *arg, uint32_t delay_us) {
+  os_irq *irq;
+  os_irq **list;
+
+  irq = malloc(sizeof(os_irq));
+  if (irq == NULL) {
+    os_fatal("no memory for an interrupt");
+  }
+  irq->handler = handler;
+  irq->arg     = arg;
+
+  pthread_mutex_lock(&os_lock);
+  if (!os_started) {
+    os_init();
+  }
+  irq->due = os_now() + delay_us;
+  for (list = &os_irqs; (*list != NULL) && ((*list)->due <= irq->due); list = &(*list)->next);
+  irq->next = *list;
+  *list = irq;
+  pthread_cond_signal(&os_idle_cond);
+
+  // Raised by the running thread: taken straight away, as on the target
+  if ((delay_us == 0U) && (os_self != NULL) && (os_run == os_self) && !os_in_isr && (os_mask == 0U)) {
+    os_preempt(os_self);
+  }
+  pthread_mutex_unlock(&os_lock);
+}
+
+static void os_print_stderr (const char *line) {
+  fprintf(stderr, "%s\n", line);
+}
+
+static void os_dump (void (*print)(const char *line)) {
+  static const char *const states[] = {
+    "inactive", "ready", "running", "delay", "interval",
+    "wait_or", "wait_and", "wait_sem", "wait_mbx", "wait_mut"
+  };
+  struct os_thread_cb *t;
+  char line[120];
+  uint64_t cycles;
+
+  if (print == NULL) {
+    print = &os_print_stderr;
+  }
+  snprintf(line, sizeof(line), "time %llu us, %lu switches, %lu kernel calls",
+           (unsigned long long)os_now(), (unsigned long)os_switches, (unsigned long)os_calls);
+  print(line);
+  print("id prio state     cpu_us       switches entry");
+  for (t = os_threads; t != NULL; t = t->next) {
+    cycles = t->cycles;
+    if (t == os_run) {
+      cycles += os_now() - t->since;
+    }
+    snprintf(line, sizeof(line), "%2u %4u %-9s %12llu %8lu %p%s",
+             t->tcb.task_id, t->tcb.prio,
+             (t->tcb.state <= WAIT_MUT) ? states[t->tcb.state] : "?",
+             (unsigned long long)cycles, (unsigned long)t->switches,
+             (void *)t->tcb.ptask,
+             (t == os_main) ? " main" : (t == os_timer_tsk) ? " timer" : "");
+    print(line);
+  }
+}
+
+void os_host_dump (void (*print)(const char *line)) {
+  pthread_mutex_lock(&os_lock);
+  if (!os_started) {
+    os_init();
+  }
+  os_dump(print);
+  pthread_mutex_unlock(&os_lock);
+}
@@ -0,0 +1,145 @@
+
+/** \addtogroup rtos */
+/** @{*/
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef OS_HOST_H
+#define OS_HOST_H
+
+#include <stdint.h>
+
+/** Host port of the RTOS
+
+  The files in rtx/TARGET_HOST implement the CMSIS-RTOS API of RTX on POSIX
+  threads, so that code written against cmsis_os.h and the rtos classes
+  (Thread, Mutex, Semaphore, Queue, Mail, MemoryPool, RtosTimer, EventQueue)
+  can be run and tested on a workstation. They are not part of the target
+  build.
+
+  The port emulates a single processor. Every thread runs on a pthread of its
+  own, but only one of them holds the processor at a time, and the kernel
+  hands it over following the RTX rules: strict priorities, priority
+  inheritance on mutexes, round robin between threads of equal priority and
+  FIFO wake-up order within a priority. Threads are switched only when they
+  call into the kernel: any osXxx function, us_ticker_read, the end of a
+  critical section, or a memory barrier (__DMB, see cmsis.h). A thread that computes for a long time without any of
+  these keeps the processor, as if it had the highest priority.
+
+  Interrupts are simulated with os_host_irq. The handler runs on the
+  processor between two threads, with the ISR rules of the RTX API: calls
+  that would block return an error, and threads it wakes run when it
+  returns. A critical section holds back interrupts and thread switches,
+  and RTOS calls made inside one follow the ISR rules too, as on the target.
+
+  The clock runs in one of two modes:
+  - OS_HOST_REALTIME: time is the host's monotonic clock. Timeouts, timers
+    and us_ticker_read follow the wall clock.
+  - OS_HOST_VIRTUAL: time only moves forward when every thread waits, and
+    then jumps straight to the next timeout, timer or interrupt. Each clock
+    read (us_ticker_read, osKernelSysTick) costs one microsecond, so busy
+    waits end. Runs are deterministic: the same program gives the same
+    schedule every time, and a sleep of an hour takes no time at all. When
+    all threads wait forever and no interrupt is pending, the port reports
+    the threads and aborts.
+
+  A non-zero seed perturbs the schedule: at kernel calls, a thread may give
+  way to another ready thread of the same priority, and woken threads may
+  be queued ahead of others of their priority. Each seed gives another
+  reproducible interleaving, which helps to find races: run a test under
+  many seeds, and replay a failing seed in the debugger.
+
+  The mode and seed are read from the environment variables OS_HOST_VIRTUAL
+  (set to 1 for virtual time) and OS_HOST_SEED when the kernel starts, and
+  can be changed later with os_host_config.
+
+  The process main thread becomes the RTOS main thread, at osPriorityNormal,
+  on its first RTOS call. Other host threads must not call the RTOS, except
+  for os_host_irq. Thread stack sizes are recorded but threads run on host
+  stacks of OS_HOST_STACK bytes, so stack use is not measured.
+
+  Building: UNITTESTS/CMakeLists.txt builds the port as the host_rtos
+  library, with the tests that run on it. By hand: compile
+  rtx/TARGET_HOST/os_host.c, rtx/TARGET_HOST/mbed_host.c and the rtos/
+  sources needed, with -pthread, and rtx/TARGET_HOST ahead of
+  rtx/TARGET_CORTEX_M on the include path. The mbed-rtos directory, the
+  mbed directory and mbed/platform complete the include path. The files of
+  rtos/ that read the Cortex-M hardware (rtos_idle.c, rtos_trace.c,
+  rtos_heap.c and rtos_mutex_profile.c) are target only. StackMonitor.cpp
+  builds, and measures what is written into the recorded stacks.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OS_HOST_REALTIME    0   /**< time follows the host clock */
+#define OS_HOST_VIRTUAL     1   /**< time jumps ahead when all threads wait */
+
+/** Select the clock mode and the schedule seed
+
+  The mode can be changed at any time; the clock continues from the
+  current time.
+
+  @param mode  OS_HOST_REALTIME or OS_HOST_VIRTUAL
+  @param seed  zero for the plain RTX schedule, otherwise the seed of the
+               schedule perturbation
+*/
+void os_host_config(int mode, uint32_t seed);
+
+/** Read the kernel clock, without a thread switch
+
+  @return microseconds since the kernel started
+*/
+uint64_t os_host_time(void);
+
+/** Raise a simulated interrupt
+
+  The handler runs once the delay has passed, at the next kernel call or
+  barrier of the running thread, or straight away when all threads wait.
+  Interrupts due at the same time run in the order they were raised. One
+  raised by a handler runs at the next such point, so a handler that raises
+  itself again with no delay steps through the points of a thread. This may be called from
+  any host thread, also one the RTOS does not know, for instance a thread
+  reading a network device.
+
+  @param handler   interrupt handler
+  @param arg       argument for the handler
+  @param delay_us  microseconds from now, 0 to run it as soon as possible
+*/
+void os_host_irq(void (*handler)(void *arg), void *arg, uint32_t delay_us);
+
+/** Print the threads, their processor time and switch counts
+
+  The first line gives the time, and the thread switches and calls of the
+  osXxx API since the kernel started.
+
+  @param print  function to output one line, without a line ending
+*/
+void os_host_dump(void (*print)(const char *line));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/** @}*/
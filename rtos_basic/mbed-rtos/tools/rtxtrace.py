@@ -0,0 +1,178 @@
+#!/usr/bin/env python
+"""Decode an RTX scheduler trace dump into a Chrome trace.
+
+The dump is the text printed by rtos_trace_dump(), captured from the
+serial port. Other output around it is ignored. The result loads into
+chrome://tracing or https://ui.perfetto.dev, with one track per thread
+showing when it ran, interrupts, semaphore events and mutex priority
+inheritance boosts as instant events, and a summary of CPU usage per
+thread is printed to stderr.
+
+    python rtxtrace.py capture.log -o trace.json --name 3=display
+"""
+
+import argparse
+import json
+import re
+import sys
+
+SWITCH, ISR, SEM_TAKE, SEM_BLOCK, SEM_GIVE, SEM_ISR, MUT_BOOST = range(1, 8)
+
+IDLE = 255
+IRQ_TRACK = 1000
+
+
+def parse(lines):
+    """Return (header, threads, events) from the last dump in the lines."""
+    header = None
+    threads = []
+    events = []
+    for line in lines:
+        m = re.search(r'rtxtrace (\d+) (\d+) (\d+) (\d+)', line)
+        if m:
+            if int(m.group(1)) != 1:
+                sys.exit('unsupported dump version %s' % m.group(1))
+            header = {'hz': int(m.group(2)), 'recorded': int(m.group(3))}
+            threads = []
+            events = []
+            continue
+        if header is None:
+            continue
+        m = re.search(r'thread (\d+) ([0-9a-f]{8}) ([0-9a-f]{8}) ([0-9a-f]{8}) (\d+) ([0-9a-f]{16})', line)
+        if m:
+            threads.append({'tid': int(m.group(1)), 'id': int(m.group(2), 16),
+                            'entry': int(m.group(3), 16), 'arg': int(m.group(4), 16),
+                            'prio': int(m.group(5)), 'cycles': int(m.group(6), 16)})
+            continue
+        m = re.search(r'event ([0-9a-f]{8}) ([0-9a-f]{8}) ([0-9a-f]{8})', line)
+        if m:
+            info = int(m.group(2), 16)
+            events.append({'time': int(m.group(1), 16), 'type': info & 0xFF,
+                           'tid': (info >> 8) & 0xFF, 'arg': info >> 16,
+                           'obj': int(m.group(3), 16)})
+    if header is None:
+        sys.exit('no rtxtrace dump found')
+    return header, threads, events
+
+
+def unwrap(events):
+    """Extend the 32-bit cycle stamps, allowing for slightly out of order events."""
+    t = 0
+    prev = None
+    for e in events:
+        if prev is not None:
+            delta = (e['time'] - prev) & 0xFFFFFFFF
+            if delta & 0x80000000:
+                delta -= 0x100000000
+            t += delta
+        prev = e['time']
+        e['cycles'] = t
+    base = min(e['cycles'] for e in events) if events else 0
+    for e in events:
+        e['cycles'] -= base
+
+
+def thread_names(threads, options):
+    names = {IDLE: 'idle', 0: 'none'}
+    for t in threads:
+        if t['tid'] != IDLE:
+            names[t['tid']] = 'thread %d (entry %08x, arg %08x)' % (t['tid'], t['entry'], t['arg'])
+    for opt in options:
+        key, _, name = opt.partition('=')
+        key = int(key, 0)
+        for t in threads:
+            if key in (t['tid'], t['id'], t['arg']):
+                names[t['tid']] = name
+        if key < 256:
+            names[key] = name
+    return names
+
+
+def convert(header, events, names):
+    us = 1e6 / header['hz']
+    out = []
+    for tid in sorted(names):
+        out.append({'ph': 'M', 'name': 'thread_name', 'pid': 1, 'tid': tid,
+                    'args': {'name': names[tid]}})
+    out.append({'ph': 'M', 'name': 'thread_name', 'pid': 1, 'tid': IRQ_TRACK,
+                'args': {'name': 'interrupts'}})
+
+    run = {}
+    running = None
+    start = None
+
+    def slice_run(tid, begin, end):
+        run[tid] = run.get(tid, 0) + end - begin
+        out.append({'ph': 'X', 'name': 'run', 'pid': 1, 'tid': tid,
+                    'ts': begin * us, 'dur': (end - begin) * us})
+
+    for e in events:
+        ts = e['cycles'] * us
+        if e['type'] == SWITCH:
+            if running:
+                slice_run(running, start, e['cycles'])
+            running = e['tid']
+            start = e['cycles']
+        elif e['type'] in (ISR, SEM_ISR):
+            irq = e['arg'] - 16
+            name = 'IRQ %d' % irq if irq >= 0 else 'exception %d' % e['arg']
+            if e['type'] == SEM_ISR:
+                name += ' gives %08x' % e['obj']
+            out.append({'ph': 'i', 's': 't', 'name': name, 'pid': 1,
+                        'tid': IRQ_TRACK, 'ts': ts})
+        elif e['type'] == MUT_BOOST:
+            waiter = e['arg'] & 0xFF
+            args = {'mutex': '%08x' % e['obj'], 'waiter': names.get(waiter, waiter),
+                    'priority': e['arg'] >> 8}
+            out.append({'ph': 'i', 's': 't', 'name': 'mutex boost', 'pid': 1,
+                        'tid': e['tid'], 'ts': ts, 'args': args})
+        else:
+            what = {SEM_TAKE: 'take', SEM_BLOCK: 'block', SEM_GIVE: 'give'}.get(e['type'])
+            if what is None:
+                continue
+            args = {'semaphore': '%08x' % e['obj']}
+            if e['type'] == SEM_TAKE:
+                args['tokens left'] = e['arg']
+            elif e['type'] == SEM_GIVE and e['arg']:
+                args['wakes'] = names.get(e['arg'], e['arg'])
+            out.append({'ph': 'i', 's': 't', 'name': 'sem ' + what, 'pid': 1,
+                        'tid': e['tid'], 'ts': ts, 'args': args})
+    span = max(e['cycles'] for e in events) if events else 0
+    if running:
+        slice_run(running, start, span)
+    return {'traceEvents': out, 'displayTimeUnit': 'ns'}, run, span
+
+
+def summary(header, threads, names, run, span):
+    hz = float(header['hz'])
+    total = sum(t['cycles'] for t in threads) or 1
+    sys.stderr.write('%-40s %12s %7s %12s %7s\n' % ('thread', 'total ms', 'total', 'window ms', 'window'))
+    for t in sorted(threads, key=lambda t: -t['cycles']):
+        w = run.get(t['tid'], 0)
+        sys.stderr.write('%-40s %12.1f %6.1f%% %12.3f %6.1f%%\n' % (
+            names.get(t['tid'], t['tid'])[:40], t['cycles'] * 1e3 / hz,
+            100.0 * t['cycles'] / total, w * 1e3 / hz, 100.0 * w / span if span else 0.0))
+    sys.stderr.write('window %.3f ms, %d events recorded since start\n' % (
+        span * 1e3 / hz, header['recorded']))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('log', help='captured serial output, or - for stdin')
+    ap.add_argument('-o', '--output', default='trace.json', help='Chrome trace JSON file to write')
+    ap.add_argument('--name', action='append', default=[], metavar='KEY=NAME',
+                    help='name a thread by task id, thread ID or argument (e.g. a Thread object address)')
+    opts = ap.parse_args()
+
+    f = sys.stdin if opts.log == '-' else open(opts.log)
+    header, threads, events = parse(f)
+    unwrap(events)
+    names = thread_names(threads, opts.name)
+    trace, run, span = convert(header, events, names)
+    with open(opts.output, 'w') as out:
+        json.dump(trace, out)
+    summary(header, threads, names, run, span)
+
+
+if __name__ == '__main__':
+    main()